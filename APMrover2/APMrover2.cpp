@@ -316,8 +316,10 @@ void Rover::one_second_loop(void)
         if (scheduler.debug() != 0) {
             hal.console->printf("G_Dt_max=%lu\n", (unsigned long)G_Dt_max);
         }
-        if (should_log(MASK_LOG_PM))
+        if (should_log(MASK_LOG_PM)) {
             Log_Write_Performance();
+            DataFlash.Log_Write_ParamStorage();
+        }
         G_Dt_max = 0;
         resetPerfData();
     }
@@ -579,6 +579,13 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
 #endif
         break;
 
+    case MSG_EKF_TIMING:
+#if AP_AHRS_NAVEKF_AVAILABLE
+        CHECK_PAYLOAD_SIZE(EKF_TIMING);
+        rover.ahrs.get_NavEKF2().send_timing(chan);
+#endif
+        break;
+
     case MSG_PID_TUNING:
         CHECK_PAYLOAD_SIZE(PID_TUNING);
         rover.send_pid_tuning(chan);
@@ -604,6 +611,10 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
     case MSG_OPTICAL_FLOW:
     case MSG_GIMBAL_REPORT:
     case MSG_RPM:
+    case MSG_VIBRATION_PEAKS:
+    case MSG_ADSB_THREAT:
+    case MSG_LOOP_TIMING:
+    case MSG_PERF_COUNTER:
         break; // just here to prevent a warning
 
     }
@@ -742,6 +753,10 @@ GCS_MAVLINK::data_stream_send(void)
         handle_log_send(rover.DataFlash);
     }
 
+    if (!rover.in_mavlink_delay) {
+        handle_param_blob_send();
+    }
+
     if (_queued_parameter != NULL) {
         if (streamRates[STREAM_PARAMS].get() <= 0) {
             streamRates[STREAM_PARAMS].set(10);
@@ -835,6 +850,7 @@ GCS_MAVLINK::data_stream_send(void)
         send_message(MSG_MAG_CAL_PROGRESS);
         send_message(MSG_MOUNT_STATUS);
         send_message(MSG_EKF_STATUS_REPORT);
+        send_message(MSG_EKF_TIMING);
     }
 }
 
@@ -1344,6 +1360,14 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
         }
         break;
 
+    case MAVLINK_MSG_ID_PARAM_BLOB_REQUEST:
+    case MAVLINK_MSG_ID_PARAM_BLOB_DATA:
+    case MAVLINK_MSG_ID_PARAM_BLOB_ACK:
+        if (!rover.in_mavlink_delay) {
+            handle_param_blob_message(msg, &rover.DataFlash);
+        }
+        break;
+
     case MAVLINK_MSG_ID_SERIAL_CONTROL:
         handle_serial_control(msg, rover.gps);
         break;
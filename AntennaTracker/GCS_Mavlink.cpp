@@ -290,6 +290,11 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
     case MSG_VIBRATION:
     case MSG_RPM:
     case MSG_MISSION_ITEM_REACHED:
+    case MSG_VIBRATION_PEAKS:
+    case MSG_ADSB_THREAT:
+    case MSG_EKF_TIMING:
+    case MSG_LOOP_TIMING:
+    case MSG_PERF_COUNTER:
         break; // just here to prevent a warning
     }
     return true;
@@ -724,6 +724,11 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
         copter.ahrs.send_ekf_status_report(chan);
         break;
 
+    case MSG_EKF_TIMING:
+        CHECK_PAYLOAD_SIZE(EKF_TIMING);
+        copter.ahrs.get_NavEKF2().send_timing(chan);
+        break;
+
     case MSG_FENCE_STATUS:
     case MSG_WIND:
         // unused
@@ -744,7 +749,15 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
         mavlink_msg_mission_item_reached_send(chan, mission_item_reached_index);
         break;
 
+    case MSG_ADSB_THREAT:
+        CHECK_PAYLOAD_SIZE(ADSB_THREAT);
+        copter.adsb.send_threat(chan);
+        break;
+
     case MSG_RETRY_DEFERRED:
+    case MSG_VIBRATION_PEAKS:
+    case MSG_LOOP_TIMING:
+    case MSG_PERF_COUNTER:
         break; // just here to prevent a warning
 
     case MSG_MAG_CAL_PROGRESS:
@@ -890,6 +903,10 @@ GCS_MAVLINK::data_stream_send(void)
         handle_log_send(copter.DataFlash);
     }
 
+    if (!copter.in_mavlink_delay) {
+        handle_param_blob_send();
+    }
+
     copter.gcs_out_of_time = false;
 
     if (_queued_parameter != NULL) {
@@ -953,6 +970,7 @@ GCS_MAVLINK::data_stream_send(void)
         send_message(MSG_ATTITUDE);
         send_message(MSG_SIMSTATE);
         send_message(MSG_PID_TUNING);
+        send_message(MSG_ADSB_THREAT);
     }
 
     if (copter.gcs_out_of_time) return;
@@ -978,6 +996,7 @@ GCS_MAVLINK::data_stream_send(void)
         send_message(MSG_MAG_CAL_REPORT);
         send_message(MSG_MAG_CAL_PROGRESS);
         send_message(MSG_EKF_STATUS_REPORT);
+        send_message(MSG_EKF_TIMING);
         send_message(MSG_VIBRATION);
         send_message(MSG_RPM);
     }
@@ -1851,6 +1870,14 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
         }
         break;
 
+    case MAVLINK_MSG_ID_PARAM_BLOB_REQUEST:
+    case MAVLINK_MSG_ID_PARAM_BLOB_DATA:
+    case MAVLINK_MSG_ID_PARAM_BLOB_ACK:
+        if (!copter.in_mavlink_delay) {
+            handle_param_blob_message(msg, &copter.DataFlash);
+        }
+        break;
+
     case MAVLINK_MSG_ID_SERIAL_CONTROL:
         handle_serial_control(msg, copter.gps);
         break;
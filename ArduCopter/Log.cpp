@@ -355,6 +355,7 @@ void Copter::Log_Write_Performance()
         ins_error_count  : ins.error_count()
     };
     DataFlash.WriteBlock(&pkt, sizeof(pkt));
+    DataFlash.Log_Write_ParamStorage();
 }
 
 // Write an attitude packet
@@ -69,6 +69,7 @@ const AP_Scheduler::Task Plane::scheduler_tasks[] = {
     SCHED_TASK(check_long_failsafe,     3,   1000),
     SCHED_TASK(read_receiver_rssi,     10,   1000),
     SCHED_TASK(rpm_update,             10,    200),
+    SCHED_TASK(spectrum_update,        50,    300),
     SCHED_TASK(airspeed_ratio_update,   1,   1000),
     SCHED_TASK(update_mount,           50,   1500),
     SCHED_TASK(update_trigger,         50,   1500),
@@ -108,6 +109,7 @@ void Plane::setup()
 void Plane::loop()
 {
     // wait for an INS sample
+    uint32_t wait_start = micros();
     ins.wait_for_sample();
 
     uint32_t timer = micros();
@@ -122,6 +124,9 @@ void Plane::loop()
     if (delta_us_fast_loop < G_Dt_min || G_Dt_min == 0) {
         G_Dt_min = delta_us_fast_loop;
     }
+    if (fast_loopTimer_us != 0) {
+        scheduler.update_loop_timing(delta_us_fast_loop, timer - wait_start);
+    }
     fast_loopTimer_us   = timer;
 
     mainLoop_count++;
@@ -344,17 +349,25 @@ void Plane::one_second_loop()
 void Plane::log_perf_info()
 {
     if (scheduler.debug() != 0) {
-        gcs_send_text_fmt(MAV_SEVERITY_INFO, "G_Dt_max=%lu G_Dt_min=%lu\n",
+        const AP_TimeHistogram *period = scheduler.get_histogram(AP_Scheduler::HISTOGRAM_LOOP_PERIOD);
+        gcs_send_text_fmt(MAV_SEVERITY_INFO, "G_Dt_max=%lu G_Dt_min=%lu p99=%lu\n",
                           (unsigned long)G_Dt_max, 
-                          (unsigned long)G_Dt_min);
+                          (unsigned long)G_Dt_min,
+                          (unsigned long)(period != nullptr ? period->percentile(0.99f) : 0));
     }
 
     if (should_log(MASK_LOG_PM)) {
         Log_Write_Performance();
+        DataFlash.Log_Write_ParamStorage();
+        DataFlash.Log_Write_Storage();
+        DataFlash.Log_Write_Scheduler_Timing(scheduler);
+        DataFlash.Log_Write_Perf_Counters();
     }
 
     G_Dt_max = 0;
     G_Dt_min = 0;
+    scheduler.reset_histograms();
+    hal.util->perf_reset_all();
     resetPerfData();
 }
 
@@ -578,6 +578,71 @@ void Plane::send_rangefinder(mavlink_channel_t chan)
 #endif
 }
 
+/*
+  send the percentiles of one scheduler timing histogram, going
+  through all of them in turn
+ */
+void Plane::send_loop_timing(mavlink_channel_t chan)
+{
+    const uint8_t num_histograms = scheduler.num_histograms();
+    if (num_histograms == 0 || chan >= MAVLINK_COMM_NUM_BUFFERS) {
+        return;
+    }
+    if (loop_timing_send_index[chan] >= num_histograms) {
+        loop_timing_send_index[chan] = 0;
+    }
+    const uint8_t id = loop_timing_send_index[chan]++;
+    const AP_TimeHistogram *hist = scheduler.get_histogram(id);
+    char name[16] {};
+    strncpy(name, scheduler.histogram_name(id), sizeof(name));
+    mavlink_msg_loop_timing_send(
+        chan,
+        millis(),
+        hist->count(),
+        hist->percentile(0.5f),
+        hist->percentile(0.99f),
+        hist->percentile(0.999f),
+        hist->max_us(),
+        id,
+        name);
+}
+
+/*
+  send one of the HAL perf counters, going through the ones that have
+  been used since the last reset in turn
+ */
+void Plane::send_perf_counter(mavlink_channel_t chan)
+{
+    const uint16_t n = MIN(hal.util->perf_num_counters(), 256);
+    if (n == 0 || chan >= MAVLINK_COMM_NUM_BUFFERS) {
+        return;
+    }
+    AP_HAL::Util::perf_counter_info info;
+    for (uint16_t tries=0; tries<n; tries++) {
+        if (perf_counter_send_index[chan] >= n) {
+            perf_counter_send_index[chan] = 0;
+        }
+        const uint8_t id = perf_counter_send_index[chan]++;
+        if (!hal.util->perf_get_info(id, info) || info.count == 0) {
+            continue;
+        }
+        char name[32] {};
+        strncpy(name, info.name, sizeof(name));
+        mavlink_msg_perf_counter_send(
+            chan,
+            millis(),
+            info.count,
+            info.min_us,
+            info.max_us,
+            info.avg_us,
+            info.stddev_us,
+            id,
+            info.type,
+            name);
+        return;
+    }
+}
+
 void Plane::send_current_waypoint(mavlink_channel_t chan)
 {
     mavlink_msg_mission_current_send(chan, mission.get_current_nav_index());
@@ -808,6 +873,23 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
 #endif
         break;
 
+    case MSG_EKF_TIMING:
+#if AP_AHRS_NAVEKF_AVAILABLE
+        CHECK_PAYLOAD_SIZE(EKF_TIMING);
+        plane.ahrs.get_NavEKF2().send_timing(chan);
+#endif
+        break;
+
+    case MSG_LOOP_TIMING:
+        CHECK_PAYLOAD_SIZE(LOOP_TIMING);
+        plane.send_loop_timing(chan);
+        break;
+
+    case MSG_PERF_COUNTER:
+        CHECK_PAYLOAD_SIZE(PERF_COUNTER);
+        plane.send_perf_counter(chan);
+        break;
+
     case MSG_GIMBAL_REPORT:
 #if MOUNT == ENABLED
         CHECK_PAYLOAD_SIZE(GIMBAL_REPORT);
@@ -837,6 +919,16 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
         plane.send_rpm(chan);
         break;
 
+    case MSG_VIBRATION_PEAKS:
+        CHECK_PAYLOAD_SIZE(VIBRATION_PEAKS);
+        plane.spectrum.send_peaks(chan);
+        break;
+
+    case MSG_ADSB_THREAT:
+        CHECK_PAYLOAD_SIZE(ADSB_THREAT);
+        plane.adsb.send_threat(chan);
+        break;
+
     case MSG_MISSION_ITEM_REACHED:
         CHECK_PAYLOAD_SIZE(MISSION_ITEM_REACHED);
         mavlink_msg_mission_item_reached_send(chan, mission_item_reached_index);
@@ -986,6 +1078,10 @@ GCS_MAVLINK::data_stream_send(void)
         handle_log_send(plane.DataFlash);
     }
 
+    if (!plane.in_mavlink_delay) {
+        handle_param_blob_send();
+    }
+
     if (_queued_parameter != NULL) {
         if (streamRates[STREAM_PARAMS].get() <= 0) {
             streamRates[STREAM_PARAMS].set(10);
@@ -1061,6 +1157,8 @@ GCS_MAVLINK::data_stream_send(void)
         send_message(MSG_ATTITUDE);
         send_message(MSG_SIMSTATE);
         send_message(MSG_RPM);
+        send_message(MSG_VIBRATION_PEAKS);
+        send_message(MSG_ADSB_THREAT);
         if (plane.control_mode != MANUAL) {
             send_message(MSG_PID_TUNING);
         }
@@ -1089,6 +1187,9 @@ GCS_MAVLINK::data_stream_send(void)
         send_message(MSG_MOUNT_STATUS);
         send_message(MSG_OPTICAL_FLOW);
         send_message(MSG_EKF_STATUS_REPORT);
+        send_message(MSG_EKF_TIMING);
+        send_message(MSG_LOOP_TIMING);
+        send_message(MSG_PERF_COUNTER);
         send_message(MSG_GIMBAL_REPORT);
         send_message(MSG_VIBRATION);
     }
@@ -1151,6 +1252,16 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
         send_text(MAV_SEVERITY_INFO,message);
         // Log data
         plane.Log_Write_Strain_Data_01();
+        // Feed the spectrum analyser: external channels 0-5 are LW01-LW06, 6-11 are RW01-RW06
+        {
+            uint64_t sample_us = plane.Strain_data_01.PIC32time_msec * 1000ULL;
+            plane.spectrum.push_sample(0, plane.Strain_data_01.Str_LW01, sample_us);
+            plane.spectrum.push_sample(2, plane.Strain_data_01.Str_LW03, sample_us);
+            plane.spectrum.push_sample(4, plane.Strain_data_01.Str_LW05, sample_us);
+            plane.spectrum.push_sample(6, plane.Strain_data_01.Str_RW01, sample_us);
+            plane.spectrum.push_sample(8, plane.Strain_data_01.Str_RW03, sample_us);
+            plane.spectrum.push_sample(10, plane.Strain_data_01.Str_RW05, sample_us);
+        }
         break;
     }
 	
@@ -1170,6 +1281,16 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
         send_text(MAV_SEVERITY_INFO,message);
         // Log data
         plane.Log_Write_Strain_Data_02();
+        // Feed the spectrum analyser
+        {
+            uint64_t sample_us = plane.Strain_data_02.PIC32time_msec * 1000ULL;
+            plane.spectrum.push_sample(1, plane.Strain_data_02.Str_LW02, sample_us);
+            plane.spectrum.push_sample(3, plane.Strain_data_02.Str_LW04, sample_us);
+            plane.spectrum.push_sample(5, plane.Strain_data_02.Str_LW06, sample_us);
+            plane.spectrum.push_sample(7, plane.Strain_data_02.Str_RW02, sample_us);
+            plane.spectrum.push_sample(9, plane.Strain_data_02.Str_RW04, sample_us);
+            plane.spectrum.push_sample(11, plane.Strain_data_02.Str_RW06, sample_us);
+        }
         break;
     }
 
@@ -1925,6 +2046,14 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
         }
         break;
 
+    case MAVLINK_MSG_ID_PARAM_BLOB_REQUEST:
+    case MAVLINK_MSG_ID_PARAM_BLOB_DATA:
+    case MAVLINK_MSG_ID_PARAM_BLOB_ACK:
+        if (!plane.in_mavlink_delay) {
+            handle_param_blob_message(msg, &plane.DataFlash);
+        }
+        break;
+
     case MAVLINK_MSG_ID_SERIAL_CONTROL:
         handle_serial_control(msg, plane.gps);
         break;
@@ -574,9 +574,9 @@ static const struct LogStructure log_structure[] = {
 	  //TAT", "QBfBBBBBB",  "PuS,MuS,L6,L5,L4,L3,L2,L1,R1,R2,R3,R4,R5,R6,TL,TR"
 	// Add log_Strain_Data to log_structure
     { LOG_STRAINDATA_01_MSG, sizeof(log_StrainData1),
-	  "STN1", "QIIffffffff",  "PxmS,McmS,L5,L3,L1,R1,R3,R5,TL,TR" },
+	  "STN1", "IIffffffff",  "PxmS,McmS,L5,L3,L1,R1,R3,R5,TL,TR" },
 	{ LOG_STRAINDATA_02_MSG, sizeof(log_StrainData2),
-	  "STN2", "QIIffffff",  "PxmS,McmS,L6,L4,L2,R2,R4,R6" },
+	  "STN2", "IIffffff",  "PxmS,McmS,L6,L4,L2,R2,R4,R6" },
 #if OPTFLOW == ENABLED
     { LOG_OPTFLOW_MSG, sizeof(log_Optflow),
       "OF",   "QBffff",   "TimeUS,Qual,flowX,flowY,bodyX,bodyY" },
@@ -1291,6 +1291,10 @@ const AP_Param::Info Plane::var_info[] = {
     // @Group: RPM
     // @Path: ../libraries/AP_RPM/AP_RPM.cpp
     GOBJECT(rpm_sensor, "RPM", AP_RPM),
+
+    // @Group: SPEC_
+    // @Path: ../libraries/AP_Spectrum/AP_Spectrum.cpp
+    GOBJECT(spectrum, "SPEC_", AP_Spectrum),
     
     // @Group: RSSI_
     // @Path: ../libraries/AP_RSSI/AP_RSSI.cpp
@@ -148,6 +148,7 @@ public:
         k_param_parachute_channel,
         k_param_crash_accel_threshold,
         k_param_override_safety,
+        k_param_spectrum,       // 104
 
         // 105: Extra parameters
         k_param_fence_retalt = 105,
@@ -58,6 +58,7 @@
 #include <AP_Airspeed/AP_Airspeed.h>
 #include <AP_Terrain/AP_Terrain.h>
 #include <AP_RPM/AP_RPM.h>
+#include <AP_Spectrum/AP_Spectrum.h>
 
 #include <APM_OBC/APM_OBC.h>
 #include <APM_Control/APM_Control.h>
@@ -208,6 +209,9 @@ private:
 #endif
 
     AP_RPM rpm_sensor;
+
+    // vibration spectrum analyser for IMU and strain channels
+    AP_Spectrum spectrum {ins};
     
 // Inertial Navigation EKF
 #if AP_AHRS_NAVEKF_AVAILABLE
@@ -686,6 +690,12 @@ private:
     uint32_t G_Dt_max = 0;
     uint32_t G_Dt_min = 0;
 
+    // next scheduler timing histogram to send on each channel
+    uint8_t loop_timing_send_index[MAVLINK_COMM_NUM_BUFFERS] {};
+
+    // next HAL perf counter to send on each channel
+    uint16_t perf_counter_send_index[MAVLINK_COMM_NUM_BUFFERS] {};
+
     // System Timers
     // Time in microseconds of start of main control loop
     uint32_t fast_loopTimer_us = 0;
@@ -751,6 +761,8 @@ private:
     void send_pid_tuning(mavlink_channel_t chan);
     void send_rpm(mavlink_channel_t chan);
     void send_rangefinder(mavlink_channel_t chan);
+    void send_loop_timing(mavlink_channel_t chan);
+    void send_perf_counter(mavlink_channel_t chan);
     void send_current_waypoint(mavlink_channel_t chan);
     void send_statustext(mavlink_channel_t chan);
     bool telemetry_delayed(mavlink_channel_t chan);
@@ -899,6 +911,7 @@ private:
     void read_battery(void);
     void read_receiver_rssi(void);
     void rpm_update(void);
+    void spectrum_update(void);
     void report_radio();
     void report_ins();
     void report_compass();
@@ -39,6 +39,8 @@ static struct GeofenceState {
     int32_t guided_lng;
     /* point 0 is the return point */
     Vector2l *boundary;
+    /* index of the boundary from point 1, NULL if out of memory */
+    PolygonIndex *boundary_index;
 } *geofence_state;
 
 
@@ -112,6 +114,7 @@ void Plane::geofence_load(void)
             goto failed;
         }
         
+        geofence_state->boundary_index = new PolygonIndex();
         geofence_state->old_switch_position = 254;
     }
 
@@ -134,6 +137,10 @@ void Plane::geofence_load(void)
         goto failed;
     }
 
+    if (geofence_state->boundary_index != NULL) {
+        geofence_state->boundary_index->build(&geofence_state->boundary[1], geofence_state->num_points-1);
+    }
+
     geofence_state->boundary_uptodate = true;
     geofence_state->fence_triggered = false;
 
@@ -325,7 +332,11 @@ void Plane::geofence_check(bool altitude_check_only)
         Vector2l location;
         location.x = loc.lat;
         location.y = loc.lng;
-        outside = Polygon_outside(location, &geofence_state->boundary[1], geofence_state->num_points-1);
+        if (geofence_state->boundary_index != NULL) {
+            outside = geofence_state->boundary_index->outside(location);
+        } else {
+            outside = Polygon_outside(location, &geofence_state->boundary[1], geofence_state->num_points-1);
+        }
         if (outside) {
             breach_type = FENCE_BREACH_BOUNDARY;
         }
@@ -149,3 +149,13 @@ void Plane::rpm_update(void)
         }
     }
 }
+
+/*
+  advance the vibration spectrum analysis, logging each new result
+ */
+void Plane::spectrum_update(void)
+{
+    if (spectrum.update() && should_log(MASK_LOG_IMU)) {
+        DataFlash.Log_Write_Spectrum(spectrum, spectrum.get_last_channel());
+    }
+}
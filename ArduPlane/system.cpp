@@ -610,6 +610,9 @@ void Plane::startup_INS_ground(void)
     ins.init(scheduler.get_loop_rate_hz());
     ahrs.reset();
 
+    // the spectrum analyser reads the raw sample rings set up by ins.init()
+    spectrum.init();
+
     // read Baro pressure at ground
     //-----------------------------
     init_barometer();
@@ -0,0 +1,471 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  Monte Carlo batch driver for SITL
+
+  Runs a scenario many times with parameters drawn from distributions,
+  each run a SITL vehicle binary in lockstep with its own seed, as many
+  at once as there are cores. Each run writes its metrics when it ends,
+  and the driver gathers them into one CSV file with a row per run.
+
+  See README.md for the scenario file format.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// a parameter drawn from a distribution for each run
+struct Distribution {
+    enum Type {
+        UNIFORM,
+        NORMAL
+    };
+    std::string name;
+    Type type;
+    double a, b;    // low and high, or mean and standard deviation
+};
+
+struct Scenario {
+    std::string binary;
+    std::string model = "plane";
+    std::string home = "-35.363261,149.165230,584,353";
+    std::string defaults;
+    std::string eeprom;
+    float run_time = 600;
+    float wall_limit = 0;   // seconds of wall clock time before a run is killed, 0 for no limit
+    std::vector<Distribution> params;
+};
+
+struct Run {
+    unsigned index;
+    unsigned seed;
+    std::string dir;
+    std::vector<double> values;     // drawn values of Scenario::params
+    pid_t pid = 0;
+    int slot = -1;
+    time_t start = 0;
+    std::string status = "pending";
+    std::map<std::string, std::string> metrics;
+};
+
+static void usage(void)
+{
+    printf("Usage: MonteCarlo [options] SCENARIO\n"
+           "Options:\n"
+           "\t-n RUNS     number of runs (default 10)\n"
+           "\t-j JOBS     runs at once, at most 100 (default number of cores)\n"
+           "\t-s SEED     seed of the first run (default 1)\n"
+           "\t-d DIR      directory for the runs (default montecarlo)\n"
+           "\t-o FILE     results file (default DIR/results.csv)\n");
+}
+
+// split a line into words on spaces and tabs
+static std::vector<std::string> split(const std::string &line)
+{
+    std::vector<std::string> words;
+    std::istringstream ss(line);
+    std::string word;
+    while (ss >> word) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+static bool load_scenario(const char *path, Scenario &scenario)
+{
+    std::ifstream f(path);
+    if (!f) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+    std::string line;
+    unsigned lineno = 0;
+    while (std::getline(f, line)) {
+        lineno++;
+        const std::vector<std::string> w = split(line);
+        if (w.empty() || w[0][0] == '#') {
+            continue;
+        }
+        if (w[0] == "param" && w.size() == 5 && (w[2] == "uniform" || w[2] == "normal")) {
+            Distribution d;
+            d.name = w[1];
+            d.type = w[2] == "uniform" ? Distribution::UNIFORM : Distribution::NORMAL;
+            d.a = atof(w[3].c_str());
+            d.b = atof(w[4].c_str());
+            scenario.params.push_back(d);
+        } else if (w.size() != 2) {
+            fprintf(stderr, "%s:%u: bad line\n", path, lineno);
+            return false;
+        } else if (w[0] == "binary") {
+            scenario.binary = w[1];
+        } else if (w[0] == "model") {
+            scenario.model = w[1];
+        } else if (w[0] == "home") {
+            scenario.home = w[1];
+        } else if (w[0] == "defaults") {
+            scenario.defaults = w[1];
+        } else if (w[0] == "eeprom") {
+            scenario.eeprom = w[1];
+        } else if (w[0] == "run_time") {
+            scenario.run_time = atof(w[1].c_str());
+        } else if (w[0] == "wall_limit") {
+            scenario.wall_limit = atof(w[1].c_str());
+        } else {
+            fprintf(stderr, "%s:%u: unknown key %s\n", path, lineno, w[0].c_str());
+            return false;
+        }
+    }
+    if (scenario.binary.empty()) {
+        fprintf(stderr, "%s: no binary given\n", path);
+        return false;
+    }
+    return true;
+}
+
+// paths in the scenario are relative to the directory it is run from
+static std::string absolute(const std::string &path)
+{
+    if (path.empty() || path[0] == '/') {
+        return path;
+    }
+    char cwd[1024];
+    if (getcwd(cwd, sizeof(cwd)) == nullptr) {
+        return path;
+    }
+    return std::string(cwd) + "/" + path;
+}
+
+static bool copy_file(const std::string &from, const std::string &to, bool append=false)
+{
+    std::ifstream in(from, std::ios::binary);
+    std::ofstream out(to, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    if (!in || !out) {
+        return false;
+    }
+    out << in.rdbuf();
+    return true;
+}
+
+/*
+  set up the directory of a run: the eeprom it starts from, and a
+  defaults file with the drawn parameters after the scenario defaults,
+  so they take precedence
+ */
+static bool setup_run(const Scenario &scenario, Run &run)
+{
+    if (mkdir(run.dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create %s - %s\n", run.dir.c_str(), strerror(errno));
+        return false;
+    }
+    unlink((run.dir + "/metrics.txt").c_str());
+    if (!scenario.eeprom.empty() && !copy_file(scenario.eeprom, run.dir + "/eeprom.bin")) {
+        fprintf(stderr, "Failed to copy %s\n", scenario.eeprom.c_str());
+        return false;
+    }
+    const std::string defaults = run.dir + "/defaults.parm";
+    if (!scenario.defaults.empty()) {
+        if (!copy_file(scenario.defaults, defaults)) {
+            fprintf(stderr, "Failed to copy %s\n", scenario.defaults.c_str());
+            return false;
+        }
+    } else {
+        std::ofstream(defaults, std::ios::trunc);
+    }
+    FILE *f = fopen(defaults.c_str(), "a");
+    if (f == nullptr) {
+        return false;
+    }
+    fprintf(f, "\n");
+    for (size_t i = 0; i < scenario.params.size(); i++) {
+        fprintf(f, "%s %.7g\n", scenario.params[i].name.c_str(), run.values[i]);
+    }
+    fclose(f);
+    return true;
+}
+
+/*
+  start a run in its own directory. The slot is the SITL instance
+  number, so runs going at once don't share ports
+ */
+static bool start_run(const Scenario &scenario, Run &run, int slot)
+{
+    if (!setup_run(scenario, run)) {
+        run.status = "setup-failed";
+        return false;
+    }
+
+    char seed[16], instance[16], run_time[16];
+    snprintf(seed, sizeof(seed), "%u", run.seed);
+    snprintf(instance, sizeof(instance), "%d", slot);
+    snprintf(run_time, sizeof(run_time), "%.1f", scenario.run_time);
+    const char *argv[] = {
+        scenario.binary.c_str(),
+        "-S",
+        "--lockstep",
+        "-I", instance,
+        "--model", scenario.model.c_str(),
+        "--home", scenario.home.c_str(),
+        "--defaults", "defaults.parm",
+        "--seed", seed,
+        "--run-time", run_time,
+        "--metrics", "metrics.txt",
+        // nothing connects to a batch run
+        "--uartA", "tcp:0",
+        nullptr
+    };
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        fprintf(stderr, "fork failed - %s\n", strerror(errno));
+        run.status = "setup-failed";
+        return false;
+    }
+    if (pid == 0) {
+        if (chdir(run.dir.c_str()) != 0) {
+            _exit(1);
+        }
+        int fd = open("sitl.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd != -1) {
+            dup2(fd, 1);
+            dup2(fd, 2);
+            close(fd);
+        }
+        execv(argv[0], (char *const *)argv);
+        _exit(127);
+    }
+    run.pid = pid;
+    run.slot = slot;
+    run.start = time(nullptr);
+    run.status = "running";
+    return true;
+}
+
+// read the name=value lines written by the run
+static void read_metrics(Run &run)
+{
+    std::ifstream f(run.dir + "/metrics.txt");
+    std::string line;
+    while (std::getline(f, line)) {
+        const size_t eq = line.find('=');
+        if (eq != std::string::npos) {
+            run.metrics[line.substr(0, eq)] = line.substr(eq + 1);
+        }
+    }
+}
+
+/*
+  write a row per run. The metric columns are those of the first run
+  to finish, as every run writes the same metrics
+ */
+static bool write_results(const char *path, const Scenario &scenario, const std::vector<Run> &runs)
+{
+    std::vector<std::string> names;
+    for (const Run &run : runs) {
+        if (!run.metrics.empty()) {
+            std::ifstream f(run.dir + "/metrics.txt");
+            std::string line;
+            while (std::getline(f, line)) {
+                const size_t eq = line.find('=');
+                if (eq != std::string::npos && line.substr(0, eq) != "seed") {
+                    names.push_back(line.substr(0, eq));
+                }
+            }
+            break;
+        }
+    }
+
+    FILE *f = fopen(path, "w");
+    if (f == nullptr) {
+        fprintf(stderr, "Failed to open %s - %s\n", path, strerror(errno));
+        return false;
+    }
+    fprintf(f, "run,seed,status");
+    for (const Distribution &d : scenario.params) {
+        fprintf(f, ",%s", d.name.c_str());
+    }
+    for (const std::string &name : names) {
+        fprintf(f, ",%s", name.c_str());
+    }
+    fprintf(f, "\n");
+    for (const Run &run : runs) {
+        fprintf(f, "%u,%u,%s", run.index, run.seed, run.status.c_str());
+        for (double v : run.values) {
+            fprintf(f, ",%.7g", v);
+        }
+        for (const std::string &name : names) {
+            auto it = run.metrics.find(name);
+            fprintf(f, ",%s", it == run.metrics.end() ? "" : it->second.c_str());
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned num_runs = 10;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned first_seed = 1;
+    std::string dir = "montecarlo";
+    std::string results;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:j:s:d:o:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_runs = strtoul(optarg, nullptr, 0);
+            break;
+        case 'j':
+            jobs = strtol(optarg, nullptr, 0);
+            if (jobs < 1) {
+                fprintf(stderr, "Invalid number of jobs %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            first_seed = strtoul(optarg, nullptr, 0);
+            break;
+        case 'd':
+            dir = optarg;
+            break;
+        case 'o':
+            results = optarg;
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage();
+        return 1;
+    }
+    // leave room in the instance numbers, which offset the SITL ports by 10 each
+    if (jobs < 1) {
+        jobs = 1;
+    } else if (jobs > 100) {
+        fprintf(stderr, "Limiting to 100 jobs\n");
+        jobs = 100;
+    }
+
+    Scenario scenario;
+    if (!load_scenario(argv[optind], scenario)) {
+        return 1;
+    }
+    scenario.binary = absolute(scenario.binary);
+    scenario.defaults = absolute(scenario.defaults);
+    scenario.eeprom = absolute(scenario.eeprom);
+    if (results.empty()) {
+        results = dir + "/results.csv";
+    }
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create %s - %s\n", dir.c_str(), strerror(errno));
+        return 1;
+    }
+
+    // draw the parameters of every run up front, so a run depends only on its seed
+    std::vector<Run> runs(num_runs);
+    for (unsigned i = 0; i < num_runs; i++) {
+        Run &run = runs[i];
+        run.index = i;
+        run.seed = first_seed + i;
+        char name[32];
+        snprintf(name, sizeof(name), "/run_%04u", i);
+        run.dir = absolute(dir + name);
+        std::mt19937 gen(run.seed);
+        for (const Distribution &d : scenario.params) {
+            if (d.type == Distribution::UNIFORM) {
+                run.values.push_back(std::uniform_real_distribution<double>(d.a, d.b)(gen));
+            } else {
+                run.values.push_back(std::normal_distribution<double>(d.a, d.b)(gen));
+            }
+        }
+    }
+
+    std::vector<bool> slot_busy(jobs, false);
+    unsigned next = 0, running = 0, done = 0;
+    while (done < num_runs) {
+        // start runs while there are free slots
+        while (next < num_runs && running < (unsigned)jobs) {
+            int slot = 0;
+            while (slot_busy[slot]) {
+                slot++;
+            }
+            Run &run = runs[next++];
+            if (start_run(scenario, run, slot)) {
+                slot_busy[slot] = true;
+                running++;
+            } else {
+                done++;
+            }
+        }
+
+        int wstatus;
+        pid_t pid = waitpid(-1, &wstatus, WNOHANG);
+        if (pid <= 0) {
+            // kill runs over the wall clock limit
+            const time_t now = time(nullptr);
+            for (Run &run : runs) {
+                if (run.pid != 0 && scenario.wall_limit > 0 && now - run.start > scenario.wall_limit) {
+                    kill(run.pid, SIGKILL);
+                    run.status = "timeout";
+                }
+            }
+            usleep(10000);
+            continue;
+        }
+        for (Run &run : runs) {
+            if (run.pid != pid) {
+                continue;
+            }
+            read_metrics(run);
+            if (run.status != "timeout") {
+                if (WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0 && !run.metrics.empty()) {
+                    run.status = "ok";
+                } else {
+                    run.status = "failed";
+                }
+            }
+            run.pid = 0;
+            slot_busy[run.slot] = false;
+            running--;
+            done++;
+            printf("run %u seed %u: %s (%u/%u)\n", run.index, run.seed, run.status.c_str(), done, num_runs);
+            break;
+        }
+    }
+
+    if (!write_results(results.c_str(), scenario, runs)) {
+        return 1;
+    }
+    printf("Results in %s\n", results.c_str());
+    return 0;
+}
@@ -261,6 +261,18 @@ private:
     uint16_t downsample = 0;
     uint32_t output_counter = 0;
 
+    /*
+      EKF2 checkpoints to start from instead of the first IMU sample,
+      see --ekf2-checkpoint
+     */
+    int32_t checkpoint_time_ms = -1;
+    bool checkpoint_restored = false;
+    struct {
+        uint8_t *data;
+        uint16_t length;
+        uint32_t time_ms;
+    } checkpoints[EKF2_CHECKPOINT_MAX_CORES] {};
+
     struct {
         float max_roll_error;
         float max_pitch_error;
@@ -289,6 +301,8 @@ private:
     bool show_error(const char *text, float max_error, float tolerance);
     void report_checks();
     bool find_log_info(struct log_information &info);
+    bool find_checkpoints(void);
+    bool restore_checkpoints(void);
     const char **parse_list_from_string(const char *str);
 };
 
@@ -309,6 +323,7 @@ void Replay::usage(void)
     ::printf("\t--tolerance-vel    tolerance for velocity in meters/second\n");
     ::printf("\t--nottypes         list of msg types not to output, comma separated\n");
     ::printf("\t--downsample       downsampling rate for output\n");
+    ::printf("\t--ekf2-checkpoint time  start EKF2 from the checkpoints logged at or after time (milliseconds)\n");
 }
 
 
@@ -319,7 +334,8 @@ enum {
     OPT_TOLERANCE_POS,
     OPT_TOLERANCE_VEL,
     OPT_NOTTYPES,
-    OPT_DOWNSAMPLE
+    OPT_DOWNSAMPLE,
+    OPT_EKF2_CHECKPOINT
 };
 
 void Replay::flush_dataflash(void) {
@@ -371,6 +387,7 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"tolerance-vel",   true,   0, OPT_TOLERANCE_VEL},
         {"nottypes",        true,   0, OPT_NOTTYPES},
         {"downsample",      true,   0, OPT_DOWNSAMPLE},
+        {"ekf2-checkpoint", true,   0, OPT_EKF2_CHECKPOINT},
         {0, false, 0, 0}
     };
 
@@ -441,6 +458,10 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             downsample = atoi(gopt.optarg);
             break;
 
+        case OPT_EKF2_CHECKPOINT:
+            checkpoint_time_ms = strtol(gopt.optarg, NULL, 0);
+            break;
+
         case 'h':
         default:
             usage();
@@ -560,6 +581,162 @@ bool Replay::find_log_info(struct log_information &info)
     return true;
 }
 
+/*
+  reads the EKF2 checkpoints logged in pieces in NKC messages, see EK2_CKPT
+ */
+class CheckpointReader : public DataFlashFileReader {
+public:
+    CheckpointReader() {}
+    ~CheckpointReader();
+    bool handle_log_format_msg(const struct log_Format &f);
+    bool handle_msg(const struct log_Format &f, uint8_t *msg);
+
+    // core of the checkpoint completed by the last message, or -1
+    int8_t completed = -1;
+
+    // take the completed checkpoint of a core
+    uint8_t *take(uint8_t core, uint16_t &length);
+
+    // true if a core logs checkpoints
+    bool seen(uint8_t core) const { return parts[core].seen; }
+
+private:
+    MsgHandler *handler = NULL;
+    struct {
+        uint8_t *data;
+        uint8_t next_seq;
+        uint8_t count;
+        bool seen;
+    } parts[EKF2_CHECKPOINT_MAX_CORES] {};
+};
+
+CheckpointReader::~CheckpointReader()
+{
+    for (uint8_t i=0; i<EKF2_CHECKPOINT_MAX_CORES; i++) {
+        free(parts[i].data);
+    }
+}
+
+bool CheckpointReader::handle_log_format_msg(const struct log_Format &f) {
+    if (!strncmp(f.name,"NKC",4)) {
+        handler = new MsgHandler(f);
+    }
+    return true;
+}
+
+bool CheckpointReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
+    completed = -1;
+    if (strncmp(f.name,"NKC",4)) {
+        return true;
+    }
+
+    uint8_t core, seq, count;
+    if (!handler->field_value(msg, "C", core) ||
+        !handler->field_value(msg, "Seq", seq) ||
+        !handler->field_value(msg, "NSeq", count) ||
+        core >= EKF2_CHECKPOINT_MAX_CORES || seq >= count) {
+        return true;
+    }
+    parts[core].seen = true;
+
+    // start again on the first piece, and drop a checkpoint with a piece missing
+    if (seq == 0) {
+        free(parts[core].data);
+        parts[core].data = (uint8_t *)malloc(count * EKF2_CHECKPOINT_CHUNK);
+        parts[core].count = count;
+        parts[core].next_seq = 0;
+    }
+    if (parts[core].data == NULL || seq != parts[core].next_seq || count != parts[core].count) {
+        return true;
+    }
+    handler->field_value(msg, "Data", (char *)&parts[core].data[seq * EKF2_CHECKPOINT_CHUNK], EKF2_CHECKPOINT_CHUNK);
+    parts[core].next_seq++;
+    if (parts[core].next_seq == count) {
+        completed = core;
+    }
+    return true;
+}
+
+uint8_t *CheckpointReader::take(uint8_t core, uint16_t &length)
+{
+    uint8_t *data = parts[core].data;
+    length = parts[core].count * EKF2_CHECKPOINT_CHUNK;
+    parts[core].data = NULL;
+    return data;
+}
+
+/*
+  find the first checkpoint of each EKF2 core logged at or after
+  checkpoint_time_ms
+ */
+bool Replay::find_checkpoints(void)
+{
+    CheckpointReader reader;
+    if (!reader.open_log(filename)) {
+        perror(filename);
+        exit(1);
+    }
+    char type[5];
+    while (reader.update(type)) {
+        if (reader.completed < 0) {
+            continue;
+        }
+        const uint8_t core = reader.completed;
+        uint16_t length;
+        uint8_t *data = reader.take(core, length);
+        EKF2_CheckpointHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (checkpoints[core].data != NULL || header.time_ms < (uint32_t)checkpoint_time_ms) {
+            free(data);
+            continue;
+        }
+        checkpoints[core].data = data;
+        checkpoints[core].length = length;
+        checkpoints[core].time_ms = header.time_ms;
+        ::printf("EKF2 core %u checkpoint at %.1f seconds\n", (unsigned)core, header.time_ms*0.001f);
+
+        // the cores log their checkpoints together, so stop once every
+        // core seen so far has one
+        bool have_all = true;
+        for (uint8_t i=0; i<EKF2_CHECKPOINT_MAX_CORES; i++) {
+            if (reader.seen(i) && checkpoints[i].data == NULL) {
+                have_all = false;
+            }
+        }
+        if (have_all) {
+            return true;
+        }
+    }
+    for (uint8_t i=0; i<EKF2_CHECKPOINT_MAX_CORES; i++) {
+        if (checkpoints[i].data != NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  restore each EKF2 core on the first update after its checkpoint was
+  taken. Returns true once any core has been restored
+ */
+bool Replay::restore_checkpoints(void)
+{
+    for (uint8_t i=0; i<EKF2_CHECKPOINT_MAX_CORES; i++) {
+        if (checkpoints[i].data == NULL || AP_HAL::millis() <= checkpoints[i].time_ms) {
+            continue;
+        }
+        if (_vehicle.ahrs.restore_EKF2_checkpoint(i, checkpoints[i].data, checkpoints[i].length)) {
+            ::printf("Restored EKF2 core %u at %.1f seconds\n", (unsigned)i, AP_HAL::millis()*0.001f);
+            checkpoint_restored = true;
+        } else {
+            ::printf("Unable to restore EKF2 core %u\n", (unsigned)i);
+        }
+        free(checkpoints[i].data);
+        checkpoints[i].data = NULL;
+    }
+    return checkpoint_restored;
+}
+
 // catch floating point exceptions
 static void _replay_sig_fpe(int signum)
 {
@@ -605,6 +782,11 @@ void Replay::setup()
 
     hal.console->printf("Using an update rate of %u Hz\n", log_info.update_rate);
 
+    if (checkpoint_time_ms >= 0 && !find_checkpoints()) {
+        ::printf("No EKF2 checkpoints at or after %d ms - was EK2_CKPT set?\n", (int)checkpoint_time_ms);
+        exit(1);
+    }
+
     if (!logreader.open_log(filename)) {
         perror(filename);
         exit(1);
@@ -739,6 +921,14 @@ void Replay::read_sensors(const char *type)
     if (check_solution) {
         run_ahrs = streq(type, "CHEK");
     }
+
+    /*
+      when starting from EKF2 checkpoints there is nothing to run
+      until the first of them is restored
+     */
+    if (run_ahrs && checkpoint_time_ms >= 0 && !restore_checkpoints()) {
+        run_ahrs = false;
+    }
     
     if (run_ahrs) {
         _vehicle.ahrs.update();
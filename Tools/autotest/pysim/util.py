@@ -105,7 +105,7 @@ def pexpect_drain(p):
     except pexpect.TIMEOUT:
         pass
 
-def start_SIL(atype, valgrind=False, gdb=False, wipe=False, synthetic_clock=True, home=None, model=None, speedup=1, defaults_file=None):
+def start_SIL(atype, valgrind=False, gdb=False, wipe=False, synthetic_clock=True, home=None, model=None, speedup=1, defaults_file=None, lockstep=False, instance=0, world=None):
     '''launch a SIL instance'''
     import pexpect
     cmd=""
@@ -128,10 +128,16 @@ def start_SIL(atype, valgrind=False, gdb=False, wipe=False, synthetic_clock=True
         cmd += ' --home=%s' % home
     if model is not None:
         cmd += ' --model=%s' % model
-    if speedup != 1:
+    if lockstep:
+        cmd += ' --lockstep'
+    elif speedup != 1:
         cmd += ' --speedup=%f' % speedup
     if defaults_file is not None:
         cmd += ' --defaults=%s' % defaults_file
+    if instance != 0:
+        cmd += ' -I%u' % instance
+    if world is not None:
+        cmd += ' --world=%s' % world
     print("Running: %s" % cmd)
     ret = pexpect.spawn(cmd, logfile=sys.stdout, timeout=5)
     ret.delaybeforesend = 0
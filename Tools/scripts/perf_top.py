@@ -0,0 +1,128 @@
+#!/usr/bin/env python
+'''
+Show the perf counters of an autopilot running on Linux, live, like top
+
+The autopilot keeps its perf counters in the shared memory segment
+/dev/shm/ardupilot-perf, see libraries/AP_HAL_Linux/Perf.h. This maps
+it read only, so it does not disturb the autopilot. The counters are
+reset at the end of each performance monitoring period, so the numbers
+shown are since the last reset.
+
+Plane also logs the counters as PRF messages and streams them to the GCS as
+the PERF_COUNTER MAVLink message (id 229), for when the
+autopilot can't be logged into.
+'''
+
+import argparse
+import mmap
+import os
+import struct
+import sys
+import time
+
+MAGIC = 0x46524550
+VERSION = 1
+HEADER = struct.Struct('<IHHIHHQ')
+COUNTER = struct.Struct('<32sBBHIQQQQQdd')
+PC_COUNT = 0
+PC_ELAPSED = 1
+
+parser = argparse.ArgumentParser(description='show the perf counters of a Linux autopilot')
+parser.add_argument('--path', default='/dev/shm/ardupilot-perf', help='perf counter registry')
+parser.add_argument('--interval', type=float, default=1.0, help='seconds between updates')
+parser.add_argument('--sort', choices=['name', 'count', 'avg', 'max', 'total'], default='total',
+                    help='order of the counters')
+parser.add_argument('--once', action='store_true', help='print the counters once and exit')
+args = parser.parse_args()
+
+
+def read_counter(mm, offset):
+    '''read a consistent copy of the counter at offset, or None if it is busy'''
+    seq_offset = offset + 36
+    for _ in range(100):
+        (seq1,) = struct.unpack_from('<I', mm, seq_offset)
+        if seq1 & 1:
+            continue
+        c = COUNTER.unpack_from(mm, offset)
+        (seq2,) = struct.unpack_from('<I', mm, seq_offset)
+        if seq1 == seq2:
+            return c
+    return None
+
+
+def read_registry(mm):
+    (magic, version, num_counters, counter_size, generation, _, reset_ns) = HEADER.unpack_from(mm, 0)
+    if magic != MAGIC or version != VERSION or counter_size != COUNTER.size:
+        print("%s is not a version %u perf counter registry" % (args.path, VERSION))
+        sys.exit(1)
+    counters = []
+    for i in range(num_counters):
+        c = read_counter(mm, HEADER.size + i * COUNTER.size)
+        if c is None:
+            continue
+        (name, ctype, _, cgen, _, count, _, total, least, most, mean, m2) = c
+        if cgen != generation:
+            # not updated since the reset, so it reads as zero
+            count = total = least = most = 0
+            mean = m2 = 0.0
+        counters.append({
+            'name': name.split(b'\0')[0].decode('ascii', 'replace'),
+            'type': ctype,
+            'count': count,
+            'total': total * 1.0e-3,
+            'min': least * 1.0e-3 if count else 0,
+            'max': most * 1.0e-3,
+            'avg': mean * 1.0e-3,
+            'sd': (m2 / (count - 1)) ** 0.5 * 1.0e-3 if count > 1 else 0,
+        })
+    return (reset_ns, counters)
+
+
+def monotonic_ns():
+    '''CLOCK_MONOTONIC, the clock of the autopilot'''
+    if hasattr(time, 'clock_gettime'):
+        return int(time.clock_gettime(time.CLOCK_MONOTONIC) * 1e9)
+    with open('/proc/uptime') as f:
+        return int(float(f.read().split()[0]) * 1e9)
+
+
+def show(reset_ns, counters):
+    period = max(monotonic_ns() - reset_ns, 1) * 1.0e-9
+    if args.sort == 'name':
+        counters.sort(key=lambda c: c['name'])
+    else:
+        counters.sort(key=lambda c: c[args.sort], reverse=True)
+    lines = ['%u counters, %.1fs since reset' % (len(counters), period),
+             '%-32s %10s %9s %10s %10s %10s %10s %6s' %
+             ('name', 'count', 'rate/s', 'avg us', 'min us', 'max us', 'sd us', 'cpu%')]
+    for c in counters:
+        rate = c['count'] / period
+        if c['type'] == PC_ELAPSED:
+            lines.append('%-32s %10u %9.1f %10.1f %10.1f %10.1f %10.1f %6.2f' %
+                         (c['name'], c['count'], rate, c['avg'], c['min'], c['max'], c['sd'],
+                          100.0e-6 * c['total'] / period))
+        else:
+            lines.append('%-32s %10u %9.1f' % (c['name'], c['count'], rate))
+    if not args.once:
+        # clear the screen
+        sys.stdout.write('\x1b[H\x1b[2J')
+    sys.stdout.write('\n'.join(lines) + '\n')
+    sys.stdout.flush()
+
+
+try:
+    fd = os.open(args.path, os.O_RDONLY)
+except OSError as e:
+    print("Failed to open %s: %s" % (args.path, e))
+    sys.exit(1)
+mm = mmap.mmap(fd, 0, mmap.MAP_SHARED, mmap.PROT_READ)
+os.close(fd)
+
+try:
+    while True:
+        show(*read_registry(mm))
+        if args.once:
+            break
+        time.sleep(args.interval)
+except KeyboardInterrupt:
+    pass
@@ -0,0 +1,183 @@
+#!/usr/bin/env python
+
+'''
+create a terrain tile database for AP_Terrain from SRTM data
+
+The tile database holds complete terrain grid blocks for an operating
+area in a single file, which the vehicle memory maps. Copy the output
+to the terrain directory of the vehicle (for example
+/var/APM/terrain/tiles.dat on Linux boards, or terrain/tiles.dat for
+SITL).
+
+SRTM files are the usual 1 or 3 arc-second .hgt files, named after
+their south west corner (for example S36E149.hgt).
+'''
+
+import sys, os, math, struct, array
+
+from optparse import OptionParser
+parser = OptionParser("terrain_tiles.py [options] <SRTM_DIR>")
+parser.add_option("--lat1", type='float', default=None, help="south edge of the area in degrees")
+parser.add_option("--lat2", type='float', default=None, help="north edge of the area in degrees")
+parser.add_option("--lon1", type='float', default=None, help="west edge of the area in degrees")
+parser.add_option("--lon2", type='float', default=None, help="east edge of the area in degrees")
+parser.add_option("--spacing", type='int', default=100, help="grid spacing in meters, must match TERRAIN_SPACING")
+parser.add_option("--output", default="tiles.dat", help="output file")
+
+(opts, args) = parser.parse_args()
+
+if len(args) != 1 or None in (opts.lat1, opts.lat2, opts.lon1, opts.lon2):
+    parser.print_help()
+    sys.exit(1)
+
+srtm_dir = args[0]
+
+# these must match AP_Terrain.h
+TERRAIN_GRID_MAVLINK_SIZE = 4
+TERRAIN_GRID_BLOCK_MUL_X = 7
+TERRAIN_GRID_BLOCK_MUL_Y = 8
+TERRAIN_GRID_BLOCK_SPACING_X = (TERRAIN_GRID_BLOCK_MUL_X-1)*TERRAIN_GRID_MAVLINK_SIZE
+TERRAIN_GRID_BLOCK_SPACING_Y = (TERRAIN_GRID_BLOCK_MUL_Y-1)*TERRAIN_GRID_MAVLINK_SIZE
+TERRAIN_GRID_BLOCK_SIZE_X = TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X
+TERRAIN_GRID_BLOCK_SIZE_Y = TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y
+TERRAIN_GRID_FORMAT_VERSION = 1
+TERRAIN_TILES_MAGIC = 0x54545041
+TERRAIN_TILES_VERSION = 1
+IO_BLOCK_SIZE = 2048
+BITMAP_MASK = (1 << (TERRAIN_GRID_BLOCK_MUL_X*TERRAIN_GRID_BLOCK_MUL_Y)) - 1
+
+# these must match AP_Math/location.cpp
+LOCATION_SCALING_FACTOR = 0.011131884502145034
+LOCATION_SCALING_FACTOR_INV = 89.83204953368922
+
+def crc16_ccitt(buf, crc=0):
+    '''crc16_ccitt from AP_Math/edc.cpp'''
+    for b in bytearray(buf):
+        crc ^= b << 8
+        for i in range(8):
+            if crc & 0x8000:
+                crc = ((crc << 1) ^ 0x1021) & 0xFFFF
+            else:
+                crc = (crc << 1) & 0xFFFF
+    return crc
+
+def longitude_scale(lat):
+    return math.cos(math.radians(lat * 1.0e-7))
+
+def trunc(v):
+    '''C conversion of a float to int32'''
+    return int(math.floor(v)) if v >= 0 else int(math.ceil(v))
+
+def location_offset(lat, lon, ofs_north, ofs_east):
+    '''location_offset() from AP_Math, in degrees*1e7'''
+    dlat = trunc(ofs_north * LOCATION_SCALING_FACTOR_INV)
+    dlng = trunc((ofs_east * LOCATION_SCALING_FACTOR_INV) / longitude_scale(lat))
+    return (lat + dlat, lon + dlng)
+
+class SRTMFile(object):
+    '''one .hgt file'''
+    def __init__(self, filename, lat, lon):
+        data = open(filename, 'rb').read()
+        self.size = int(math.sqrt(len(data)/2))
+        if self.size * self.size * 2 != len(data):
+            raise ValueError("bad SRTM file %s" % filename)
+        self.heights = array.array('h')
+        if hasattr(self.heights, 'frombytes'):
+            self.heights.frombytes(data)
+        else:
+            self.heights.fromstring(data)
+        if sys.byteorder == 'little':
+            # SRTM data is big-endian
+            self.heights.byteswap()
+        self.lat = lat
+        self.lon = lon
+
+    def height(self, lat, lon):
+        '''bilinear interpolated height, or None over a void'''
+        n = self.size - 1
+        row = (self.lat + 1 - lat) * n
+        col = (lon - self.lon) * n
+        r = min(max(int(math.floor(row)), 0), n-1)
+        c = min(max(int(math.floor(col)), 0), n-1)
+        fr = row - r
+        fc = col - c
+        h00 = self.heights[r*self.size + c]
+        h01 = self.heights[r*self.size + c+1]
+        h10 = self.heights[(r+1)*self.size + c]
+        h11 = self.heights[(r+1)*self.size + c+1]
+        if -32768 in (h00, h01, h10, h11):
+            return None
+        return ((1-fr)*((1-fc)*h00 + fc*h01) +
+                fr*((1-fc)*h10 + fc*h11))
+
+srtm_cache = {}
+
+def srtm_height(lat, lon):
+    '''height at lat/lon in degrees, or None if not available'''
+    lat_deg = int(math.floor(lat))
+    lon_deg = int(math.floor(lon))
+    key = (lat_deg, lon_deg)
+    if not key in srtm_cache:
+        name = "%c%02u%c%03u.hgt" % ('S' if lat_deg < 0 else 'N', abs(lat_deg),
+                                     'W' if lon_deg < 0 else 'E', abs(lon_deg))
+        path = os.path.join(srtm_dir, name)
+        srtm_cache[key] = SRTMFile(path, lat_deg, lon_deg) if os.path.exists(path) else None
+    f = srtm_cache[key]
+    if f is None:
+        return None
+    return f.height(lat, lon)
+
+def make_block(lat_deg, lon_deg, grid_idx_x, grid_idx_y, spacing):
+    '''create one grid_block, or None if SRTM data is missing'''
+    (lat, lon) = location_offset(lat_deg*10*1000*1000, lon_deg*10*1000*1000,
+                                 grid_idx_x * TERRAIN_GRID_BLOCK_SPACING_X * float(spacing),
+                                 grid_idx_y * TERRAIN_GRID_BLOCK_SPACING_Y * float(spacing))
+    heights = []
+    for x in range(TERRAIN_GRID_BLOCK_SIZE_X):
+        for y in range(TERRAIN_GRID_BLOCK_SIZE_Y):
+            (plat, plon) = location_offset(lat, lon, x*spacing, y*spacing)
+            h = srtm_height(plat*1.0e-7, plon*1.0e-7)
+            if h is None:
+                return None
+            heights.append(int(round(h)))
+
+    def pack(crc):
+        fmt = '<QiiHHH%uhHHhb' % len(heights)
+        return struct.pack(fmt, BITMAP_MASK, lat, lon, crc, TERRAIN_GRID_FORMAT_VERSION, spacing,
+                           *(heights + [grid_idx_x, grid_idx_y, lon_deg, lat_deg]))
+    block = pack(crc16_ccitt(pack(0)))
+    return block + b'\0' * (IO_BLOCK_SIZE - len(block))
+
+def grid_range(ofs0, ofs1, block_spacing):
+    return range(int(math.floor(ofs0 / block_spacing)), int(math.floor(ofs1 / block_spacing)) + 1)
+
+blocks = []
+missing = 0
+for lat_deg in range(int(math.floor(opts.lat1)), int(math.floor(opts.lat2)) + 1):
+    for lon_deg in range(int(math.floor(opts.lon1)), int(math.floor(opts.lon2)) + 1):
+        # offsets in meters of the area within this degree, as
+        # calculate_grid_info() works them out
+        scale = longitude_scale(lat_deg*10*1000*1000)
+        north0 = (max(opts.lat1, lat_deg) - lat_deg) * 1.0e7 * LOCATION_SCALING_FACTOR
+        north1 = (min(opts.lat2, lat_deg+1) - lat_deg) * 1.0e7 * LOCATION_SCALING_FACTOR
+        east0 = (max(opts.lon1, lon_deg) - lon_deg) * 1.0e7 * LOCATION_SCALING_FACTOR * scale
+        east1 = (min(opts.lon2, lon_deg+1) - lon_deg) * 1.0e7 * LOCATION_SCALING_FACTOR * scale
+        for grid_idx_x in grid_range(north0, north1, TERRAIN_GRID_BLOCK_SPACING_X*opts.spacing):
+            for grid_idx_y in grid_range(east0, east1, TERRAIN_GRID_BLOCK_SPACING_Y*opts.spacing):
+                block = make_block(lat_deg, lon_deg, grid_idx_x, grid_idx_y, opts.spacing)
+                if block is None:
+                    missing += 1
+                    continue
+                blocks.append(((lat_deg, lon_deg, grid_idx_x, grid_idx_y), block))
+
+# the vehicle does a binary search on this order
+blocks.sort(key=lambda b: b[0])
+
+f = open(opts.output, 'wb')
+header = struct.pack('<IHHI', TERRAIN_TILES_MAGIC, TERRAIN_TILES_VERSION, opts.spacing, len(blocks))
+f.write(header + b'\0' * (IO_BLOCK_SIZE - len(header)))
+for (key, block) in blocks:
+    f.write(block)
+f.close()
+
+print("Wrote %u blocks to %s, %u blocks skipped for missing SRTM data" % (len(blocks), opts.output, missing))
@@ -42,6 +42,13 @@ const AP_Param::GroupInfo AP_ADSB::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("BEHAVIOR",   1, AP_ADSB, _behavior, ADSB_BEHAVIOR_NONE),
 
+    // @Param: LIST_MAX
+    // @DisplayName: ADSB vehicle list size
+    // @Description: Maximum number of ADS-B vehicles tracked at a time. When the list is full a new vehicle replaces the furthest one if it is closer. Takes effect when ADS-B is next enabled
+    // @Range: 1 2000
+    // @User: Advanced
+    AP_GROUPINFO("LIST_MAX",   2, AP_ADSB, _list_max, VEHICLE_LIST_LENGTH),
+
     AP_GROUPEND
 };
 
@@ -51,19 +58,38 @@ const AP_Param::GroupInfo AP_ADSB::var_info[] = {
 void AP_ADSB::init(void)
 {
     if (_vehicle_list == NULL) {
-        _vehicle_list = new adsb_vehicle_t[VEHICLE_LIST_LENGTH];
+        uint16_t size = constrain_int16(_list_max, 1, VEHICLE_LIST_LENGTH_MAX);
+
+        // the hash is kept at most half full so probe chains stay short
+        uint16_t hash_size = 2;
+        uint8_t hash_bits = 1;
+        while (hash_size < 2*size) {
+            hash_size *= 2;
+            hash_bits++;
+        }
 
-        if (_vehicle_list == NULL) {
+        _vehicle_list = new adsb_vehicle_t[size];
+        _hash = new int16_t[hash_size];
+
+        if (_vehicle_list == NULL || _hash == NULL) {
             // dynamic RAM allocation of _vehicle_list[] failed, disable gracefully
             hal.console->printf("Unable to initialize ADS-B vehicle list\n");
+            deinit();
             _enabled.set(0);
+            return;
         }
+        _vehicle_list_size = size;
+        _hash_mask = hash_size - 1;
+        _hash_shift = 32 - hash_bits;
     }
+    memset(_hash, 0xFF, (_hash_mask+1) * sizeof(_hash[0]));
     _vehicle_count = 0;
     _lowest_threat_distance = 0;
     _highest_threat_distance = 0;
     _another_vehicle_within_radius = false;
     _is_evading_threat = false;
+    _threat_count = 0;
+    _pass.cursor = 0;
 }
 
 /*
@@ -75,7 +101,13 @@ void AP_ADSB::deinit(void)
         delete [] _vehicle_list;
         _vehicle_list = NULL;
     }
+    if (_hash != NULL) {
+        delete [] _hash;
+        _hash = NULL;
+    }
+    _vehicle_list_size = 0;
     _vehicle_count = 0;
+    _threat_count = 0;
 }
 
 /*
@@ -107,66 +139,194 @@ void AP_ADSB::update(void)
     }
 
     perform_threat_detection();
-    //hal.console->printf("ADSB: cnt %u, lowT %.0f, highT %.0f\r", _vehicle_count, _lowest_threat_distance, _highest_threat_distance);
+    //hal.console->printf("ADSB: cnt %u, threats %u, lowT %.0f, highT %.0f\r", _vehicle_count, _threat_count, _lowest_threat_distance, _highest_threat_distance);
 }
 
 /*
- * calculate threat vectors
+ * calculate threat vectors. With hundreds of vehicles this takes too
+ * long for one update, so each update works through the list for up
+ * to VEHICLE_CPA_BUDGET_US and the results are published when the
+ * whole list has been done. Vehicles moved by delete_vehicle() during
+ * a pass may be missed until the next pass
  */
 void AP_ADSB::perform_threat_detection(void)
 {
-    Location my_loc;
-    if (_vehicle_count == 0 ||
-        _ahrs.get_position(my_loc) == false) {
-        // nothing to do or current location is unknown so we can't calculate any collisions
-        _another_vehicle_within_radius = false;
-        _lowest_threat_distance = 0; // 0 means invalid
-        _highest_threat_distance = 0; // 0 means invalid
-        return;
+    if (_pass.cursor == 0) {
+        Location my_loc;
+        if (_vehicle_count == 0 ||
+            _ahrs.get_position(my_loc) == false) {
+            // nothing to do or current location is unknown so we can't calculate any collisions
+            _another_vehicle_within_radius = false;
+            _lowest_threat_distance = 0; // 0 means invalid
+            _highest_threat_distance = 0; // 0 means invalid
+            _threat_count = 0;
+            return;
+        }
+
+        // all vehicles of a pass are compared against our state at its start
+        _pass.my_loc = my_loc;
+        if (!_ahrs.get_velocity_NED(_pass.my_velocity)) {
+            _pass.my_velocity.zero();
+        }
+        _pass.start_ms = AP_HAL::millis();
+        _pass.min_cpa_distance = FLT_MAX;
+        _pass.max_distance = -1;
+        _pass.threat_count = 0;
     }
 
-    // TODO: compute lowest_threat using the 3D flight vector with respect to
-    // time-to-collision and probability of collision instead of furthest 2D distance
+    const uint32_t start_us = AP_HAL::micros();
+    while (_pass.cursor < _vehicle_count) {
+        adsb_vehicle_t &vehicle = _vehicle_list[_pass.cursor++];
 
-    // TODO: compute highest_threat using the 3D flight vector with respect to
-    // time-to-collision and probability of collision instead of closest 2D distance
+        float altitude_diff;
+        calc_cpa(vehicle, altitude_diff);
 
-    float min_distance = 0;
-    float max_distance = 0;
-    uint16_t min_distance_index = 0;
-    uint16_t max_distance_index = 0;
+        if (vehicle.cpa_distance <= VEHICLE_THREAT_RADIUS_M) {
+            vehicle.threat_level = ADSB_THREAT_HIGH;
+            rank_threat(vehicle, altitude_diff);
+        } else {
+            vehicle.threat_level = ADSB_THREAT_LOW;
+        }
 
-    for (uint16_t index = 0; index < _vehicle_count; index++) {
-        float distance = get_distance(my_loc, get_location(_vehicle_list[index]));
-        if (min_distance > distance || index == 0) {
-            min_distance = distance;
-            min_distance_index = index;
+        if (vehicle.cpa_distance < _pass.min_cpa_distance) {
+            _pass.min_cpa_distance = vehicle.cpa_distance;
         }
-        if (max_distance < distance || index == 0) {
-            max_distance = distance;
-            max_distance_index = index;
+        if (vehicle.distance > _pass.max_distance) {
+            _pass.max_distance = vehicle.distance;
+            _pass.max_distance_ICAO = vehicle.info.ICAO_address;
         }
 
-        if (distance <= VEHICLE_THREAT_RADIUS_M) {
-            _vehicle_list[index].threat_level = ADSB_THREAT_HIGH;
-        } else {
-            _vehicle_list[index].threat_level = ADSB_THREAT_LOW;
+        if ((_pass.cursor & 7) == 0 &&
+            _pass.cursor < _vehicle_count &&
+            AP_HAL::micros() - start_us > VEHICLE_CPA_BUDGET_US) {
+            // carry on from here next time
+            return;
         }
-    } // for index
+    }
+    _pass.cursor = 0;
 
-    _highest_threat_index = min_distance_index;
-    _highest_threat_distance = min_distance;
+    memcpy(_threats, _pass.threats, _pass.threat_count * sizeof(_threats[0]));
+    _threat_count = _pass.threat_count;
 
-    _lowest_threat_index = max_distance_index;
-    _lowest_threat_distance = max_distance;
+    _lowest_threat_ICAO = _pass.max_distance_ICAO;
+    _lowest_threat_distance = MAX(_pass.max_distance, 0); // 0 means invalid
+    _highest_threat_distance = _pass.min_cpa_distance;
 
-    // if within radius, set flag and enforce a double radius to clear flag
-    if (is_zero(_highest_threat_distance) ||  // 0 means invalid
-            _highest_threat_distance > 2*VEHICLE_THREAT_RADIUS_M) {
-        _another_vehicle_within_radius = false;
-    } else if (_highest_threat_distance <= VEHICLE_THREAT_RADIUS_M) {
+    // if on course to come within radius, set flag and enforce a double radius to clear flag
+    if (_threat_count > 0) {
         _another_vehicle_within_radius = true;
+    } else if (_highest_threat_distance > 2*VEHICLE_THREAT_RADIUS_M) {
+        _another_vehicle_within_radius = false;
+    }
+}
+
+/*
+ * closest point of approach of a vehicle, assuming both it and us keep
+ * a constant velocity. Sets the distance, time_to_cpa and cpa_distance
+ * of the vehicle, and the current altitude difference
+ */
+void AP_ADSB::calc_cpa(adsb_vehicle_t &vehicle, float &altitude_diff) const
+{
+    const Location loc = get_location(vehicle);
+    const Vector2f ne = location_diff(_pass.my_loc, loc);
+
+    // without an altitude the vehicle could be at ours
+    float up = 0;
+    if (vehicle.info.flags & ADSB_FLAGS_VALID_ALTITUDE) {
+        up = (loc.alt - _pass.my_loc.alt) * 0.01f;
+    }
+
+    // relative position at the start of the pass, dead reckoned from the last report
+    const float dt = (int32_t)(_pass.start_ms - vehicle.last_update_ms) * 0.001f;
+    const Vector3f r = Vector3f(ne.x, ne.y, -up) + vehicle.velocity * dt;
+    const Vector3f v = vehicle.velocity - _pass.my_velocity;
+
+    float t = 0;
+    const float v_sq = v.length_squared();
+    if (v_sq > 0.01f) {
+        t = constrain_float(-(r * v) / v_sq, 0, VEHICLE_CPA_HORIZON_S);
+    }
+
+    vehicle.distance = r.length();
+    vehicle.time_to_cpa = t;
+    vehicle.cpa_distance = (r + v * t).length();
+    altitude_diff = -r.z;
+}
+
+// true if threat a needs attention before threat b
+static bool more_urgent(const AP_ADSB::adsb_threat_t &a, const AP_ADSB::adsb_threat_t &b)
+{
+    if (a.time_to_cpa != b.time_to_cpa) {
+        return a.time_to_cpa < b.time_to_cpa;
     }
+    return a.cpa_distance < b.cpa_distance;
+}
+
+/*
+ * insert a vehicle into the threats of the pass in progress, which
+ * are kept sorted with the soonest closest approach first
+ */
+void AP_ADSB::rank_threat(const adsb_vehicle_t &vehicle, float altitude_diff)
+{
+    adsb_threat_t threat;
+    threat.ICAO_address = vehicle.info.ICAO_address;
+    threat.time_to_cpa = vehicle.time_to_cpa;
+    threat.cpa_distance = vehicle.cpa_distance;
+    threat.distance = vehicle.distance;
+    threat.altitude_diff = altitude_diff;
+
+    uint8_t i = _pass.threat_count;
+    if (i == VEHICLE_THREAT_LIST_LENGTH) {
+        if (!more_urgent(threat, _pass.threats[i-1])) {
+            return;
+        }
+        // drop the least urgent
+        i--;
+    } else {
+        _pass.threat_count++;
+    }
+    while (i > 0 && more_urgent(threat, _pass.threats[i-1])) {
+        _pass.threats[i] = _pass.threats[i-1];
+        i--;
+    }
+    _pass.threats[i] = threat;
+}
+
+/*
+ * get a threat from the last complete threat detection, rank 0 being
+ * the most urgent
+ */
+bool AP_ADSB::get_threat(uint8_t rank, adsb_threat_t &threat) const
+{
+    if (!_enabled || rank >= _threat_count) {
+        return false;
+    }
+    threat = _threats[rank];
+    return true;
+}
+
+/*
+ * send one threat on a link, cycling through them in rank order
+ */
+void AP_ADSB::send_threat(mavlink_channel_t chan)
+{
+    if (chan >= MAVLINK_COMM_NUM_BUFFERS || _threat_count == 0) {
+        return;
+    }
+    if (_send_rank[chan] >= _threat_count) {
+        _send_rank[chan] = 0;
+    }
+    const uint8_t rank = _send_rank[chan]++;
+    const adsb_threat_t &t = _threats[rank];
+    mavlink_msg_adsb_threat_send(
+        chan,
+        t.ICAO_address,
+        t.time_to_cpa,
+        t.cpa_distance,
+        t.distance,
+        t.altitude_diff,
+        rank,
+        _threat_count);
 }
 
 /*
@@ -189,15 +349,14 @@ Location AP_ADSB::get_location(const adsb_vehicle_t &vehicle) const
 void AP_ADSB::delete_vehicle(uint16_t index)
 {
     if (index < _vehicle_count) {
-        // if the vehicle is the lowest/highest threat, invalidate it
-        if (index == _lowest_threat_index) {
+        // if the vehicle is the lowest threat, invalidate it
+        if (_vehicle_list[index].info.ICAO_address == _lowest_threat_ICAO) {
             _lowest_threat_distance = 0;
         }
-        if (index == _highest_threat_index) {
-            _highest_threat_distance = 0;
-        }
 
+        hash_remove(_vehicle_list[index].info.ICAO_address);
         if (index != _vehicle_count-1) {
+            _hash[hash_find(_vehicle_list[_vehicle_count-1].info.ICAO_address)] = index;
             _vehicle_list[index] = _vehicle_list[_vehicle_count-1];
         }
         // TODO: is memset needed? When we decrement the index we essentially forget about it
@@ -206,6 +365,60 @@ void AP_ADSB::delete_vehicle(uint16_t index)
     }
 }
 
+/*
+ * home slot of an ICAO_address in the hash, from the top bits of a
+ * multiplicative hash
+ */
+uint16_t AP_ADSB::hash_slot(uint32_t ICAO_address) const
+{
+    return (uint32_t)(ICAO_address * 2654435761U) >> _hash_shift;
+}
+
+/*
+ * find the hash slot holding a vehicle, or -1 if it isn't in the list
+ */
+int32_t AP_ADSB::hash_find(uint32_t ICAO_address) const
+{
+    for (uint16_t slot = hash_slot(ICAO_address); _hash[slot] != -1; slot = (slot + 1) & _hash_mask) {
+        if (_vehicle_list[_hash[slot]].info.ICAO_address == ICAO_address) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+void AP_ADSB::hash_insert(uint32_t ICAO_address, uint16_t index)
+{
+    uint16_t slot = hash_slot(ICAO_address);
+    while (_hash[slot] != -1) {
+        slot = (slot + 1) & _hash_mask;
+    }
+    _hash[slot] = index;
+}
+
+/*
+ * remove a vehicle from the hash. The vehicle must still be in
+ * _vehicle_list. Following entries of the probe chain are moved back
+ * so that lookups never stop early at the freed slot
+ */
+void AP_ADSB::hash_remove(uint32_t ICAO_address)
+{
+    int32_t found = hash_find(ICAO_address);
+    if (found < 0) {
+        return;
+    }
+    uint16_t hole = found;
+    for (uint16_t slot = (hole + 1) & _hash_mask; _hash[slot] != -1; slot = (slot + 1) & _hash_mask) {
+        uint16_t home = hash_slot(_vehicle_list[_hash[slot]].info.ICAO_address);
+        // the entry can fill the hole unless its home is between the hole and it
+        if (((slot - home) & _hash_mask) >= ((slot - hole) & _hash_mask)) {
+            _hash[hole] = _hash[slot];
+            hole = slot;
+        }
+    }
+    _hash[hole] = -1;
+}
+
 /*
  * Search _vehicle_list for the given vehicle. A match
  * depends on ICAO_address. Returns true if match found
@@ -213,13 +426,12 @@ void AP_ADSB::delete_vehicle(uint16_t index)
  */
 bool AP_ADSB::find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const
 {
-    for (uint16_t i = 0; i < _vehicle_count; i++) {
-        if (_vehicle_list[i].info.ICAO_address == vehicle.info.ICAO_address) {
-            *index = i;
-            return true;
-        }
+    int32_t slot = hash_find(vehicle.info.ICAO_address);
+    if (slot < 0) {
+        return false;
     }
-    return false;
+    *index = _hash[slot];
+    return true;
 }
 
 /*
@@ -242,37 +454,41 @@ void AP_ADSB::update_vehicle(const mavlink_message_t* packet)
         // found, update it
         set_vehicle(index, vehicle);
 
-    } else if (_vehicle_count < VEHICLE_LIST_LENGTH-1) {
+    } else if (_vehicle_count < _vehicle_list_size) {
 
         // not found and there's room, add it to the end of the list
         set_vehicle(_vehicle_count, vehicle);
+        hash_insert(vehicle.info.ICAO_address, _vehicle_count);
         _vehicle_count++;
 
     } else {
 
         // buffer is full, replace the vehicle with lowest threat as long as it's not further away
+        adsb_vehicle_t lowest_threat {};
+        lowest_threat.info.ICAO_address = _lowest_threat_ICAO;
         Location my_loc;
         if (!is_zero(_lowest_threat_distance) && // nonzero means it is valid
+            find_index(lowest_threat, &index) &&
             _ahrs.get_position(my_loc)) {       // true means my_loc is valid
 
-            float distance = get_distance(my_loc, get_location(vehicle));
+            const Location loc = get_location(vehicle);
+            const Vector2f ne = location_diff(my_loc, loc);
+            float up = 0;
+            if (vehicle.info.flags & ADSB_FLAGS_VALID_ALTITUDE) {
+                up = (loc.alt - my_loc.alt) * 0.01f;
+            }
+            float distance = pythagorous3(ne.x, ne.y, up);
             if (distance < _lowest_threat_distance) { // is closer than the furthest
 
                  // overwrite the lowest_threat/furthest
-                index = _lowest_threat_index;
+                hash_remove(_lowest_threat_ICAO);
                 set_vehicle(index, vehicle);
+                hash_insert(vehicle.info.ICAO_address, index);
 
                 // this is now invalid because the vehicle was overwritten, need
                 // to run perform_threat_detection() to determine new one because
                 // we aren't keeping track of the second-furthest vehicle.
                 _lowest_threat_distance = 0;
-
-                // is it the nearest? Then it's the highest threat. That's an easy check
-                // that we don't need to run perform_threat_detection() to determine
-                if (_highest_threat_distance > distance) {
-                    _highest_threat_distance = distance;
-                    _highest_threat_index = index;
-                }
             } // if distance
 
         } // if !zero
@@ -280,13 +496,26 @@ void AP_ADSB::update_vehicle(const mavlink_message_t* packet)
 }
 
 /*
- * Copy a vehicle's data into the list
+ * Copy a vehicle's data into the list, along with its velocity
  */
 void AP_ADSB::set_vehicle(uint16_t index, const adsb_vehicle_t &vehicle)
 {
-    if (index < VEHICLE_LIST_LENGTH) {
-        _vehicle_list[index] = vehicle;
-        _vehicle_list[index].last_update_ms = AP_HAL::millis();
+    if (index < _vehicle_list_size) {
+        adsb_vehicle_t &v = _vehicle_list[index];
+        v = vehicle;
+        v.last_update_ms = AP_HAL::millis();
+
+        v.velocity.zero();
+        if ((v.info.flags & ADSB_FLAGS_VALID_HEADING) &&
+            (v.info.flags & ADSB_FLAGS_VALID_VELOCITY)) {
+            const float heading = radians(v.info.heading * 0.01f);
+            const float speed = v.info.hor_velocity * 0.01f;
+            v.velocity.x = speed * cosf(heading);
+            v.velocity.y = speed * sinf(heading);
+        }
+        if (v.info.flags & ADSB_FLAGS_VALID_VELOCITY) {
+            // ver_velocity is positive up
+            v.velocity.z = -v.info.ver_velocity * 0.01f;
+        }
     }
 }
-
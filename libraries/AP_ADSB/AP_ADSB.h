@@ -28,8 +28,16 @@
 #include <GCS_MAVLink/GCS.h>
 
 #define VEHICLE_THREAT_RADIUS_M         1000
-#define VEHICLE_LIST_LENGTH             25      // # of ADS-B vehicles to remember at any given time
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#define VEHICLE_LIST_LENGTH             250     // default # of ADS-B vehicles to remember at any given time
+#else
+#define VEHICLE_LIST_LENGTH             25      // default # of ADS-B vehicles to remember at any given time
+#endif
+#define VEHICLE_LIST_LENGTH_MAX         2000    // limit of ADSB_LIST_MAX
 #define VEHICLE_TIMEOUT_MS              10000   // if no updates in this time, drop it from the list
+#define VEHICLE_CPA_HORIZON_S           60      // closest approaches further ahead than this are not threats
+#define VEHICLE_THREAT_LIST_LENGTH      5       // # of prioritised threats kept for the GCS and avoidance
+#define VEHICLE_CPA_BUDGET_US           200     // time allowed per update() for closest approach calculations
 
 class AP_ADSB
 {
@@ -50,6 +58,19 @@ public:
         mavlink_adsb_vehicle_t info; // the whole mavlink struct with all the juicy details. sizeof() == 38
         uint32_t last_update_ms; // last time this was refreshed, allows timeouts
         ADSB_THREAT_LEVEL threat_level;   // basic threat level
+        Vector3f velocity;      // NED velocity in m/s, zero when not reported
+        float distance;         // 3D distance in meters at the last threat detection
+        float time_to_cpa;      // seconds to the closest point of approach, 0 if it is now or past
+        float cpa_distance;     // 3D distance in meters at the closest point of approach
+    };
+
+    // a vehicle on a course to come within VEHICLE_THREAT_RADIUS_M
+    struct adsb_threat_t {
+        uint32_t ICAO_address;
+        float time_to_cpa;      // seconds
+        float cpa_distance;     // meters
+        float distance;         // meters
+        float altitude_diff;    // meters, positive when the other vehicle is above us
     };
 
 
@@ -76,6 +97,15 @@ public:
     void set_is_evading_threat(bool is_evading) { if (_enabled) { _is_evading_threat = is_evading; } }
     uint16_t get_vehicle_count() { return _vehicle_count; }
 
+    // number of threats found by the last threat detection
+    uint8_t get_threat_count() const { return _threat_count; }
+
+    // get a threat by rank, 0 being the soonest closest approach
+    bool get_threat(uint8_t rank, adsb_threat_t &threat) const;
+
+    // send the next threat on a link as ADSB_THREAT
+    void send_threat(mavlink_channel_t chan);
+
 private:
 
     // initialize _vehicle_list
@@ -87,12 +117,24 @@ private:
     // compares current vector against vehicle_list to detect threats
     void perform_threat_detection(void);
 
+    // closest point of approach of one vehicle against our own state
+    void calc_cpa(adsb_vehicle_t &vehicle, float &altitude_diff) const;
+
+    // add a vehicle to the threats of the current pass if it ranks
+    void rank_threat(const adsb_vehicle_t &vehicle, float altitude_diff);
+
     // extract a location out of a vehicle item
     Location get_location(const adsb_vehicle_t &vehicle) const;
 
     // return index of given vehicle if ICAO_ADDRESS matches. return -1 if no match
     bool find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const;
 
+    // hash of ICAO_address to vehicle index
+    uint16_t hash_slot(uint32_t ICAO_address) const;
+    int32_t hash_find(uint32_t ICAO_address) const;
+    void hash_insert(uint32_t ICAO_address, uint16_t index);
+    void hash_remove(uint32_t ICAO_address);
+
     // remove a vehicle from the list
     void delete_vehicle(uint16_t index);
 
@@ -104,17 +146,45 @@ private:
 
     AP_Int8     _enabled;
     AP_Int8     _behavior;
+    AP_Int16    _list_max;
     adsb_vehicle_t *_vehicle_list;
+    uint16_t    _vehicle_list_size = 0;
     uint16_t    _vehicle_count = 0;
+
+    // open addressed hash of vehicle indexes, -1 for an empty slot
+    int16_t     *_hash = NULL;
+    uint16_t    _hash_mask = 0;
+    uint8_t     _hash_shift = 0;
+
     bool        _another_vehicle_within_radius = false;
     bool        _is_evading_threat = false;
 
-    // index of and distance to vehicle with lowest threat
-    uint16_t    _lowest_threat_index = 0;
+    // address of and distance to vehicle with lowest threat
+    uint32_t    _lowest_threat_ICAO = 0;
     float       _lowest_threat_distance = 0;
 
-    // index of and distance to vehicle with highest threat
-    uint16_t    _highest_threat_index = 0;
+    // closest approach distance of vehicle with highest threat
     float       _highest_threat_distance = 0;
+
+    // threat detection runs over several updates. The state of the
+    // pass in progress is kept here, and published when it completes
+    struct {
+        uint16_t cursor;
+        uint32_t start_ms;
+        Location my_loc;
+        Vector3f my_velocity;
+        float min_cpa_distance;
+        float max_distance;
+        uint32_t max_distance_ICAO;
+        uint8_t threat_count;
+        adsb_threat_t threats[VEHICLE_THREAT_LIST_LENGTH];
+    } _pass;
+
+    // threats from the last complete pass, most urgent first
+    adsb_threat_t _threats[VEHICLE_THREAT_LIST_LENGTH];
+    uint8_t     _threat_count = 0;
+
+    // next threat rank to send on each link
+    uint8_t     _send_rank[MAVLINK_COMM_NUM_BUFFERS];
 };
 #endif // AP_ADSB_H
@@ -1018,6 +1018,18 @@ bool AP_AHRS_NavEKF::resetHeightDatum(void)
     return false;
 }
 
+// start an EKF2 core from a checkpoint. Once one core has been
+// restored EKF2 counts as started, so the other cores are not
+// bootstrapped and wait for their own checkpoints
+bool AP_AHRS_NavEKF::restore_EKF2_checkpoint(uint8_t instance, const uint8_t *data, uint16_t length)
+{
+    if (!EKF2.restoreCheckpoint(instance, data, length)) {
+        return false;
+    }
+    ekf2_started = true;
+    return true;
+}
+
 // send a EKF_STATUS_REPORT for current EKF
 void AP_AHRS_NavEKF::send_ekf_status_report(mavlink_channel_t chan)
 {
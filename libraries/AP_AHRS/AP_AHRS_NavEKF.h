@@ -179,6 +179,10 @@ public:
     // If using a range finder for height no reset is performed and it returns false
     bool resetHeightDatum(void);
 
+    // start an EKF2 core from a checkpoint instead of from the sensors, used by Replay
+    // Returns true if the core was restored
+    bool restore_EKF2_checkpoint(uint8_t instance, const uint8_t *data, uint16_t length);
+
     // send a EKF_STATUS_REPORT for current EKF
     void send_ekf_status_report(mavlink_channel_t chan);
     
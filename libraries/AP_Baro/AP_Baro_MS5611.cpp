@@ -95,10 +95,8 @@ void AP_Baro_MS56XX::_init()
     _last_timer = AP_HAL::micros();
     _state = 0;
 
-    _s_D1 = 0;
-    _s_D2 = 0;
-    _d1_count = 0;
-    _d2_count = 0;
+    _d1_cursor = _d1_samples.get_count();
+    _d2_cursor = _d2_samples.get_count();
 
     _dev->get_semaphore()->give();
 
@@ -227,15 +225,7 @@ void AP_Baro_MS56XX::_timer(void)
         // On state 0 we read temp
         uint32_t d2 = _read_adc();
         if (d2 != 0) {
-            _s_D2 += d2;
-            _d2_count++;
-            if (_d2_count == 32) {
-                // we have summed 32 values. This only happens
-                // when we stop reading the barometer for a long time
-                // (more than 1.2 seconds)
-                _s_D2 >>= 1;
-                _d2_count = 16;
-            }
+            _d2_samples.push(d2);
 
             if (_dev->transfer(&ADDR_CMD_CONVERT_PRESSURE, 1, nullptr, 0)) {
                 _state++;
@@ -250,17 +240,10 @@ void AP_Baro_MS56XX::_timer(void)
         if (d1 != 0) {
             // occasional zero values have been seen on the PXF
             // board. These may be SPI errors, but safest to ignore
-            _s_D1 += d1;
-            _d1_count++;
-            if (_d1_count == 128) {
-                // we have summed 128 values. This only happens
-                // when we stop reading the barometer for a long time
-                // (more than 1.2 seconds)
-                _s_D1 >>= 1;
-                _d1_count = 64;
-            }
-            // Now a new reading exists
-            _updated = true;
+            // if we stop reading the barometer for a long time the
+            // oldest readings are overwritten, so the average is
+            // always over the most recent ones
+            _d1_samples.push(d1);
 
             if (_state == 4) {
                 if (_dev->transfer(&ADDR_CMD_CONVERT_TEMPERATURE, 1, nullptr, 0)) {
@@ -290,27 +273,28 @@ void AP_Baro_MS56XX::update()
         accumulate();
     }
 
-    if (!_updated) {
+    if (!_d1_samples.pending(_d1_cursor)) {
         return;
     }
-    uint32_t sD1, sD2;
-    uint8_t d1count, d2count;
 
-    // Suspend timer procs because these variables are written to
-    // in "_update".
-    hal.scheduler->suspend_timer_procs();
-    sD1 = _s_D1; _s_D1 = 0;
-    sD2 = _s_D2; _s_D2 = 0;
-    d1count = _d1_count; _d1_count = 0;
-    d2count = _d2_count; _d2_count = 0;
-    _updated = false;
-    hal.scheduler->resume_timer_procs();
-
-    if (d1count != 0) {
-        _D1 = ((float)sD1) / d1count;
+    // the queues are lock-free, so there is no need to suspend the
+    // timer while taking the readings
+    uint32_t samples[MS56XX_D1_QUEUE_SIZE];
+    uint16_t n = _d1_samples.read(_d1_cursor, samples, MS56XX_D1_QUEUE_SIZE);
+    if (n != 0) {
+        uint32_t sD1 = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            sD1 += samples[i];
+        }
+        _D1 = ((float)sD1) / n;
     }
-    if (d2count != 0) {
-        _D2 = ((float)sD2) / d2count;
+    n = _d2_samples.read(_d2_cursor, samples, MS56XX_D2_QUEUE_SIZE);
+    if (n != 0) {
+        uint32_t sD2 = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            sD2 += samples[i];
+        }
+        _D2 = ((float)sD2) / n;
     }
     _calculate();
 }
@@ -5,6 +5,11 @@
 
 #include <AP_HAL/AP_HAL.h>
 #include <AP_HAL/Device.h>
+#include <AP_HAL/utility/SampleChannel.h>
+
+// raw conversions kept for averaging between updates
+#define MS56XX_D1_QUEUE_SIZE 32
+#define MS56XX_D2_QUEUE_SIZE 8
 
 class AP_Baro_MS56XX : public AP_Baro_Backend
 {
@@ -26,11 +31,11 @@ protected:
 
     AP_HAL::OwnPtr<AP_HAL::Device> _dev;
 
-    /* Asynchronous state: */
-    volatile bool            _updated;
-    volatile uint8_t         _d1_count;
-    volatile uint8_t         _d2_count;
-    volatile uint32_t        _s_D1, _s_D2;
+    /* Asynchronous state: raw conversions queued by the timer */
+    SampleChannel<uint32_t>  _d1_samples{MS56XX_D1_QUEUE_SIZE};
+    SampleChannel<uint32_t>  _d2_samples{MS56XX_D2_QUEUE_SIZE};
+    uint32_t                 _d1_cursor;
+    uint32_t                 _d2_cursor;
     uint8_t                  _state;
     uint32_t                 _last_timer;
     bool                     _timesliced;
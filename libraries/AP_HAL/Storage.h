@@ -8,4 +8,20 @@ public:
     virtual void init() = 0;
     virtual void read_block(void *dst, uint16_t src, size_t n) = 0;
     virtual void write_block(uint16_t dst, const void* src, size_t n) = 0;
+
+    /*
+      statistics of writes to the underlying medium, for backends
+      that buffer writes. The write amplification is
+      bytes_written/bytes_changed
+     */
+    struct Stats {
+        uint32_t bytes_changed;     // bytes changed by write_block()
+        uint32_t bytes_written;     // bytes written to the medium
+        uint32_t flushes;           // completed flushes to the medium
+        uint32_t flush_max_us;      // longest single flush step
+        uint32_t errors;            // failed flushes
+    };
+
+    // returns false if the backend doesn't keep statistics
+    virtual bool get_stats(Stats &stats) { return false; }
 };
@@ -93,6 +93,25 @@ public:
     virtual void perf_end(perf_counter_t h) {}
     virtual void perf_count(perf_counter_t h) {}
 
+    /*
+      the registry of perf counters, for exporting them in logs and
+      telemetry. Times are in microseconds and only set for PC_ELAPSED
+      counters. Counters are numbered from 0 in the order they were
+      allocated, and are never freed
+     */
+    struct perf_counter_info {
+        const char *name;
+        perf_counter_type type;
+        uint64_t count;
+        float min_us;
+        float max_us;
+        float avg_us;
+        float stddev_us;
+    };
+    virtual uint16_t perf_num_counters(void) { return 0; }
+    virtual bool perf_get_info(uint16_t i, perf_counter_info &info) { return false; }
+    virtual void perf_reset_all(void) {}
+
     // create a new semaphore
     virtual Semaphore *new_semaphore(void) { return nullptr; }
     
@@ -3,106 +3,245 @@
 #include <string.h>
 
 /*
-  implement a simple ringbuffer of bytes
+  this file is also built for the QFLIGHT DSP without any board
+  defines, so mirroring is selected by the host OS
  */
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define BYTEBUFFER_HAVE_MIRROR 1
+#else
+#define BYTEBUFFER_HAVE_MIRROR 0
+#endif
 
-ByteBuffer::ByteBuffer(uint32_t _size)
+/*
+  implement a lock-free ringbuffer of bytes
+ */
+
+#if BYTEBUFFER_HAVE_MIRROR
+/*
+  map size bytes of shared memory twice, back to back. size must be a
+  multiple of the page size. Returns nullptr on failure
+ */
+static uint8_t *map_mirrored(uint32_t size)
 {
-    size = _size;
-    buf = new uint8_t[size];
-    head = tail = 0;
+    char shm_path[] = "/dev/shm/ap_ringbuffer_XXXXXX";
+    char tmp_path[] = "/tmp/ap_ringbuffer_XXXXXX";
+    int fd = mkstemp(shm_path);
+    if (fd != -1) {
+        unlink(shm_path);
+    } else {
+        fd = mkstemp(tmp_path);
+        if (fd == -1) {
+            return nullptr;
+        }
+        unlink(tmp_path);
+    }
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    // reserve the address space for both copies, then map the file
+    // over each half of it
+    uint8_t *base = (uint8_t *)mmap(nullptr, 2*size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+    void *lower = mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void *upper = mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd);
+    if (lower != base || upper != base + size) {
+        munmap(base, 2*size);
+        return nullptr;
+    }
+    return base;
+}
+#endif
+
+ByteBuffer::ByteBuffer(uint32_t _size, bool _mirrored)
+{
+    set_size(_size, _mirrored);
 }
 
 ByteBuffer::~ByteBuffer(void)
 {
-    delete [] buf;
+    _free();
+}
+
+void ByteBuffer::_free(void)
+{
+#if BYTEBUFFER_HAVE_MIRROR
+    if (mirrored) {
+        munmap(buf, 2*size);
+    } else
+#endif
+    {
+        delete [] buf;
+    }
+    buf = nullptr;
+    size = 0;
+    mirrored = false;
+}
+
+bool ByteBuffer::set_size(uint32_t _size, bool _mirrored)
+{
+#if BYTEBUFFER_HAVE_MIRROR
+    if (_mirrored && _size != 0) {
+        uint32_t page = sysconf(_SC_PAGESIZE);
+        _size = ((_size + page - 1) / page) * page;
+    }
+#else
+    _mirrored = false;
+#endif
+
+    if (_size == size) {
+        return true;
+    }
+
+    _free();
+    head = tail = 0;
+    if (_size == 0) {
+        return true;
+    }
+
+#if BYTEBUFFER_HAVE_MIRROR
+    if (_mirrored) {
+        buf = map_mirrored(_size);
+        if (buf != nullptr) {
+            size = _size;
+            mirrored = true;
+            return true;
+        }
+    }
+#endif
+
+    buf = new uint8_t[_size];
+    if (buf == nullptr) {
+        return false;
+    }
+    size = _size;
+    return true;
 }
 
 uint32_t ByteBuffer::available(void) const
 {
-    uint32_t _tail;
-    return ((head > (_tail=tail))? (size - head) + _tail: _tail - head);
+    uint32_t _head = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    uint32_t _tail = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    return (_tail >= _head) ? _tail - _head : (size - _head) + _tail;
 }
 
 uint32_t ByteBuffer::space(void) const
 {
-    uint32_t _head;
-    return (((_head=head) > tail)?(_head - tail) - 1:((size - tail) + _head) - 1);
+    if (size == 0) {
+        return 0;
+    }
+    return (size - 1) - available();
 }
 
 bool ByteBuffer::empty(void) const
 {
-    return head == tail;
+    return __atomic_load_n(&head, __ATOMIC_ACQUIRE) == __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
 }
 
-uint32_t ByteBuffer::write(const uint8_t *data, uint32_t len)
+void ByteBuffer::clear(void)
+{
+    __atomic_store_n(&head, __atomic_load_n(&tail, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
+
+/*
+  split len bytes starting at offset start into contiguous regions
+ */
+uint8_t ByteBuffer::_regions(IoVec vec[2], uint32_t start, uint32_t len) const
 {
-    if (len > space()) {
-        len = space();
-    }
     if (len == 0) {
         return 0;
     }
-    if (tail+len <= size) {
-        // perform as single memcpy
-        memcpy(&buf[tail], data, len);
-        tail = (tail + len) % size;
-        return len;
+    vec[0].data = &buf[start];
+    if (mirrored || start + len <= size) {
+        vec[0].len = len;
+        return 1;
+    }
+    vec[0].len = size - start;
+    vec[1].data = &buf[0];
+    vec[1].len = len - vec[0].len;
+    return 2;
+}
+
+uint8_t ByteBuffer::reserve(IoVec vec[2], uint32_t len)
+{
+    uint32_t n = space();
+    if (len > n) {
+        len = n;
     }
+    return _regions(vec, __atomic_load_n(&tail, __ATOMIC_RELAXED), len);
+}
 
-    // perform as two memcpy calls
-    uint32_t n = size - tail;
-    if (n > len) {
-        n = len;
+bool ByteBuffer::commit(uint32_t n)
+{
+    if (n == 0) {
+        return true;
     }
-    memcpy(&buf[tail], data, n);
-    tail = (tail + n) % size;
-    data += n;
-    n = len - n;
-    if (n > 0) {
-        memcpy(&buf[tail], data, n);
-        tail = (tail + n) % size;
+    if (n > space()) {
+        return false;
     }
-    return len;
+    uint32_t _tail = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+    __atomic_store_n(&tail, (_tail + n) % size, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint8_t ByteBuffer::peekiovec(IoVec vec[2], uint32_t len)
+{
+    uint32_t n = available();
+    if (len > n) {
+        len = n;
+    }
+    return _regions(vec, __atomic_load_n(&head, __ATOMIC_RELAXED), len);
 }
 
 bool ByteBuffer::advance(uint32_t n)
 {
+    if (n == 0) {
+        return true;
+    }
     if (n > available()) {
         return false;
     }
-    head = (head + n) % size;
+    uint32_t _head = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    __atomic_store_n(&head, (_head + n) % size, __ATOMIC_RELEASE);
     return true;
 }
 
-uint32_t ByteBuffer::read(uint8_t *data, uint32_t len)
+uint32_t ByteBuffer::write(const uint8_t *data, uint32_t len)
 {
-    if (len > available()) {
-        len = available();
-    }
-    if (len == 0) {
-        return 0;
+    IoVec vec[2];
+    uint8_t n = reserve(vec, len);
+    len = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        memcpy(vec[i].data, data + len, vec[i].len);
+        len += vec[i].len;
     }
-    uint32_t n;
-    const uint8_t *b = readptr(n);
-    if (n > len) {
-        n = len;
+    if (len > 0) {
+        // reserve() has already checked the space
+        __atomic_store_n(&tail, (__atomic_load_n(&tail, __ATOMIC_RELAXED) + len) % size, __ATOMIC_RELEASE);
     }
+    return len;
+}
 
-    // perform first memcpy
-    memcpy(data, b, n);
-    advance(n);
-    data += n;
-
-    if (len > n) {
-        // possible second memcpy
-        uint32_t n2;
-        b = readptr(n2);
-        if (n2 > len-n) {
-            n2 = len-n;
-        }
-        memcpy(data, b, n2);
-        advance(n2);
+uint32_t ByteBuffer::read(uint8_t *data, uint32_t len)
+{
+    IoVec vec[2];
+    uint8_t n = peekiovec(vec, len);
+    len = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        memcpy(data + len, vec[i].data, vec[i].len);
+        len += vec[i].len;
+    }
+    if (len > 0) {
+        // peekiovec() has already checked the data is available
+        __atomic_store_n(&head, (__atomic_load_n(&head, __ATOMIC_RELAXED) + len) % size, __ATOMIC_RELEASE);
     }
     return len;
 }
@@ -112,14 +251,13 @@ uint32_t ByteBuffer::read(uint8_t *data, uint32_t len)
  */
 const uint8_t *ByteBuffer::readptr(uint32_t &available_bytes)
 {
-    available_bytes = available();
-    if (available_bytes == 0) {
+    IoVec vec[2];
+    if (peekiovec(vec, available()) == 0) {
+        available_bytes = 0;
         return nullptr;
     }
-    if (head+available_bytes > size) {
-        available_bytes = size - head;
-    }
-    return &buf[head];
+    available_bytes = vec[0].len;
+    return vec[0].data;
 }
 
 int16_t ByteBuffer::peek(uint32_t ofs) const
@@ -127,5 +265,5 @@ int16_t ByteBuffer::peek(uint32_t ofs) const
     if (ofs >= available()) {
         return -1;
     }
-    return buf[(head+ofs)%size];
+    return buf[(__atomic_load_n(&head, __ATOMIC_RELAXED) + ofs) % size];
 }
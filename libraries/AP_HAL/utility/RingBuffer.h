@@ -5,90 +5,171 @@
 
 
 /*
-  old style ring buffer handling macros
+  ring buffer of bytes
 
-  These macros assume a ring buffer like this:
+  This is lock-free for one producer thread and one consumer thread,
+  with the same index ownership as ObjectBuffer below: only the
+  producer writes tail and only the consumer writes head.
 
-    uint8_t *_buf;
-    uint16_t _buf_size;
-    volatile uint16_t _buf_head;
-    volatile uint16_t _buf_tail;
+  As well as copying with write() and read(), data can be produced
+  and consumed in place. reserve() returns the free space as at most
+  two contiguous regions, which the producer fills (for example with
+  ::read()) and then publishes with commit(). peekiovec() returns the
+  pending data as at most two regions, which the consumer passes
+  straight to ::write() or a parser and then releases with advance().
 
-  These should be converted to a class in future
- */
-#define BUF_AVAILABLE(buf) ((buf##_head > (_tail=buf##_tail))? (buf##_size - buf##_head) + _tail: _tail - buf##_head)
-#define BUF_SPACE(buf) (((_head=buf##_head) > buf##_tail)?(_head - buf##_tail) - 1:((buf##_size - buf##_tail) + _head) - 1)
-#define BUF_EMPTY(buf) (buf##_head == buf##_tail)
-#define BUF_ADVANCETAIL(buf, n) buf##_tail = (buf##_tail + n) % buf##_size
-#define BUF_ADVANCEHEAD(buf, n) buf##_head = (buf##_head + n) % buf##_size
-
-
-/*
-  new style buffers
+  A mirrored buffer maps its storage twice, back to back, so a region
+  of up to get_size() bytes starting anywhere in the buffer is
+  contiguous and reserve() and peekiovec() always return a single
+  region. Mirroring needs virtual memory, so it is only done on Linux
+  hosts (the Linux HAL and SITL), and rounds the size up to a whole
+  number of pages. If the mapping can't be made a plain buffer is used
+  instead.
  */
 class ByteBuffer {
 public:
-    ByteBuffer(uint32_t size);
+    // a contiguous region of the buffer
+    struct IoVec {
+        uint8_t *data;
+        uint32_t len;
+    };
+
+    ByteBuffer(uint32_t size, bool mirrored = false);
     ~ByteBuffer(void);
-    
+
+    ByteBuffer(const ByteBuffer &other) = delete;
+    ByteBuffer &operator=(const ByteBuffer&) = delete;
+
+    // number of bytes waiting to be read
     uint32_t available(void) const;
+    // number of bytes that can be written
     uint32_t space(void) const;
     bool empty(void) const;
+
+    // copy in or out as many bytes as possible, returning the count
     uint32_t write(const uint8_t *data, uint32_t len);
     uint32_t read(uint8_t *data, uint32_t len);
+
+    /*
+      change the size, discarding any data. The contents are kept if
+      the size doesn't change. The caller must make sure neither the
+      producer nor the consumer is using the buffer. Returns false if
+      the storage could not be allocated, leaving a zero size buffer
+     */
+    bool set_size(uint32_t size, bool mirrored = false);
     uint32_t get_size(void) const { return size; }
+    bool is_mirrored(void) const { return mirrored; }
+
+    // consumer: discard all pending data
+    void clear(void);
+
+    /*
+      consumer: fill vec with the regions holding the next len bytes
+      of data, or all of the data if there is less. Returns the number
+      of regions used, 0 if the buffer is empty
+     */
+    uint8_t peekiovec(IoVec vec[2], uint32_t len);
+    // consumer: release n bytes after they have been used
     bool advance(uint32_t n);
+    // consumer: contiguous data at the read position
     const uint8_t *readptr(uint32_t &available_bytes);
+    // consumer: byte at offset ofs from the read position, or -1
     int16_t peek(uint32_t ofs) const;
-    
+
+    /*
+      producer: fill vec with the regions of the next len bytes of free
+      space, or all of the free space if there is less. Returns the
+      number of regions used, 0 if the buffer is full
+     */
+    uint8_t reserve(IoVec vec[2], uint32_t len);
+    // producer: publish n bytes written to the reserved space
+    bool commit(uint32_t n);
+
 private:
+    void _free(void);
+    uint8_t _regions(IoVec vec[2], uint32_t start, uint32_t len) const;
+
     uint8_t *buf = nullptr;
     uint32_t size = 0;
+    bool mirrored = false;
 
     // head is where the next available data is. tail is where new
     // data is written
-    volatile uint32_t head = 0;
-    volatile uint32_t tail = 0;
+    uint32_t head = 0;
+    uint32_t tail = 0;
 };
 
 /*
   ring buffer class for objects of fixed size
+
+  This is lock-free for one producer thread and one consumer
+  thread. Only the producer writes tail and only the consumer writes
+  head. Each side publishes its index with release ordering after it
+  has finished with the object storage, and reads the other side's
+  index with acquire ordering, so an object is never seen before it
+  has been completely written, nor overwritten while it is being read.
  */
 template <class T>
 class ObjectBuffer {
 public:
     ObjectBuffer(uint32_t _size) {
-        size = _size;
-        buffer = new ByteBuffer((size * sizeof(T))+1);
+        // one slot is always left empty to tell full from empty
+        size = _size + 1;
+        buffer = new T[size];
     }
     ~ObjectBuffer(void) {
-        delete buffer;
+        delete [] buffer;
     }
 
     uint32_t available(void) const {
-        return buffer->available() / sizeof(T);
+        uint32_t _head = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+        uint32_t _tail = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+        return (_tail >= _head) ? _tail - _head : (size - _head) + _tail;
     }
     uint32_t space(void) const {
-        return buffer->space() / sizeof(T);
+        return (size - 1) - available();
     }
     bool empty(void) const {
-        return buffer->empty();
+        return __atomic_load_n(&head, __ATOMIC_ACQUIRE) == __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
     }
+
+    // add an object, called from the producer only. Returns false
+    // and counts an overrun if the buffer is full
     bool push(const T &object) {
-        if (buffer->space() < sizeof(T)) {
+        uint32_t _tail = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        uint32_t next = (_tail + 1) % size;
+        if (buffer == nullptr || next == __atomic_load_n(&head, __ATOMIC_ACQUIRE)) {
+            __atomic_store_n(&overrun_count, overrun_count + 1, __ATOMIC_RELAXED);
             return false;
         }
-        return buffer->write((uint8_t*)&object, sizeof(T)) == sizeof(T);
+        buffer[_tail] = object;
+        __atomic_store_n(&tail, next, __ATOMIC_RELEASE);
+        return true;
     }
+
+    // remove the oldest object, called from the consumer only
     bool pop(T &object) {
-        if (buffer->available() < sizeof(T)) {
+        uint32_t _head = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        if (buffer == nullptr || _head == __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) {
             return false;
         }
-        return buffer->read((uint8_t*)&object, sizeof(T)) == sizeof(T);
+        object = buffer[_head];
+        __atomic_store_n(&head, (_head + 1) % size, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // number of objects that have been refused because the buffer was full
+    uint32_t overruns(void) const {
+        return __atomic_load_n(&overrun_count, __ATOMIC_RELAXED);
     }
 
 private:
-    ByteBuffer *buffer = nullptr;
+    T *buffer = nullptr;
     uint32_t size = 0;
+
+    // head is the next object to read, tail is where the next object
+    // is written
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    uint32_t overrun_count = 0;
 };
-    
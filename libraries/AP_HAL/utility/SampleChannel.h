@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+  lock-free channel of timestamped sensor samples from one producer,
+  normally a driver running in the timer thread, to any number of
+  consumers.
+
+  The producer never blocks and never fails: when the ring is full the
+  oldest sample is overwritten. Each consumer keeps its own cursor,
+  which is the total number of samples it has consumed, so consumers
+  don't interfere with each other and the producer never looks at
+  them.
+
+  Reads are validated in the same way as a sequence lock. The producer
+  keeps two counts: _started is bumped before a slot is written and
+  _count once the write is complete. A consumer copies the samples
+  below _count, then reads _started, and discards any copied sample
+  whose slot the producer may have begun rewriting in between. A
+  consumer therefore never sees a torn sample, and every sample it
+  misses, whether because it fell behind or because of a concurrent
+  overwrite, is reported as dropped.
+ */
+template <class T>
+class SampleChannel {
+public:
+    SampleChannel(uint16_t size) {
+        // round up to a power of two so the slot is a simple mask
+        uint16_t n = 1;
+        while (n < size && n < 0x8000) {
+            n <<= 1;
+        }
+        _samples = new T[n];
+        if (_samples != nullptr) {
+            _mask = n - 1;
+        }
+    }
+    ~SampleChannel(void) {
+        delete [] _samples;
+    }
+
+    SampleChannel(const SampleChannel &other) = delete;
+    SampleChannel &operator=(const SampleChannel&) = delete;
+
+    // true if the sample storage could be allocated
+    bool initialised(void) const { return _samples != nullptr; }
+
+    // capacity in samples
+    uint16_t get_size(void) const { return _mask + 1; }
+
+    // total number of samples ever pushed
+    uint32_t get_count(void) const { return __atomic_load_n(&_count, __ATOMIC_ACQUIRE); }
+
+    // true if there are samples after cursor
+    bool pending(uint32_t cursor) const { return get_count() != cursor; }
+
+    // add a sample, called from the producer only
+    void push(const T &sample) {
+        uint32_t count = __atomic_load_n(&_count, __ATOMIC_RELAXED);
+        // announce the overwrite before touching the slot, so a reader
+        // that sees any part of the new sample also sees _started
+        __atomic_store_n(&_started, count + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        _samples[count & _mask] = sample;
+        __atomic_store_n(&_count, count + 1, __ATOMIC_RELEASE);
+    }
+
+    /*
+      copy up to max_samples samples following cursor, advancing
+      cursor. Returns the number of samples copied. If dropped is not
+      null it is set to the number of samples skipped because they
+      were overwritten before they could be read
+     */
+    uint16_t read(uint32_t &cursor, T *samples, uint16_t max_samples, uint32_t *dropped = nullptr) const {
+        uint32_t lost = 0;
+        uint16_t n = 0;
+
+        if (_samples != nullptr) {
+            const uint32_t size = get_size();
+            uint32_t count = get_count();
+            if (count - cursor > size) {
+                lost += count - cursor - size;
+                cursor = count - size;
+            }
+            while (cursor + n != count && n < max_samples) {
+                samples[n] = _samples[(cursor + n) & _mask];
+                n++;
+            }
+
+            // any sample size or more behind a write the producer has
+            // started may have been overwritten while we were copying it
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            uint32_t started = __atomic_load_n(&_started, __ATOMIC_RELAXED);
+            uint32_t oldest_valid = started - size;
+            if (started - cursor > size) {
+                uint32_t bad = oldest_valid - cursor;
+                if (bad > n) {
+                    bad = n;
+                }
+                memmove(&samples[0], &samples[bad], (n - bad) * sizeof(T));
+                n -= bad;
+                lost += oldest_valid - cursor;
+                cursor = oldest_valid;
+            }
+            cursor += n;
+        }
+
+        if (dropped != nullptr) {
+            *dropped = lost;
+        }
+        return n;
+    }
+
+private:
+    T *_samples = nullptr;
+    uint16_t _mask = 0;
+    // number of samples whose write has begun, and has completed
+    uint32_t _started = 0;
+    uint32_t _count = 0;
+};
@@ -0,0 +1,130 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
+#include <string.h>
+
+#define BM_BUFFER_SIZE 4096
+
+/*
+  the old BUF_* macros, kept here to compare against
+ */
+#define BUF_AVAILABLE(buf) ((buf##_head > (_tail=buf##_tail))? (buf##_size - buf##_head) + _tail: _tail - buf##_head)
+#define BUF_SPACE(buf) (((_head=buf##_head) > buf##_tail)?(_head - buf##_tail) - 1:((buf##_size - buf##_tail) + _head) - 1)
+#define BUF_ADVANCETAIL(buf, n) buf##_tail = (buf##_tail + n) % buf##_size
+#define BUF_ADVANCEHEAD(buf, n) buf##_head = (buf##_head + n) % buf##_size
+
+/*
+ * Push packets through a macro ring buffer the way the UART drivers
+ * did: copy in with up to two memcpy calls, then copy out through a
+ * bounce buffer when the data wraps
+ */
+static void BM_MacroRingBuffer(benchmark::State& state)
+{
+    uint8_t *_buf = new uint8_t[BM_BUFFER_SIZE];
+    uint16_t _buf_size = BM_BUFFER_SIZE;
+    volatile uint16_t _buf_head = 0;
+    volatile uint16_t _buf_tail = 0;
+    uint16_t _head, _tail;
+    uint8_t packet[263];
+    uint8_t out[263];
+    const uint16_t len = state.range_x();
+
+    memset(packet, 0x55, sizeof(packet));
+
+    while (state.KeepRunning()) {
+        if (BUF_SPACE(_buf) >= len) {
+            uint16_t n = _buf_size - _buf_tail;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(&_buf[_buf_tail], packet, n);
+            BUF_ADVANCETAIL(_buf, n);
+            if (len > n) {
+                memcpy(&_buf[_buf_tail], &packet[n], len - n);
+                BUF_ADVANCETAIL(_buf, len - n);
+            }
+        }
+        if (BUF_AVAILABLE(_buf) >= len) {
+            uint16_t n1 = _buf_size - _buf_head;
+            if (n1 >= len) {
+                memcpy(out, &_buf[_buf_head], len);
+            } else {
+                memcpy(out, &_buf[_buf_head], n1);
+                memcpy(&out[n1], &_buf[0], len - n1);
+            }
+            BUF_ADVANCEHEAD(_buf, len);
+        }
+        gbenchmark_escape(out);
+    }
+    delete [] _buf;
+}
+
+BENCHMARK(BM_MacroRingBuffer)->Arg(17)->Arg(263);
+
+/*
+ * Same traffic through ByteBuffer::write() and read()
+ */
+static void BM_ByteBufferCopy(benchmark::State& state)
+{
+    ByteBuffer buf(BM_BUFFER_SIZE);
+    uint8_t packet[263];
+    uint8_t out[263];
+    const uint32_t len = state.range_x();
+
+    memset(packet, 0x55, sizeof(packet));
+
+    while (state.KeepRunning()) {
+        buf.write(packet, len);
+        buf.read(out, len);
+        gbenchmark_escape(out);
+    }
+}
+
+BENCHMARK(BM_ByteBufferCopy)->Arg(17)->Arg(263);
+
+/*
+ * Produce in place with reserve() and commit() and consume in place
+ * with peekiovec() and advance(), as the UART timer tick does
+ */
+static void ByteBufferInPlace(benchmark::State& state, bool mirrored)
+{
+    ByteBuffer buf(BM_BUFFER_SIZE, mirrored);
+    ByteBuffer::IoVec vec[2];
+    uint8_t packet[263];
+    const uint32_t len = state.range_x();
+
+    memset(packet, 0x55, sizeof(packet));
+
+    while (state.KeepRunning()) {
+        uint8_t n = buf.reserve(vec, len);
+        uint32_t ofs = 0;
+        for (uint8_t i = 0; i < n; i++) {
+            memcpy(vec[i].data, &packet[ofs], vec[i].len);
+            ofs += vec[i].len;
+        }
+        buf.commit(ofs);
+
+        n = buf.peekiovec(vec, len);
+        for (uint8_t i = 0; i < n; i++) {
+            gbenchmark_escape(vec[i].data);
+        }
+        buf.advance(ofs);
+    }
+}
+
+static void BM_ByteBufferInPlace(benchmark::State& state)
+{
+    ByteBufferInPlace(state, false);
+}
+
+BENCHMARK(BM_ByteBufferInPlace)->Arg(17)->Arg(263);
+
+static void BM_ByteBufferMirrored(benchmark::State& state)
+{
+    ByteBufferInPlace(state, true);
+}
+
+BENCHMARK(BM_ByteBufferMirrored)->Arg(17)->Arg(263);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,125 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_gtest.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+
+TEST(ByteBufferTest, CopyWraps)
+{
+    ByteBuffer buf(8);
+    uint8_t data[10];
+    uint8_t out[10];
+
+    for (uint8_t i = 0; i < sizeof(data); i++) {
+        data[i] = i;
+    }
+    EXPECT_EQ(7U, buf.space());
+    EXPECT_EQ(5U, buf.write(data, 5));
+    EXPECT_EQ(3U, buf.read(out, 3));
+    // this write wraps and is truncated to the free space
+    EXPECT_EQ(5U, buf.write(&data[5], 5));
+    EXPECT_EQ(0U, buf.space());
+    EXPECT_EQ(7U, buf.available());
+    EXPECT_EQ(3, buf.peek(0));
+    EXPECT_EQ(-1, buf.peek(7));
+    EXPECT_EQ(7U, buf.read(out, sizeof(out)));
+    for (uint8_t i = 0; i < 7; i++) {
+        EXPECT_EQ(i + 3, out[i]);
+    }
+    EXPECT_TRUE(buf.empty());
+}
+
+TEST(ByteBufferTest, ReserveCommit)
+{
+    ByteBuffer buf(8);
+    ByteBuffer::IoVec vec[2];
+    uint8_t out[8];
+
+    // move the indexes to the middle of the storage
+    EXPECT_EQ(6U, buf.write((const uint8_t *)"abcdef", 6));
+    EXPECT_TRUE(buf.advance(6));
+
+    // nothing is visible to the consumer until it is committed
+    EXPECT_EQ(2, buf.reserve(vec, 5));
+    EXPECT_EQ(2U, vec[0].len);
+    EXPECT_EQ(3U, vec[1].len);
+    memcpy(vec[0].data, "12", 2);
+    memcpy(vec[1].data, "345", 3);
+    EXPECT_TRUE(buf.empty());
+    EXPECT_TRUE(buf.commit(5));
+    EXPECT_FALSE(buf.commit(5));
+    EXPECT_EQ(5U, buf.available());
+
+    EXPECT_EQ(2, buf.peekiovec(vec, 8));
+    EXPECT_EQ(0, memcmp(vec[0].data, "12", vec[0].len));
+    EXPECT_EQ(0, memcmp(vec[1].data, "345", vec[1].len));
+    EXPECT_TRUE(buf.advance(vec[0].len));
+    EXPECT_EQ(1, buf.peekiovec(vec, 8));
+    EXPECT_EQ(3U, vec[0].len);
+    EXPECT_EQ(3U, buf.read(out, sizeof(out)));
+    EXPECT_EQ(0, buf.peekiovec(vec, 8));
+}
+
+TEST(ByteBufferTest, Resize)
+{
+    ByteBuffer buf(0);
+    uint8_t c = 1;
+
+    EXPECT_EQ(0U, buf.space());
+    EXPECT_EQ(0U, buf.write(&c, 1));
+    EXPECT_TRUE(buf.set_size(16));
+    EXPECT_EQ(1U, buf.write(&c, 1));
+    // same size keeps the contents
+    EXPECT_TRUE(buf.set_size(16));
+    EXPECT_EQ(1U, buf.available());
+    EXPECT_TRUE(buf.set_size(32));
+    EXPECT_TRUE(buf.empty());
+    EXPECT_EQ(31U, buf.space());
+}
+
+#if defined(__linux__)
+TEST(ByteBufferTest, MirroredIsContiguous)
+{
+    ByteBuffer buf(100, true);
+    ByteBuffer::IoVec vec[2];
+
+    ASSERT_TRUE(buf.is_mirrored());
+    const uint32_t size = buf.get_size();
+    EXPECT_EQ(0U, size % 4096);
+
+    // place the indexes 10 bytes before the end of the storage
+    EXPECT_EQ(1, buf.reserve(vec, size - 10));
+    EXPECT_TRUE(buf.commit(size - 10));
+    EXPECT_TRUE(buf.advance(size - 10));
+
+    // a region crossing the end is still a single span
+    EXPECT_EQ(1, buf.reserve(vec, 20));
+    EXPECT_EQ(20U, vec[0].len);
+    for (uint8_t i = 0; i < 20; i++) {
+        vec[0].data[i] = i;
+    }
+    EXPECT_TRUE(buf.commit(20));
+    EXPECT_EQ(1, buf.peekiovec(vec, 20));
+    EXPECT_EQ(20U, vec[0].len);
+    for (uint8_t i = 0; i < 20; i++) {
+        EXPECT_EQ(i, vec[0].data[i]);
+    }
+    EXPECT_TRUE(buf.advance(20));
+    EXPECT_TRUE(buf.empty());
+}
+#endif
+
+AP_GTEST_MAIN()
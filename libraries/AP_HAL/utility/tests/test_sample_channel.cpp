@@ -0,0 +1,154 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_gtest.h>
+
+#include <pthread.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+#include <AP_HAL/utility/SampleChannel.h>
+
+TEST(SampleChannelTest, ReadInOrder)
+{
+    SampleChannel<uint32_t> channel(5);
+    uint32_t cursor = 0;
+    uint32_t samples[8];
+    uint32_t dropped;
+
+    EXPECT_EQ(8, channel.get_size());
+    EXPECT_FALSE(channel.pending(cursor));
+
+    for (uint32_t i = 0; i < 6; i++) {
+        channel.push(i);
+    }
+    EXPECT_TRUE(channel.pending(cursor));
+
+    EXPECT_EQ(4, channel.read(cursor, samples, 4, &dropped));
+    EXPECT_EQ(0U, dropped);
+    EXPECT_EQ(4U, cursor);
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_EQ(i, samples[i]);
+    }
+
+    EXPECT_EQ(2, channel.read(cursor, samples, 8, &dropped));
+    EXPECT_EQ(4U, samples[0]);
+    EXPECT_EQ(5U, samples[1]);
+    EXPECT_FALSE(channel.pending(cursor));
+}
+
+TEST(SampleChannelTest, OverwriteCountsDrops)
+{
+    SampleChannel<uint32_t> channel(8);
+    uint32_t cursor = 0;
+    uint32_t samples[8];
+    uint32_t dropped;
+
+    for (uint32_t i = 0; i < 20; i++) {
+        channel.push(i);
+    }
+
+    // only the newest samples survive
+    uint16_t n = channel.read(cursor, samples, 8, &dropped);
+    EXPECT_EQ(20U, cursor);
+    EXPECT_EQ(8, n);
+    EXPECT_EQ(12U, dropped);
+    EXPECT_EQ(19U, samples[n-1]);
+    EXPECT_EQ(12U, samples[0]);
+}
+
+struct checked_sample {
+    uint32_t value;
+    uint32_t check;
+};
+
+static void *push_samples(void *arg)
+{
+    SampleChannel<checked_sample> *channel = (SampleChannel<checked_sample> *)arg;
+    for (uint32_t i = 0; i < 2000000; i++) {
+        checked_sample s = { i, ~i };
+        channel->push(s);
+        // pace the producer so the consumer reads some samples
+        // rather than only counting drops
+        for (volatile uint8_t j = 0; j < 20; j++) {
+        }
+    }
+    return nullptr;
+}
+
+/*
+  a consumer racing a producer on another thread must only see whole
+  samples, in order, with every gap reported as dropped
+ */
+TEST(SampleChannelTest, ConcurrentProducer)
+{
+    SampleChannel<checked_sample> channel(8);
+    checked_sample samples[8];
+    uint32_t cursor = 0;
+    uint32_t dropped;
+    uint32_t total = 0;
+
+    pthread_t producer;
+    ASSERT_EQ(0, pthread_create(&producer, nullptr, push_samples, &channel));
+    while (cursor < 2000000) {
+        uint16_t n = channel.read(cursor, samples, 8, &dropped);
+        for (uint16_t i = 0; i < n; i++) {
+            ASSERT_EQ(~samples[i].value, samples[i].check);
+            ASSERT_EQ(cursor - n + i, samples[i].value);
+        }
+        total += n + dropped;
+    }
+    pthread_join(producer, nullptr);
+    EXPECT_EQ(2000000U, total);
+}
+
+TEST(SampleChannelTest, IndependentConsumers)
+{
+    SampleChannel<uint32_t> channel(4);
+    uint32_t cursor1 = 0, cursor2 = 0;
+    uint32_t samples[4];
+
+    channel.push(1);
+    channel.push(2);
+    EXPECT_EQ(2, channel.read(cursor1, samples, 4));
+    EXPECT_EQ(2, channel.read(cursor2, samples, 4));
+    EXPECT_EQ(1U, samples[0]);
+}
+
+TEST(ObjectBufferTest, PushPop)
+{
+    ObjectBuffer<uint16_t> buf(3);
+    uint16_t v;
+
+    EXPECT_TRUE(buf.empty());
+    EXPECT_EQ(3U, buf.space());
+    EXPECT_TRUE(buf.push(1));
+    EXPECT_TRUE(buf.push(2));
+    EXPECT_TRUE(buf.push(3));
+    EXPECT_FALSE(buf.push(4));
+    EXPECT_EQ(1U, buf.overruns());
+    EXPECT_EQ(3U, buf.available());
+
+    EXPECT_TRUE(buf.pop(v));
+    EXPECT_EQ(1, v);
+    EXPECT_TRUE(buf.push(5));
+    EXPECT_TRUE(buf.pop(v));
+    EXPECT_TRUE(buf.pop(v));
+    EXPECT_TRUE(buf.pop(v));
+    EXPECT_EQ(5, v);
+    EXPECT_FALSE(buf.pop(v));
+    EXPECT_TRUE(buf.empty());
+}
+
+AP_GTEST_MAIN()
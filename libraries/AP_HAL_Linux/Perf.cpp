@@ -20,130 +20,184 @@
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX && !defined(PERF_LTTNG)
 
-#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <AP_Math/AP_Math.h>
 
 #include "AP_HAL_Linux.h"
+#include "Perf.h"
 #include "Util.h"
 
 using namespace Linux;
 
-struct perf_counter_base_t {
-    const char *name;
-    enum Util::perf_counter_type type;
-};
-
-struct perf_counter_count_t {
-    struct perf_counter_base_t base;
-    uint64_t count;
-};
-
-struct perf_counter_elapsed_t {
-    struct perf_counter_base_t base;
-    uint64_t count;
-    /* Everything below is in nanoseconds */
-    uint64_t start;
-    uint64_t total;
-    uint64_t least;
-    uint64_t most;
-    double mean;
-    double m2;
-};
-
 static const AP_HAL::HAL& hal = AP_HAL::get_HAL();
 
-Util::perf_counter_t Util::perf_alloc(perf_counter_type type, const char *name)
-{
-    struct perf_counter_base_t *base;
-
-    switch(type) {
-    case PC_COUNT: {
-        struct perf_counter_count_t *count;
-        count = (struct perf_counter_count_t *)calloc(1, sizeof(struct perf_counter_count_t));
-        if (!count) {
-            return nullptr;
-        }
+/*
+  the registry lives in shared memory when that is available, and
+  otherwise in this process only, so the counters can still be logged
+ */
+static perf_registry local_registry;
+static perf_registry *registry;
+static pthread_mutex_t registry_mtx = PTHREAD_MUTEX_INITIALIZER;
 
-        base = &count->base;
-        break;
+static perf_registry *registry_create(void)
+{
+    int fd = shm_open(LINUX_PERF_SHM_NAME, O_RDWR | O_CREAT, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "perf: shm_open %s failed - %s\n", LINUX_PERF_SHM_NAME, strerror(errno));
+        return &local_registry;
     }
-    case PC_ELAPSED: {
-        struct perf_counter_elapsed_t *elapsed;
-        elapsed = (struct perf_counter_elapsed_t *)calloc(1, sizeof(struct perf_counter_elapsed_t));
-        if (!elapsed) {
-            return nullptr;
-        }
+    if (ftruncate(fd, sizeof(perf_registry)) == -1) {
+        fprintf(stderr, "perf: ftruncate %s failed - %s\n", LINUX_PERF_SHM_NAME, strerror(errno));
+        close(fd);
+        return &local_registry;
+    }
+    void *p = mmap(nullptr, sizeof(perf_registry), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "perf: mmap %s failed - %s\n", LINUX_PERF_SHM_NAME, strerror(errno));
+        return &local_registry;
+    }
+
+    // counters left over from a previous run are no use to anyone
+    perf_registry *r = (perf_registry *)p;
+    memset(r, 0, sizeof(*r));
+    return r;
+}
+
+static inline uint64_t timespec_to_nsec(const struct timespec *ts)
+{
+    return ts->tv_nsec + (ts->tv_sec * NSEC_PER_SEC);
+}
+
+static uint64_t now_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return timespec_to_nsec(&ts);
+}
 
-        elapsed->least = ULONG_MAX;
+static void clear_stats(perf_registry_counter *c)
+{
+    c->count = 0;
+    c->total = 0;
+    c->least = UINT64_MAX;
+    c->most = 0;
+    c->mean = 0;
+    c->m2 = 0;
+}
 
-        base = &elapsed->base;
-        break;
+/*
+  start and finish an update of a counter by its own thread, first
+  clearing it if the registry has been reset since its last update
+ */
+static void update_begin(perf_registry_counter *c)
+{
+    c->seq++;
+    __sync_synchronize();
+    const uint16_t generation = registry->generation;
+    if (c->generation != generation) {
+        clear_stats(c);
+        c->generation = generation;
     }
-    default:
-    case PC_INTERVAL: {
+}
+
+static void update_end(perf_registry_counter *c)
+{
+    __sync_synchronize();
+    c->seq++;
+}
+
+Util::perf_counter_t Util::perf_alloc(perf_counter_type type, const char *name)
+{
+    if (type != PC_COUNT && type != PC_ELAPSED) {
         /*
-         * Not implemented now because it is not used even on PX4 specific
-         * code and by looking at PX4 implementation without perf_reset()
-         * the average is broken.
+         * PC_INTERVAL is not implemented now because it is not used even on
+         * PX4 specific code and by looking at PX4 implementation without
+         * perf_reset() the average is broken.
          */
         return nullptr;
     }
+
+    pthread_mutex_lock(&registry_mtx);
+    if (registry == nullptr) {
+        perf_registry *r = registry_create();
+        r->version = LINUX_PERF_VERSION;
+        r->counter_size = sizeof(perf_registry_counter);
+        r->reset_ns = now_nsec();
+        __sync_synchronize();
+        r->magic = LINUX_PERF_MAGIC;
+        registry = r;
     }
 
-    base->name = name;
-    base->type = type;
-    return (perf_counter_t)base;
-}
+    const uint16_t i = registry->num_counters;
+    if (i >= LINUX_PERF_MAX_COUNTERS) {
+        pthread_mutex_unlock(&registry_mtx);
+        hal.console->printf("perf_alloc(): no room for %s\n", name);
+        return nullptr;
+    }
 
-static inline uint64_t timespec_to_nsec(const struct timespec *ts)
-{
-    return ts->tv_nsec + (ts->tv_sec * NSEC_PER_SEC);
+    perf_registry_counter *c = &registry->counters[i];
+    strncpy(c->name, name, sizeof(c->name) - 1);
+    c->type = type;
+    c->generation = registry->generation;
+    clear_stats(c);
+    __sync_synchronize();
+    // readers only look at counters below num_counters
+    registry->num_counters = i + 1;
+    pthread_mutex_unlock(&registry_mtx);
+
+    return (perf_counter_t)c;
 }
 
 void Util::perf_begin(perf_counter_t perf)
 {
-    struct perf_counter_elapsed_t *perf_elapsed = (struct perf_counter_elapsed_t *)perf;
+    perf_registry_counter *perf_elapsed = (perf_registry_counter *)perf;
 
     if (perf_elapsed == NULL) {
         return;
     }
-    if (perf_elapsed->base.type != PC_ELAPSED) {
+    if (perf_elapsed->type != PC_ELAPSED) {
         hal.console->printf("perf_begin() called over a perf_counter_t(%s) that"
                             " is not of the PC_ELAPSED type.\n",
-                            perf_elapsed->base.name);
+                            perf_elapsed->name);
         return;
     }
 
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    perf_elapsed->start = timespec_to_nsec(&ts);
+    perf_elapsed->start = now_nsec();
 }
 
 void Util::perf_end(perf_counter_t perf)
 {
-    struct perf_counter_elapsed_t *perf_elapsed = (struct perf_counter_elapsed_t *)perf;
+    perf_registry_counter *perf_elapsed = (perf_registry_counter *)perf;
 
     if (perf_elapsed == NULL) {
         return;
     }
 
-    if (perf_elapsed->base.type != PC_ELAPSED) {
+    if (perf_elapsed->type != PC_ELAPSED) {
         hal.console->printf("perf_end() called over a perf_counter_t(%s) "
                             "that is not of the PC_ELAPSED type.\n",
-                            perf_elapsed->base.name);
+                            perf_elapsed->name);
         return;
     }
     if (perf_elapsed->start == 0) {
         hal.console->printf("perf_end() called before an perf_begin() on %s.\n",
-                            perf_elapsed->base.name);
+                            perf_elapsed->name);
         return;
     }
 
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    const uint64_t elapsed = timespec_to_nsec(&ts) - perf_elapsed->start;
+    const uint64_t elapsed = now_nsec() - perf_elapsed->start;
+
+    update_begin(perf_elapsed);
 
     perf_elapsed->count++;
     perf_elapsed->total += elapsed;
@@ -165,25 +219,98 @@ void Util::perf_end(perf_counter_t perf)
     perf_elapsed->mean += (delta_intvl / perf_elapsed->count);
     perf_elapsed->m2 += (delta_intvl * (elapsed - perf_elapsed->mean));
 
+    update_end(perf_elapsed);
+
     perf_elapsed->start = 0;
 }
 
 void Util::perf_count(perf_counter_t perf)
 {
-    struct perf_counter_count_t *perf_counter = (struct perf_counter_count_t *)perf;
+    perf_registry_counter *perf_counter = (perf_registry_counter *)perf;
 
     if (perf_counter == NULL) {
         return;
     }
 
-    if (perf_counter->base.type != PC_COUNT) {
+    if (perf_counter->type != PC_COUNT) {
         hal.console->printf("perf_count() called over a perf_counter_t(%s) "
                             "that is not of the PC_COUNT type.\n",
-                            perf_counter->base.name);
+                            perf_counter->name);
         return;
     }
 
+    update_begin(perf_counter);
     perf_counter->count++;
+    update_end(perf_counter);
+}
+
+uint16_t Util::perf_num_counters(void)
+{
+    if (registry == nullptr) {
+        return 0;
+    }
+    return registry->num_counters;
+}
+
+/*
+  get a consistent copy of counter i. This may be called from any
+  thread, and gives up rather than wait if the counter is busy
+ */
+bool Util::perf_get_info(uint16_t i, perf_counter_info &info)
+{
+    if (registry == nullptr || i >= registry->num_counters) {
+        return false;
+    }
+    const perf_registry_counter *c = &registry->counters[i];
+    perf_registry_counter copy;
+    bool ok = false;
+    for (uint8_t tries=0; tries<10 && !ok; tries++) {
+        const uint32_t seq = c->seq;
+        __sync_synchronize();
+        if (seq & 1) {
+            continue;
+        }
+        memcpy(&copy, (const void *)c, sizeof(copy));
+        __sync_synchronize();
+        ok = (c->seq == seq);
+    }
+    if (!ok) {
+        return false;
+    }
+    if (copy.generation != registry->generation) {
+        clear_stats(&copy);
+    }
+
+    info.name = c->name;
+    info.type = (perf_counter_type)copy.type;
+    info.count = copy.count;
+    info.min_us = 0;
+    info.max_us = 0;
+    info.avg_us = 0;
+    info.stddev_us = 0;
+    if (copy.type == PC_ELAPSED && copy.count > 0) {
+        info.min_us = copy.least * 1.0e-3f;
+        info.max_us = copy.most * 1.0e-3f;
+        info.avg_us = copy.mean * 1.0e-3f;
+        if (copy.count > 1) {
+            info.stddev_us = sqrt(copy.m2 / (copy.count - 1)) * 1.0e-3f;
+        }
+    }
+    return true;
+}
+
+/*
+  start all counters again from zero. Each counter is cleared by its
+  own thread on its next update
+ */
+void Util::perf_reset_all(void)
+{
+    if (registry == nullptr) {
+        return;
+    }
+    registry->reset_ns = now_nsec();
+    __sync_synchronize();
+    registry->generation++;
 }
 
 #endif
@@ -0,0 +1,72 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <AP_Common/AP_Common.h>
+
+/*
+  Layout of the perf counter registry. The registry is a POSIX shared
+  memory segment, so tools such as Tools/scripts/perf_top.py can map it
+  read only and watch the counters live without any cost to the
+  autopilot. Change LINUX_PERF_VERSION when the layout changes.
+
+  Each counter has a sequence number that is odd while it is being
+  updated. A reader copies a counter and tries again if the sequence
+  number was odd or changed while it copied.
+
+  Counters are reset by bumping the generation of the registry. A
+  counter from an older generation reads as zero, and is cleared by the
+  thread that owns it on its next update, so each counter only ever has
+  one writer.
+ */
+#define LINUX_PERF_SHM_NAME     "/ardupilot-perf"
+#define LINUX_PERF_MAGIC        0x46524550 // PERF
+#define LINUX_PERF_VERSION      1
+#define LINUX_PERF_MAX_COUNTERS 128
+#define LINUX_PERF_NAME_LEN     32
+
+namespace Linux {
+
+struct PACKED perf_registry_counter {
+    char name[LINUX_PERF_NAME_LEN];
+    uint8_t type;                   // AP_HAL::Util::perf_counter_type
+    uint8_t pad;
+    volatile uint16_t generation;
+    volatile uint32_t seq;
+    uint64_t count;
+    // everything below is in nanoseconds, and only used by PC_ELAPSED
+    uint64_t start;
+    uint64_t total;
+    uint64_t least;
+    uint64_t most;
+    double mean;
+    double m2;                      // sum of squared differences from the mean
+};
+
+struct PACKED perf_registry {
+    uint32_t magic;
+    uint16_t version;
+    volatile uint16_t num_counters;
+    uint32_t counter_size;
+    volatile uint16_t generation;
+    uint16_t pad;
+    volatile uint64_t reset_ns;     // CLOCK_MONOTONIC time of the last reset
+    perf_registry_counter counters[LINUX_PERF_MAX_COUNTERS];
+};
+
+}
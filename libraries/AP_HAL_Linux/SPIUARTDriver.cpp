@@ -31,8 +31,6 @@ SPIUARTDriver::SPIUARTDriver() :
     _buffer(NULL),
     _external(false)
 {
-    _readbuf = NULL;
-    _writebuf = NULL;
 }
 
 bool SPIUARTDriver::sem_take_nonblocking()
@@ -63,30 +61,10 @@ void SPIUARTDriver::begin(uint32_t b, uint16_t rxS, uint16_t txS)
    }
 
    /*
-     allocate the read buffer
+     allocate the read and write buffers
    */
-   if (rxS != 0 && rxS != _readbuf_size) {
-       _readbuf_size = rxS;
-       if (_readbuf != NULL) {
-           free(_readbuf);
-       }
-       _readbuf = (uint8_t *)malloc(_readbuf_size);
-       _readbuf_head = 0;
-       _readbuf_tail = 0;
-   }
-
-   /*
-     allocate the write buffer
-   */
-   if (txS != 0 && txS != _writebuf_size) {
-       _writebuf_size = txS;
-       if (_writebuf != NULL) {
-           free(_writebuf);
-       }
-       _writebuf = (uint8_t *)malloc(_writebuf_size);
-       _writebuf_head = 0;
-       _writebuf_tail = 0;
-   }
+   _readbuf.set_size(rxS);
+   _writebuf.set_size(txS);
 
    if (_buffer == NULL) {
        /* Do not allocate new buffer, if we're just changing speed */
@@ -143,7 +121,7 @@ int SPIUARTDriver::_write_fd(const uint8_t *buf, uint16_t size)
 
     sem_give();
 
-    BUF_ADVANCEHEAD(_writebuf, size);
+    _writebuf.advance(size);
 
     uint16_t ret = size;
 
@@ -153,44 +131,9 @@ int SPIUARTDriver::_write_fd(const uint8_t *buf, uint16_t size)
      * UARTDriver::write().  
      */
 
-    uint8_t *buffer = _buffer;
-
-    uint16_t _head, space;
-    space = BUF_SPACE(_readbuf);
-
-    if (space == 0) {
-        return ret;
-    }
-
-    if (size > space) {
-        size = space;
-    }
-
-    if (_readbuf_tail < _head) {
-        // perform as single memcpy
-        assert(_readbuf_tail+size <= _readbuf_size);
-        memcpy(&_readbuf[_readbuf_tail], buffer, size);
-        BUF_ADVANCETAIL(_readbuf, size);
-        return ret;
-    }
-
-    // perform as two memcpy calls
-    uint16_t n = _readbuf_size - _readbuf_tail;
-    if (n > size) n = size;
-    assert(_readbuf_tail+n <= _readbuf_size);
-    memcpy(&_readbuf[_readbuf_tail], buffer, n);
-    BUF_ADVANCETAIL(_readbuf, n);
-    buffer += n;
-    n = size - n;
-    if (n > 0) {
-        assert(_readbuf_tail+n <= _readbuf_size);
-        memcpy(&_readbuf[_readbuf_tail], buffer, n);
-        BUF_ADVANCETAIL(_readbuf, n);
-    }
-
+    _readbuf.write(_buffer, size);
 
     return ret;
-    
 }
 
 static const uint8_t ff_stub[300] = {0xff};
@@ -218,7 +161,7 @@ int SPIUARTDriver::_read_fd(uint8_t *buf, uint16_t n)
 
     sem_give();
 
-    BUF_ADVANCETAIL(_readbuf, n);
+    _readbuf.commit(n);
 
     return n;
 }
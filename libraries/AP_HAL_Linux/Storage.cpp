@@ -16,6 +16,12 @@ using namespace Linux;
 /*
   This stores 'eeprom' data on the SD card, with a 4k size, and a
   in-memory buffer. This keeps the latency down.
+
+  Changes are coalesced in the buffer and written out as a whole new
+  file which is then renamed over the old one, so a power loss can't
+  leave a partly written line behind, and a burst of small changes
+  such as a mission upload costs one write of the file rather than
+  one per change.
  */
 
 // name the storage file after the sketch so you can use the same board
@@ -26,6 +32,10 @@ using namespace Linux;
 #define STORAGE_DIR "/var/APM"
 #endif
 #define STORAGE_FILE STORAGE_DIR "/" SKETCHNAME ".stg"
+#define STORAGE_TMP_FILE STORAGE_FILE ".new"
+
+// bytes of the snapshot written per call of _timer_tick()
+#define STORAGE_FLUSH_STEP 4096
 
 extern const AP_HAL::HAL& hal;
 
@@ -55,6 +65,11 @@ void Storage::_storage_open(void)
     }
 
     _dirty_mask = 0;
+
+    // a flush interrupted by a power loss leaves its temporary file
+    // behind, the storage file itself is still intact
+    unlink(STORAGE_TMP_FILE);
+
     int fd = open(STORAGE_FILE, O_RDWR);
     if (fd == -1) {
         _storage_create();
@@ -99,7 +114,13 @@ void Storage::_storage_open(void)
  */
 void Storage::_mark_dirty(uint16_t loc, uint16_t length)
 {
-    uint16_t end = loc + length;
+    uint32_t now = AP_HAL::millis();
+    if (_dirty_mask == 0) {
+        _first_dirty_ms = now;
+    }
+    _last_dirty_ms = now;
+
+    uint16_t end = loc + length - 1;
     for (uint8_t line=loc>>LINUX_STORAGE_LINE_SHIFT;
          line <= end>>LINUX_STORAGE_LINE_SHIFT;
          line++) {
@@ -125,66 +146,145 @@ void Storage::write_block(uint16_t loc, const void *src, size_t n)
         _storage_open();
         memcpy(&_buffer[loc], src, n);
         _mark_dirty(loc, n);
+        _stats.bytes_changed += n;
     }
 }
 
+bool Storage::get_stats(Stats &stats)
+{
+    stats = _stats;
+    return true;
+}
+
 void Storage::_timer_tick(void)
 {
-    if (!_initialised || _dirty_mask == 0) {
+    if (!_initialised) {
         return;
     }
 
-    if (_fd == -1) {
-        _fd = open(STORAGE_FILE, O_WRONLY);
-        if (_fd == -1) {
-            return;    
+    if (_flush_state == FLUSH_IDLE) {
+        if (_dirty_mask == 0) {
+            return;
+        }
+        uint32_t now = AP_HAL::millis();
+        if (now - _last_dirty_ms < LINUX_STORAGE_COALESCE_MS &&
+            now - _first_dirty_ms < LINUX_STORAGE_MAX_DELAY_MS) {
+            // wait for more changes to write out together
+            return;
         }
     }
 
-    // write out the first dirty set of lines. We don't write more
-    // than one to keep the latency of this call to a minimum
-    uint8_t i, n;
-    for (i=0; i<LINUX_STORAGE_NUM_LINES; i++) {
-        if (_dirty_mask & (1<<i)) {
-            break;
-        }
+    /*
+      each call does one step of the flush to keep the latency of
+      this call down. Note that because this is a SCHED_FIFO thread
+      it will not be preempted by the main task except during
+      blocking calls. This means we don't need a semaphore around the
+      _dirty_mask updates.
+     */
+    uint32_t start_us = AP_HAL::micros();
+    bool ok = (_flush_state == FLUSH_IDLE) ? _flush_start() : _flush_step();
+    if (!ok) {
+        _flush_abort();
     }
-    if (i == LINUX_STORAGE_NUM_LINES) {
-        // this shouldn't be possible
-        return;
+    uint32_t dt = AP_HAL::micros() - start_us;
+    if (dt > _stats.flush_max_us) {
+        _stats.flush_max_us = dt;
     }
-    uint32_t write_mask = (1U<<i);
-    // see how many lines to write
-    for (n=1; (i+n) < LINUX_STORAGE_NUM_LINES && 
-             n < (LINUX_STORAGE_MAX_WRITE>>LINUX_STORAGE_LINE_SHIFT); n++) {
-        if (!(_dirty_mask & (1<<(n+i)))) {
-            break;
-        }        
-        // mark that line clean
-        write_mask |= (1<<(n+i));
+}
+
+/*
+  take a snapshot of the buffer and start writing it to the temporary
+  file
+ */
+bool Storage::_flush_start(void)
+{
+    if (_flush_buffer == nullptr) {
+        _flush_buffer = new uint8_t[LINUX_STORAGE_SIZE];
+        if (_flush_buffer == nullptr) {
+            return false;
+        }
     }
 
-    /*
-      write the lines. This also updates _dirty_mask. Note that
-      because this is a SCHED_FIFO thread it will not be preempted
-      by the main task except during blocking calls. This means we
-      don't need a semaphore around the _dirty_mask updates.
-     */
-    if (lseek(_fd, i<<LINUX_STORAGE_LINE_SHIFT, SEEK_SET) == (i<<LINUX_STORAGE_LINE_SHIFT)) {
-        _dirty_mask &= ~write_mask;
-        if (write(_fd, &_buffer[i<<LINUX_STORAGE_LINE_SHIFT], n<<LINUX_STORAGE_LINE_SHIFT) != n<<LINUX_STORAGE_LINE_SHIFT) {
+    _fd = open(STORAGE_TMP_FILE, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (_fd == -1) {
+        return false;
+    }
+
+    // the dirty mask is cleared before the copy, so a change made
+    // while copying is flushed again
+    _flush_mask = _dirty_mask;
+    _dirty_mask = 0;
+    memcpy(_flush_buffer, _buffer, LINUX_STORAGE_SIZE);
+    _flush_ofs = 0;
+    _flush_state = FLUSH_WRITE;
+    return true;
+}
+
+bool Storage::_flush_step(void)
+{
+    switch (_flush_state) {
+    case FLUSH_WRITE: {
+        uint16_t n = LINUX_STORAGE_SIZE - _flush_ofs;
+        if (n > STORAGE_FLUSH_STEP) {
+            n = STORAGE_FLUSH_STEP;
+        }
+        if (write(_fd, &_flush_buffer[_flush_ofs], n) != (ssize_t)n) {
             // write error - likely EINTR
-            _dirty_mask |= write_mask;
-            close(_fd);
-            _fd = -1;
+            return false;
         }
-        if (_dirty_mask == 0) {
-            if (fsync(_fd) != 0) {
-                close(_fd);
-                _fd = -1;
-            }
+        _stats.bytes_written += n;
+        _flush_ofs += n;
+        if (_flush_ofs == LINUX_STORAGE_SIZE) {
+            _flush_state = FLUSH_SYNC;
+        }
+        return true;
+    }
+
+    case FLUSH_SYNC:
+        if (fsync(_fd) != 0) {
+            return false;
         }
+        close(_fd);
+        _fd = -1;
+        _flush_state = FLUSH_RENAME;
+        return true;
+
+    case FLUSH_RENAME: {
+        if (rename(STORAGE_TMP_FILE, STORAGE_FILE) != 0) {
+            return false;
+        }
+        // make the rename itself survive a power loss
+        int dfd = open(STORAGE_DIR, O_RDONLY);
+        if (dfd != -1) {
+            fsync(dfd);
+            close(dfd);
+        }
+        _stats.flushes++;
+        _flush_state = FLUSH_IDLE;
+        return true;
+    }
+
+    case FLUSH_IDLE:
+        break;
+    }
+    return true;
+}
+
+/*
+  give up on a flush. The snapshot lines are marked dirty again so the
+  whole flush is retried once the coalescing delay has passed
+ */
+void Storage::_flush_abort(void)
+{
+    if (_fd != -1) {
+        close(_fd);
+        _fd = -1;
     }
+    unlink(STORAGE_TMP_FILE);
+    _dirty_mask |= _flush_mask;
+    _first_dirty_ms = _last_dirty_ms = AP_HAL::millis();
+    _flush_state = FLUSH_IDLE;
+    _stats.errors++;
 }
 
 #endif // CONFIG_HAL_BOARD
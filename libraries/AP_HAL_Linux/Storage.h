@@ -11,10 +11,25 @@
 #define LINUX_STORAGE_LINE_SIZE (1<<LINUX_STORAGE_LINE_SHIFT)
 #define LINUX_STORAGE_NUM_LINES (LINUX_STORAGE_SIZE/LINUX_STORAGE_LINE_SIZE)
 
+/*
+  writes are flushed once no change has been made for
+  LINUX_STORAGE_COALESCE_MS, or LINUX_STORAGE_MAX_DELAY_MS after the
+  first unflushed change, whichever comes first
+ */
+#ifndef LINUX_STORAGE_COALESCE_MS
+#define LINUX_STORAGE_COALESCE_MS 500
+#endif
+#ifndef LINUX_STORAGE_MAX_DELAY_MS
+#define LINUX_STORAGE_MAX_DELAY_MS 2000
+#endif
+
 class Linux::Storage : public AP_HAL::Storage
 {
 public:
-    Storage() : _fd(-1),_dirty_mask(0) { }
+    Storage() : _fd(-1),_dirty_mask(0),_first_dirty_ms(0),_last_dirty_ms(0),
+                _flush_state(FLUSH_IDLE),_flush_ofs(0),_flush_mask(0),_flush_buffer(nullptr) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
 
     static Storage *from(AP_HAL::Storage *storage) {
         return static_cast<Storage*>(storage);
@@ -31,6 +46,8 @@ public:
     void write_dword(uint16_t loc, uint32_t value);
     void write_block(uint16_t dst, const void* src, size_t n);
 
+    bool get_stats(Stats &stats);
+
     virtual void _timer_tick(void);
 protected:
     void _mark_dirty(uint16_t loc, uint16_t length);
@@ -40,6 +57,31 @@ protected:
     volatile bool _initialised;
     uint8_t _buffer[LINUX_STORAGE_SIZE];
     volatile uint32_t _dirty_mask;
+    volatile uint32_t _first_dirty_ms;
+    volatile uint32_t _last_dirty_ms;
+    Stats _stats;
+
+private:
+    /*
+      a flush writes a snapshot of the whole buffer to a temporary
+      file a step at a time, then renames it over the storage file,
+      so the storage file always holds either the old or the new
+      contents
+     */
+    enum flush_state {
+        FLUSH_IDLE = 0,
+        FLUSH_WRITE,
+        FLUSH_SYNC,
+        FLUSH_RENAME
+    };
+    bool _flush_start(void);
+    bool _flush_step(void);
+    void _flush_abort(void);
+
+    enum flush_state _flush_state;
+    uint16_t _flush_ofs;
+    uint32_t _flush_mask;
+    uint8_t *_flush_buffer;
 };
 
 #include "Storage_FRAM.h"
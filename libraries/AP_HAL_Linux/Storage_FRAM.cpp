@@ -125,6 +125,8 @@ void Storage_FRAM::_timer_tick(void)
             // write error - likely EINTR
             _dirty_mask |= write_mask;
             _fd = -1;
+        } else {
+            _stats.bytes_written += n<<LINUX_STORAGE_LINE_SHIFT;
         }
     }
 }
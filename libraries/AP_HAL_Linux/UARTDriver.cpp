@@ -141,53 +141,21 @@ void UARTDriver::_allocate_buffers(uint16_t rxS, uint16_t txS)
     }
 
     /*
-      allocate the read buffer
+      allocate the read and write buffers. The contents are kept if
+      the size is unchanged
     */
-    if (rxS != 0 && rxS != _readbuf_size) {
-        _readbuf_size = rxS;
-        if (_readbuf != NULL) {
-            free(_readbuf);
-        }
-        _readbuf = (uint8_t *)malloc(_readbuf_size);
-        _readbuf_head = 0;
-        _readbuf_tail = 0;
-    }
-
-    /*
-      allocate the write buffer
-    */
-    if (txS != 0 && txS != _writebuf_size) {
-        _writebuf_size = txS;
-        if (_writebuf != NULL) {
-            free(_writebuf);
-        }
-        _writebuf = (uint8_t *)malloc(_writebuf_size);
-        _writebuf_head = 0;
-        _writebuf_tail = 0;
-    }
+    _readbuf.set_size(rxS);
+    _writebuf.set_size(txS, true);
 
-    if (_writebuf_size != 0 && _readbuf_size != 0) {
+    if (_writebuf.get_size() != 0 && _readbuf.get_size() != 0) {
         _initialised = true;
     }
 }
 
 void UARTDriver::_deallocate_buffers()
 {
-    if (_readbuf) {
-        free(_readbuf);
-        _readbuf = NULL;
-    }
-
-    if (_writebuf) {
-        free(_writebuf);
-        _writebuf = NULL;
-    }
-
-    _readbuf_size = _writebuf_size = 0;
-    _writebuf_head = 0;
-    _writebuf_tail = 0;
-    _readbuf_head = 0;
-    _readbuf_tail = 0;
+    _readbuf.set_size(0);
+    _writebuf.set_size(0);
 }
 
 /*
@@ -352,7 +320,7 @@ void UARTDriver::set_blocking_writes(bool blocking)
  */
 bool UARTDriver::tx_pending() 
 { 
-    return !BUF_EMPTY(_writebuf);
+    return !_writebuf.empty();
 }
 
 /*
@@ -363,8 +331,7 @@ int16_t UARTDriver::available()
     if (!_initialised) {
         return 0;
     }
-    uint16_t _tail;
-    return BUF_AVAILABLE(_readbuf);
+    return _readbuf.available();
 }
 
 /*
@@ -375,21 +342,18 @@ int16_t UARTDriver::txspace()
     if (!_initialised) {
         return 0;
     }
-    uint16_t _head;
-    return BUF_SPACE(_writebuf);
+    return _writebuf.space();
 }
 
 int16_t UARTDriver::read() 
 { 
     uint8_t c;
-    if (!_initialised || _readbuf == NULL) {
+    if (!_initialised) {
         return -1;
     }
-    if (BUF_EMPTY(_readbuf)) {
+    if (_readbuf.read(&c, 1) == 0) {
         return -1;
     }
-    c = _readbuf[_readbuf_head];
-    BUF_ADVANCEHEAD(_readbuf, 1);
     return c;
 }
 
@@ -399,17 +363,13 @@ size_t UARTDriver::write(uint8_t c)
     if (!_initialised) {
         return 0;
     }
-    uint16_t _head;
-
-    while (BUF_SPACE(_writebuf) == 0) {
+    while (_writebuf.space() == 0) {
         if (_nonblocking_writes) {
             return 0;
         }
         hal.scheduler->delay(1);
     }
-    _writebuf[_writebuf_tail] = c;
-    BUF_ADVANCETAIL(_writebuf, 1);
-    return 1;
+    return _writebuf.write(&c, 1);
 }
 
 /*
@@ -432,36 +392,7 @@ size_t UARTDriver::write(const uint8_t *buffer, size_t size)
         return ret;
     }
 
-    uint16_t _head, space;
-    space = BUF_SPACE(_writebuf);
-    if (space == 0) {
-        return 0;
-    }
-    if (size > space) {
-        size = space;
-    }
-    if (_writebuf_tail < _head) {
-        // perform as single memcpy
-        assert(_writebuf_tail+size <= _writebuf_size);
-        memcpy(&_writebuf[_writebuf_tail], buffer, size);
-        BUF_ADVANCETAIL(_writebuf, size);
-        return size;
-    }
-
-    // perform as two memcpy calls
-    uint16_t n = _writebuf_size - _writebuf_tail;
-    if (n > size) n = size;
-    assert(_writebuf_tail+n <= _writebuf_size);
-    memcpy(&_writebuf[_writebuf_tail], buffer, n);
-    BUF_ADVANCETAIL(_writebuf, n);
-    buffer += n;
-    n = size - n;
-    if (n > 0) {
-        assert(_writebuf_tail+n <= _writebuf_size);
-        memcpy(&_writebuf[_writebuf_tail], buffer, n);
-        BUF_ADVANCETAIL(_writebuf, n);
-    }        
-    return size;
+    return _writebuf.write(buffer, size);
 }
 
 /*
@@ -485,7 +416,7 @@ int UARTDriver::_write_fd(const uint8_t *buf, uint16_t n)
     ret = _device->write(buf, n);
 
     if (ret > 0) {
-        BUF_ADVANCEHEAD(_writebuf, ret);
+        _writebuf.advance(ret);
         return ret;
     }
 
@@ -502,8 +433,8 @@ int UARTDriver::_read_fd(uint8_t *buf, uint16_t n)
     ret = _device->read(buf, n);
 
     if (ret > 0) {
-        BUF_ADVANCETAIL(_readbuf, ret);
-    } 
+        _readbuf.commit(ret);
+    }
 
     return ret;
 }
@@ -515,13 +446,12 @@ int UARTDriver::_read_fd(uint8_t *buf, uint16_t n)
  */
 bool UARTDriver::_write_pending_bytes(void)
 {
-    uint16_t n;
+    ByteBuffer::IoVec vec[2];
 
     // write any pending bytes
-    uint16_t _tail;
-    uint16_t available_bytes = BUF_AVAILABLE(_writebuf);
-    n = available_bytes;
-    if (_packetise && n > 0 && _writebuf[_writebuf_head] != 254) {
+    uint32_t available_bytes = _writebuf.available();
+    uint32_t n = available_bytes;
+    if (_packetise && n > 0 && _writebuf.peek(0) != 254) {
         /*
           we have a non-mavlink packet at the start of the
           buffer. Look ahead for a MAVLink start byte, up to 256 bytes
@@ -530,7 +460,7 @@ bool UARTDriver::_write_pending_bytes(void)
         uint16_t limit = n>256?256:n;
         uint16_t i;
         for (i=0; i<limit; i++) {
-            if (_writebuf[(_writebuf_head + i) % _writebuf_size] == 254) {
+            if (_writebuf.peek(i) == 254) {
                 n = i;
                 break;
             }
@@ -540,7 +470,7 @@ bool UARTDriver::_write_pending_bytes(void)
             n = limit;
         }
     }
-    if (_packetise && n > 0 && _writebuf[_writebuf_head] == 254) {
+    if (_packetise && n > 0 && _writebuf.peek(0) == 254) {
         // this looks like a MAVLink packet - try to write on
         // packet boundaries when possible
         if (n < 8) {
@@ -549,12 +479,11 @@ bool UARTDriver::_write_pending_bytes(void)
             // the length of the packet is the 2nd byte, and mavlink
             // packets have a 6 byte header plus 2 byte checksum,
             // giving len+8 bytes
-            uint16_t ofs = (_writebuf_head + 1) % _writebuf_size;
-            uint8_t len = _writebuf[ofs];
-            if (n < len+8) {
+            uint8_t len = _writebuf.peek(1);
+            if (n < len+8U) {
                 // we don't have a full packet yet
                 n = 0;
-            } else if (n > len+8) {
+            } else if (n > len+8U) {
                 // send just 1 packet at a time (so MAVLink packets
                 // are aligned on UDP boundaries)
                 n = len+8;
@@ -563,30 +492,27 @@ bool UARTDriver::_write_pending_bytes(void)
     }
 
     if (n > 0) {
-        uint16_t n1 = _writebuf_size - _writebuf_head;
-        if (n1 >= n) {
+        uint8_t count = _writebuf.peekiovec(vec, n);
+        if (count == 1) {
             // do as a single write
-            _write_fd(&_writebuf[_writebuf_head], n);
+            _write_fd(vec[0].data, vec[0].len);
+        } else if (_packetise) {
+            // keep as a single UDP packet. This only happens if the
+            // write buffer could not be mirrored
+            uint8_t tmpbuf[n];
+            memcpy(tmpbuf, vec[0].data, vec[0].len);
+            memcpy(&tmpbuf[vec[0].len], vec[1].data, vec[1].len);
+            _write_fd(tmpbuf, n);
         } else {
             // split into two writes
-            if (_packetise) {
-                // keep as a single UDP packet
-                uint8_t tmpbuf[n];
-                memcpy(tmpbuf, &_writebuf[_writebuf_head], n1);
-                if (n > n1) {
-                    memcpy(&tmpbuf[n1], &_writebuf[0], n-n1);
-                }
-                _write_fd(tmpbuf, n);
-            } else {
-                int ret = _write_fd(&_writebuf[_writebuf_head], n1);
-                if (ret == n1 && n > n1) {
-                    _write_fd(&_writebuf[_writebuf_head], n - n1);                
-                }
+            int ret = _write_fd(vec[0].data, vec[0].len);
+            if (ret == (int)vec[0].len) {
+                _write_fd(vec[1].data, vec[1].len);
             }
         }
     }
 
-    return BUF_AVAILABLE(_writebuf) != available_bytes;
+    return _writebuf.available() != available_bytes;
 }
 
 /*
@@ -596,8 +522,6 @@ bool UARTDriver::_write_pending_bytes(void)
  */
 void UARTDriver::_timer_tick(void)
 {
-    uint16_t n;
-
     if (!_initialised) return;
 
     _in_timer = true;
@@ -608,21 +532,12 @@ void UARTDriver::_timer_tick(void)
     }
 
     // try to fill the read buffer
-    uint16_t _head;
-    n = BUF_SPACE(_readbuf);
-    if (n > 0) {
-        uint16_t n1 = _readbuf_size - _readbuf_tail;
-        if (n1 >= n) {
-            // one read will do
-            assert(_readbuf_tail+n <= _readbuf_size);
-            _read_fd(&_readbuf[_readbuf_tail], n);
-        } else {
-            assert(_readbuf_tail+n1 <= _readbuf_size);
-            int ret = _read_fd(&_readbuf[_readbuf_tail], n1);
-            if (ret == n1 && n > n1) {
-                assert(_readbuf_tail+(n-n1) <= _readbuf_size);
-                _read_fd(&_readbuf[_readbuf_tail], n - n1);                
-            }
+    ByteBuffer::IoVec vec[2];
+    uint8_t count = _readbuf.reserve(vec, _readbuf.space());
+    if (count > 0) {
+        int ret = _read_fd(vec[0].data, vec[0].len);
+        if (count > 1 && ret == (int)vec[0].len) {
+            _read_fd(vec[1].data, vec[1].len);
         }
     }
 
@@ -67,6 +67,11 @@ public:
     void perf_begin(perf_counter_t perf) override;
     void perf_end(perf_counter_t perf) override;
     void perf_count(perf_counter_t perf) override;
+#ifndef PERF_LTTNG
+    uint16_t perf_num_counters(void) override;
+    bool perf_get_info(uint16_t i, perf_counter_info &info) override;
+    void perf_reset_all(void) override;
+#endif
 
     // create a new semaphore
     AP_HAL::Semaphore *new_semaphore(void) override { return new Linux::Semaphore; }
@@ -95,8 +95,16 @@ void SITL_State::_sitl_setup(const char *home_str)
         if (enable_gimbal) {
             gimbal = new Gimbal(_sitl->state);
         }
+        if (_world_name != NULL) {
+            world = new World(_world_name, _instance, _lockstep);
+            if (!world->joined()) {
+                fprintf(stderr, "SITL: failed to join world %s\n", _world_name);
+                exit(1);
+            }
+        }
         if (enable_ADSB) {
-            adsb = new ADSB(_sitl->state, home_str);
+            // ADSB traffic goes to uartC of this instance
+            adsb = new ADSB(_sitl->state, home_str, _base_port + 2, world);
         }
 
         fg_socket.connect("127.0.0.1", 5503);
@@ -262,6 +270,11 @@ void SITL_State::_fdm_input_local(void)
     // construct servos structure for FDM
     _simulator_servos(input);
 
+    if (world != NULL) {
+        // keep pace with the rest of the world
+        world->wait_step(_sitl->state.timestamp_us);
+    }
+
     // update the model
     sitl_model->update(input);
 
@@ -269,6 +282,16 @@ void SITL_State::_fdm_input_local(void)
     sitl_model->fill_fdm(_sitl->state);
     _sitl->update_rate_hz = sitl_model->get_rate_hz();
 
+    if (world != NULL) {
+        world->update(_sitl->state);
+    }
+
+    _update_metrics();
+    if (_run_time_us != 0 && _sitl->state.timestamp_us >= _run_time_us) {
+        _write_metrics();
+        exit(0);
+    }
+
     if (gimbal != NULL) {
         gimbal->update();
     }
@@ -276,7 +299,10 @@ void SITL_State::_fdm_input_local(void)
         adsb->update();
     }
 
-    _output_to_flightgear();
+    if (!_lockstep) {
+        // there is no point viewing a lockstep run
+        _output_to_flightgear();
+    }
 
     // update simulation time
     hal.scheduler->stop_clock(_sitl->state.timestamp_us);
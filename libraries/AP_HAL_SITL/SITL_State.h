@@ -25,8 +25,12 @@
 #include <SITL/SITL.h>
 #include <SITL/SIM_Gimbal.h>
 #include <SITL/SIM_ADSB.h>
+#include <SITL/SIM_World.h>
 #include <AP_HAL/utility/Socket.h>
 
+// UTC time at the start of a lockstep simulation, 2016-01-01
+#define SITL_LOCKSTEP_START_TIME 1451606400
+
 class HAL_SITL;
 
 class HALSITL::SITL_State {
@@ -62,6 +66,9 @@ public:
     // return TCP client address for uartC
     const char *get_client_address(void) const { return _client_address; }
 
+    // true when running in lockstep with the FDM, with no wall clock pacing
+    bool lockstep(void) const { return _lockstep; }
+
     // paths for UART devices
     const char *_uart_path[5] {
         "tcp:0:wait",
@@ -134,6 +141,9 @@ private:
 
     void wait_clock(uint64_t wait_time_usec);
 
+    // UTC time for the simulated GPS
+    void _utc_time(struct timeval &tv) const;
+
     // internal state
     enum vehicle_type _vehicle;
     uint16_t _framerate;
@@ -157,6 +167,7 @@ private:
     float _current;
 
     bool _synthetic_clock_mode;
+    bool _lockstep;
 
     const char *_fdm_address;
 
@@ -209,6 +220,38 @@ private:
     bool enable_ADSB;
     SITL::ADSB *adsb;
 
+    // world shared with other instances, from --world
+    const char *_world_name;
+    SITL::World *world;
+
+    // metrics of a batch run, written when the run ends. See sitl_metrics.cpp
+    unsigned _seed;
+    uint64_t _run_time_us;
+    const char *_metrics_path;
+    struct {
+        uint64_t last_sample_us;    // simulated time
+        uint64_t start_wall_us;
+        uint64_t last_step_wall_us;
+        uint64_t step_wall_sum_us;
+        uint32_t step_wall_max_us;
+        uint32_t steps;
+        uint32_t samples;
+        uint32_t track_samples;
+        float track_err_sq_sum;
+        float track_err_max;
+        float pos_err_sq_sum;
+        float pos_err_max;
+        float alt_err_max;
+        float vel_test_max;
+        float pos_test_max;
+        float hgt_test_max;
+        float mag_test_max;
+        float tas_test_max;
+        float load_max;
+    } _metrics;
+    void _update_metrics(void);
+    void _write_metrics(void);
+
     // output socket for flightgear viewing
     SocketAPM fg_socket{true};
     
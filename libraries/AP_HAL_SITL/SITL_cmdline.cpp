@@ -48,8 +48,13 @@ void SITL_State::_usage(void)
            "\t--console          use console instead of TCP ports\n"
            "\t--instance N       set instance of SITL (adds 10*instance to all port numbers)\n"
            "\t--speedup SPEEDUP  set simulation speedup\n"
+           "\t--lockstep         run as fast as possible in lockstep with the model, ignoring speedup\n"
            "\t--gimbal           enable simulated MAVLink gimbal\n"
            "\t--adsb             enable simulated ADSB peripheral\n"
+           "\t--world NAME       share a world with other instances of the same NAME\n"
+           "\t--seed SEED        seed the random numbers of the simulation\n"
+           "\t--run-time SECS    exit after SECS of simulated time\n"
+           "\t--metrics FILE     write metrics of the run to FILE when it exits\n"
            "\t--autotest-dir DIR set directory for additional files\n"
            "\t--uartA device     set device string for UARTA\n"
            "\t--uartB device     set device string for UARTB\n"
@@ -106,12 +111,17 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     setvbuf(stderr, (char *)0, _IONBF, 0);
 
     _synthetic_clock_mode = false;
+    _lockstep = false;
     _base_port = 5760;
     _rcout_port = 5502;
     _simin_port = 5501;
     _fdm_address = "127.0.0.1";
     _client_address = NULL;
     _instance = 0;
+    _world_name = NULL;
+    _seed = 0;
+    _run_time_us = 0;
+    _metrics_path = NULL;
 
     enum long_options {
         CMDLINE_CLIENT=0,
@@ -123,7 +133,12 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         CMDLINE_UARTD,
         CMDLINE_UARTE,
         CMDLINE_ADSB,
-        CMDLINE_DEFAULTS
+        CMDLINE_DEFAULTS,
+        CMDLINE_LOCKSTEP,
+        CMDLINE_WORLD,
+        CMDLINE_SEED,
+        CMDLINE_RUN_TIME,
+        CMDLINE_METRICS
     };
 
     const struct GetOptLong::option options[] = {
@@ -147,6 +162,11 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         {"adsb",            false,  0, CMDLINE_ADSB},
         {"autotest-dir",    true,   0, CMDLINE_AUTOTESTDIR},
         {"defaults",        true,   0, CMDLINE_DEFAULTS},
+        {"lockstep",        false,  0, CMDLINE_LOCKSTEP},
+        {"world",           true,   0, CMDLINE_WORLD},
+        {"seed",            true,   0, CMDLINE_SEED},
+        {"run-time",        true,   0, CMDLINE_RUN_TIME},
+        {"metrics",         true,   0, CMDLINE_METRICS},
         {0, false, 0, 0}
     };
 
@@ -205,6 +225,23 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case CMDLINE_DEFAULTS:
             defaults_path = strdup(gopt.optarg);
             break;
+        case CMDLINE_LOCKSTEP:
+            _lockstep = true;
+            break;
+        case CMDLINE_WORLD:
+            _world_name = gopt.optarg;
+            break;
+        case CMDLINE_SEED:
+            _seed = strtoul(gopt.optarg, NULL, 0);
+            srandom(_seed);
+            srand(_seed);
+            break;
+        case CMDLINE_RUN_TIME:
+            _run_time_us = strtof(gopt.optarg, NULL) * 1.0e6f;
+            break;
+        case CMDLINE_METRICS:
+            _metrics_path = gopt.optarg;
+            break;
 
         case CMDLINE_UARTA:
         case CMDLINE_UARTB:
@@ -232,7 +269,12 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
             sitl_model->set_instance(_instance);
             sitl_model->set_autotest_dir(autotest_dir);
             _synthetic_clock_mode = true;
-            printf("Started model %s at %s at speed %.1f\n", model_str, home_str, speedup);
+            if (_lockstep) {
+                sitl_model->set_lockstep();
+                printf("Started model %s at %s in lockstep\n", model_str, home_str);
+            } else {
+                printf("Started model %s at %s at speed %.1f\n", model_str, home_str, speedup);
+            }
             break;
         }
     }
@@ -6,15 +6,28 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
 
 #include "Storage.h"
 using namespace HALSITL;
 
+/*
+  eeprom.bin is mapped shared into memory, so reads and writes are a
+  memcpy rather than a system call and the kernel writes the changes
+  back. Writes go to the page cache straight away, so they survive the
+  simulator being killed. If the mapping fails the file is accessed
+  with pread and pwrite instead
+ */
 void EEPROMStorage::_eeprom_open(void)
 {
     if (_eeprom_fd == -1) {
         _eeprom_fd = open("eeprom.bin", O_RDWR|O_CREAT, 0777);
         assert(ftruncate(_eeprom_fd, HAL_STORAGE_SIZE) == 0);
+        void *p = mmap(NULL, HAL_STORAGE_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, _eeprom_fd, 0);
+        if (p != MAP_FAILED) {
+            _eeprom = (uint8_t *)p;
+        }
     }
 }
 
@@ -22,13 +35,21 @@ void EEPROMStorage::read_block(void *dst, uint16_t src, size_t n)
 {
     assert(src < HAL_STORAGE_SIZE && src + n <= HAL_STORAGE_SIZE);
     _eeprom_open();
+    if (_eeprom != NULL) {
+        memcpy(dst, &_eeprom[src], n);
+        return;
+    }
     assert(pread(_eeprom_fd, dst, n, src) == (ssize_t)n);
 }
 
 void EEPROMStorage::write_block(uint16_t dst, const void *src, size_t n)
 {
-    assert(dst < HAL_STORAGE_SIZE);
+    assert(dst < HAL_STORAGE_SIZE && dst + n <= HAL_STORAGE_SIZE);
     _eeprom_open();
+    if (_eeprom != NULL) {
+        memcpy(&_eeprom[dst], src, n);
+        return;
+    }
     assert(pwrite(_eeprom_fd, src, n, dst) == (ssize_t)n);
 }
 
@@ -10,6 +10,7 @@ class HALSITL::EEPROMStorage : public AP_HAL::Storage {
 public:
     EEPROMStorage() {
         _eeprom_fd = -1;
+        _eeprom = NULL;
     }
     void init() {}
     void read_block(void *dst, uint16_t src, size_t n);
@@ -17,6 +18,7 @@ public:
 
 private:
     int _eeprom_fd;
+    uint8_t *_eeprom;   // shared mapping of the file, NULL if not mapped
     void _eeprom_open(void);
 };
 
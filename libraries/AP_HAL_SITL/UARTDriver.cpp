@@ -102,7 +102,9 @@ void UARTDriver::end()
 
 int16_t UARTDriver::available(void)
 {
-    _check_connection();
+    if (!_sitlState->lockstep()) {
+        _check_connection();
+    }
 
     if (!_connected) {
         return 0;
@@ -115,7 +117,9 @@ int16_t UARTDriver::available(void)
 
 int16_t UARTDriver::txspace(void)
 {
-    _check_connection();
+    if (!_sitlState->lockstep()) {
+        _check_connection();
+    }
     if (!_connected) {
         return 0;
     }
@@ -385,6 +389,11 @@ void UARTDriver::_set_nonblocking(int fd)
 
 void UARTDriver::_timer_tick(void)
 {
+    if (!_connected && _sitlState->lockstep()) {
+        // in lockstep connections are only taken between model
+        // steps, so they happen at a repeatable simulated time
+        _check_connection();
+    }
     if (!_connected) {
         return;
     }
@@ -403,19 +412,20 @@ void UARTDriver::_timer_tick(void)
         }
     }
 
-    uint32_t space = _readbuffer.space();
-    if (space == 0) {
+    // read straight into the free space of the read buffer. It is
+    // mirrored, so all of the free space is normally one region
+    ByteBuffer::IoVec vec[2];
+    if (_readbuffer.reserve(vec, _readbuffer.space()) == 0) {
         return;
     }
-    
-    char buf[space];
+
     ssize_t nread = 0;
     if (!_use_send_recv) {
         int fd = _console?0:_fd;
-        nread = ::read(fd, buf, space);
+        nread = ::read(fd, vec[0].data, vec[0].len);
     } else {
         if (_select_check(_fd)) {
-            nread = recv(_fd, buf, space, MSG_DONTWAIT);
+            nread = recv(_fd, vec[0].data, vec[0].len, MSG_DONTWAIT);
             if (nread <= 0) {
                 // the socket has reached EOF
                 close(_fd);
@@ -429,7 +439,7 @@ void UARTDriver::_timer_tick(void)
         }
     }
     if (nread > 0) {
-        _readbuffer.write((uint8_t *)buf, nread);
+        _readbuffer.commit(nread);
     }
 }
 
@@ -71,8 +71,8 @@ private:
     int _serial_port;
     static bool _console;
     bool _nonblocking_writes;
-    ByteBuffer _readbuffer{16384};
-    ByteBuffer _writebuffer{16384};
+    ByteBuffer _readbuffer{16384, true};
+    ByteBuffer _writebuffer{16384, true};
 
     // IPv4 address of target for uartC
     const char *_tcp_client_addr;
@@ -155,16 +155,29 @@ void SITL_State::_gps_send_ubx(uint8_t msgid, uint8_t *buf, uint16_t size)
 /*
   return GPS time of week in milliseconds
  */
-static void gps_time(uint16_t *time_week, uint32_t *time_week_ms)
+static void gps_time(const struct timeval &tv, uint16_t *time_week, uint32_t *time_week_ms)
 {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
     const uint32_t epoch = 86400*(10*365 + (1980-1969)/4 + 1 + 6 - 2) - 15;
     uint32_t epoch_seconds = tv.tv_sec - epoch;
     *time_week = epoch_seconds / (86400*7UL);
     *time_week_ms = (epoch_seconds % (86400*7UL))*1000 + tv.tv_usec/1000;
 }
 
+/*
+  return UTC time for the GPS. In lockstep mode this is simulated time
+  from a fixed start, so that runs repeat exactly
+ */
+void SITL_State::_utc_time(struct timeval &tv) const
+{
+    if (!_lockstep) {
+        gettimeofday(&tv, NULL);
+        return;
+    }
+    uint64_t now_us = AP_HAL::micros64();
+    tv.tv_sec = SITL_LOCKSTEP_START_TIME + now_us / 1000000;
+    tv.tv_usec = now_us % 1000000;
+}
+
 /*
   send a new set of GPS UBLOX packets
  */
@@ -235,8 +248,10 @@ void SITL_State::_update_gps_ubx(const struct gps_data *d)
     const uint8_t MSG_SOL = 0x6;
     uint16_t time_week;
     uint32_t time_week_ms;
+    struct timeval tv;
 
-    gps_time(&time_week, &time_week_ms);
+    _utc_time(tv);
+    gps_time(tv, &time_week, &time_week_ms);
 
     pos.time = time_week_ms;
     pos.longitude = d->longitude * 1.0e7;
@@ -355,7 +370,7 @@ void SITL_State::_update_gps_mtk(const struct gps_data *d)
     struct tm tm;
     struct timeval tv;
 
-    gettimeofday(&tv, NULL);
+    _utc_time(tv);
     tm = *gmtime(&tv.tv_sec);
     uint32_t hsec = (tv.tv_usec / (10000*20)) * 20; // always multiple of 20
 
@@ -412,7 +427,7 @@ void SITL_State::_update_gps_mtk16(const struct gps_data *d)
     struct tm tm;
     struct timeval tv;
 
-    gettimeofday(&tv, NULL);
+    _utc_time(tv);
     tm = *gmtime(&tv.tv_sec);
     uint32_t millisec = (tv.tv_usec / (1000*200)) * 200; // always multiple of 200
 
@@ -470,7 +485,7 @@ void SITL_State::_update_gps_mtk19(const struct gps_data *d)
     struct tm tm;
     struct timeval tv;
 
-    gettimeofday(&tv, NULL);
+    _utc_time(tv);
     tm = *gmtime(&tv.tv_sec);
     uint32_t millisec = (tv.tv_usec / (1000*200)) * 200; // always multiple of 200
 
@@ -531,7 +546,7 @@ void SITL_State::_update_gps_nmea(const struct gps_data *d)
     char lat_string[20];
     char lng_string[20];
 
-    gettimeofday(&tv, NULL);
+    _utc_time(tv);
 
     tm = gmtime(&tv.tv_sec);
 
@@ -647,8 +662,10 @@ void SITL_State::_update_gps_sbp(const struct gps_data *d)
 
     uint16_t time_week;
     uint32_t time_week_ms;
+    struct timeval tv;
 
-    gps_time(&time_week, &time_week_ms);
+    _utc_time(tv);
+    gps_time(tv, &time_week, &time_week_ms);
 
     t.wn = time_week;
     t.tow = time_week_ms;
@@ -0,0 +1,149 @@
+/*
+  SITL handling
+
+  This gathers metrics of a run for batch simulation, such as the
+  Monte Carlo runs of Tools/MonteCarlo
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include "AP_HAL_SITL.h"
+#include "AP_HAL_SITL_Namespace.h"
+#include "HAL_SITL_Class.h"
+
+#include <AP_Math/AP_Math.h>
+#include <AP_AHRS/AP_AHRS.h>
+#include <AP_Navigation/AP_Navigation.h>
+#include <SITL/SITL.h>
+
+#include <stdio.h>
+#include <time.h>
+
+extern const AP_HAL::HAL& hal;
+
+using namespace HALSITL;
+
+// simulated time between samples of the vehicle state
+#define METRICS_SAMPLE_US 100000
+
+static uint64_t wall_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/*
+  update the metrics after a model step. The wall clock time between
+  steps is the cost of simulating one step of the autopilot and the
+  model. The navigation errors are sampled at 10Hz of simulated time
+ */
+void SITL_State::_update_metrics(void)
+{
+    if (_metrics_path == NULL) {
+        return;
+    }
+
+    const uint64_t now_wall = wall_time_us();
+    if (_metrics.steps == 0) {
+        _metrics.start_wall_us = now_wall;
+    } else {
+        const uint32_t dt = now_wall - _metrics.last_step_wall_us;
+        _metrics.step_wall_sum_us += dt;
+        if (dt > _metrics.step_wall_max_us) {
+            _metrics.step_wall_max_us = dt;
+        }
+    }
+    _metrics.last_step_wall_us = now_wall;
+    _metrics.steps++;
+
+    const SITL::sitl_fdm &fdm = _sitl->state;
+    if (fdm.timestamp_us - _metrics.last_sample_us < METRICS_SAMPLE_US) {
+        return;
+    }
+    _metrics.last_sample_us = fdm.timestamp_us;
+    _metrics.samples++;
+
+    // the peak load on the airframe, in g
+    const float load = pythagorous3(fdm.xAccel, fdm.yAccel, fdm.zAccel) / GRAVITY_MSS;
+    _metrics.load_max = MAX(_metrics.load_max, load);
+
+    // error of the AHRS position against the true position
+    const AP_AHRS *ahrs = (const AP_AHRS *)AP_Param::find_object("AHRS_");
+    Location loc;
+    if (ahrs != NULL && ahrs->get_position(loc)) {
+        Location truth {};
+        truth.lat = fdm.latitude * 1.0e7;
+        truth.lng = fdm.longitude * 1.0e7;
+        const float pos_err = get_distance(loc, truth);
+        const float alt_err = fabsf(loc.alt * 0.01f - fdm.altitude);
+        _metrics.pos_err_sq_sum += sq(pos_err);
+        _metrics.pos_err_max = MAX(_metrics.pos_err_max, pos_err);
+        _metrics.alt_err_max = MAX(_metrics.alt_err_max, alt_err);
+    }
+
+#if AP_AHRS_NAVEKF_AVAILABLE
+    // peak innovation test ratios of the EKF
+    float velVar, posVar, hgtVar, tasVar;
+    Vector3f magVar;
+    Vector2f offset;
+    if (ahrs != NULL && ((const AP_AHRS_NavEKF *)ahrs)->get_variances(velVar, posVar, hgtVar, magVar, tasVar, offset)) {
+        _metrics.vel_test_max = MAX(_metrics.vel_test_max, velVar);
+        _metrics.pos_test_max = MAX(_metrics.pos_test_max, posVar);
+        _metrics.hgt_test_max = MAX(_metrics.hgt_test_max, hgtVar);
+        _metrics.mag_test_max = MAX(_metrics.mag_test_max, magVar.length());
+        _metrics.tas_test_max = MAX(_metrics.tas_test_max, tasVar);
+    }
+#endif
+
+    // cross track error of the navigation controller, on vehicles that have one
+    const AP_Navigation *nav = (const AP_Navigation *)AP_Param::find_object("NAVL1_");
+    if (nav != NULL) {
+        const float track_err = fabsf(nav->crosstrack_error());
+        _metrics.track_samples++;
+        _metrics.track_err_sq_sum += sq(track_err);
+        _metrics.track_err_max = MAX(_metrics.track_err_max, track_err);
+    }
+}
+
+/*
+  write the metrics as one name=value line each, in a fixed order
+ */
+void SITL_State::_write_metrics(void)
+{
+    if (_metrics_path == NULL) {
+        return;
+    }
+    FILE *f = fopen(_metrics_path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "SITL: failed to open %s\n", _metrics_path);
+        return;
+    }
+    const float sim_time = _sitl->state.timestamp_us * 1.0e-6f;
+    const float wall_time = (_metrics.last_step_wall_us - _metrics.start_wall_us) * 1.0e-6f;
+    const uint32_t samples = MAX(_metrics.samples, 1U);
+    const uint32_t track_samples = MAX(_metrics.track_samples, 1U);
+    const uint32_t steps = MAX(_metrics.steps, 2U) - 1;
+
+    fprintf(f, "seed=%u\n", _seed);
+    fprintf(f, "sim_time=%.1f\n", sim_time);
+    fprintf(f, "wall_time=%.2f\n", wall_time);
+    fprintf(f, "speedup=%.1f\n", wall_time > 0 ? sim_time / wall_time : 0);
+    fprintf(f, "step_us_mean=%.1f\n", _metrics.step_wall_sum_us / (float)steps);
+    fprintf(f, "step_us_max=%u\n", (unsigned)_metrics.step_wall_max_us);
+    fprintf(f, "track_err_rms=%.2f\n", sqrtf(_metrics.track_err_sq_sum / track_samples));
+    fprintf(f, "track_err_max=%.2f\n", _metrics.track_err_max);
+    fprintf(f, "pos_err_rms=%.2f\n", sqrtf(_metrics.pos_err_sq_sum / samples));
+    fprintf(f, "pos_err_max=%.2f\n", _metrics.pos_err_max);
+    fprintf(f, "alt_err_max=%.2f\n", _metrics.alt_err_max);
+    fprintf(f, "vel_test_max=%.3f\n", _metrics.vel_test_max);
+    fprintf(f, "pos_test_max=%.3f\n", _metrics.pos_test_max);
+    fprintf(f, "hgt_test_max=%.3f\n", _metrics.hgt_test_max);
+    fprintf(f, "mag_test_max=%.3f\n", _metrics.mag_test_max);
+    fprintf(f, "tas_test_max=%.3f\n", _metrics.tas_test_max);
+    fprintf(f, "load_max=%.2f\n", _metrics.load_max);
+    fclose(f);
+}
+
+#endif
@@ -71,18 +71,12 @@ void VRBRAINUARTDriver::begin(uint32_t b, uint16_t rxS, uint16_t txS)
       thrashing of the heap once we are up. The ttyACM0 driver may not
       connect for some time after boot
      */
-	if (rxS != 0 && rxS != _readbuf_size) {
+	if (rxS != 0 && rxS != _readbuf.get_size()) {
         _initialised = false;
         while (_in_timer) {
             hal.scheduler->delay(1);
         }
-		_readbuf_size = rxS;
-		if (_readbuf != NULL) {
-			free(_readbuf);
-		}
-		_readbuf = (uint8_t *)malloc(_readbuf_size);
-		_readbuf_head = 0;
-		_readbuf_tail = 0;
+        _readbuf.set_size(rxS);
 	}
 
     if (b != 0) {
@@ -92,18 +86,12 @@ void VRBRAINUARTDriver::begin(uint32_t b, uint16_t rxS, uint16_t txS)
     /*
       allocate the write buffer
      */
-	if (txS != 0 && txS != _writebuf_size) {
+	if (txS != 0 && txS != _writebuf.get_size()) {
         _initialised = false;
         while (_in_timer) {
             hal.scheduler->delay(1);
         }
-		_writebuf_size = txS;
-		if (_writebuf != NULL) {
-			free(_writebuf);
-		}
-		_writebuf = (uint8_t *)malloc(_writebuf_size+16);
-		_writebuf_head = 0;
-		_writebuf_tail = 0;
+        _writebuf.set_size(txS);
 	}
 
 	if (_fd == -1) {
@@ -131,10 +119,10 @@ void VRBRAINUARTDriver::begin(uint32_t b, uint16_t rxS, uint16_t txS)
 		tcsetattr(_fd, TCSANOW, &t);
 	}
 
-    if (_writebuf_size != 0 && _readbuf_size != 0 && _fd != -1) {
+    if (_writebuf.get_size() != 0 && _readbuf.get_size() != 0 && _fd != -1) {
         if (!_initialised) {
             ::printf("initialised %s OK %u %u\n", _devpath, 
-                     (unsigned)_writebuf_size, (unsigned)_readbuf_size);
+                     (unsigned)_writebuf.get_size(), (unsigned)_readbuf.get_size());
         }
         _initialised = true;
     }
@@ -197,19 +185,8 @@ void VRBRAINUARTDriver::end()
         close(_fd);
         _fd = -1;
     }
-    if (_readbuf) {
-        free(_readbuf);
-        _readbuf = NULL;
-    }
-    if (_writebuf) {
-        free(_writebuf);
-        _writebuf = NULL;
-    }
-    _readbuf_size = _writebuf_size = 0;
-    _writebuf_head = 0;
-    _writebuf_tail = 0;
-    _readbuf_head = 0;
-    _readbuf_tail = 0;
+    _readbuf.set_size(0);
+    _writebuf.set_size(0);
 }
 
 void VRBRAINUARTDriver::flush() {}
@@ -236,8 +213,7 @@ int16_t VRBRAINUARTDriver::available()
         try_initialise();
 		return 0;
 	}
-    uint16_t _tail;
-    return BUF_AVAILABLE(_readbuf);
+    return _readbuf.available();
 }
 
 /*
@@ -249,8 +225,7 @@ int16_t VRBRAINUARTDriver::txspace()
         try_initialise();
 		return 0;
 	}
-    uint16_t _head;
-    return BUF_SPACE(_writebuf);
+    return _writebuf.space();
 }
 
 /*
@@ -263,14 +238,9 @@ int16_t VRBRAINUARTDriver::read()
         try_initialise();
         return -1;
     }
-	if (_readbuf == NULL) {
-		return -1;
-	}
-    if (BUF_EMPTY(_readbuf)) {
+    if (_readbuf.read(&c, 1) == 0) {
         return -1;
     }
-    c = _readbuf[_readbuf_head];
-    BUF_ADVANCEHEAD(_readbuf, 1);
 	return c;
 }
 
@@ -287,17 +257,13 @@ size_t VRBRAINUARTDriver::write(uint8_t c)
         // not allowed from timers
         return 0;
     }
-    uint16_t _head;
-
-    while (BUF_SPACE(_writebuf) == 0) {
+    while (_writebuf.space() == 0) {
         if (_nonblocking_writes) {
             return 0;
         }
         hal.scheduler->delay(1);
     }
-    _writebuf[_writebuf_tail] = c;
-    BUF_ADVANCETAIL(_writebuf, 1);
-    return 1;
+    return _writebuf.write(&c, 1);
 }
 
 /*
@@ -326,36 +292,7 @@ size_t VRBRAINUARTDriver::write(const uint8_t *buffer, size_t size)
         return ret;
     }
 
-    uint16_t _head, space;
-    space = BUF_SPACE(_writebuf);
-    if (space == 0) {
-        return 0;
-    }
-    if (size > space) {
-        size = space;
-    }
-    if (_writebuf_tail < _head) {
-        // perform as single memcpy
-        assert(_writebuf_tail+size <= _writebuf_size);
-        memcpy(&_writebuf[_writebuf_tail], buffer, size);
-        BUF_ADVANCETAIL(_writebuf, size);
-        return size;
-    }
-
-    // perform as two memcpy calls
-    uint16_t n = _writebuf_size - _writebuf_tail;
-    if (n > size) n = size;
-    assert(_writebuf_tail+n <= _writebuf_size);
-    memcpy(&_writebuf[_writebuf_tail], buffer, n);
-    BUF_ADVANCETAIL(_writebuf, n);
-    buffer += n;
-    n = size - n;
-    if (n > 0) {
-        assert(_writebuf_tail+n <= _writebuf_size);
-        memcpy(&_writebuf[_writebuf_tail], buffer, n);
-        BUF_ADVANCETAIL(_writebuf, n);
-    }        
-    return size;
+    return _writebuf.write(buffer, size);
 }
 
 /*
@@ -404,7 +341,7 @@ int VRBRAINUARTDriver::_write_fd(const uint8_t *buf, uint16_t n)
     }
 
     if (ret > 0) {
-        BUF_ADVANCEHEAD(_writebuf, ret);
+        _writebuf.advance(ret);
         _last_write_time = AP_HAL::micros64();
         _total_written += ret;
         if (! _first_write_time && _total_written > 5) {
@@ -442,7 +379,7 @@ int VRBRAINUARTDriver::_write_fd(const uint8_t *buf, uint16_t n)
         // discarding bytes, even if this is a blocking port. This
         // prevents the ttyACM0 port blocking startup if the endpoint
         // is not connected
-        BUF_ADVANCEHEAD(_writebuf, n);
+        _writebuf.advance(n);
         return n;
     }
     return ret;
@@ -467,7 +404,7 @@ int VRBRAINUARTDriver::_read_fd(uint8_t *buf, uint16_t n)
         }
     }
     if (ret > 0) {
-        BUF_ADVANCETAIL(_readbuf, ret);
+        _readbuf.commit(ret);
         _total_read += ret;
     }
     return ret;
@@ -481,8 +418,6 @@ int VRBRAINUARTDriver::_read_fd(uint8_t *buf, uint16_t n)
  */
 void VRBRAINUARTDriver::_timer_tick(void)
 {
-    uint16_t n;
-
     if (!_initialised) return;
 
     // don't try IO on a disconnected USB port
@@ -493,41 +428,24 @@ void VRBRAINUARTDriver::_timer_tick(void)
     _in_timer = true;
 
     // write any pending bytes
-    uint16_t _tail;
-    n = BUF_AVAILABLE(_writebuf);
-    if (n > 0) {
-        uint16_t n1 = _writebuf_size - _writebuf_head;
+    ByteBuffer::IoVec vec[2];
+    uint8_t count = _writebuf.peekiovec(vec, _writebuf.available());
+    if (count > 0) {
         perf_begin(_perf_uart);
-        if (n1 >= n) {
-            // do as a single write
-            _write_fd(&_writebuf[_writebuf_head], n);
-        } else {
-            // split into two writes
-            int ret = _write_fd(&_writebuf[_writebuf_head], n1);
-            if (ret == n1 && n > n1) {
-                _write_fd(&_writebuf[_writebuf_head], n - n1);                
-            }
+        int ret = _write_fd(vec[0].data, vec[0].len);
+        if (count > 1 && ret == (int)vec[0].len) {
+            _write_fd(vec[1].data, vec[1].len);
         }
         perf_end(_perf_uart);
     }
 
     // try to fill the read buffer
-    uint16_t _head;
-    n = BUF_SPACE(_readbuf);
-    if (n > 0) {
-        uint16_t n1 = _readbuf_size - _readbuf_tail;
+    count = _readbuf.reserve(vec, _readbuf.space());
+    if (count > 0) {
         perf_begin(_perf_uart);
-        if (n1 >= n) {
-            // one read will do
-            assert(_readbuf_tail+n <= _readbuf_size);
-            _read_fd(&_readbuf[_readbuf_tail], n);
-        } else {
-            assert(_readbuf_tail+n1 <= _readbuf_size);
-            int ret = _read_fd(&_readbuf[_readbuf_tail], n1);
-            if (ret == n1 && n > n1) {
-                assert(_readbuf_tail+(n-n1) <= _readbuf_size);
-                _read_fd(&_readbuf[_readbuf_tail], n - n1);                
-            }
+        int ret = _read_fd(vec[0].data, vec[0].len);
+        if (count > 1 && ret == (int)vec[0].len) {
+            _read_fd(vec[1].data, vec[1].len);
         }
         perf_end(_perf_uart);
     }
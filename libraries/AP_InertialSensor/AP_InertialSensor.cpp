@@ -322,6 +322,14 @@ const AP_Param::GroupInfo AP_InertialSensor::var_info[] = {
     // @User: Advanced
     // @Values: 1:IMU 1,2:IMU 2,3:IMU 3
     AP_GROUPINFO("ACC_BODYFIX", 26, AP_InertialSensor, _acc_body_aligned, 2),
+
+    // @Param: FAST_SAMPLE
+    // @DisplayName: Fast sampling mask
+    // @Description: Mask of IMUs to run at the full sensor rate. Backends that support it drain the whole sensor FIFO on each poll so that every sample goes through the filters, and keep a deeper ring of raw samples for vibration and spectrum analysis. This uses more CPU and memory
+    // @Bitmask: 0:IMU1,1:IMU2,2:IMU3
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("FAST_SAMPLE", 27, AP_InertialSensor, _fast_sampling_mask, 0),
     /*
       NOTE: parameter indexes have gaps above. When adding new
       parameters check for conflicts carefully
@@ -379,6 +387,13 @@ AP_InertialSensor::AP_InertialSensor() :
 
         _accel_startup_error_count[i] = 0;
         _gyro_startup_error_count[i] = 0;
+
+        _accel_raw_ring[i] = nullptr;
+        _gyro_raw_ring[i] = nullptr;
+        _accel_cursor[i] = 0;
+        _gyro_cursor[i] = 0;
+        _accel_sample_drops[i] = 0;
+        _gyro_sample_drops[i] = 0;
     }
     for (uint8_t i=0; i<INS_VIBRATION_CHECK_INSTANCES; i++) {
         _accel_vibe_floor_filter[i].set_cutoff_frequency(AP_INERTIAL_SENSOR_ACCEL_VIBE_FLOOR_FILT_HZ);
@@ -409,6 +424,7 @@ uint8_t AP_InertialSensor::register_gyro(uint16_t raw_sample_rate_hz)
         AP_HAL::panic("Too many gyros");
     }
     _gyro_raw_sample_rates[_gyro_count] = raw_sample_rate_hz;
+    _gyro_raw_ring[_gyro_count] = _alloc_raw_ring(_gyro_count, raw_sample_rate_hz);
     return _gyro_count++;
 }
 
@@ -421,9 +437,69 @@ uint8_t AP_InertialSensor::register_accel(uint16_t raw_sample_rate_hz)
         AP_HAL::panic("Too many accels");
     }
     _accel_raw_sample_rates[_accel_count] = raw_sample_rate_hz;
+    _accel_raw_ring[_accel_count] = _alloc_raw_ring(_accel_count, raw_sample_rate_hz);
     return _accel_count++;
 }
 
+/*
+  allocate the raw sample ring of an instance as it registers. A fast
+  sampling instance gets a ring deep enough for INS_SAMPLE_RING_MS of
+  samples at the rate its backend actually runs, up to
+  INS_RAW_SAMPLE_RING_SIZE, so setting the mask for a backend that
+  can't sample fast costs no memory. If the deeper ring can't be
+  allocated we fall back to the normal one, and if that fails too the
+  instance is left without a ring and never becomes healthy
+ */
+AP_InertialSensor_SampleRing *AP_InertialSensor::_alloc_raw_ring(uint8_t instance, uint16_t raw_sample_rate_hz)
+{
+    uint16_t size = INS_SAMPLE_RING_SIZE;
+    if (fast_sampling_enabled(instance)) {
+        uint32_t wanted = (uint32_t)raw_sample_rate_hz * INS_SAMPLE_RING_MS / 1000;
+        size = constrain_int32(wanted, INS_SAMPLE_RING_SIZE, INS_RAW_SAMPLE_RING_SIZE);
+    }
+
+    while (true) {
+        AP_InertialSensor_SampleRing *ring = new AP_InertialSensor_SampleRing(size);
+        if (ring != nullptr && ring->initialised()) {
+            return ring;
+        }
+        delete ring;
+        if (size == INS_SAMPLE_RING_SIZE) {
+            break;
+        }
+        size = INS_SAMPLE_RING_SIZE;
+    }
+    hal.console->printf("INS: unable to allocate sample ring, instance %u disabled\n",
+                        (unsigned)instance);
+    return nullptr;
+}
+
+/*
+  read a batch of raw gyro samples
+ */
+uint16_t AP_InertialSensor::get_raw_gyro_batch(uint8_t instance, uint32_t &cursor,
+                                               AP_InertialSensor_SampleRing::sample *samples,
+                                               uint16_t max_samples, uint32_t *dropped)
+{
+    if (instance >= _gyro_count || _gyro_raw_ring[instance] == nullptr) {
+        return 0;
+    }
+    return _gyro_raw_ring[instance]->read(cursor, samples, max_samples, dropped);
+}
+
+/*
+  read a batch of raw accel samples
+ */
+uint16_t AP_InertialSensor::get_raw_accel_batch(uint8_t instance, uint32_t &cursor,
+                                                AP_InertialSensor_SampleRing::sample *samples,
+                                                uint16_t max_samples, uint32_t *dropped)
+{
+    if (instance >= _accel_count || _accel_raw_ring[instance] == nullptr) {
+        return 0;
+    }
+    return _accel_raw_ring[instance]->read(cursor, samples, max_samples, dropped);
+}
+
 /*
  * Start all backends for gyro and accel measurements. It automatically calls
  * detect_backends() if it has not been called already.
@@ -1066,10 +1142,24 @@ check_sample:
             for (uint8_t i=0; i<_backend_count; i++) {
                 _backends[i]->accumulate();
             }
-            for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
-                gyro_available |= _new_gyro_data[i];
-                accel_available |= _new_accel_data[i];
+            // an instance without a ring never has samples, so don't
+            // wait on it. If every instance is disabled don't wait at all
+            bool have_gyro_ring = false;
+            bool have_accel_ring = false;
+            for (uint8_t i=0; i<_gyro_count; i++) {
+                if (_gyro_raw_ring[i] != nullptr) {
+                    have_gyro_ring = true;
+                    gyro_available |= _gyro_raw_ring[i]->pending(_gyro_cursor[i]);
+                }
+            }
+            for (uint8_t i=0; i<_accel_count; i++) {
+                if (_accel_raw_ring[i] != nullptr) {
+                    have_accel_ring = true;
+                    accel_available |= _accel_raw_ring[i]->pending(_accel_cursor[i]);
+                }
             }
+            gyro_available |= !have_gyro_ring;
+            accel_available |= !have_accel_ring;
             if (!gyro_available || !accel_available) {
                 hal.scheduler->delay_microseconds(100);
             }
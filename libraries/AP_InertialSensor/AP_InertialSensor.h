@@ -16,15 +16,22 @@
 #define INS_MAX_INSTANCES 3
 #define INS_MAX_BACKENDS  6
 #define INS_VIBRATION_CHECK_INSTANCES 2
+#define INS_RAW_SAMPLE_RING_SIZE 256    // most raw samples kept per instance when fast sampling
+#define INS_SAMPLE_RING_SIZE 64         // raw samples kept per instance otherwise
+#define INS_SAMPLE_RING_MS 32           // time a fast sampling ring should cover
+#define INS_SAMPLE_BATCH 16             // samples consumed at a time by the frontend
 
 #include <stdint.h>
 
 #include <AP_AccelCal/AP_AccelCal.h>
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
+#include <Filter/BiquadFilterBank.h>
 #include <Filter/LowPassFilter2p.h>
 #include <Filter/LowPassFilter.h>
 
+#include "AP_InertialSensor_SampleRing.h"
+
 class AP_InertialSensor_Backend;
 class AuxiliaryBus;
 
@@ -209,6 +216,29 @@ public:
     // check for vibration movement. True when all axis show nearly zero movement
     bool is_still();
 
+    // number of raw samples lost because the main loop fell behind
+    uint32_t get_accel_sample_drops(uint8_t instance) const { return _accel_sample_drops[instance]; }
+    uint32_t get_gyro_sample_drops(uint8_t instance) const { return _gyro_sample_drops[instance]; }
+
+    // return true if fast sampling is requested for an IMU instance
+    bool fast_sampling_enabled(uint8_t instance) const { return (_fast_sampling_mask & (1U<<instance)) != 0; }
+
+    /*
+      retrieve a batch of raw samples at the native sensor rate. The
+      ring holds INS_SAMPLE_RING_MS of samples, up to
+      INS_RAW_SAMPLE_RING_SIZE, for instances with fast sampling
+      enabled and INS_SAMPLE_RING_SIZE samples otherwise. cursor
+      is owned by the caller and should start at zero; it is advanced
+      by the number of samples returned. dropped, if not null, is set
+      to the number of samples missed since the last call
+     */
+    uint16_t get_raw_gyro_batch(uint8_t instance, uint32_t &cursor,
+                                AP_InertialSensor_SampleRing::sample *samples,
+                                uint16_t max_samples, uint32_t *dropped = nullptr);
+    uint16_t get_raw_accel_batch(uint8_t instance, uint32_t &cursor,
+                                 AP_InertialSensor_SampleRing::sample *samples,
+                                 uint16_t max_samples, uint32_t *dropped = nullptr);
+
     /*
       HIL set functions. The minimum for HIL is set_accel() and
       set_gyro(). The others are option for higher fidelity log
@@ -259,6 +289,9 @@ private:
     // gyro initialisation
     void _init_gyro();
 
+    // allocate the raw sample ring of an instance
+    AP_InertialSensor_SampleRing *_alloc_raw_ring(uint8_t instance, uint16_t raw_sample_rate_hz);
+
     // Calibration routines borrowed from Rolfe Schmidt
     // blog post describing the method: http://chionophilous.wordpress.com/2011/10/24/accelerometer-calibration-iv-1-implementing-gauss-newton-on-an-atmega/
     // original sketch available at http://rolfeschmidt.com/mathtools/skimetrics/adxl_gn_calibration.pde
@@ -292,13 +325,22 @@ private:
     // time accumulator for delta velocity accumulator
     float _delta_velocity_acc_dt[INS_MAX_INSTANCES];
 
-    // Low Pass filters for gyro and accel
-    LowPassFilter2pVector3f _accel_filter[INS_MAX_INSTANCES];
-    LowPassFilter2pVector3f _gyro_filter[INS_MAX_INSTANCES];
+    // Low Pass filters for gyro and accel, three channels per instance
+    BiquadFilterBank<3*INS_MAX_INSTANCES, 1> _accel_filter;
+    BiquadFilterBank<3*INS_MAX_INSTANCES, 1> _gyro_filter;
     Vector3f _accel_filtered[INS_MAX_INSTANCES];
     Vector3f _gyro_filtered[INS_MAX_INSTANCES];
-    bool _new_accel_data[INS_MAX_INSTANCES];
-    bool _new_gyro_data[INS_MAX_INSTANCES];
+
+    // raw samples queued by the backends, and how far the frontend
+    // has consumed them
+    AP_InertialSensor_SampleRing *_accel_raw_ring[INS_MAX_INSTANCES];
+    AP_InertialSensor_SampleRing *_gyro_raw_ring[INS_MAX_INSTANCES];
+    uint32_t _accel_cursor[INS_MAX_INSTANCES];
+    uint32_t _gyro_cursor[INS_MAX_INSTANCES];
+
+    // samples lost because the frontend fell behind the backends
+    uint32_t _accel_sample_drops[INS_MAX_INSTANCES];
+    uint32_t _gyro_sample_drops[INS_MAX_INSTANCES];
 
     // Most recent gyro reading
     Vector3f _gyro[INS_MAX_INSTANCES];
@@ -334,6 +376,9 @@ private:
     AP_Int8     _gyro_filter_cutoff;
     AP_Int8     _gyro_cal_timing;
 
+    // bitmask of IMU instances to run at the full sensor rate
+    AP_Int8     _fast_sampling_mask;
+
     // use for attitude, velocity, position estimates
     AP_Int8     _use[INS_MAX_INSTANCES];
 
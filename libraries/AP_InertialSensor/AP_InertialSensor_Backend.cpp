@@ -58,17 +58,45 @@ void AP_InertialSensor_Backend::_publish_gyro(uint8_t instance, const Vector3f &
     _imu._delta_angle_valid[instance] = true;
 }
 
+/*
+  queue a raw gyro sample for the frontend. This may be called from
+  the timer thread, so it only pushes the sample into the lock-free
+  ring; integration and filtering happen in update_gyro()
+ */
 void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
                                                             const Vector3f &gyro,
                                                             uint64_t sample_us)
 {
-    float dt;
-
     if (_imu._gyro_raw_sample_rates[instance] <= 0) {
         return;
     }
 
-    dt = 1.0f / _imu._gyro_raw_sample_rates[instance];
+    uint64_t now = AP_HAL::micros64();
+
+    if (_imu._gyro_raw_ring[instance] != nullptr) {
+        _imu._gyro_raw_ring[instance]->push(gyro, sample_us?sample_us:now);
+    }
+
+    DataFlash_Class *dataflash = get_dataflash();
+    if (dataflash != NULL) {
+        struct log_GYRO pkt = {
+            LOG_PACKET_HEADER_INIT((uint8_t)(LOG_GYR1_MSG+instance)),
+            time_us   : now,
+            sample_us : sample_us?sample_us:now,
+            GyrX      : gyro.x,
+            GyrY      : gyro.y,
+            GyrZ      : gyro.z
+        };
+        dataflash->WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+
+/*
+  integrate one raw gyro sample. Called from the main thread only
+ */
+void AP_InertialSensor_Backend::_accumulate_gyro_sample(uint8_t instance, const Vector3f &gyro)
+{
+    float dt = 1.0f / _imu._gyro_raw_sample_rates[instance];
 
     // compute delta angle
     Vector3f delta_angle = (gyro + _imu._last_raw_gyro[instance]) * 0.5f * dt;
@@ -93,27 +121,6 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
     // save previous delta angle for coning correction
     _imu._last_delta_angle[instance] = delta_angle;
     _imu._last_raw_gyro[instance] = gyro;
-
-    _imu._gyro_filtered[instance] = _imu._gyro_filter[instance].apply(gyro);
-    if (_imu._gyro_filtered[instance].is_nan() || _imu._gyro_filtered[instance].is_inf()) {
-        _imu._gyro_filter[instance].reset();
-    }
-
-    _imu._new_gyro_data[instance] = true;
-
-    DataFlash_Class *dataflash = get_dataflash();
-    if (dataflash != NULL) {
-        uint64_t now = AP_HAL::micros64();
-        struct log_GYRO pkt = {
-            LOG_PACKET_HEADER_INIT((uint8_t)(LOG_GYR1_MSG+instance)),
-            time_us   : now,
-            sample_us : sample_us?sample_us:now,
-            GyrX      : gyro.x,
-            GyrY      : gyro.y,
-            GyrZ      : gyro.z
-        };
-        dataflash->WriteBlock(&pkt, sizeof(pkt));
-    }
 }
 
 /*
@@ -153,36 +160,26 @@ void AP_InertialSensor_Backend::_publish_accel(uint8_t instance, const Vector3f
     }
 }
 
+/*
+  queue a raw accel sample for the frontend, see
+  _notify_new_gyro_raw_sample()
+ */
 void AP_InertialSensor_Backend::_notify_new_accel_raw_sample(uint8_t instance,
                                                              const Vector3f &accel,
                                                              uint64_t sample_us)
 {
-    float dt;
-
     if (_imu._accel_raw_sample_rates[instance] <= 0) {
         return;
     }
 
-    dt = 1.0f / _imu._accel_raw_sample_rates[instance];
-
-    _imu.calc_vibration_and_clipping(instance, accel, dt);
-
-    // delta velocity
-    _imu._delta_velocity_acc[instance] += accel * dt;
-    _imu._delta_velocity_acc_dt[instance] += dt;
+    uint64_t now = AP_HAL::micros64();
 
-    _imu._accel_filtered[instance] = _imu._accel_filter[instance].apply(accel);
-    if (_imu._accel_filtered[instance].is_nan() || _imu._accel_filtered[instance].is_inf()) {
-        _imu._accel_filter[instance].reset();
+    if (_imu._accel_raw_ring[instance] != nullptr) {
+        _imu._accel_raw_ring[instance]->push(accel, sample_us?sample_us:now);
     }
 
-    _imu.set_accel_peak_hold(instance, _imu._accel_filtered[instance]);
-
-    _imu._new_accel_data[instance] = true;
-
     DataFlash_Class *dataflash = get_dataflash();
     if (dataflash != NULL) {
-        uint64_t now = AP_HAL::micros64();
         struct log_ACCEL pkt = {
             LOG_PACKET_HEADER_INIT((uint8_t)(LOG_ACC1_MSG+instance)),
             time_us   : now,
@@ -195,6 +192,20 @@ void AP_InertialSensor_Backend::_notify_new_accel_raw_sample(uint8_t instance,
     }
 }
 
+/*
+  integrate one raw accel sample. Called from the main thread only
+ */
+void AP_InertialSensor_Backend::_accumulate_accel_sample(uint8_t instance, const Vector3f &accel)
+{
+    float dt = 1.0f / _imu._accel_raw_sample_rates[instance];
+
+    _imu.calc_vibration_and_clipping(instance, accel, dt);
+
+    // delta velocity
+    _imu._delta_velocity_acc[instance] += accel * dt;
+    _imu._delta_velocity_acc_dt[instance] += dt;
+}
+
 void AP_InertialSensor_Backend::_set_accel_max_abs_offset(uint8_t instance,
                                                           float max_offset)
 {
@@ -229,43 +240,103 @@ void AP_InertialSensor_Backend::_publish_temperature(uint8_t instance, float tem
 }
 
 /*
-  common gyro update function for all backends
+  common gyro update function for all backends. This consumes the
+  samples queued since the last call and publishes the result
  */
 void AP_InertialSensor_Backend::update_gyro(uint8_t instance)
-{    
-    hal.scheduler->suspend_timer_procs();
-
-    if (_imu._new_gyro_data[instance]) {
-        _publish_gyro(instance, _imu._gyro_filtered[instance]);
-        _imu._new_gyro_data[instance] = false;
-    }
-
+{
     // possibly update filter frequency
     if (_last_gyro_filter_hz[instance] != _gyro_filter_cutoff()) {
-        _imu._gyro_filter[instance].set_cutoff_frequency(_gyro_raw_sample_rate(instance), _gyro_filter_cutoff());
+        _imu._gyro_filter.set_lowpass(0, instance*3, 3, _gyro_raw_sample_rate(instance), _gyro_filter_cutoff());
         _last_gyro_filter_hz[instance] = _gyro_filter_cutoff();
     }
 
-    hal.scheduler->resume_timer_procs();
+    AP_InertialSensor_SampleRing *ring = _imu._gyro_raw_ring[instance];
+    if (ring == nullptr) {
+        return;
+    }
+
+    AP_InertialSensor_SampleRing::sample samples[INS_SAMPLE_BATCH];
+    float filtered[INS_SAMPLE_BATCH*3];
+    uint32_t dropped;
+    uint16_t n;
+    bool have_sample = false;
+    do {
+        n = ring->read(_imu._gyro_cursor[instance], samples, INS_SAMPLE_BATCH, &dropped);
+        _imu._gyro_sample_drops[instance] += dropped;
+        if (n == 0) {
+            break;
+        }
+        for (uint16_t i = 0; i < n; i++) {
+            _accumulate_gyro_sample(instance, samples[i].v);
+            filtered[i*3]   = samples[i].v.x;
+            filtered[i*3+1] = samples[i].v.y;
+            filtered[i*3+2] = samples[i].v.z;
+        }
+
+        // filter the whole batch in one call, keeping the newest output
+        _imu._gyro_filter.apply(filtered, instance*3, 3, n);
+        const float *last = &filtered[(n-1)*3];
+        _imu._gyro_filtered[instance] = Vector3f(last[0], last[1], last[2]);
+        if (_imu._gyro_filtered[instance].is_nan() || _imu._gyro_filtered[instance].is_inf()) {
+            _imu._gyro_filter.reset(instance*3, 3);
+        }
+        have_sample = true;
+    } while (n == INS_SAMPLE_BATCH);
+
+    if (have_sample) {
+        _publish_gyro(instance, _imu._gyro_filtered[instance]);
+    }
 }
 
 /*
   common accel update function for all backends
  */
 void AP_InertialSensor_Backend::update_accel(uint8_t instance)
-{    
-    hal.scheduler->suspend_timer_procs();
-
-    if (_imu._new_accel_data[instance]) {
-        _publish_accel(instance, _imu._accel_filtered[instance]);
-        _imu._new_accel_data[instance] = false;
-    }
-    
+{
     // possibly update filter frequency
     if (_last_accel_filter_hz[instance] != _accel_filter_cutoff()) {
-        _imu._accel_filter[instance].set_cutoff_frequency(_accel_raw_sample_rate(instance), _accel_filter_cutoff());
+        _imu._accel_filter.set_lowpass(0, instance*3, 3, _accel_raw_sample_rate(instance), _accel_filter_cutoff());
         _last_accel_filter_hz[instance] = _accel_filter_cutoff();
     }
 
-    hal.scheduler->resume_timer_procs();
+    AP_InertialSensor_SampleRing *ring = _imu._accel_raw_ring[instance];
+    if (ring == nullptr) {
+        return;
+    }
+
+    AP_InertialSensor_SampleRing::sample samples[INS_SAMPLE_BATCH];
+    float filtered[INS_SAMPLE_BATCH*3];
+    uint32_t dropped;
+    uint16_t n;
+    bool have_sample = false;
+    do {
+        n = ring->read(_imu._accel_cursor[instance], samples, INS_SAMPLE_BATCH, &dropped);
+        _imu._accel_sample_drops[instance] += dropped;
+        if (n == 0) {
+            break;
+        }
+        for (uint16_t i = 0; i < n; i++) {
+            _accumulate_accel_sample(instance, samples[i].v);
+            filtered[i*3]   = samples[i].v.x;
+            filtered[i*3+1] = samples[i].v.y;
+            filtered[i*3+2] = samples[i].v.z;
+        }
+
+        // filter the whole batch in one call, then hold the peaks of every output
+        _imu._accel_filter.apply(filtered, instance*3, 3, n);
+        for (uint16_t i = 0; i < n; i++) {
+            _imu.set_accel_peak_hold(instance, Vector3f(filtered[i*3], filtered[i*3+1], filtered[i*3+2]));
+        }
+        const float *last = &filtered[(n-1)*3];
+        _imu._accel_filtered[instance] = Vector3f(last[0], last[1], last[2]);
+        if (_imu._accel_filtered[instance].is_nan() || _imu._accel_filtered[instance].is_inf()) {
+            _imu._accel_filter.reset(instance*3, 3);
+        }
+        have_sample = true;
+    } while (n == INS_SAMPLE_BATCH);
+
+    if (have_sample) {
+        _publish_accel(instance, _imu._accel_filtered[instance]);
+    }
 }
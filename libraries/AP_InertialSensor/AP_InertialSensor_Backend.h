@@ -88,6 +88,9 @@ protected:
     // be rotated and corrected (_rotate_and_correct_gyro)
     void _notify_new_gyro_raw_sample(uint8_t instance, const Vector3f &accel, uint64_t sample_us=0);
 
+    // integrate a queued gyro sample, filtering is done per batch in update_gyro()
+    void _accumulate_gyro_sample(uint8_t instance, const Vector3f &gyro);
+
     // rotate accel vector, scale, offset and publish
     void _publish_accel(uint8_t instance, const Vector3f &accel);
 
@@ -97,6 +100,9 @@ protected:
     // be rotated and corrected (_rotate_and_correct_accel)
     void _notify_new_accel_raw_sample(uint8_t instance, const Vector3f &accel, uint64_t sample_us=0);
 
+    // integrate a queued accel sample, filtering is done per batch in update_accel()
+    void _accumulate_accel_sample(uint8_t instance, const Vector3f &accel);
+
     // set accelerometer max absolute offset for calibration
     void _set_accel_max_abs_offset(uint8_t instance, float offset);
 
@@ -76,6 +76,11 @@ extern const AP_HAL::HAL &hal;
 #define MPUREG_ZRMOT_THR                                0x21    // detection threshold for Zero Motion interrupt generation.
 #define MPUREG_ZRMOT_DUR                                0x22    // duration counter threshold for Zero Motion interrupt generation. The duration counter ticks at 16 Hz, therefore ZRMOT_DUR has a unit of 1 LSB = 64 ms.
 #define MPUREG_FIFO_EN                                  0x23
+#       define BIT_TEMP_FIFO_EN                                 0x80
+#       define BIT_XG_FIFO_EN                                   0x40
+#       define BIT_YG_FIFO_EN                                   0x20
+#       define BIT_ZG_FIFO_EN                                   0x10
+#       define BIT_ACCEL_FIFO_EN                                0x08
 #define MPUREG_INT_PIN_CFG                              0x37
 #       define BIT_INT_RD_CLEAR                                 0x10    // clear the interrupt when any read occurs
 #       define BIT_LATCH_INT_EN                                 0x20    // latch data ready pin
@@ -180,8 +185,16 @@ extern const AP_HAL::HAL &hal;
 #define DEFAULT_SMPLRT_DIV MPUREG_SMPLRT_1000HZ
 #define DEFAULT_SAMPLE_RATE (1000 / (DEFAULT_SMPLRT_DIV + 1))
 
+/*
+ * With DLPF_CFG 0 the gyro is sampled internally at 8kHz and SMPLRT_DIV is
+ * ignored, so the FIFO fills at 8kHz. The accel is only updated at 1kHz and
+ * is repeated in between, which is equivalent to a zero-order hold.
+ */
+#define FAST_SAMPLE_RATE 8000
+
 #define MPU9250_SAMPLE_SIZE 14
-#define MPU9250_MAX_FIFO_SAMPLES 3
+#define MPU9250_FIFO_SIZE 512
+#define MPU9250_MAX_FIFO_SAMPLES (MPU9250_FIFO_SIZE / MPU9250_SAMPLE_SIZE)
 #define MAX_DATA_READ (MPU9250_MAX_FIFO_SAMPLES * MPU9250_SAMPLE_SIZE)
 
 #define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
@@ -208,6 +221,11 @@ AP_InertialSensor_MPU9250::AP_InertialSensor_MPU9250(AP_InertialSensor &imu,
     : AP_InertialSensor_Backend(imu)
     , _read_flag(read_flag)
     , _bus_type(type)
+    , _fast_sampling(false)
+    , _sample_period_us(1000000UL / DEFAULT_SAMPLE_RATE)
+    , _fifo_buffer(nullptr)
+    , _fifo_overflow_count(0)
+    , _perf_read(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "MPU9250_read"))
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
     , _default_rotation(ROTATION_ROLL_180_YAW_270)
 #elif CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NAVIO
@@ -230,6 +248,7 @@ AP_InertialSensor_MPU9250::AP_InertialSensor_MPU9250(AP_InertialSensor &imu,
 AP_InertialSensor_MPU9250::~AP_InertialSensor_MPU9250()
 {
     delete _auxiliary_bus;
+    delete[] _fifo_buffer;
 }
 
 AP_InertialSensor_Backend *AP_InertialSensor_MPU9250::probe(AP_InertialSensor &imu,
@@ -274,6 +293,23 @@ bool AP_InertialSensor_MPU9250::_init()
     return success;
 }
 
+void AP_InertialSensor_MPU9250::_fifo_reset()
+{
+    uint8_t user_ctrl = _register_read(MPUREG_USER_CTRL);
+    user_ctrl &= ~BIT_USER_CTRL_FIFO_EN;
+    _register_write(MPUREG_USER_CTRL, user_ctrl);
+    _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_RESET);
+    _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_EN);
+}
+
+void AP_InertialSensor_MPU9250::_fifo_enable()
+{
+    _register_write(MPUREG_FIFO_EN, BIT_XG_FIFO_EN | BIT_YG_FIFO_EN |
+                    BIT_ZG_FIFO_EN | BIT_ACCEL_FIFO_EN | BIT_TEMP_FIFO_EN);
+    _fifo_reset();
+    hal.scheduler->delay(1);
+}
+
 bool AP_InertialSensor_MPU9250::_has_auxiliary_bus()
 {
     return _bus_type != BUS_TYPE_I2C;
@@ -283,6 +319,16 @@ void AP_InertialSensor_MPU9250::start()
 {
     hal.scheduler->suspend_timer_procs();
 
+    // the instances we are about to register decide the sampling mode
+    if (_imu.fast_sampling_enabled(_imu.get_gyro_count()) ||
+        _imu.fast_sampling_enabled(_imu.get_accel_count())) {
+        _fifo_buffer = new uint8_t[MAX_DATA_READ];
+        _fast_sampling = _fifo_buffer != nullptr;
+    }
+    if (_fast_sampling) {
+        _sample_period_us = 1000000UL / FAST_SAMPLE_RATE;
+    }
+
     if (!_dev->get_semaphore()->take(100)) {
         AP_HAL::panic("MPU92500: Unable to get semaphore");
     }
@@ -311,8 +357,14 @@ void AP_InertialSensor_MPU9250::start()
     // RM-MPU-9250A-00.pdf, pg. 15, select accel full scale 16g
     _register_write(MPUREG_ACCEL_CONFIG,3<<3);
 
-    // configure interrupt to fire when new data arrives
-    _register_write(MPUREG_INT_ENABLE, BIT_RAW_RDY_EN);
+    if (_fast_sampling) {
+        // also latch FIFO overflows so that they can be detected and reset
+        _register_write(MPUREG_INT_ENABLE, BIT_RAW_RDY_EN | BIT_FIFO_OFLOW_EN);
+        _fifo_enable();
+    } else {
+        // configure interrupt to fire when new data arrives
+        _register_write(MPUREG_INT_ENABLE, BIT_RAW_RDY_EN);
+    }
 
     // clear interrupt on any read, and hold the data ready pin high
     // until we clear the interrupt
@@ -326,8 +378,9 @@ void AP_InertialSensor_MPU9250::start()
     _dev->get_semaphore()->give();
 
     // grab the used instances
-    _gyro_instance = _imu.register_gyro(DEFAULT_SAMPLE_RATE);
-    _accel_instance = _imu.register_accel(DEFAULT_SAMPLE_RATE);
+    uint16_t rate = _fast_sampling ? FAST_SAMPLE_RATE : DEFAULT_SAMPLE_RATE;
+    _gyro_instance = _imu.register_gyro(rate);
+    _accel_instance = _imu.register_accel(rate);
 
     hal.scheduler->resume_timer_procs();
 
@@ -383,30 +436,92 @@ void AP_InertialSensor_MPU9250::_poll_data()
         return;
     }
 
-    _read_sample();
+    hal.util->perf_begin(_perf_read);
+    if (_fast_sampling) {
+        _read_fifo();
+    } else {
+        _read_sample();
+    }
+    hal.util->perf_end(_perf_read);
 
     _dev->get_semaphore()->give();
 }
 
-void AP_InertialSensor_MPU9250::_accumulate(uint8_t *rx)
+/*
+ * Feed a block of samples to the frontend. Samples are evenly spaced at the
+ * sensor rate, the last one having been taken at last_sample_us
+ */
+void AP_InertialSensor_MPU9250::_accumulate(uint8_t *samples, uint8_t n_samples,
+                                            uint64_t last_sample_us)
+{
+    for (uint8_t i = 0; i < n_samples; i++) {
+        uint8_t *rx = samples + MPU9250_SAMPLE_SIZE * i;
+        uint64_t sample_us = last_sample_us - (uint64_t)(n_samples - 1 - i) * _sample_period_us;
+        Vector3f accel, gyro;
+
+        accel = Vector3f(int16_val(rx, 1),
+                         int16_val(rx, 0),
+                         -int16_val(rx, 2));
+        accel *= MPU9250_ACCEL_SCALE_1G;
+        accel.rotate(_default_rotation);
+        _rotate_and_correct_accel(_accel_instance, accel);
+        _notify_new_accel_raw_sample(_accel_instance, accel, sample_us);
+
+        gyro = Vector3f(int16_val(rx, 5),
+                        int16_val(rx, 4),
+                        -int16_val(rx, 6));
+        gyro *= GYRO_SCALE;
+        gyro.rotate(_default_rotation);
+        _rotate_and_correct_gyro(_gyro_instance, gyro);
+        _notify_new_gyro_raw_sample(_gyro_instance, gyro, sample_us);
+    }
+}
+
+/*
+ * Drain every complete sample from the FIFO in a single transfer so that the
+ * filters see the full sensor rate rather than a decimated (and aliased) copy
+ */
+void AP_InertialSensor_MPU9250::_read_fifo()
 {
-    Vector3f accel, gyro;
+    uint8_t int_status;
+    uint8_t count[2];
+
+    if (!_block_read(MPUREG_INT_STATUS, &int_status, 1) ||
+        !_block_read(MPUREG_FIFO_COUNTH, count, 2)) {
+        hal.console->printf("MPU9250: error in fifo read\n");
+        return;
+    }
+
+    if (int_status & BIT_FIFO_OFLOW_INT) {
+        /* the FIFO wrapped, so the sample boundaries can't be trusted */
+        _fifo_overflow_count++;
+        _set_gyro_error_count(_gyro_instance, _fifo_overflow_count);
+        _set_accel_error_count(_accel_instance, _fifo_overflow_count);
+        _fifo_reset();
+        return;
+    }
+
+    uint16_t bytes_read = uint16_val(count, 0) & 0x1FFF;
+    uint16_t n_samples = bytes_read / MPU9250_SAMPLE_SIZE;
+
+    if (n_samples == 0) {
+        /* Not enough data in FIFO */
+        return;
+    }
 
-    accel = Vector3f(int16_val(rx, 1),
-                     int16_val(rx, 0),
-                     -int16_val(rx, 2));
-    accel *= MPU9250_ACCEL_SCALE_1G;
-    accel.rotate(_default_rotation);
-    _rotate_and_correct_accel(_accel_instance, accel);
-    _notify_new_accel_raw_sample(_accel_instance, accel);
+    if (n_samples > MPU9250_MAX_FIFO_SAMPLES) {
+        n_samples = MPU9250_MAX_FIFO_SAMPLES;
+    }
+
+    uint64_t now = AP_HAL::micros64();
+
+    if (!_block_read(MPUREG_FIFO_R_W, _fifo_buffer, n_samples * MPU9250_SAMPLE_SIZE)) {
+        hal.console->printf("MPU9250: error in fifo read %u bytes\n",
+                            (unsigned)(n_samples * MPU9250_SAMPLE_SIZE));
+        return;
+    }
 
-    gyro = Vector3f(int16_val(rx, 5),
-                    int16_val(rx, 4),
-                    -int16_val(rx, 6));
-    gyro *= GYRO_SCALE;
-    gyro.rotate(_default_rotation);
-    _rotate_and_correct_gyro(_gyro_instance, gyro);
-    _notify_new_gyro_raw_sample(_gyro_instance, gyro);
+    _accumulate(_fifo_buffer, n_samples, now);
 }
 
 
@@ -430,7 +545,7 @@ void AP_InertialSensor_MPU9250::_read_sample()
         return;
     }
 
-    _accumulate(rx.d);
+    _accumulate(rx.d, 1, AP_HAL::micros64());
 }
 
 bool AP_InertialSensor_MPU9250::_block_read(uint8_t reg, uint8_t *buf,
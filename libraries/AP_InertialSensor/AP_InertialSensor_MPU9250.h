@@ -67,8 +67,13 @@ private:
     bool _hardware_init();
 
     void _set_filter_register(uint16_t filter_hz);
+    void _fifo_reset();
+    void _fifo_enable();
     bool _has_auxiliary_bus();
 
+    /* Drain all samples from FIFO (fast sampling) */
+    void _read_fifo();
+
     /* Read a single sample */
     void _read_sample();
 
@@ -86,7 +91,7 @@ private:
     void _register_write(uint8_t reg, uint8_t val );
     void _register_write_check(uint8_t reg, uint8_t val);
 
-    void _accumulate(uint8_t *sample);
+    void _accumulate(uint8_t *samples, uint8_t n_samples, uint64_t last_sample_us);
 
     // instance numbers of accel and gyro data
     uint8_t _gyro_instance;
@@ -95,6 +100,19 @@ private:
     const uint8_t _read_flag;
     const enum bus_type _bus_type;
 
+    // true when running at the full sensor rate from the FIFO
+    bool _fast_sampling;
+
+    // sensor sample period in microseconds
+    uint32_t _sample_period_us;
+
+    // buffer large enough to drain the whole FIFO in one transfer
+    uint8_t *_fifo_buffer;
+
+    uint32_t _fifo_overflow_count;
+
+    AP_HAL::Util::perf_counter_t _perf_read;
+
     // The default rotation for the IMU, its value depends on how the IMU is
     // placed by default on the system
     enum Rotation _default_rotation;
@@ -0,0 +1,58 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  ring of raw (rotated and corrected, but unfiltered) IMU samples at
+  the native sensor rate.
+
+  The ring is written by the backend, usually from the timer thread,
+  and read without locking by the frontend, which integrates and
+  filters every sample, and by any number of other consumers
+  (vibration analysis, FFT, strain correlation...). Each consumer
+  keeps its own cursor, which is the total number of samples it has
+  consumed so far. If a consumer falls more than the ring size behind,
+  the oldest samples are lost and the number of samples skipped is
+  reported back.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <AP_HAL/utility/SampleChannel.h>
+#include <AP_Math/AP_Math.h>
+
+struct AP_InertialSensor_RawSample {
+    uint64_t sample_us;
+    Vector3f v;
+};
+
+class AP_InertialSensor_SampleRing : public SampleChannel<AP_InertialSensor_RawSample>
+{
+public:
+    typedef AP_InertialSensor_RawSample sample;
+
+    AP_InertialSensor_SampleRing(uint16_t size) :
+        SampleChannel<AP_InertialSensor_RawSample>(size)
+    {}
+
+    // add a sample, overwriting the oldest one when full
+    void push(const Vector3f &v, uint64_t sample_us) {
+        sample s;
+        s.sample_us = sample_us;
+        s.v = v;
+        SampleChannel<AP_InertialSensor_RawSample>::push(s);
+    }
+};
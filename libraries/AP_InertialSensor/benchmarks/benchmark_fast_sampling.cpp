@@ -0,0 +1,191 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <Filter/BiquadFilterBank.h>
+#include <AP_InertialSensor/AP_InertialSensor.h>
+
+#define BM_SAMPLE_SIZE 14   // accel, temperature and gyro, as read from an MPU9250
+#define BM_MAX_SAMPLES 8
+
+#define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
+
+static const float BM_ACCEL_SCALE_1G = GRAVITY_MSS / 2048.0f;
+static const float BM_GYRO_SCALE = 0.0174532f / 16.4f;
+
+/*
+ * State of one accel and gyro instance, from the backend through the
+ * frontend. Channels 0-2 of the filter are the accel, 3-5 the gyro
+ */
+struct bm_imu {
+    bm_imu(uint16_t ring_size) :
+        accel_ring(ring_size),
+        gyro_ring(ring_size)
+    {}
+
+    AP_InertialSensor_SampleRing accel_ring;
+    AP_InertialSensor_SampleRing gyro_ring;
+    uint32_t accel_cursor = 0;
+    uint32_t gyro_cursor = 0;
+    BiquadFilterBank<6, 1> filter;
+
+    Vector3f accel_offset = Vector3f(0.1f, -0.05f, 0.2f);
+    Vector3f accel_scale = Vector3f(1.01f, 0.99f, 1.0f);
+    Vector3f gyro_offset = Vector3f(0.001f, -0.002f, 0.0005f);
+
+    Vector3f delta_angle_acc;
+    Vector3f last_delta_angle;
+    Vector3f last_raw_gyro;
+    float delta_angle_acc_dt = 0;
+    Vector3f delta_velocity_acc;
+    float delta_velocity_acc_dt = 0;
+    Vector3f gyro_filtered;
+    Vector3f accel_filtered;
+};
+
+/*
+ * backend: decode a block of samples read from the FIFO, rotate and
+ * correct them and queue them for the frontend, as
+ * AP_InertialSensor_MPU9250::_accumulate() does
+ */
+static void bm_backend(bm_imu &imu, const uint8_t *samples, uint8_t n_samples, uint64_t sample_us)
+{
+    for (uint8_t i = 0; i < n_samples; i++) {
+        const uint8_t *rx = samples + BM_SAMPLE_SIZE * i;
+        Vector3f accel, gyro;
+
+        accel = Vector3f(int16_val(rx, 1),
+                         int16_val(rx, 0),
+                         -int16_val(rx, 2));
+        accel *= BM_ACCEL_SCALE_1G;
+        accel.rotate(ROTATION_NONE);
+        accel -= imu.accel_offset;
+        accel.x *= imu.accel_scale.x;
+        accel.y *= imu.accel_scale.y;
+        accel.z *= imu.accel_scale.z;
+        accel.rotate(ROTATION_NONE);
+        imu.accel_ring.push(accel, sample_us);
+
+        gyro = Vector3f(int16_val(rx, 5),
+                        int16_val(rx, 4),
+                        -int16_val(rx, 6));
+        gyro *= BM_GYRO_SCALE;
+        gyro.rotate(ROTATION_NONE);
+        gyro -= imu.gyro_offset;
+        gyro.rotate(ROTATION_NONE);
+        imu.gyro_ring.push(gyro, sample_us);
+
+        sample_us += 125;
+    }
+}
+
+/*
+ * frontend: consume the queued samples, integrating each one and
+ * filtering each batch, as AP_InertialSensor_Backend::update_gyro() and
+ * update_accel() do. The accel vibration, clipping and peak hold checks
+ * are left out
+ */
+static void bm_frontend(bm_imu &imu, float rate_hz)
+{
+    const float dt = 1.0f / rate_hz;
+    AP_InertialSensor_SampleRing::sample samples[INS_SAMPLE_BATCH];
+    float filtered[INS_SAMPLE_BATCH*3];
+    uint16_t n;
+
+    do {
+        n = imu.gyro_ring.read(imu.gyro_cursor, samples, INS_SAMPLE_BATCH);
+        for (uint16_t i = 0; i < n; i++) {
+            const Vector3f &gyro = samples[i].v;
+            Vector3f delta_angle = (gyro + imu.last_raw_gyro) * 0.5f * dt;
+            Vector3f delta_coning = (imu.delta_angle_acc +
+                                     imu.last_delta_angle * (1.0f / 6.0f));
+            delta_coning = delta_coning % delta_angle;
+            delta_coning *= 0.5f;
+            imu.delta_angle_acc += delta_angle + delta_coning;
+            imu.delta_angle_acc_dt += dt;
+            imu.last_delta_angle = delta_angle;
+            imu.last_raw_gyro = gyro;
+            filtered[i*3]   = gyro.x;
+            filtered[i*3+1] = gyro.y;
+            filtered[i*3+2] = gyro.z;
+        }
+        if (n > 0) {
+            imu.filter.apply(filtered, 3, 3, n);
+            const float *last = &filtered[(n-1)*3];
+            imu.gyro_filtered = Vector3f(last[0], last[1], last[2]);
+            if (imu.gyro_filtered.is_nan() || imu.gyro_filtered.is_inf()) {
+                imu.filter.reset(3, 3);
+            }
+        }
+    } while (n == INS_SAMPLE_BATCH);
+
+    do {
+        n = imu.accel_ring.read(imu.accel_cursor, samples, INS_SAMPLE_BATCH);
+        for (uint16_t i = 0; i < n; i++) {
+            const Vector3f &accel = samples[i].v;
+            imu.delta_velocity_acc += accel * dt;
+            imu.delta_velocity_acc_dt += dt;
+            filtered[i*3]   = accel.x;
+            filtered[i*3+1] = accel.y;
+            filtered[i*3+2] = accel.z;
+        }
+        if (n > 0) {
+            imu.filter.apply(filtered, 0, 3, n);
+            const float *last = &filtered[(n-1)*3];
+            imu.accel_filtered = Vector3f(last[0], last[1], last[2]);
+            if (imu.accel_filtered.is_nan() || imu.accel_filtered.is_inf()) {
+                imu.filter.reset(0, 3);
+            }
+        }
+    } while (n == INS_SAMPLE_BATCH);
+}
+
+/*
+ * Cost of one 1kHz poll of an IMU, from the bytes read out of the sensor
+ * to the filtered values and deltas the frontend publishes, leaving out
+ * the SPI transfer and logging. The argument is the number of samples
+ * delivered per poll: 1 for the data register path, 8 when draining the
+ * FIFO of an 8kHz sensor
+ */
+static void BM_FastSamplingPoll(benchmark::State& state)
+{
+    const uint8_t n_samples = state.range_x();
+    const float rate_hz = 1000.0f * n_samples;
+    bm_imu imu(n_samples > 1 ? 256 : INS_SAMPLE_RING_SIZE);
+    uint8_t fifo[BM_SAMPLE_SIZE * BM_MAX_SAMPLES];
+    uint64_t sample_us = 0;
+
+    imu.filter.set_lowpass(0, 0, 6, rate_hz, 20);
+    for (uint16_t i = 0; i < sizeof(fifo); i++) {
+        fifo[i] = (uint8_t)(i * 37 + 11);
+    }
+
+    while (state.KeepRunning()) {
+        bm_backend(imu, fifo, n_samples, sample_us);
+        bm_frontend(imu, rate_hz);
+        gbenchmark_escape(&imu);
+        sample_us += 1000;
+    }
+}
+
+BENCHMARK(BM_FastSamplingPoll)->Arg(1)->Arg(BM_MAX_SAMPLES);
+
+static void BM_SampleRingRead(benchmark::State& state)
+{
+    AP_InertialSensor_SampleRing ring(256);
+    AP_InertialSensor_SampleRing::sample samples[64];
+    Vector3f v(1.0f, 2.0f, 3.0f);
+    uint32_t cursor = 0;
+
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i < state.range_x(); i++) {
+            ring.push(v, i);
+        }
+        uint16_t n = ring.read(cursor, samples, state.range_x());
+        gbenchmark_escape(&n);
+        gbenchmark_escape(samples);
+    }
+}
+
+BENCHMARK(BM_SampleRingRead)->Arg(8)->Arg(64);
+
+BENCHMARK_MAIN()
@@ -13,8 +13,10 @@
 #include "vector2.h"
 #include "vector3.h"
 #include "matrix3.h"
+#include "matrix_alg.h"
 #include "quaternion.h"
 #include "polygon.h"
+#include "geo_index.h"
 #include "edc.h"
 #include "float.h"
 #include <AP_Param/AP_Param.h>
@@ -114,8 +116,11 @@ bool                    inverse3x3(float m[], float invOut[]);
 // invOut is an inverted 3x3 matrix when returns true, otherwise matrix is Singular
 bool                    inverse4x4(float m[],float invOut[]);
 
-// matrix multiplication of two NxN matrices
-float* mat_mul(float *A, float *B, uint8_t n);
+// matrix multiplication of two NxN matrices, out = A*B. out must not be A or B
+void mat_mul(const float *A, const float *B, float *out, uint8_t n);
+
+// inv is an inverted NxN matrix when returns true, otherwise matrix is Singular. inv may be A
+bool mat_inverse(const float *A, float *inv, uint8_t n);
 
 // see if location is past a line perpendicular to
 // the line between point1 and point2. If point1 is
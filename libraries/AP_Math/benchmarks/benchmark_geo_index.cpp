@@ -0,0 +1,103 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+
+/*
+  a fence of n vertices around a point, with a wavy boundary, closed
+  with V[n]=V[0]
+ */
+static Vector2l *make_fence(uint16_t n)
+{
+    Vector2l *V = new Vector2l[n+1];
+    for (uint16_t i = 0; i < n; i++) {
+        float a = 2 * M_PI_F * i / n;
+        float r = 30000 + 10000 * sinf(5 * a);
+        V[i] = Vector2l(-353632620 + r * cosf(a), 1491652300 + r * sinf(a));
+    }
+    V[n] = V[0];
+    return V;
+}
+
+// a point that moves around the fence, in and out of it
+static Vector2l test_point(uint32_t k)
+{
+    return Vector2l(-353632620 + (int32_t)((k * 37) % 80000) - 40000,
+                    1491652300 + (int32_t)((k * 91) % 80000) - 40000);
+}
+
+static void BM_PolygonOutside(benchmark::State& state)
+{
+    const uint16_t n = state.range_x();
+    Vector2l *V = make_fence(n);
+    uint32_t k = 0;
+
+    while (state.KeepRunning()) {
+        bool outside = Polygon_outside(test_point(k++), V, n+1);
+        gbenchmark_escape(&outside);
+    }
+    delete[] V;
+}
+
+BENCHMARK(BM_PolygonOutside)->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_PolygonIndexOutside(benchmark::State& state)
+{
+    const uint16_t n = state.range_x();
+    Vector2l *V = make_fence(n);
+    PolygonIndex index;
+    index.build(V, n+1);
+    uint32_t k = 0;
+
+    while (state.KeepRunning()) {
+        bool outside = index.outside(test_point(k++));
+        gbenchmark_escape(&outside);
+    }
+    delete[] V;
+}
+
+BENCHMARK(BM_PolygonIndexOutside)->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_PolygonIndexBuild(benchmark::State& state)
+{
+    const uint16_t n = state.range_x();
+    Vector2l *V = make_fence(n);
+    PolygonIndex index;
+
+    while (state.KeepRunning()) {
+        index.build(V, n+1);
+        gbenchmark_escape(&index);
+    }
+    delete[] V;
+}
+
+BENCHMARK(BM_PolygonIndexBuild)->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_PointIndexNearest(benchmark::State& state)
+{
+    const uint16_t n = state.range_x();
+    PointIndex index;
+    index.init(n);
+    for (uint16_t i = 0; i < n; i++) {
+        Vector2l p = test_point(i * 7919);
+        Location loc = {};
+        loc.lat = p.x;
+        loc.lng = p.y;
+        index.add(loc, i);
+    }
+    index.finish();
+    uint32_t k = 0;
+
+    while (state.KeepRunning()) {
+        Vector2l p = test_point(k++);
+        Location loc = {};
+        loc.lat = p.x;
+        loc.lng = p.y;
+        float distance;
+        int32_t nearest = index.nearest(loc, distance);
+        gbenchmark_escape(&nearest);
+    }
+}
+
+BENCHMARK(BM_PointIndexNearest)->Arg(10)->Arg(100)->Arg(1000);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,166 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/matrixN.h>
+#include <AP_Math/vectorN.h>
+
+/*
+  the covariance prediction P = F*P*F' + Q and the sequential fusion
+  update P -= K*(H*P) of an EKF, done with MatrixN, with plain arrays
+  in the style of the hand written EKF code, and with the nested
+  VectorN used by the EKFs when MATH_CHECK_INDEXES is set
+ */
+
+static void fill(float *m, uint16_t n, uint32_t seed)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        m[i] = ((seed >> 16) & 0x7fff) / 16384.0f - 1.0f;
+    }
+}
+
+template <uint8_t N>
+static void BM_PredictArray(benchmark::State& state)
+{
+    float F[N][N], P[N][N], Q[N][N], FP[N][N];
+    fill(&F[0][0], N*N, 1);
+    fill(&P[0][0], N*N, 2);
+    fill(&Q[0][0], N*N, 3);
+
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i < N; i++) {
+            for (uint8_t j = 0; j < N; j++) {
+                FP[i][j] = 0;
+                for (uint8_t k = 0; k < N; k++) {
+                    FP[i][j] += F[i][k] * P[k][j];
+                }
+            }
+        }
+        for (uint8_t i = 0; i < N; i++) {
+            for (uint8_t j = 0; j < N; j++) {
+                P[i][j] = Q[i][j];
+                for (uint8_t k = 0; k < N; k++) {
+                    P[i][j] += FP[i][k] * F[j][k];
+                }
+            }
+        }
+        gbenchmark_escape(P);
+    }
+}
+
+template <uint8_t N>
+static void BM_PredictVectorN(benchmark::State& state)
+{
+    VectorN<VectorN<float,N>,N> F, P, Q, FP;
+    for (uint8_t i = 0; i < N; i++) {
+        fill(&F[i][0], N, 1 + i);
+        fill(&P[i][0], N, 2 + i);
+        fill(&Q[i][0], N, 3 + i);
+    }
+
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i < N; i++) {
+            for (uint8_t j = 0; j < N; j++) {
+                FP[i][j] = 0;
+                for (uint8_t k = 0; k < N; k++) {
+                    FP[i][j] += F[i][k] * P[k][j];
+                }
+            }
+        }
+        for (uint8_t i = 0; i < N; i++) {
+            for (uint8_t j = 0; j < N; j++) {
+                P[i][j] = Q[i][j];
+                for (uint8_t k = 0; k < N; k++) {
+                    P[i][j] += FP[i][k] * F[j][k];
+                }
+            }
+        }
+        gbenchmark_escape(&P);
+    }
+}
+
+template <uint8_t N>
+static void BM_PredictMatrixN(benchmark::State& state)
+{
+    MatrixN<float,N,N> F, P, Q;
+    fill(F[0], N*N, 1);
+    fill(P[0], N*N, 2);
+    fill(Q[0], N*N, 3);
+
+    while (state.KeepRunning()) {
+        P = F * P * F.transposed() + Q;
+        gbenchmark_escape(&P);
+    }
+}
+
+template <uint8_t N>
+static void BM_PredictMatrixNSymmetric(benchmark::State& state)
+{
+    MatrixN<float,N,N> F, P, Q;
+    fill(F[0], N*N, 1);
+    fill(P[0], N*N, 2);
+    fill(Q[0], N*N, 3);
+
+    while (state.KeepRunning()) {
+        P.symmetric_update(F, Q);
+        gbenchmark_escape(&P);
+    }
+}
+
+template <uint8_t N>
+static void BM_FuseArray(benchmark::State& state)
+{
+    float P[N][N], H[N], K[N], HP[N];
+    fill(&P[0][0], N*N, 2);
+    fill(H, N, 4);
+    fill(K, N, 5);
+
+    while (state.KeepRunning()) {
+        for (uint8_t j = 0; j < N; j++) {
+            HP[j] = 0;
+            for (uint8_t k = 0; k < N; k++) {
+                HP[j] += H[k] * P[k][j];
+            }
+        }
+        for (uint8_t i = 0; i < N; i++) {
+            for (uint8_t j = 0; j < N; j++) {
+                P[i][j] -= K[i] * HP[j];
+            }
+        }
+        gbenchmark_escape(P);
+    }
+}
+
+template <uint8_t N>
+static void BM_FuseMatrixN(benchmark::State& state)
+{
+    MatrixN<float,N,N> P;
+    MatrixN<float,1,N> H, HP;
+    float K[N], HP_row[N];
+    fill(P[0], N*N, 2);
+    fill(H[0], N, 4);
+    fill(K, N, 5);
+
+    while (state.KeepRunning()) {
+        HP.noalias() = H * P;
+        memcpy(HP_row, HP[0], sizeof(HP_row));
+        P.add_outer(-1, K, HP_row);
+        gbenchmark_escape(&P);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_PredictArray, 9);
+BENCHMARK_TEMPLATE(BM_PredictArray, 24);
+BENCHMARK_TEMPLATE(BM_PredictVectorN, 9);
+BENCHMARK_TEMPLATE(BM_PredictVectorN, 24);
+BENCHMARK_TEMPLATE(BM_PredictMatrixN, 9);
+BENCHMARK_TEMPLATE(BM_PredictMatrixN, 24);
+BENCHMARK_TEMPLATE(BM_PredictMatrixNSymmetric, 9);
+BENCHMARK_TEMPLATE(BM_PredictMatrixNSymmetric, 24);
+
+BENCHMARK_TEMPLATE(BM_FuseArray, 9);
+BENCHMARK_TEMPLATE(BM_FuseArray, 24);
+BENCHMARK_TEMPLATE(BM_FuseMatrixN, 9);
+BENCHMARK_TEMPLATE(BM_FuseMatrixN, 24);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,117 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+
+// a diagonally dominant matrix, so it is well conditioned
+static void make_matrix(float *A, uint8_t n)
+{
+    uint32_t seed = n;
+    for (uint16_t i = 0; i < n*n; i++) {
+        seed = seed * 1103515245 + 12345;
+        A[i] = ((seed >> 16) & 0x7fff) / 16384.0f - 1.0f;
+    }
+    for (uint8_t i = 0; i < n; i++) {
+        A[i*n + i] += n;
+    }
+}
+
+template <uint8_t N>
+static void BM_MatMul(benchmark::State& state)
+{
+    float A[N*N], B[N*N], out[N*N];
+    make_matrix(A, N);
+    make_matrix(B, N);
+
+    while (state.KeepRunning()) {
+        mat_mul(A, B, out, N);
+        gbenchmark_escape(out);
+    }
+}
+
+template <uint8_t N>
+static void BM_MatMulFixed(benchmark::State& state)
+{
+    float A[N*N], B[N*N], out[N*N];
+    make_matrix(A, N);
+    make_matrix(B, N);
+
+    while (state.KeepRunning()) {
+        mat_mul<N>(A, B, out);
+        gbenchmark_escape(out);
+    }
+}
+
+template <uint8_t N>
+static void BM_MatInverse(benchmark::State& state)
+{
+    float A[N*N], inv[N*N];
+    make_matrix(A, N);
+
+    while (state.KeepRunning()) {
+        gbenchmark_escape(A);
+        bool ok = mat_inverse(A, inv, N);
+        gbenchmark_escape(&ok);
+        gbenchmark_escape(inv);
+    }
+}
+
+template <uint8_t N>
+static void BM_MatInverseFixed(benchmark::State& state)
+{
+    float A[N*N], inv[N*N];
+    make_matrix(A, N);
+
+    while (state.KeepRunning()) {
+        gbenchmark_escape(A);
+        bool ok = mat_inverse<N>(A, inv);
+        gbenchmark_escape(&ok);
+        gbenchmark_escape(inv);
+    }
+}
+
+// the dispatching inverse() used by the calibrators
+template <uint8_t N>
+static void BM_Inverse(benchmark::State& state)
+{
+    float A[N*N], inv[N*N];
+    make_matrix(A, N);
+
+    while (state.KeepRunning()) {
+        gbenchmark_escape(A);
+        bool ok = inverse(A, inv, N);
+        gbenchmark_escape(&ok);
+        gbenchmark_escape(inv);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_MatMul, 3);
+BENCHMARK_TEMPLATE(BM_MatMul, 4);
+BENCHMARK_TEMPLATE(BM_MatMul, 6);
+BENCHMARK_TEMPLATE(BM_MatMul, 9);
+BENCHMARK_TEMPLATE(BM_MatMul, 24);
+
+BENCHMARK_TEMPLATE(BM_MatMulFixed, 3);
+BENCHMARK_TEMPLATE(BM_MatMulFixed, 4);
+BENCHMARK_TEMPLATE(BM_MatMulFixed, 6);
+BENCHMARK_TEMPLATE(BM_MatMulFixed, 9);
+BENCHMARK_TEMPLATE(BM_MatMulFixed, 24);
+
+BENCHMARK_TEMPLATE(BM_MatInverse, 3);
+BENCHMARK_TEMPLATE(BM_MatInverse, 4);
+BENCHMARK_TEMPLATE(BM_MatInverse, 6);
+BENCHMARK_TEMPLATE(BM_MatInverse, 9);
+BENCHMARK_TEMPLATE(BM_MatInverse, 24);
+
+BENCHMARK_TEMPLATE(BM_MatInverseFixed, 3);
+BENCHMARK_TEMPLATE(BM_MatInverseFixed, 4);
+BENCHMARK_TEMPLATE(BM_MatInverseFixed, 6);
+BENCHMARK_TEMPLATE(BM_MatInverseFixed, 9);
+BENCHMARK_TEMPLATE(BM_MatInverseFixed, 24);
+
+BENCHMARK_TEMPLATE(BM_Inverse, 3);
+BENCHMARK_TEMPLATE(BM_Inverse, 4);
+BENCHMARK_TEMPLATE(BM_Inverse, 6);
+BENCHMARK_TEMPLATE(BM_Inverse, 9);
+BENCHMARK_TEMPLATE(BM_Inverse, 24);
+
+BENCHMARK_MAIN()
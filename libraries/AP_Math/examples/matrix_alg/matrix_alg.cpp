@@ -44,7 +44,7 @@ static void test_matrix_inverse(void)
 {
     //fast inverses
     float test_mat[25],ident_mat[25];
-    float *out_mat;
+    float out_mat[25];
     for(uint8_t i = 0;i<25;i++) {
         test_mat[i] = pow(-1,i)*get_random()/0.7f;
     }
@@ -57,7 +57,7 @@ static void test_matrix_inverse(void)
         ident_mat[i*3+i] = 1.0f;
     }
     if(inverse(test_mat,mat,3)){
-        out_mat = mat_mul(test_mat,mat,3);
+        mat_mul(test_mat,mat,out_mat,3);
         inverse(mat,mat,3);
     } else {
         hal.console->printf("3x3 Matrix is Singular!\n");
@@ -88,7 +88,7 @@ static void test_matrix_inverse(void)
         ident_mat[i*4+i] = 1.0f;
     }
     if(inverse(test_mat,mat,4)){
-        out_mat = mat_mul(test_mat,mat,4);
+        mat_mul(test_mat,mat,out_mat,4);
         inverse(mat,mat,4);
     } else {
         hal.console->printf("4x4 Matrix is Singular!\n");
@@ -118,7 +118,7 @@ static void test_matrix_inverse(void)
         ident_mat[i*5+i] = 1.0f;
     }
     if(inverse(test_mat,mat,5)) {
-        out_mat = mat_mul(test_mat,mat,5);
+        mat_mul(test_mat,mat,out_mat,5);
         inverse(mat,mat,5);
     } else {
         hal.console->printf("5x5 Matrix is Singular!\n");
@@ -0,0 +1,194 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  fixed size radix-2 FFT of a real signal that can be computed a few
+  butterflies at a time.
+
+  All storage, including the twiddle factors and the Hann window, is
+  part of the object so there is no allocation once it has been
+  constructed. A transform is started with load() and advanced with
+  run(), which does at most the requested number of butterflies so
+  that the cost per call is bounded. A complete transform is
+  (N/2)*log2(N) butterflies.
+ */
+#ifndef FFT_H
+#define FFT_H
+
+#include <math.h>
+#include <stdint.h>
+
+template <uint16_t N>
+class IncrementalFFT
+{
+    static_assert(N >= 4 && (N & (N - 1)) == 0, "FFT size must be a power of two");
+
+public:
+    IncrementalFFT() :
+        _half(N),
+        _shift(0),
+        _butterfly(0)
+    {
+        for (uint16_t i = 0; i < N/2; i++) {
+            float angle = -2.0f * M_PI * i / N;
+            _twiddle_re[i] = cosf(angle);
+            _twiddle_im[i] = sinf(angle);
+        }
+        for (uint16_t i = 0; i < N; i++) {
+            _window[i] = 0.5f - 0.5f * cosf(2.0f * M_PI * i / (N - 1));
+        }
+        _log2_n = 0;
+        while ((1U << _log2_n) < N) {
+            _log2_n++;
+        }
+    }
+
+    // number of butterflies for a complete transform
+    static uint32_t total_butterflies() {
+        uint32_t stages = 0;
+        while ((1U << stages) < N) {
+            stages++;
+        }
+        return (N / 2) * stages;
+    }
+
+    /*
+      start a new transform of N real samples. The samples are
+      windowed and stored in bit-reversed order ready for the
+      in-place butterflies. The mean is removed so that the DC bin
+      does not leak into the low frequency bins
+     */
+    void load(const float *samples) {
+        float mean = 0;
+        for (uint16_t i = 0; i < N; i++) {
+            mean += samples[i];
+        }
+        mean /= N;
+        for (uint16_t i = 0; i < N; i++) {
+            uint16_t j = _bit_reverse(i);
+            _re[j] = (samples[i] - mean) * _window[i];
+            _im[j] = 0;
+        }
+        _half = 1;
+        _shift = 0;
+        _butterfly = 0;
+    }
+
+    /*
+      do up to max_butterflies butterflies. Returns true once the
+      transform is complete
+     */
+    bool run(uint32_t max_butterflies) {
+        while (_half < N && max_butterflies > 0) {
+            // decompose the butterfly index into group and position in group
+            uint16_t j = _butterfly & (_half - 1);
+            uint16_t a = ((_butterfly >> _shift) << (_shift + 1)) + j;
+            uint16_t b = a + _half;
+            uint16_t t = j << (_log2_n - 1 - _shift);
+
+            float wr = _twiddle_re[t];
+            float wi = _twiddle_im[t];
+            float tr = wr * _re[b] - wi * _im[b];
+            float ti = wr * _im[b] + wi * _re[b];
+            _re[b] = _re[a] - tr;
+            _im[b] = _im[a] - ti;
+            _re[a] += tr;
+            _im[a] += ti;
+
+            max_butterflies--;
+            if (++_butterfly == N/2) {
+                _butterfly = 0;
+                _half <<= 1;
+                _shift++;
+            }
+        }
+        return complete();
+    }
+
+    // true when the last transform has completed
+    bool complete() const { return _half >= N; }
+
+    // squared magnitude of a frequency bin, 0 <= bin <= N/2
+    float power(uint16_t bin) const {
+        return _re[bin] * _re[bin] + _im[bin] * _im[bin];
+    }
+
+    /*
+      find the largest local maxima of the spectrum, ignoring DC.
+      freq_bins is filled with the interpolated bin of each peak and
+      power with its power, strongest first. Returns the number of
+      peaks found
+     */
+    uint8_t find_peaks(float *freq_bins, float *peak_power, uint8_t max_peaks) const {
+        uint8_t n = 0;
+        for (uint16_t k = 2; k < N/2; k++) {
+            float p = power(k);
+            if (p <= power(k-1) || p < power(k+1)) {
+                continue;
+            }
+            // insert in descending power order
+            uint8_t i;
+            if (n < max_peaks) {
+                i = n++;
+            } else if (p > peak_power[max_peaks-1]) {
+                i = max_peaks-1;
+            } else {
+                continue;
+            }
+            while (i > 0 && peak_power[i-1] < p) {
+                peak_power[i] = peak_power[i-1];
+                freq_bins[i] = freq_bins[i-1];
+                i--;
+            }
+            peak_power[i] = p;
+            freq_bins[i] = k + _interpolate(k);
+        }
+        return n;
+    }
+
+private:
+    uint16_t _bit_reverse(uint16_t i) const {
+        uint16_t r = 0;
+        for (uint8_t b = 0; b < _log2_n; b++) {
+            r = (r << 1) | ((i >> b) & 1);
+        }
+        return r;
+    }
+
+    // parabolic interpolation of a peak on the bin magnitudes
+    float _interpolate(uint16_t k) const {
+        float y0 = sqrtf(power(k-1));
+        float y1 = sqrtf(power(k));
+        float y2 = sqrtf(power(k+1));
+        float d = y0 - 2.0f * y1 + y2;
+        if (d >= 0.0f) {
+            return 0.0f;
+        }
+        return 0.5f * (y0 - y2) / d;
+    }
+
+    float _re[N];
+    float _im[N];
+    float _twiddle_re[N/2];
+    float _twiddle_im[N/2];
+    float _window[N];
+    uint16_t _half;
+    uint8_t _shift;
+    uint16_t _butterfly;
+    uint8_t _log2_n;
+};
+
+#endif // FFT_H
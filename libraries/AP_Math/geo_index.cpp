@@ -0,0 +1,253 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Math.h"
+
+#include <stdlib.h>
+
+// limit on the edges listed per polygon edge, over all bands. Long
+// edges are listed in many bands, and if that takes too much memory
+// fewer bands are used
+#define POLYGON_INDEX_MAX_ENTRIES_PER_EDGE 4
+
+// the band entries are indexed with 16 bits
+#define POLYGON_INDEX_MAX_EDGES (0xFFFF / POLYGON_INDEX_MAX_ENTRIES_PER_EDGE)
+
+PolygonIndex::PolygonIndex() :
+    _V(nullptr),
+    _n(0),
+    _num_bands(0),
+    _band_start(nullptr),
+    _edges(nullptr)
+{
+}
+
+PolygonIndex::~PolygonIndex()
+{
+    clear();
+}
+
+void PolygonIndex::clear(void)
+{
+    delete[] _band_start;
+    delete[] _edges;
+    _band_start = nullptr;
+    _edges = nullptr;
+    _num_bands = 0;
+}
+
+// band holding y, which must be within the bounding box
+uint16_t PolygonIndex::band(int32_t y, uint16_t num_bands) const
+{
+    return ((int64_t)y - _min.y) * num_bands / ((int64_t)_max.y - _min.y + 1);
+}
+
+// number of band entries needed for a number of bands
+uint32_t PolygonIndex::count_entries(uint16_t num_bands) const
+{
+    uint32_t total = 0;
+    for (unsigned i = 0, j = _n-1; i < _n; j = i++) {
+        total += band(MAX(_V[i].y, _V[j].y), num_bands) - band(MIN(_V[i].y, _V[j].y), num_bands) + 1;
+    }
+    return total;
+}
+
+void PolygonIndex::build(const Vector2l *V, unsigned n)
+{
+    clear();
+    _V = V;
+    _n = n;
+    if (n < 4 || n > POLYGON_INDEX_MAX_EDGES) {
+        return;
+    }
+
+    _min = _max = V[0];
+    for (uint16_t i = 1; i < n; i++) {
+        _min.x = MIN(_min.x, V[i].x);
+        _min.y = MIN(_min.y, V[i].y);
+        _max.x = MAX(_max.x, V[i].x);
+        _max.y = MAX(_max.y, V[i].y);
+    }
+
+    // about one band per edge, with fewer bands if edges span many
+    uint16_t num_bands = n;
+    uint32_t total;
+    while ((total = count_entries(num_bands)) > POLYGON_INDEX_MAX_ENTRIES_PER_EDGE * n && num_bands > 1) {
+        num_bands /= 2;
+    }
+    if (total > POLYGON_INDEX_MAX_ENTRIES_PER_EDGE * n) {
+        return;
+    }
+
+    _band_start = new uint16_t[num_bands+1];
+    _edges = new uint16_t[total];
+    if (_band_start == nullptr || _edges == nullptr) {
+        clear();
+        return;
+    }
+    _num_bands = num_bands;
+
+    // count the edges of each band, then fill the bands in
+    memset(_band_start, 0, (num_bands+1) * sizeof(_band_start[0]));
+    for (uint16_t i = 0, j = _n-1; i < _n; j = i++) {
+        uint16_t b1 = band(MAX(V[i].y, V[j].y), num_bands);
+        for (uint16_t b = band(MIN(V[i].y, V[j].y), num_bands); b <= b1; b++) {
+            _band_start[b+1]++;
+        }
+    }
+    for (uint16_t b = 0; b < num_bands; b++) {
+        _band_start[b+1] += _band_start[b];
+    }
+    for (uint16_t i = 0, j = _n-1; i < _n; j = i++) {
+        uint16_t b1 = band(MAX(V[i].y, V[j].y), num_bands);
+        for (uint16_t b = band(MIN(V[i].y, V[j].y), num_bands); b <= b1; b++) {
+            // _band_start[b] is used as the fill position of band b,
+            // and ends up as the start of band b+1
+            _edges[_band_start[b]++] = i;
+        }
+    }
+    for (uint16_t b = num_bands; b > 0; b--) {
+        _band_start[b] = _band_start[b-1];
+    }
+    _band_start[0] = 0;
+}
+
+bool PolygonIndex::outside(const Vector2l &P) const
+{
+    if (_band_start == nullptr) {
+        return Polygon_outside(P, _V, _n);
+    }
+
+    // a closed polygon crosses any line outside its bounding box an
+    // even number of times
+    if (P.x < _min.x || P.x > _max.x || P.y < _min.y || P.y > _max.y) {
+        return true;
+    }
+
+    bool outside = true;
+    uint16_t b = band(P.y, _num_bands);
+    for (uint16_t k = _band_start[b]; k < _band_start[b+1]; k++) {
+        uint16_t i = _edges[k];
+        uint16_t j = (i == 0) ? _n-1 : i-1;
+        if (Polygon_crosses(P, _V[i], _V[j])) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+PointIndex::PointIndex() :
+    _points(nullptr),
+    _max_points(0),
+    _count(0)
+{
+    memset(&_origin, 0, sizeof(_origin));
+}
+
+PointIndex::~PointIndex()
+{
+    delete[] _points;
+}
+
+bool PointIndex::init(uint16_t max_points)
+{
+    _count = 0;
+    if (max_points > _max_points) {
+        delete[] _points;
+        _max_points = 0;
+        _points = new struct entry[max_points];
+        if (_points == nullptr) {
+            return false;
+        }
+        _max_points = max_points;
+    }
+    return true;
+}
+
+void PointIndex::add(const Location &loc, uint16_t id)
+{
+    if (_count >= _max_points) {
+        return;
+    }
+    if (_count == 0) {
+        _origin = loc;
+    }
+    _points[_count].ne = location_diff(_origin, loc);
+    _points[_count].id = id;
+    _count++;
+}
+
+void PointIndex::finish(void)
+{
+    // insertion sort by north, the sets are small
+    for (uint16_t i = 1; i < _count; i++) {
+        struct entry e = _points[i];
+        uint16_t j = i;
+        while (j > 0 && _points[j-1].ne.x > e.ne.x) {
+            _points[j] = _points[j-1];
+            j--;
+        }
+        _points[j] = e;
+    }
+}
+
+int32_t PointIndex::nearest(const Location &loc, float &distance) const
+{
+    if (_count == 0) {
+        return -1;
+    }
+    Vector2f p = location_diff(_origin, loc);
+
+    // find the first point north of p, then search outwards from it
+    // until the north distance alone is more than the best distance
+    uint16_t lo = 0, hi = _count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (_points[mid].ne.x < p.x) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    float best_sq = -1;
+    uint16_t best = 0;
+    for (uint16_t i = lo; i < _count; i++) {
+        float dx = _points[i].ne.x - p.x;
+        if (best_sq >= 0 && dx*dx > best_sq) {
+            break;
+        }
+        float d_sq = (_points[i].ne - p).length_squared();
+        if (best_sq < 0 || d_sq < best_sq) {
+            best_sq = d_sq;
+            best = i;
+        }
+    }
+    for (uint16_t i = lo; i > 0; i--) {
+        float dx = p.x - _points[i-1].ne.x;
+        if (best_sq >= 0 && dx*dx > best_sq) {
+            break;
+        }
+        float d_sq = (_points[i-1].ne - p).length_squared();
+        if (best_sq < 0 || d_sq < best_sq) {
+            best_sq = d_sq;
+            best = i-1;
+        }
+    }
+
+    distance = sqrtf(best_sq);
+    return _points[best].id;
+}
@@ -0,0 +1,104 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  spatial indexes for fence and rally point queries. Both are built
+  once when the points change, and make each query cost roughly the
+  same whatever the number of points
+ */
+
+/*
+  index of a polygon as taken by Polygon_outside(). The y range of the
+  polygon is split into bands, each listing the edges that cross it,
+  so a test only looks at the edges in the band of the point. Results
+  are identical to Polygon_outside()
+ */
+class PolygonIndex
+{
+public:
+    PolygonIndex();
+    ~PolygonIndex();
+
+    /*
+      build the index over V[n] with V[n-1]=V[0]. V is not copied and
+      must stay valid while the index is used. If there isn't enough
+      memory for the index, outside() does a full Polygon_outside()
+     */
+    void build(const Vector2l *V, unsigned n);
+
+    // true if P is outside the polygon
+    bool outside(const Vector2l &P) const;
+
+private:
+    void clear(void);
+    uint16_t band(int32_t y, uint16_t num_bands) const;
+    uint32_t count_entries(uint16_t num_bands) const;
+
+    const Vector2l *_V;
+    unsigned _n;
+
+    // bounding box of the polygon
+    Vector2l _min;
+    Vector2l _max;
+
+    // the edges of band b are _edges[_band_start[b]] up to
+    // _edges[_band_start[b+1]], edge i running from V[i] to V[i-1]
+    uint16_t _num_bands;
+    uint16_t *_band_start;
+    uint16_t *_edges;
+};
+
+/*
+  nearest point queries over a set of locations. The points are
+  projected to a local north/east frame in meters around the first
+  point and sorted by north, so a query only looks at the points
+  within the best distance found so far
+ */
+class PointIndex
+{
+public:
+    PointIndex();
+    ~PointIndex();
+
+    // start a new set of up to max_points points. Returns false if out of memory
+    bool init(uint16_t max_points);
+
+    // add a point with an identifier for the caller
+    void add(const Location &loc, uint16_t id);
+
+    // sort the points, call after the last add()
+    void finish(void);
+
+    uint16_t count(void) const { return _count; }
+
+    /*
+      find the nearest point to loc. Returns its identifier and sets
+      distance in meters, or returns -1 if there are no points
+     */
+    int32_t nearest(const Location &loc, float &distance) const;
+
+private:
+    struct entry {
+        Vector2f ne;
+        uint16_t id;
+    };
+
+    Location _origin;
+    struct entry *_points;
+    uint16_t _max_points;
+    uint16_t _count;
+};
@@ -0,0 +1,469 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  fixed size RxC matrices for filter algebra, such as EKF covariance
+  updates.
+
+  Arithmetic on matrices does not compute anything straight away. It
+  builds a small expression object, and the loops run when the
+  expression is assigned to a MatrixN, so P = A + B*s - C.transposed()
+  is one pass over P with no temporary matrices.
+
+  Products are the exception. Each element of a product is a sum over a
+  whole row and column, so a product that is an operand of another
+  product is worked out once into a temporary, and assigning a product
+  to a matrix goes through a temporary in case the matrix is also one
+  of the operands, as in P = F * P. Use noalias() when it is not, to
+  write the result straight into the matrix:
+
+      FP.noalias() = F * P;
+
+  Element-wise expressions are written in place, so A = A.transposed()
+  does not work. Use transpose() for that.
+
+  Rows are stored one after another with no padding, and m[i][j] works
+  as it does on a two dimensional array, so MatrixN can take the place
+  of one. The storage is aligned for SIMD on 64 bit targets. Elsewhere
+  the heap does not promise 16 byte alignment, and these matrices are
+  often members of objects made with new.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+#include <assert.h>
+#endif
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#define MATRIXN_ALIGNED alignas(16)
+#else
+#define MATRIXN_ALIGNED
+#endif
+
+template <typename T, uint8_t R, uint8_t C> class MatrixN;
+template <typename E, typename T, uint8_t R, uint8_t C> class MatrixTranspose;
+
+// stops a scalar argument taking part in template argument deduction
+template <typename T> struct matrix_scalar { typedef T type; };
+
+/*
+  base of all matrix expressions. E is the expression type, which gives
+  element (i,j) of an RxC result
+ */
+template <typename E, typename T, uint8_t R, uint8_t C>
+class MatrixExpr
+{
+public:
+    const E &derived() const { return static_cast<const E &>(*this); }
+
+    T operator()(uint8_t i, uint8_t j) const { return derived()(i, j); }
+
+    MatrixTranspose<E,T,C,R> transposed() const {
+        return MatrixTranspose<E,T,C,R>(derived());
+    }
+};
+
+/*
+  how an expression holds its operands. Matrices are held by reference
+  and expressions, which are small, by value
+ */
+template <typename E>
+struct matrix_operand { typedef const E type; };
+
+template <typename T, uint8_t R, uint8_t C>
+struct matrix_operand<MatrixN<T,R,C> > { typedef const MatrixN<T,R,C> &type; };
+
+/*
+  how a product holds its operands. Its loops run along the rows of
+  each operand, so anything but a matrix, including a transpose, is
+  worked out into a matrix first
+ */
+template <typename E, typename T, uint8_t R, uint8_t C>
+struct matrix_product_operand { typedef const MatrixN<T,R,C> type; };
+
+template <typename T, uint8_t R, uint8_t C>
+struct matrix_product_operand<MatrixN<T,R,C>,T,R,C> { typedef const MatrixN<T,R,C> &type; };
+
+template <typename E, typename T, uint8_t R, uint8_t C>
+class MatrixTranspose : public MatrixExpr<MatrixTranspose<E,T,R,C>,T,R,C>
+{
+public:
+    static const bool has_product = E::has_product;
+
+    explicit MatrixTranspose(const E &e) : _e(e) {}
+    T operator()(uint8_t i, uint8_t j) const { return _e(j, i); }
+
+private:
+    typename matrix_operand<E>::type _e;
+};
+
+template <typename A, typename B, typename T, uint8_t R, uint8_t C>
+class MatrixSum : public MatrixExpr<MatrixSum<A,B,T,R,C>,T,R,C>
+{
+public:
+    static const bool has_product = A::has_product || B::has_product;
+
+    MatrixSum(const A &a, const B &b) : _a(a), _b(b) {}
+    T operator()(uint8_t i, uint8_t j) const { return _a(i, j) + _b(i, j); }
+
+private:
+    typename matrix_operand<A>::type _a;
+    typename matrix_operand<B>::type _b;
+};
+
+template <typename A, typename B, typename T, uint8_t R, uint8_t C>
+class MatrixDifference : public MatrixExpr<MatrixDifference<A,B,T,R,C>,T,R,C>
+{
+public:
+    static const bool has_product = A::has_product || B::has_product;
+
+    MatrixDifference(const A &a, const B &b) : _a(a), _b(b) {}
+    T operator()(uint8_t i, uint8_t j) const { return _a(i, j) - _b(i, j); }
+
+private:
+    typename matrix_operand<A>::type _a;
+    typename matrix_operand<B>::type _b;
+};
+
+template <typename E, typename T, uint8_t R, uint8_t C>
+class MatrixScale : public MatrixExpr<MatrixScale<E,T,R,C>,T,R,C>
+{
+public:
+    static const bool has_product = E::has_product;
+
+    MatrixScale(const E &e, T s) : _e(e), _s(s) {}
+    T operator()(uint8_t i, uint8_t j) const { return _e(i, j) * _s; }
+
+private:
+    typename matrix_operand<E>::type _e;
+    const T _s;
+};
+
+/*
+  the product of an RxK and a KxC matrix
+ */
+template <typename A, typename B, typename T, uint8_t R, uint8_t K, uint8_t C>
+class MatrixProduct : public MatrixExpr<MatrixProduct<A,B,T,R,K,C>,T,R,C>
+{
+public:
+    static const bool has_product = true;
+
+    MatrixProduct(const A &a, const B &b) : _a(a), _b(b) {}
+
+    T operator()(uint8_t i, uint8_t j) const {
+        T sum = 0;
+        for (uint8_t k = 0; k < K; k++) {
+            sum += _a(i, k) * _b(k, j);
+        }
+        return sum;
+    }
+
+    /*
+      add the product times sign to m. Each element of A scales a row
+      of B into a row of m, so the inner loop runs along rows
+     */
+    void add_to(MatrixN<T,R,C> &m, T sign) const {
+        for (uint8_t i = 0; i < R; i++) {
+            T *m_row = m[i];
+            const T *a_row = _a[i];
+            for (uint8_t k = 0; k < K; k++) {
+                const T a = sign * a_row[k];
+                const T *b_row = _b[k];
+                for (uint8_t j = 0; j < C; j++) {
+                    m_row[j] += a * b_row[j];
+                }
+            }
+        }
+    }
+
+private:
+    typename matrix_product_operand<A,T,R,K>::type _a;
+    typename matrix_product_operand<B,T,K,C>::type _b;
+};
+
+template <typename A, typename B, typename T, uint8_t R, uint8_t C>
+MatrixSum<A,B,T,R,C> operator +(const MatrixExpr<A,T,R,C> &a, const MatrixExpr<B,T,R,C> &b)
+{
+    return MatrixSum<A,B,T,R,C>(a.derived(), b.derived());
+}
+
+template <typename A, typename B, typename T, uint8_t R, uint8_t C>
+MatrixDifference<A,B,T,R,C> operator -(const MatrixExpr<A,T,R,C> &a, const MatrixExpr<B,T,R,C> &b)
+{
+    return MatrixDifference<A,B,T,R,C>(a.derived(), b.derived());
+}
+
+template <typename E, typename T, uint8_t R, uint8_t C>
+MatrixScale<E,T,R,C> operator *(const MatrixExpr<E,T,R,C> &e, typename matrix_scalar<T>::type s)
+{
+    return MatrixScale<E,T,R,C>(e.derived(), s);
+}
+
+template <typename E, typename T, uint8_t R, uint8_t C>
+MatrixScale<E,T,R,C> operator *(typename matrix_scalar<T>::type s, const MatrixExpr<E,T,R,C> &e)
+{
+    return MatrixScale<E,T,R,C>(e.derived(), s);
+}
+
+template <typename E, typename T, uint8_t R, uint8_t C>
+MatrixScale<E,T,R,C> operator -(const MatrixExpr<E,T,R,C> &e)
+{
+    return MatrixScale<E,T,R,C>(e.derived(), -1);
+}
+
+template <typename A, typename B, typename T, uint8_t R, uint8_t K, uint8_t C>
+MatrixProduct<A,B,T,R,K,C> operator *(const MatrixExpr<A,T,R,K> &a, const MatrixExpr<B,T,K,C> &b)
+{
+    return MatrixProduct<A,B,T,R,K,C>(a.derived(), b.derived());
+}
+
+/*
+  assignment to a matrix that is known not to be an operand of the
+  expression, see noalias()
+ */
+template <typename T, uint8_t R, uint8_t C>
+class MatrixNoAlias
+{
+public:
+    explicit MatrixNoAlias(MatrixN<T,R,C> &m) : _m(m) {}
+
+    template <typename E>
+    MatrixN<T,R,C> &operator =(const MatrixExpr<E,T,R,C> &e) {
+        _m.assign(e.derived());
+        return _m;
+    }
+
+    template <typename E>
+    MatrixN<T,R,C> &operator +=(const MatrixExpr<E,T,R,C> &e) {
+        _m.add(e.derived(), 1);
+        return _m;
+    }
+
+    template <typename E>
+    MatrixN<T,R,C> &operator -=(const MatrixExpr<E,T,R,C> &e) {
+        _m.add(e.derived(), -1);
+        return _m;
+    }
+
+private:
+    MatrixN<T,R,C> &_m;
+};
+
+template <typename T, uint8_t R, uint8_t C>
+class MatrixN : public MatrixExpr<MatrixN<T,R,C>,T,R,C>
+{
+public:
+    static const bool has_product = false;
+
+    // all zero
+    MatrixN() {
+        zero();
+    }
+
+    // work out an expression
+    template <typename E>
+    MatrixN(const MatrixExpr<E,T,R,C> &e) {
+        assign(e.derived());
+    }
+
+    T &operator()(uint8_t i, uint8_t j) {
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+        assert(i < R && j < C);
+#endif
+        return _m[i][j];
+    }
+
+    const T &operator()(uint8_t i, uint8_t j) const {
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+        assert(i < R && j < C);
+#endif
+        return _m[i][j];
+    }
+
+    // row i, so that m[i][j] is element (i,j)
+    T *operator[](uint8_t i) {
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+        assert(i < R);
+#endif
+        return _m[i];
+    }
+
+    const T *operator[](uint8_t i) const {
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+        assert(i < R);
+#endif
+        return _m[i];
+    }
+
+    void zero() {
+        memset(_m, 0, sizeof(_m));
+    }
+
+    void identity() {
+        zero();
+        for (uint8_t i = 0; i < R && i < C; i++) {
+            _m[i][i] = 1;
+        }
+    }
+
+    template <typename E>
+    MatrixN &operator =(const MatrixExpr<E,T,R,C> &e) {
+        if (E::has_product) {
+            const MatrixN tmp(e);
+            memcpy(_m, tmp._m, sizeof(_m));
+        } else {
+            assign(e.derived());
+        }
+        return *this;
+    }
+
+    template <typename E>
+    MatrixN &operator +=(const MatrixExpr<E,T,R,C> &e) {
+        if (E::has_product) {
+            const MatrixN tmp(e);
+            add(tmp, 1);
+        } else {
+            add(e.derived(), 1);
+        }
+        return *this;
+    }
+
+    template <typename E>
+    MatrixN &operator -=(const MatrixExpr<E,T,R,C> &e) {
+        if (E::has_product) {
+            const MatrixN tmp(e);
+            add(tmp, -1);
+        } else {
+            add(e.derived(), -1);
+        }
+        return *this;
+    }
+
+    MatrixN &operator *=(T s) {
+        for (uint8_t i = 0; i < R; i++) {
+            for (uint8_t j = 0; j < C; j++) {
+                _m[i][j] *= s;
+            }
+        }
+        return *this;
+    }
+
+    // assign without a temporary, when this matrix is not an operand
+    MatrixNoAlias<T,R,C> noalias() {
+        return MatrixNoAlias<T,R,C>(*this);
+    }
+
+    // transpose a square matrix in place
+    void transpose() {
+        static_assert(R == C, "transpose() needs a square matrix");
+        for (uint8_t i = 1; i < R; i++) {
+            for (uint8_t j = 0; j < i; j++) {
+                const T t = _m[i][j];
+                _m[i][j] = _m[j][i];
+                _m[j][i] = t;
+            }
+        }
+    }
+
+    // make a square matrix symmetric by averaging it with its transpose
+    void force_symmetry() {
+        static_assert(R == C, "force_symmetry() needs a square matrix");
+        for (uint8_t i = 1; i < R; i++) {
+            for (uint8_t j = 0; j < i; j++) {
+                const T t = (_m[i][j] + _m[j][i]) * 0.5f;
+                _m[i][j] = t;
+                _m[j][i] = t;
+            }
+        }
+    }
+
+    /*
+      P = F * P * F' + Q, for a symmetric P and Q. The loops run along
+      rows of FP and of F', and the lower triangle is then copied to the
+      upper so that rounding leaves P exactly symmetric
+     */
+    template <typename E, typename EQ>
+    void symmetric_update(const MatrixExpr<E,T,R,R> &F, const MatrixExpr<EQ,T,R,R> &Q) {
+        static_assert(R == C, "symmetric_update() needs a square matrix");
+        MatrixN FP;
+        FP.noalias() = F * *this;
+        const MatrixN Ft = F.transposed();
+        for (uint8_t i = 0; i < R; i++) {
+            T *row = _m[i];
+            for (uint8_t j = 0; j < R; j++) {
+                row[j] = Q(i, j);
+            }
+            for (uint8_t k = 0; k < R; k++) {
+                const T a = FP._m[i][k];
+                const T *Ft_row = Ft._m[k];
+                for (uint8_t j = 0; j < R; j++) {
+                    row[j] += a * Ft_row[j];
+                }
+            }
+        }
+        for (uint8_t i = 1; i < R; i++) {
+            for (uint8_t j = 0; j < i; j++) {
+                _m[j][i] = _m[i][j];
+            }
+        }
+    }
+
+    // add s * u * v' to the matrix, such as P -= K * (H * P) in a sequential fusion
+    void add_outer(T s, const T (&u)[R], const T (&v)[C]) {
+        for (uint8_t i = 0; i < R; i++) {
+            const T su = s * u[i];
+            for (uint8_t j = 0; j < C; j++) {
+                _m[i][j] += su * v[j];
+            }
+        }
+    }
+
+private:
+    friend class MatrixNoAlias<T,R,C>;
+
+    template <typename E>
+    void assign(const E &e) {
+        for (uint8_t i = 0; i < R; i++) {
+            for (uint8_t j = 0; j < C; j++) {
+                _m[i][j] = e(i, j);
+            }
+        }
+    }
+
+    template <typename A, typename B, uint8_t K>
+    void assign(const MatrixProduct<A,B,T,R,K,C> &p) {
+        zero();
+        p.add_to(*this, 1);
+    }
+
+    template <typename E>
+    void add(const E &e, T sign) {
+        for (uint8_t i = 0; i < R; i++) {
+            for (uint8_t j = 0; j < C; j++) {
+                _m[i][j] += sign * e(i, j);
+            }
+        }
+    }
+
+    template <typename A, typename B, uint8_t K>
+    void add(const MatrixProduct<A,B,T,R,K,C> &p, T sign) {
+        p.add_to(*this, sign);
+    }
+
+    MATRIXN_ALIGNED T _m[R][C];
+};
@@ -30,199 +30,50 @@ extern const AP_HAL::HAL& hal;
  *
  *    @param     A,           Matrix A
  *    @param     B,           Matrix B
+ *    @param     out,         Output multiplied matrix i.e. A*B, which must not be A or B
  *    @param     n,           dimemsion of square matrices
- *    @returns                multiplied matrix i.e. A*B
  */
 
-float* mat_mul(float *A, float *B, uint8_t n)
+void mat_mul(const float *A, const float *B, float *out, uint8_t n)
 {
-    float* ret = new float[n*n];
-    memset(ret,0.0f,n*n*sizeof(float));
-
-    for(uint8_t i = 0; i < n; i++) {
-        for(uint8_t j = 0; j < n; j++) {
-            for(uint8_t k = 0;k < n; k++) {
-                ret[i*n + j] += A[i*n + k] * B[k*n + j];
-            }
-        }
-    }
-    return ret;
-}
-
-static inline void swap(float &a, float &b)
-{
-    float c;
-    c = a;
-    a = b;
-    b = c;
-}
-
-/*
- *    calculates pivot matrix such that all the larger elements in the row are on diagonal
- *
- *    @param     A,           input matrix matrix
- *    @param     pivot
- *    @param     n,           dimenstion of square matrix
- *    @returns                false = matrix is Singular or non positive definite, true = matrix inversion successful
- */
-
-void mat_pivot(float* A, float* pivot, uint8_t n)
-{
-    for(uint8_t i = 0;i<n;i++){
-        for(uint8_t j=0;j<n;j++) {
-            pivot[i*n+j] = (i==j);
-        }
-    }
-
-    for(uint8_t i = 0;i < n; i++) {
-        uint8_t max_j = i;
-        for(uint8_t j=i;j<n;j++){
-            if(fabsf(A[j*n + i]) > fabsf(A[max_j*n + i])) {
-                max_j = j;
-            }
-        }
-
-        if(max_j != i) {
-            for(uint8_t k = 0; k < n; k++) {
-                swap(pivot[i*n + k], pivot[max_j*n + k]);
-            }
-        }
+    // small matrices go to unrolled versions
+    switch (n) {
+    case 2: return mat_mul<2>(A, B, out);
+    case 3: return mat_mul<3>(A, B, out);
+    case 4: return mat_mul<4>(A, B, out);
+    case 5: return mat_mul<5>(A, B, out);
+    case 6: return mat_mul<6>(A, B, out);
+    case 9: return mat_mul<9>(A, B, out);
+    default: return mat_mul_kernel(A, B, out, n);
     }
 }
 
 /*
- *    calculates matrix inverse of Lower trangular matrix using forward substitution
+ *    matrix inverse code for any square matrix using Gauss-Jordan
+ *    elimination with partial pivoting, in place in the output matrix
  *
- *    @param     L,           lower triangular matrix
- *    @param     out,         Output inverted lower triangular matrix
- *    @param     n,           dimension of matrix
- */
-
-void mat_forward_sub(float *L, float *out, uint8_t n)
-{
-    // Forward substitution solve LY = I
-    for(int i = 0; i < n; i++) {
-        out[i*n + i] = 1/L[i*n + i];
-        for (int j = i+1; j < n; j++) {
-            for (int k = i; k < j; k++) {
-                out[j*n + i] -= L[j*n + k] * out[k*n + i];
-            }
-            out[j*n + i] /= L[j*n + j];
-        }
-    }
-}
-
-/*
- *    calculates matrix inverse of Upper trangular matrix using backward substitution
- *
- *    @param     U,           upper triangular matrix
- *    @param     out,         Output inverted upper triangular matrix
- *    @param     n,           dimension of matrix
- */
-
-void mat_back_sub(float *U, float *out, uint8_t n)
-{
-    // Backward Substitution solve UY = I
-    for(int i = n-1; i >= 0; i--) {
-        out[i*n + i] = 1/U[i*n + i];
-        for (int j = i - 1; j >= 0; j--) {
-            for (int k = i; k > j; k--) {
-                out[j*n + i] -= U[j*n + k] * out[k*n + i];
-            }
-            out[j*n + i] /= U[j*n + j];
-        }
-    }
-}
-
-/*
- *    Decomposes square matrix into Lower and Upper triangular matrices such that
- *    A*P = L*U, where P is the pivot matrix
- *    ref: http://rosettacode.org/wiki/LU_decomposition
- *    @param     U,           upper triangular matrix
- *    @param     out,         Output inverted upper triangular matrix
- *    @param     n,           dimension of matrix
- */
-
-void mat_LU_decompose(float* A, float* L, float* U, float *P, uint8_t n)
-{
-    memset(L,0,n*n*sizeof(float));
-    memset(U,0,n*n*sizeof(float));
-    memset(P,0,n*n*sizeof(float));
-    mat_pivot(A,P,n);
-
-    float *APrime = mat_mul(P,A,n);
-    for(uint8_t i = 0; i < n; i++) {
-        L[i*n + i] = 1;
-    }
-    for(uint8_t i = 0; i < n; i++) {
-        for(uint8_t j = 0; j < n; j++) {
-            if(j <= i) {    
-                U[j*n + i] = APrime[j*n + i];
-                for(uint8_t k = 0; k < j; k++) {
-                    U[j*n + i] -= L[j*n + k] * U[k*n + i]; 
-                }
-            }
-            if(j >= i) {
-                L[j*n + i] = APrime[j*n + i];
-                for(uint8_t k = 0; k < i; k++) {
-                    L[j*n + i] -= L[j*n + k] * U[k*n + i]; 
-                }
-                L[j*n + i] /= U[i*n + i];
-            }
-        }
-    }
-    free(APrime);
-}
-
-/*
- *    matrix inverse code for any square matrix using LU decomposition
- *    inv = inv(U)*inv(L)*P, where L and U are triagular matrices and P the pivot matrix
- *    ref: http://www.cl.cam.ac.uk/teaching/1314/NumMethods/supporting/mcmaster-kiruba-ludecomp.pdf
- *    @param     m,           input 4x4 matrix
- *    @param     inv,      Output inverted 4x4 matrix
+ *    @param     A,           input nxn matrix
+ *    @param     inv,         Output inverted nxn matrix, which may be A
  *    @param     n,           dimension of square matrix
  *    @returns                false = matrix is Singular, true = matrix inversion successful
  */
-bool mat_inverse(float* A, float* inv, uint8_t n)
+bool mat_inverse(const float *A, float *inv, uint8_t n)
 {
-    float *L, *U, *P;
-    bool ret = true;
-    L = new float[n*n];
-    U = new float[n*n];
-    P = new float[n*n];
-    mat_LU_decompose(A,L,U,P,n);
-
-    float *L_inv = new float[n*n];
-    float *U_inv = new float[n*n];
-
-    memset(L_inv,0,n*n*sizeof(float));
-    mat_forward_sub(L,L_inv,n);
-
-    memset(U_inv,0,n*n*sizeof(float));
-    mat_back_sub(U,U_inv,n);
-
-    // decomposed matrices no loger required
-    free(L);
-    free(U);
-
-    float *inv_unpivoted = mat_mul(U_inv,L_inv,n);
-    float *inv_pivoted = mat_mul(inv_unpivoted, P, n);
-
-    //check sanity of results
-    for(uint8_t i = 0; i < n; i++) {
-        for(uint8_t j = 0; j < n; j++) {
-            if(isnan(inv_pivoted[i*n+j]) || isinf(inv_pivoted[i*n+j])){
-                ret = false;
-            }
-        }
+    // small matrices go to unrolled versions
+    switch (n) {
+    case 2: return mat_inverse<2>(A, inv);
+    case 3: return mat_inverse<3>(A, inv);
+    case 4: return mat_inverse<4>(A, inv);
+    case 5: return mat_inverse<5>(A, inv);
+    case 6: return mat_inverse<6>(A, inv);
+    case 9: return mat_inverse<9>(A, inv);
+    default: break;
     }
-    memcpy(inv,inv_pivoted,n*n*sizeof(float));
-
-    //free memory
-    free(inv_pivoted);
-    free(inv_unpivoted);
-    free(P);
-    return ret;
+    uint8_t perm[UINT8_MAX];
+    if (inv != A) {
+        memcpy(inv, A, n*n*sizeof(float));
+    }
+    return mat_inverse_kernel(inv, n, perm);
 }
 
 /*
@@ -0,0 +1,142 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  square matrix algebra on row major float arrays. None of these
+  allocate memory, so they are safe to use while flying.
+
+  The kernels take the dimension as an argument. The templates with the
+  dimension as a parameter use the same kernels, but with a constant
+  dimension the compiler can unroll the loops, which it does for
+  matrices up to about 6x6. mat_mul() and mat_inverse() pass the common
+  small sizes on to the templates.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+  matrix multiplication of two nxn matrices, out = A*B. out must not be
+  A or B. Rows of B are added into rows of out, so the inner loop runs
+  along contiguous rows and can be vectorised
+ */
+static inline void mat_mul_kernel(const float *A, const float *B, float *out, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++) {
+        float *out_row = &out[i*n];
+        for (uint8_t j = 0; j < n; j++) {
+            out_row[j] = 0;
+        }
+        for (uint8_t k = 0; k < n; k++) {
+            const float a = A[i*n + k];
+            const float *B_row = &B[k*n];
+            for (uint8_t j = 0; j < n; j++) {
+                out_row[j] += a * B_row[j];
+            }
+        }
+    }
+}
+
+/*
+  invert the nxn matrix m in place by Gauss-Jordan elimination with
+  partial pivoting. perm must have room for n row numbers. Returns
+  false if the matrix is singular, leaving m undefined
+ */
+static inline bool mat_inverse_kernel(float *m, uint8_t n, uint8_t *perm)
+{
+    for (uint8_t k = 0; k < n; k++) {
+        // use the largest element left in column k as the pivot
+        uint8_t p = k;
+        for (uint8_t i = k+1; i < n; i++) {
+            if (fabsf(m[i*n + k]) > fabsf(m[p*n + k])) {
+                p = i;
+            }
+        }
+        perm[k] = p;
+        if (p != k) {
+            for (uint8_t j = 0; j < n; j++) {
+                const float t = m[k*n + j];
+                m[k*n + j] = m[p*n + j];
+                m[p*n + j] = t;
+            }
+        }
+
+        const float pivot = m[k*n + k];
+        if (pivot == 0.0f) {
+            return false;
+        }
+        const float inv_pivot = 1.0f / pivot;
+        m[k*n + k] = 1.0f;
+        for (uint8_t j = 0; j < n; j++) {
+            m[k*n + j] *= inv_pivot;
+        }
+
+        // eliminate column k from the other rows
+        for (uint8_t i = 0; i < n; i++) {
+            if (i == k) {
+                continue;
+            }
+            const float f = m[i*n + k];
+            m[i*n + k] = 0.0f;
+            for (uint8_t j = 0; j < n; j++) {
+                m[i*n + j] -= f * m[k*n + j];
+            }
+        }
+    }
+
+    // undo the row swaps, as column swaps in the reverse order
+    for (int16_t k = n-1; k >= 0; k--) {
+        const uint8_t p = perm[k];
+        if (p != k) {
+            for (uint8_t i = 0; i < n; i++) {
+                const float t = m[i*n + k];
+                m[i*n + k] = m[i*n + p];
+                m[i*n + p] = t;
+            }
+        }
+    }
+
+    // check sanity of results
+    for (uint16_t i = 0; i < n*n; i++) {
+        if (isnan(m[i]) || isinf(m[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// matrix multiplication of two NxN matrices, out = A*B. out must not be A or B
+template <uint8_t N>
+void mat_mul(const float *A, const float *B, float *out)
+{
+    mat_mul_kernel(A, B, out, N);
+}
+
+/*
+  inverse of an NxN matrix. inv may be the same as A. Returns false if
+  the matrix is singular
+ */
+template <uint8_t N>
+bool mat_inverse(const float *A, float *inv)
+{
+    uint8_t perm[N];
+    if (inv != A) {
+        memcpy(inv, A, N*N*sizeof(float));
+    }
+    return mat_inverse_kernel(inv, N, perm);
+}
@@ -25,6 +25,45 @@
  */
 
 
+/*
+ *  Polygon_crosses(): test if the edge from V1 to V2 crosses the ray
+ *  used by Polygon_outside() from point P
+ */
+bool Polygon_crosses(const Vector2l &P, const Vector2l &V1, const Vector2l &V2)
+{
+    if ((V1.y > P.y) == (V2.y > P.y)) {
+        return false;
+    }
+    int32_t dx1, dx2, dy1, dy2;
+    dx1 = P.x - V1.x;
+    dx2 = V2.x - V1.x;
+    dy1 = P.y - V1.y;
+    dy2 = V2.y - V1.y;
+    int8_t dx1s, dx2s, dy1s, dy2s, m1, m2;
+#define sign(x) ((x)<0 ? -1 : 1)
+    dx1s = sign(dx1);
+    dx2s = sign(dx2);
+    dy1s = sign(dy1);
+    dy2s = sign(dy2);
+    m1 = dx1s * dy2s;
+    m2 = dx2s * dy1s;
+    // we avoid the 64 bit multiplies if we can based on sign checks.
+    if (dy2 < 0) {
+        if (m1 > m2) {
+            return true;
+        } else if (m1 < m2) {
+            return false;
+        }
+        return dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1;
+    }
+    if (m1 < m2) {
+        return true;
+    } else if (m1 > m2) {
+        return false;
+    }
+    return dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1;
+}
+
 /*
  *  Polygon_outside(): test for a point in a polygon
  *     Input:   P = a point,
@@ -40,39 +79,8 @@ bool Polygon_outside(const Vector2l &P, const Vector2l *V, unsigned n)
     unsigned i, j;
     bool outside = true;
     for (i = 0, j = n-1; i < n; j = i++) {
-        if ((V[i].y > P.y) == (V[j].y > P.y)) {
-            continue;
-        }
-        int32_t dx1, dx2, dy1, dy2;
-        dx1 = P.x - V[i].x;
-        dx2 = V[j].x - V[i].x;
-        dy1 = P.y - V[i].y;
-        dy2 = V[j].y - V[i].y;
-        int8_t dx1s, dx2s, dy1s, dy2s, m1, m2;
-#define sign(x) ((x)<0 ? -1 : 1)
-        dx1s = sign(dx1);
-        dx2s = sign(dx2);
-        dy1s = sign(dy1);
-        dy2s = sign(dy2);
-        m1 = dx1s * dy2s;
-        m2 = dx2s * dy1s;
-        // we avoid the 64 bit multiplies if we can based on sign checks.
-        if (dy2 < 0) {
-            if (m1 > m2) {
-                outside = !outside;
-            } else if (m1 < m2) {
-                continue;
-            } else if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
-                outside = !outside;
-            }
-        } else {
-            if (m1 < m2) {
-                outside = !outside;
-            } else if (m1 > m2) {
-                continue;
-            } else if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
-                outside = !outside;
-            }
+        if (Polygon_crosses(P, V[i], V[j])) {
+            outside = !outside;
         }
     }
     return outside;
@@ -17,6 +17,7 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+bool        Polygon_crosses(const Vector2l &P, const Vector2l &V1, const Vector2l &V2);
 bool        Polygon_outside(const Vector2l &P, const Vector2l *V, unsigned n);
 bool        Polygon_complete(const Vector2l *V, unsigned n);
 
@@ -0,0 +1,191 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/matrixN.h>
+
+typedef MatrixN<float,3,3> Matrix3N;
+
+static void make_matrix(float *m, uint8_t n, uint32_t seed)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        m[i] = ((seed >> 16) & 0x7fff) / 16384.0f - 1.0f;
+    }
+}
+
+template <uint8_t R, uint8_t C>
+static void make_matrix(MatrixN<float,R,C> &m, uint32_t seed)
+{
+    make_matrix(m[0], R*C, seed);
+}
+
+// the product done with plain loops
+template <uint8_t R, uint8_t K, uint8_t C>
+static void multiply(const MatrixN<float,R,K> &a, const MatrixN<float,K,C> &b, MatrixN<float,R,C> &out)
+{
+    for (uint8_t i = 0; i < R; i++) {
+        for (uint8_t j = 0; j < C; j++) {
+            float sum = 0;
+            for (uint8_t k = 0; k < K; k++) {
+                sum += a[i][k] * b[k][j];
+            }
+            out[i][j] = sum;
+        }
+    }
+}
+
+template <uint8_t R, uint8_t C>
+static void expect_equal(const MatrixN<float,R,C> &a, const MatrixN<float,R,C> &b)
+{
+    for (uint8_t i = 0; i < R; i++) {
+        for (uint8_t j = 0; j < C; j++) {
+            EXPECT_NEAR(a[i][j], b[i][j], 1.0e-5f);
+        }
+    }
+}
+
+TEST(MatrixNTest, Layout)
+{
+    Matrix3N m;
+    m(1, 2) = 5;
+    EXPECT_FLOAT_EQ(5, m[1][2]);
+    EXPECT_FLOAT_EQ(5, m[0][5]);
+
+    m.identity();
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            EXPECT_FLOAT_EQ(i == j ? 1 : 0, m(i, j));
+        }
+    }
+}
+
+TEST(MatrixNTest, ElementWise)
+{
+    MatrixN<float,4,6> a, b, c;
+    make_matrix(a, 1);
+    make_matrix(b, 2);
+    make_matrix(c, 3);
+
+    MatrixN<float,4,6> r;
+    r = a + b * 2.0f - 0.5f * c;
+    for (uint8_t i = 0; i < 4; i++) {
+        for (uint8_t j = 0; j < 6; j++) {
+            EXPECT_FLOAT_EQ(a[i][j] + b[i][j] * 2 - 0.5f * c[i][j], r[i][j]);
+        }
+    }
+
+    r = -a;
+    r += a;
+    for (uint8_t i = 0; i < 4; i++) {
+        for (uint8_t j = 0; j < 6; j++) {
+            EXPECT_FLOAT_EQ(0, r[i][j]);
+        }
+    }
+
+    MatrixN<float,6,4> t = a.transposed();
+    for (uint8_t i = 0; i < 4; i++) {
+        for (uint8_t j = 0; j < 6; j++) {
+            EXPECT_FLOAT_EQ(a[i][j], t[j][i]);
+        }
+    }
+}
+
+TEST(MatrixNTest, Product)
+{
+    MatrixN<float,4,5> a;
+    MatrixN<float,5,3> b;
+    MatrixN<float,3,2> c;
+    make_matrix(a, 4);
+    make_matrix(b, 5);
+    make_matrix(c, 6);
+
+    MatrixN<float,4,3> ab, ab2;
+    multiply(a, b, ab);
+    ab2.noalias() = a * b;
+    expect_equal(ab, ab2);
+
+    // a nested product
+    MatrixN<float,4,2> abc, abc2;
+    multiply(ab, c, abc);
+    abc2 = a * b * c;
+    expect_equal(abc, abc2);
+    abc2 = a * (b * c);
+    expect_equal(abc, abc2);
+
+    // products of transposes
+    MatrixN<float,5,4> at = a.transposed();
+    MatrixN<float,5,5> ata, ata2;
+    multiply(at, a, ata);
+    ata2 = a.transposed() * a;
+    expect_equal(ata, ata2);
+
+    // a product inside a sum
+    MatrixN<float,4,3> r;
+    r = a * b + ab;
+    for (uint8_t i = 0; i < 4; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            EXPECT_NEAR(2 * ab[i][j], r[i][j], 1.0e-5f);
+        }
+    }
+    r -= a * b;
+    expect_equal(ab, r);
+}
+
+TEST(MatrixNTest, Aliasing)
+{
+    MatrixN<float,6,6> f, p, fp;
+    make_matrix(f, 7);
+    make_matrix(p, 8);
+    multiply(f, p, fp);
+
+    // p is an operand of the product it is assigned
+    p = f * p;
+    expect_equal(fp, p);
+
+    MatrixN<float,6,6> q = p;
+    q.transpose();
+    MatrixN<float,6,6> qt = p.transposed();
+    expect_equal(q, qt);
+}
+
+TEST(MatrixNTest, SymmetricUpdate)
+{
+    MatrixN<float,9,9> f, p, q;
+    make_matrix(f, 9);
+    make_matrix(p, 10);
+    make_matrix(q, 11);
+    p.force_symmetry();
+    q.force_symmetry();
+    for (uint8_t i = 0; i < 9; i++) {
+        for (uint8_t j = 0; j < 9; j++) {
+            EXPECT_FLOAT_EQ(p[i][j], p[j][i]);
+        }
+    }
+
+    MatrixN<float,9,9> fp, fpft, ft = f.transposed();
+    multiply(f, p, fp);
+    multiply(fp, ft, fpft);
+    MatrixN<float,9,9> expected = fpft + q;
+
+    MatrixN<float,9,9> p2 = p;
+    p2 = f * p2 * f.transposed() + q;
+    expect_equal(expected, p2);
+
+    p.symmetric_update(f, q);
+    expect_equal(expected, p);
+}
+
+TEST(MatrixNTest, AddOuter)
+{
+    MatrixN<float,3,4> m;
+    const float u[3] = { 1, 2, 3 };
+    const float v[4] = { 4, 5, 6, 7 };
+    m.add_outer(-0.5f, u, v);
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 4; j++) {
+            EXPECT_FLOAT_EQ(-0.5f * u[i] * v[j], m[i][j]);
+        }
+    }
+}
+
+AP_GTEST_MAIN()
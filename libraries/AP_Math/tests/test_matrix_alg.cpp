@@ -0,0 +1,126 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+#define MAX_N 24
+
+// a diagonally dominant matrix, so it is well conditioned
+static void make_matrix(float *A, uint8_t n, uint32_t seed)
+{
+    for (uint16_t i = 0; i < n*n; i++) {
+        seed = seed * 1103515245 + 12345;
+        A[i] = ((seed >> 16) & 0x7fff) / 16384.0f - 1.0f;
+    }
+    for (uint8_t i = 0; i < n; i++) {
+        A[i*n + i] += n;
+    }
+}
+
+static void expect_identity(const float *A, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = 0; j < n; j++) {
+            EXPECT_NEAR(i == j ? 1.0f : 0.0f, A[i*n + j], 1.0e-5f);
+        }
+    }
+}
+
+TEST(MatrixAlgTest, Multiply)
+{
+    const float A[4] = { 1, 2, 3, 4 };
+    const float B[4] = { 5, 6, 7, 8 };
+    float out[4];
+
+    mat_mul(A, B, out, 2);
+    EXPECT_FLOAT_EQ(19, out[0]);
+    EXPECT_FLOAT_EQ(22, out[1]);
+    EXPECT_FLOAT_EQ(43, out[2]);
+    EXPECT_FLOAT_EQ(50, out[3]);
+
+    float out2[4];
+    mat_mul<2>(A, B, out2);
+    for (uint8_t i = 0; i < 4; i++) {
+        EXPECT_FLOAT_EQ(out[i], out2[i]);
+    }
+}
+
+TEST(MatrixAlgTest, Inverse)
+{
+    float A[MAX_N*MAX_N], inv[MAX_N*MAX_N], I[MAX_N*MAX_N];
+
+    for (uint8_t n = 1; n <= MAX_N; n++) {
+        make_matrix(A, n, n);
+        EXPECT_TRUE(mat_inverse(A, inv, n));
+        mat_mul(A, inv, I, n);
+        expect_identity(I, n);
+        mat_mul(inv, A, I, n);
+        expect_identity(I, n);
+    }
+}
+
+TEST(MatrixAlgTest, InverseNeedsPivoting)
+{
+    // zero on the diagonal, so this fails without row swaps
+    float A[9] = { 0, 1, 2,
+                   1, 0, 3,
+                   4, -3, 8 };
+    float inv[9], I[9];
+
+    EXPECT_TRUE(mat_inverse(A, inv, 3));
+    mat_mul(A, inv, I, 3);
+    expect_identity(I, 3);
+}
+
+TEST(MatrixAlgTest, InverseFixedSize)
+{
+    float A[81], inv[81], inv2[81];
+
+    make_matrix(A, 6, 6);
+    EXPECT_TRUE(mat_inverse<6>(A, inv));
+    EXPECT_TRUE(mat_inverse(A, inv2, 6));
+    for (uint8_t i = 0; i < 36; i++) {
+        EXPECT_FLOAT_EQ(inv2[i], inv[i]);
+    }
+
+    // matches the closed form inverses
+    make_matrix(A, 3, 3);
+    EXPECT_TRUE(mat_inverse<3>(A, inv));
+    EXPECT_TRUE(inverse3x3(A, inv2));
+    for (uint8_t i = 0; i < 9; i++) {
+        EXPECT_NEAR(inv2[i], inv[i], 1.0e-6f);
+    }
+    make_matrix(A, 4, 4);
+    EXPECT_TRUE(mat_inverse<4>(A, inv));
+    EXPECT_TRUE(inverse4x4(A, inv2));
+    for (uint8_t i = 0; i < 16; i++) {
+        EXPECT_NEAR(inv2[i], inv[i], 1.0e-6f);
+    }
+}
+
+TEST(MatrixAlgTest, InverseInPlace)
+{
+    float A[81], inv[81];
+
+    make_matrix(A, 9, 9);
+    EXPECT_TRUE(mat_inverse(A, inv, 9));
+    EXPECT_TRUE(inverse(A, A, 9));
+    for (uint8_t i = 0; i < 81; i++) {
+        EXPECT_FLOAT_EQ(inv[i], A[i]);
+    }
+}
+
+TEST(MatrixAlgTest, Singular)
+{
+    float A[9] = { 1, 2, 3,
+                   2, 4, 6,
+                   1, 0, 1 };
+    float inv[9];
+
+    EXPECT_FALSE(mat_inverse(A, inv, 3));
+    EXPECT_FALSE(mat_inverse<3>(A, inv));
+
+    float Z[25] {};
+    EXPECT_FALSE(mat_inverse(Z, inv, 5));
+}
+
+AP_GTEST_MAIN()
@@ -46,6 +46,10 @@ void AP_Mission::init()
         AP_HAL::panic("AP_Mission Content must be 12 bytes");
     }
 
+    // decode the stored commands once, so the mission doesn't go back to
+    // storage at each waypoint
+    cache_load();
+
     _last_change_time_ms = AP_HAL::millis();
 }
 
@@ -261,6 +265,9 @@ bool AP_Mission::get_next_nav_cmd(uint16_t start_index, Mission_Command& cmd)
 
     // search until the end of the mission command list
     while(cmd_index < (unsigned)_cmd_total) {
+        // skip "do" commands without reading them
+        cmd_index = cache_next_nav_or_jump(cmd_index);
+
         // get next command
         if (!get_next_cmd(cmd_index, cmd, false)) {
             // no more commands so return failure
@@ -418,24 +425,32 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         cmd.id = MAV_CMD_NAV_WAYPOINT;
         cmd.p1 = 0;
         cmd.content.location = _ahrs.get_home();
+    }else if (index < _cache_size) {
+        cmd = _cache[index];
     }else{
-        // Find out proper location in memory by using the start_byte position + the index
-        // we can load a command, we don't process it yet
-        // read WP position
-        uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
-
-        cmd.id = _storage.read_byte(pos_in_storage);
-        cmd.p1 = _storage.read_uint16(pos_in_storage+1);
-        _storage.read_block(cmd.content.bytes, pos_in_storage+3, 12);
-
-        // set command's index to it's position in eeprom
-        cmd.index = index;
+        read_cmd_raw(index, cmd);
     }
 
     // return success
     return true;
 }
 
+/// read_cmd_raw - decode a command from storage without any checks
+void AP_Mission::read_cmd_raw(uint16_t index, Mission_Command& cmd) const
+{
+    // Find out proper location in memory by using the start_byte position + the index
+    // we can load a command, we don't process it yet
+    // read WP position
+    uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
+
+    cmd.id = _storage.read_byte(pos_in_storage);
+    cmd.p1 = _storage.read_uint16(pos_in_storage+1);
+    _storage.read_block(cmd.content.bytes, pos_in_storage+3, 12);
+
+    // set command's index to it's position in eeprom
+    cmd.index = index;
+}
+
 /// write_cmd_to_storage - write a command to storage
 ///     index is used to calculate the storage location
 ///     true is returned if successful
@@ -453,6 +468,13 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, Mission_Command& cmd)
     _storage.write_uint16(pos_in_storage+1, cmd.p1);
     _storage.write_block(pos_in_storage+3, cmd.content.bytes, 12);
 
+    // keep the cache in step with storage
+    if (index < _cache_size) {
+        _cache[index] = cmd;
+        _cache[index].index = index;
+        _cache_index_valid = false;
+    }
+
     // remember when the mission last changed
     _last_change_time_ms = AP_HAL::millis();
 
@@ -1459,3 +1481,64 @@ uint16_t AP_Mission::get_landing_sequence_start()
     return landing_start_index;
 }
 
+///
+/// command cache methods
+///
+
+/// cache_load - load the decoded commands into RAM. The cache covers
+///     the first AP_MISSION_CACHE_MAX commands that fit in storage, and
+///     is left empty if there isn't enough memory
+void AP_Mission::cache_load()
+{
+#if AP_MISSION_CACHE_MAX > 0
+    if (_cache != NULL) {
+        return;
+    }
+
+    uint16_t size = MIN(num_commands_max(), AP_MISSION_CACHE_MAX);
+    Mission_Command *cache = new Mission_Command[size];
+    uint16_t *next = new uint16_t[size];
+    if (cache == NULL || next == NULL) {
+        delete[] cache;
+        delete[] next;
+        return;
+    }
+
+    // command #0 is home and is always taken from ahrs, so it is never
+    // read from the cache
+    for (uint16_t i=AP_MISSION_FIRST_REAL_COMMAND; i<size; i++) {
+        read_cmd_raw(i, cache[i]);
+    }
+
+    _cache = cache;
+    _cache_next = next;
+    _cache_size = size;
+    _cache_index_valid = false;
+#endif
+}
+
+/// cache_next_nav_or_jump - returns the index of the first "navigation" or do-jump command at or after index
+///     returns index itself if the command isn't cached
+uint16_t AP_Mission::cache_next_nav_or_jump(uint16_t index)
+{
+    if (index >= _cache_size) {
+        return index;
+    }
+
+    if (!_cache_index_valid) {
+        // home counts as a navigation command. Runs of "do" commands at
+        // the end of the cache point past it, to the first command read
+        // from storage
+        uint16_t next_index = _cache_size;
+        for (uint16_t i=_cache_size; i>0; i--) {
+            const Mission_Command &cmd = _cache[i-1];
+            if (i-1 == 0 || is_nav_cmd(cmd) || cmd.id == MAV_CMD_DO_JUMP) {
+                next_index = i-1;
+            }
+            _cache_next[i-1] = next_index;
+        }
+        _cache_index_valid = true;
+    }
+
+    return _cache_next[index];
+}
@@ -40,6 +40,18 @@
 
 #define AP_MISSION_RESTART_DEFAULT          0       // resume the mission from the last command run by default
 
+// maximum number of commands held decoded in RAM, 0 disables the cache.
+// Commands beyond this are read from storage when needed
+#ifndef AP_MISSION_CACHE_MAX
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define AP_MISSION_CACHE_MAX                1024
+#elif HAL_CPU_CLASS >= HAL_CPU_CLASS_150
+#define AP_MISSION_CACHE_MAX                256
+#else
+#define AP_MISSION_CACHE_MAX                0
+#endif
+#endif
+
 /// @class    AP_Mission
 /// @brief    Object managing Mission
 class AP_Mission {
@@ -240,7 +252,11 @@ public:
         _mission_complete_fn(mission_complete_fn),
         _prev_nav_cmd_index(AP_MISSION_CMD_INDEX_NONE),
         _prev_nav_cmd_wp_index(AP_MISSION_CMD_INDEX_NONE),
-        _last_change_time_ms(0)
+        _last_change_time_ms(0),
+        _cache(NULL),
+        _cache_next(NULL),
+        _cache_size(0),
+        _cache_index_valid(false)
     {
         // load parameter defaults
         AP_Param::setup_object_defaults(this, var_info);
@@ -440,6 +456,19 @@ private:
     /// command list will be cleared if they do not match
     void check_eeprom_version();
 
+    /// read_cmd_raw - decode a command from storage without any checks
+    void read_cmd_raw(uint16_t index, Mission_Command& cmd) const;
+
+    ///
+    /// command cache methods
+    ///
+    /// cache_load - load the decoded commands into RAM
+    void cache_load();
+
+    /// cache_next_nav_or_jump - returns the index of the first "navigation" or do-jump command at or after index
+    ///     returns index itself if the command isn't cached
+    uint16_t cache_next_nav_or_jump(uint16_t index);
+
     // references to external libraries
     const AP_AHRS&   _ahrs;      // used only for home position
 
@@ -466,6 +495,14 @@ private:
 
     // last time that mission changed
     uint32_t _last_change_time_ms;
+
+    // decoded copy of the first _cache_size commands in storage, kept
+    // up to date by write_cmd_to_storage, and for each of them the
+    // index of the first "navigation" or do-jump command at or after it
+    Mission_Command *_cache;
+    uint16_t *_cache_next;
+    uint16_t _cache_size;
+    bool _cache_index_valid;
 };
 
 #endif
@@ -45,7 +45,7 @@ void SoloGimbalEKF::reset()
 {
     memset(&states,0,sizeof(states));
     memset(&gSense,0,sizeof(gSense));
-    memset(&Cov,0,sizeof(Cov));
+    Cov.zero();
     TiltCorrection = 0;
     StartTime_ms = 0;
     FiltInit = false;
@@ -487,7 +487,7 @@ void SoloGimbalEKF::predictCovariance()
     float t1625 = Cov[2][8]*t1526;
     float t1626 = Cov[0][8]*t1523;
     float t1627 = Cov[5][8]+t1625+t1626-Cov[1][8]*t1521;
-    float nextCov[9][9];
+    MatrixN<float,9,9> nextCov;
     nextCov[0][0] = daxNoise*t1485+t1397*t1424+t1411*t1431-t1419*t1432-t1402*t1454;
     nextCov[1][0] = -t1397*t1478-t1411*t1481+t1419*t1484+t1402*(t1527+t1528-Cov[1][6]*t1468-Cov[2][6]*t1472);
     nextCov[2][0] = -t1397*t1538-t1411*t1541+t1419*t1544+t1402*(t1553+t1554-Cov[0][6]*t1491-Cov[2][6]*t1503);
@@ -575,20 +575,13 @@ void SoloGimbalEKF::predictCovariance()
         nextCov[i][i] = nextCov[i][i] + delAngBiasVariance;
     }
 
-    // copy predicted variances whilst constraining to be non-negative
+    // copy elements to covariance matrix whilst enforcing symmetry
+    Cov = (nextCov + nextCov.transposed()) * 0.5f;
+
+    // constrain predicted variances to be non-negative
     for (uint8_t index=0; index<=8; index++) {
-        if (nextCov[index][index] < 0.0f) {
+        if (Cov[index][index] < 0.0f) {
             Cov[index][index] = 0.0f;
-        } else {
-            Cov[index][index] = nextCov[index][index];
-        }
-    }
-
-    // copy elements to covariance matrix whilst enforcing symmetry
-    for (uint8_t rowIndex=1; rowIndex<=8; rowIndex++) {
-        for (uint8_t colIndex=0; colIndex<=rowIndex-1; colIndex++) {
-            Cov[rowIndex][colIndex] = 0.5f*(nextCov[rowIndex][colIndex] + nextCov[colIndex][rowIndex]);
-            Cov[colIndex][rowIndex] = Cov[rowIndex][colIndex];
         }
     }
 
@@ -648,12 +641,11 @@ void SoloGimbalEKF::fuseVelocity()
         // re-normalise the quaternion
         state.quat.normalize();
 
-        // Update the covariance
-        for (uint8_t rowIndex=0;rowIndex<=8;rowIndex++) {
-            for (uint8_t colIndex=0;colIndex<=8;colIndex++) {
-                Cov[rowIndex][colIndex] = Cov[rowIndex][colIndex] - K[rowIndex]*Cov[stateIndex][colIndex];
-            }
-        }
+        // Update the covariance using P = P - K*H*P, where H*P is the
+        // row of the observed state from before the update
+        float HP[9];
+        memcpy(HP, Cov[stateIndex], sizeof(HP));
+        Cov.add_outer(-1.0f, K, HP);
 
         // force symmetry and constrain diagonals to be non-negative
         fixCovariance();
@@ -820,11 +812,7 @@ void SoloGimbalEKF::fuseCompass()
             HP[colIndex] += H_MAG[rowIndex]*Cov[rowIndex][colIndex];
         }
     }
-    for (uint8_t rowIndex=0;rowIndex<=8;rowIndex++) {
-        for (uint8_t colIndex=0;colIndex<=8;colIndex++) {
-            Cov[rowIndex][colIndex] -= K_MAG[rowIndex] * HP[colIndex];
-        }
-    }
+    Cov.add_outer(-1.0f, K_MAG, HP);
 
     // force symmetry and constrain diagonals to be non-negative
     fixCovariance();
@@ -910,12 +898,7 @@ float SoloGimbalEKF::calcMagHeadingInnov()
 void SoloGimbalEKF::fixCovariance()
 {
     // force symmetry
-    for (uint8_t rowIndex=1; rowIndex<=8; rowIndex++) {
-        for (uint8_t colIndex=0; colIndex<=rowIndex-1; colIndex++) {
-            Cov[rowIndex][colIndex] = 0.5f*(Cov[rowIndex][colIndex] + Cov[colIndex][rowIndex]);
-            Cov[colIndex][rowIndex] = Cov[rowIndex][colIndex];
-        }
-    }
+    Cov.force_symmetry();
 
     // constrain diagonals to be non-negative
     for (uint8_t index=1; index<=8; index++) {
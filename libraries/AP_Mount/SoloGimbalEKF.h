@@ -32,6 +32,7 @@
 #include <AP_NavEKF/AP_NavEKF.h>
 
 #include <AP_Math/vectorN.h>
+#include <AP_Math/matrixN.h>
 
 class SoloGimbalEKF
 {
@@ -125,7 +126,7 @@ private:
         float gTheta;
     } gSense;
 
-    float Cov[9][9];                // covariance matrix
+    MatrixN<float,9,9> Cov;         // covariance matrix
     Matrix3f Tsn;                   // Sensor to NED rotation matrix
     float TiltCorrection;           // Angle correction applied to tilt from last velocity fusion (rad)
     bool newDataMag;                // true when new magnetometer data is waiting to be used
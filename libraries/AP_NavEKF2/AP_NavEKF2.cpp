@@ -427,6 +427,21 @@ const AP_Param::GroupInfo NavEKF2::var_info[] = {
     // @Units: m/s
     AP_GROUPINFO("NOAID_NOISE", 35, NavEKF2, _noaidHorizNoise, 10.0f),
 
+    // @Param: TIMING
+    // @DisplayName: Filter update stage timing
+    // @Description: This enables timing of each stage of the filter update (strapdown, covariance prediction, and each fusion type) for each core. The minimum, mean and maximum times and the number of fusions are logged in NKT messages once a second. When sending is enabled along with timing they are also sent to the GCS as EKF_TIMING messages, sending alone does nothing. This has a small cost in CPU load and is intended for development.
+    // @Bitmask: 0:Enable,1:SendToGCS
+    // @User: Advanced
+    AP_GROUPINFO("TIMING", 36, NavEKF2, _timing, 0),
+
+    // @Param: CKPT
+    // @DisplayName: Filter checkpoints
+    // @Description: This enables checkpoints of the filter. When storing is enabled each core keeps a checkpoint of its states, covariances and IMU history, taken once a second while it is aligned and healthy, and one is logged in NKC messages every 10 seconds so that Replay can start from it. When lane restore is enabled a core that has been unhealthy for 5 seconds while the primary core is healthy is restored from a checkpoint of the primary core. Each core needs about 7kB of memory for its checkpoints. Set before the filter starts.
+    // @Bitmask: 0:Store,1:RestoreLanes
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("CKPT", 37, NavEKF2, _checkpoint, 0),
+
     AP_GROUPEND
 };
 
@@ -462,6 +477,8 @@ NavEKF2::NavEKF2(const AP_AHRS *ahrs, AP_Baro &baro, const RangeFinder &rng) :
     fusionTimeStep_ms(10)           // The minimum number of msec between covariance prediction and fusion operations
 {
     AP_Param::setup_object_defaults(this, var_info);
+    memset(_timing_send_index, 0, sizeof(_timing_send_index));
+    memset(_coreHealthyTime_ms, 0, sizeof(_coreHealthyTime_ms));
 }
 
 
@@ -471,6 +488,22 @@ bool NavEKF2::InitialiseFilter(void)
     if (_enable == 0) {
         return false;
     }
+    if (!setupCores()) {
+        return false;
+    }
+
+    // initialse the cores. We return success only if all cores
+    // initialise successfully
+    bool ret = true;
+    for (uint8_t i=0; i<num_cores; i++) {
+        ret &= core[i].InitialiseFilterBootstrap();
+    }
+    return ret;
+}
+
+// allocate and setup the cores if not done already
+bool NavEKF2::setupCores(void)
+{
     if (core == nullptr) {
 
         // don't run multiple filters for 1 IMU
@@ -513,14 +546,7 @@ bool NavEKF2::InitialiseFilter(void)
         // Set the primary initially to be the lowest index
         primary = 0;
     }
-
-    // initialse the cores. We return success only if all cores
-    // initialise successfully
-    bool ret = true;
-    for (uint8_t i=0; i<num_cores; i++) {
-        ret &= core[i].InitialiseFilterBootstrap();
-    }
-    return ret;
+    return true;
 }
 
 // Update Filter States - this should be called whenever new IMU data is available
@@ -558,6 +584,41 @@ void NavEKF2::UpdateFilter(void)
             }
         }
     }
+
+    if (_checkpoint & EK2_CKPT_RESTORE_LANES) {
+        restoreFailedCores();
+    }
+}
+
+/*
+  restore cores that have been unhealthy for EKF2_CHECKPOINT_LANE_RESTORE_MS
+  from a checkpoint of the healthy primary taken now, instead of
+  waiting for them to recover
+ */
+void NavEKF2::restoreFailedCores(void)
+{
+    const uint32_t now = AP_HAL::millis();
+    const bool primaryHealthy = core[primary].healthy();
+    for (uint8_t i=0; i<num_cores; i++) {
+        if (i == primary || !primaryHealthy || core[i].healthy()) {
+            _coreHealthyTime_ms[i] = now;
+            continue;
+        }
+        if (now - _coreHealthyTime_ms[i] < EKF2_CHECKPOINT_LANE_RESTORE_MS) {
+            continue;
+        }
+        // wait again before another attempt whatever happens
+        _coreHealthyTime_ms[i] = now;
+        if (!core[primary].storeCheckpoint()) {
+            continue;
+        }
+        uint16_t length;
+        const uint8_t *data = core[primary].getCheckpoint(length);
+        if (core[i].restoreCheckpoint(data, length)) {
+            GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_WARNING, "EKF2 core %u restored from core %u",
+                                             (unsigned)i, (unsigned)primary);
+        }
+    }
 }
 
 // Check basic filter health metrics and return a consolidated health status
@@ -965,6 +1026,61 @@ void NavEKF2::send_status_report(mavlink_channel_t chan)
     }
 }
 
+// timing of the filter update stages of a core
+EKF2_Timing *NavEKF2::getStageTiming(uint8_t instance)
+{
+    if (!core || instance >= num_cores) {
+        return nullptr;
+    }
+    return &core[instance].getStageTiming();
+}
+
+// send the timing of one stage of one core, going through all of them in turn
+void NavEKF2::send_timing(mavlink_channel_t chan)
+{
+    // nothing is gathered unless timing is enabled, so both bits are needed
+    const uint8_t send_mask = EK2_TIMING_ENABLE | EK2_TIMING_SEND;
+    if (!core || (_timing & send_mask) != send_mask || chan >= MAVLINK_COMM_NUM_BUFFERS) {
+        return;
+    }
+    if (_timing_send_index[chan] >= num_cores * EKF2_NUM_STAGES) {
+        _timing_send_index[chan] = 0;
+    }
+    const uint8_t index = _timing_send_index[chan]++;
+    const uint8_t instance = index / EKF2_NUM_STAGES;
+    const uint8_t stage = index % EKF2_NUM_STAGES;
+    const EKF2_Timing &timing = core[instance].getStageTiming();
+    const EKF2_Timing::Stage &s = timing.get_report(stage);
+    mavlink_msg_ekf_timing_send(
+        chan,
+        timing.get_report_ms(),
+        s.count ? EKF2_Timing::ticks_to_us(s.min_ticks) : 0,
+        s.count ? EKF2_Timing::ticks_to_us(s.sum_ticks) / s.count : 0,
+        EKF2_Timing::ticks_to_us(s.max_ticks),
+        s.count,
+        s.fusions,
+        instance,
+        stage);
+}
+
+// the next piece of a checkpoint of a core to log
+bool NavEKF2::getCheckpointLogChunk(uint8_t instance, uint8_t &seq, uint8_t &count, uint8_t chunk[EKF2_CHECKPOINT_CHUNK])
+{
+    if (!core || instance >= num_cores) {
+        return false;
+    }
+    return core[instance].getCheckpointLogChunk(seq, count, chunk);
+}
+
+// start a core from a checkpoint
+bool NavEKF2::restoreCheckpoint(uint8_t instance, const uint8_t *data, uint16_t length)
+{
+    if (_enable == 0 || !setupCores() || instance >= num_cores) {
+        return false;
+    }
+    return core[instance].restoreCheckpoint(data, length);
+}
+
 // provides the height limit to be observed by the control loops
 // returns false if no height limiting is required
 // this is needed to ensure the vehicle does not fly too high when using optical flow navigation
@@ -31,6 +31,8 @@
 #include <AP_Compass/AP_Compass.h>
 #include <AP_NavEKF/AP_Nav_Common.h>
 #include <AP_RangeFinder/AP_RangeFinder.h>
+#include <AP_NavEKF2/AP_NavEKF2_Timing.h>
+#include <AP_NavEKF2/AP_NavEKF2_Checkpoint.h>
 
 class NavEKF2_core;
 class AP_AHRS;
@@ -244,6 +246,20 @@ public:
     // send an EKF_STATUS_REPORT message to GCS
     void send_status_report(mavlink_channel_t chan);
 
+    // timing of the filter update stages of a core, nullptr if there is no such core
+    EKF2_Timing *getStageTiming(uint8_t instance);
+
+    // send the timing of the next core and stage as an EKF_TIMING message, if enabled in EK2_TIMING
+    void send_timing(mavlink_channel_t chan);
+
+    // the next piece of a checkpoint of a core to log, see EK2_CKPT
+    // returns false when there is nothing to log
+    bool getCheckpointLogChunk(uint8_t instance, uint8_t &seq, uint8_t &count, uint8_t chunk[EKF2_CHECKPOINT_CHUNK]);
+
+    // start a core from a checkpoint instead of from the sensors, used by Replay
+    // returns false if the checkpoint does not fit the core
+    bool restoreCheckpoint(uint8_t instance, const uint8_t *data, uint16_t length);
+
     // provides the height limit to be observed by the control loops
     // returns false if no height limiting is required
     // this is needed to ensure the vehicle does not fly too high when using optical flow navigation
@@ -312,6 +328,15 @@ private:
     AP_Int8 _imuMask;               // Bitmask of IMUs to instantiate EKF2 for
     AP_Int16 _gpsCheckScaler;       // Percentage increase to be applied to GPS pre-flight accuracy and drift thresholds
     AP_Float _noaidHorizNoise;      // horizontal position measurement noise assumed when synthesised zero position measurements are used to constrain attitude drift : m
+    AP_Int8 _timing;                // Bitmask enabling timing of the filter update stages, EK2_TIMING_*
+
+    AP_Int8 _checkpoint;            // Bitmask enabling checkpoints of the cores, EK2_CKPT_*
+
+    // next core and stage of the timing to send on each channel
+    uint8_t _timing_send_index[MAVLINK_COMM_NUM_BUFFERS];
+
+    // last time each core was healthy, or not restored because the primary wasn't (msec)
+    uint32_t _coreHealthyTime_ms[EKF2_CHECKPOINT_MAX_CORES];
 
     // Tuning parameters
     const float gpsNEVelVarAccScale;    // Scale factor applied to NE velocity measurement variance due to manoeuvre acceleration
@@ -340,6 +365,12 @@ private:
     const float gndEffectBaroScaler;    // scaler applied to the barometer observation variance when ground effect mode is active
     const uint8_t gndGradientSigma;     // RMS terrain gradient percentage assumed by the terrain height estimation
     const uint8_t fusionTimeStep_ms;    // The minimum time interval between covariance predictions and measurement fusions in msec
+
+    // allocate and setup the cores if not done already
+    bool setupCores(void);
+
+    // restore failed cores from a checkpoint of the primary, see EK2_CKPT
+    void restoreFailedCores(void);
 };
 
 #endif //AP_NavEKF2
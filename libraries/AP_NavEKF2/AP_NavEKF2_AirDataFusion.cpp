@@ -30,6 +30,7 @@ void NavEKF2_core::FuseAirspeed()
 {
     // start performance timer
     hal.util->perf_begin(_perf_FuseAirspeed);
+    stageTiming.fused(EKF2_STAGE_TAS);
 
     // declarations
     float vn;
@@ -147,43 +148,23 @@ void NavEKF2_core::FuseAirspeed()
             stateStruct.quat.rotate(stateStruct.angErr);
 
             // correct the covariance P = (I - K*H)*P
-            // take advantage of the empty columns in KH to reduce the
+            // take advantage of the empty columns in H to reduce the
             // number of operations
-            for (unsigned i = 0; i<=stateIndexLim; i++) {
-                for (unsigned j = 0; j<=2; j++) {
-                    KH[i][j] = 0.0f;
-                }
-                for (unsigned j = 3; j<=5; j++) {
-                    KH[i][j] = Kfusion[i] * H_TAS[j];
-                }
-                for (unsigned j = 6; j<=21; j++) {
-                    KH[i][j] = 0.0f;
-                }
-                for (unsigned j = 22; j<=23; j++) {
-                    KH[i][j] = Kfusion[i] * H_TAS[j];
-                }
-            }
+            Vector24 HP;
             for (unsigned j = 0; j<=stateIndexLim; j++) {
-                for (unsigned i = 0; i<=stateIndexLim; i++) {
-                    ftype res = 0;
-                    res += KH[i][3] * P[3][j];
-                    res += KH[i][4] * P[4][j];
-                    res += KH[i][5] * P[5][j];
-                    res += KH[i][22] * P[22][j];
-                    res += KH[i][23] * P[23][j];
-                    KHP[i][j] = res;
-                }
-            }
-            for (unsigned i = 0; i<=stateIndexLim; i++) {
-                for (unsigned j = 0; j<=stateIndexLim; j++) {
-                    P[i][j] = P[i][j] - KHP[i][j];
-                }
+                ftype res = 0;
+                res += H_TAS[3] * P[3][j];
+                res += H_TAS[4] * P[4][j];
+                res += H_TAS[5] * P[5][j];
+                res += H_TAS[22] * P[22][j];
+                res += H_TAS[23] * P[23][j];
+                HP[j] = res;
             }
+            EKF2_UpdateCovariance(P, Kfusion, HP, stateIndexLim);
         }
     }
 
-    // force the covariance matrix to me symmetrical and limit the variances to prevent ill-condiioning.
-    ForceSymmetry();
+    // limit the variances to prevent ill-condiioning.
     ConstrainVariances();
 
     // stop performance timer
@@ -256,6 +237,7 @@ void NavEKF2_core::FuseSideslip()
 {
     // start performance timer
     hal.util->perf_begin(_perf_FuseSideslip);
+    stageTiming.fused(EKF2_STAGE_BETA);
 
     // declarations
     float q0;
@@ -395,42 +377,25 @@ void NavEKF2_core::FuseSideslip()
         stateStruct.quat.rotate(stateStruct.angErr);
 
         // correct the covariance P = (I - K*H)*P
-        // take advantage of the empty columns in KH to reduce the
+        // take advantage of the empty columns in H to reduce the
         // number of operations
-        for (unsigned i = 0; i<=stateIndexLim; i++) {
-            for (unsigned j = 0; j<=5; j++) {
-                KH[i][j] = Kfusion[i] * H_BETA[j];
-            }
-            for (unsigned j = 6; j<=21; j++) {
-                KH[i][j] = 0.0f;
-            }
-            for (unsigned j = 22; j<=23; j++) {
-                KH[i][j] = Kfusion[i] * H_BETA[j];
-            }
-        }
+        Vector24 HP;
         for (unsigned j = 0; j<=stateIndexLim; j++) {
-            for (unsigned i = 0; i<=stateIndexLim; i++) {
-                ftype res = 0;
-                res += KH[i][0] * P[0][j];
-                res += KH[i][1] * P[1][j];
-                res += KH[i][2] * P[2][j];
-                res += KH[i][3] * P[3][j];
-                res += KH[i][4] * P[4][j];
-                res += KH[i][5] * P[5][j];
-                res += KH[i][22] * P[22][j];
-                res += KH[i][23] * P[23][j];
-                KHP[i][j] = res;
-            }
-        }
-        for (unsigned i = 0; i<=stateIndexLim; i++) {
-            for (unsigned j = 0; j<=stateIndexLim; j++) {
-                P[i][j] = P[i][j] - KHP[i][j];
-            }
+            ftype res = 0;
+            res += H_BETA[0] * P[0][j];
+            res += H_BETA[1] * P[1][j];
+            res += H_BETA[2] * P[2][j];
+            res += H_BETA[3] * P[3][j];
+            res += H_BETA[4] * P[4][j];
+            res += H_BETA[5] * P[5][j];
+            res += H_BETA[22] * P[22][j];
+            res += H_BETA[23] * P[23][j];
+            HP[j] = res;
         }
+        EKF2_UpdateCovariance(P, Kfusion, HP, stateIndexLim);
     }
 
-    // force the covariance matrix to me symmetrical and limit the variances to prevent ill-condiioning.
-    ForceSymmetry();
+    // limit the variances to prevent ill-condiioning.
     ConstrainVariances();
 
     // stop the performance timer
@@ -4,112 +4,108 @@
 
 // this buffer model is to be used for observation buffers,
 // the data is pushed into buffer like any standard ring buffer
-// return is based on the sample time provided
-template <typename element_type>
+// return is based on the sample time provided.
+// The capacity is fixed at compile time and must be a power of two,
+// so the buffer needs no allocation and wraps with a mask
+template <typename element_type, uint16_t capacity>
 class obs_ring_buffer_t
 {
-public:
-    struct element_t{
-        element_type element;
-    } *buffer;
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
 
-    // initialise buffer, returns false when allocation has failed
-    bool init(uint32_t size)
+public:
+    obs_ring_buffer_t()
     {
-        buffer = new element_t[size];
-        if(buffer == NULL)
-        {
-            return false;
-        }
-        memset(buffer,0,size*sizeof(element_t));
-        _size = size;
-        _head = 0;
-        _tail = 0;
-        _new_data = false;
-        return true;
+        reset();
     }
 
     /*
      * Searches through a ring buffer and return the newest data that is older than the
      * time specified by sample_time_ms
-     * Zeros old data so it cannot not be used again
+     * Drops that data and all older data so it cannot be used again
      * Returns false if no data can be found that is less than 100msec old
+     * Data is kept in time order by push(), so the search is a binary search
     */
-
-    bool recall(element_type &element,uint32_t sample_time)
+    bool recall(element_type &element, uint32_t sample_time)
     {
-        if(!_new_data) {
-            return false;
-        }
-        bool success = false;
-        uint8_t tail = _tail, bestIndex;
-
-        if(_head == tail) {
-            if (buffer[tail].element.time_ms != 0 && buffer[tail].element.time_ms <= sample_time) {
-                // if head is equal to tail just check if the data is unused and within time horizon window
-                if (((sample_time - buffer[tail].element.time_ms) < 100)) {
-                    bestIndex = tail;
-                    success = true;
-                    _new_data = false;
-                }
-            }
-        } else {
-            while(_head != tail) {
-                // find a measurement older than the fusion time horizon that we haven't checked before
-                if (buffer[tail].element.time_ms != 0 && buffer[tail].element.time_ms <= sample_time) {
-                    // Find the most recent non-stale measurement that meets the time horizon criteria
-                    if (((sample_time - buffer[tail].element.time_ms) < 100)) {
-                        bestIndex = tail;
-                        success = true;
-                    }
-                } else if(buffer[tail].element.time_ms > sample_time){
-                    break;
-                }
-                tail = (tail+1)%_size;
+        // find how many of the stored elements are not newer than the sample time
+        uint16_t lo = 0, hi = _count;
+        while (lo < hi) {
+            const uint16_t mid = (lo + hi) / 2;
+            if (at(mid).time_ms <= sample_time) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
             }
         }
+        if (lo == 0) {
+            return false;
+        }
 
+        // the newest of them is either used now or too old to ever be used
+        const element_type &best = at(lo - 1);
+        const bool success = (sample_time - best.time_ms) < 100;
         if (success) {
-            element = buffer[bestIndex].element;
-            _tail = (bestIndex+1)%_size;
-            //make time zero to stop using it again, 
-            //resolves corner case of reusing the element when head == tail
-            buffer[bestIndex].element.time_ms = 0;
-            return true;
-        } else {
-            return false;
+            element = best;
         }
+        _count -= lo;
+        return success;
     }
 
     /*
      * Writes data and timestamp to a Ring buffer and advances indices that
      * define the location of the newest and oldest data
+     * When the buffer is full the oldest data is overwritten
+     * Data older than the newest stored is inserted in time order, as some
+     * sensors (eg the median filtered range finder) stamp it out of order
     */
-    inline void push(element_type element)
+    inline void push(const element_type &element)
     {
-        // Advance head to next available index
-        _head = (_head+1)%_size;
-        // New data is written at the head
-        buffer[_head].element = element;
-        _new_data = true;
-    }
-    // writes the same data to all elements in the ring buffer
-    inline void reset_history(element_type element, uint32_t sample_time) {
-        for (uint8_t index=0; index<_size; index++) {
-            buffer[index].element = element;
+        if (_count == capacity) {
+            if (element.time_ms < at(0).time_ms) {
+                // it would be the oldest, so it is the one overwritten
+                return;
+            }
+            _count--;
+        }
+        uint16_t k = _count;
+        while (k > 0 && at(k - 1).time_ms > element.time_ms) {
+            slot(k) = at(k - 1);
+            k--;
         }
+        slot(k) = element;
+        _head = (_head + 1) & (capacity - 1);
+        _count++;
     }
 
-    // zeroes all data in the ring buffer
-    inline void reset() {
+    // empties the ring buffer
+    inline void reset()
+    {
         _head = 0;
-        _tail = 0;
-        _new_data = false;
-        memset(buffer,0,_size*sizeof(element_t));
+        _count = 0;
+    }
+
+    // number of elements that can still be recalled
+    inline uint16_t count() const
+    {
+        return _count;
     }
 
 private:
-    uint8_t _size,_head,_tail,_new_data;
+    // the stored element k places after the oldest
+    inline const element_type &at(uint16_t k) const
+    {
+        return _buffer[(uint16_t)(_head - _count + k) & (capacity - 1)];
+    }
+
+    // as above, for writing, where k == _count is the slot at the head
+    inline element_type &slot(uint16_t k)
+    {
+        return _buffer[(uint16_t)(_head - _count + k) & (capacity - 1)];
+    }
+
+    element_type _buffer[capacity] {};
+    uint16_t _head;     // index the next element is written to
+    uint16_t _count;    // number of elements stored
 };
 
 
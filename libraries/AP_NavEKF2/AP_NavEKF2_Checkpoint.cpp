@@ -0,0 +1,199 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#include <AP_HAL/AP_HAL.h>
+
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_150
+
+#include "AP_NavEKF2.h"
+#include "AP_NavEKF2_core.h"
+#include <AP_AHRS/AP_AHRS.h>
+#include <AP_Vehicle/AP_Vehicle.h>
+
+#include <stdio.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  A checkpoint holds what the filter needs to carry on from where it
+  was taken: the states, the upper triangle of the covariance, the IMU
+  and output histories back to the fusion time horizon, and the flags
+  that set the fusion modes. Observation buffers and innovation test
+  state are not kept, and start afresh on restore.
+ */
+void NavEKF2_core::transferCheckpoint(EKF2_CheckpointIO &io)
+{
+    // checked by restoreCheckpoint() before reading
+    EKF2_CheckpointHeader header;
+    header.version = EKF2_CHECKPOINT_VERSION;
+    header.imu_buffer_length = imu_buffer_length;
+    header.core_index = core_index;
+    header.imu_index = imu_index;
+    header.time_ms = imuSampleTime_ms;
+    io.field(header);
+
+    // time the filter has been running, for the checks that wait for it to settle
+    uint32_t runTime_ms = imuSampleTime_ms - ekfStartTime_ms;
+    io.field(runTime_ms);
+    if (io.reading()) {
+        ekfStartTime_ms = imuSampleTime_ms - runTime_ms;
+    }
+
+    // states and covariances
+    io.field(statesArray);
+    io.field(stateIndexLim);
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=i; j<24; j++) {
+            io.field(P[i][j]);
+            if (io.reading()) {
+                P[j][i] = P[i][j];
+            }
+        }
+    }
+    io.field(Popt);
+    io.field(terrainState);
+
+    // fusion modes
+    bool *const alignFlags[] = {
+        &tiltAlignComplete,
+        &yawAlignComplete,
+        &firstMagYawInit,
+        &inhibitWindStates,
+        &inhibitMagStates,
+        &validOrigin,
+        &inFlight,
+        &onGround
+    };
+    io.flags(alignFlags, ARRAY_SIZE(alignFlags));
+    bool *const aidingFlags[] = {
+        &isAiding,
+        &posTimeout,
+        &velTimeout,
+        &hgtTimeout,
+        &tasTimeout,
+        &magTimeout,
+        &gpsGoodToAlign,
+        &useGpsVertVel
+    };
+    io.flags(aidingFlags, ARRAY_SIZE(aidingFlags));
+    io.field(PV_AidingMode);
+    io.field(EKF_origin);
+    io.field(lastKnownPositionNE);
+    if (io.reading()) {
+        prevIsAiding = isAiding;
+        prevOnGround = onGround;
+        prevInFlight = inFlight;
+    }
+
+    // IMU data being accumulated and at the fusion time horizon
+    io.field(imuDataDownSampledNew);
+    io.field(imuQuatDownSampleNew);
+    io.field(framesSincePredict);
+    io.field(imuDataDelayed);
+
+    // output observer
+    io.field(outputDataNew);
+    io.field(outputDataDelayed);
+    io.field(delAngCorrection);
+    io.field(delVelCorrection);
+    io.field(velCorrection);
+    io.field(posDown);
+    io.field(posDownDerivative);
+
+    // IMU and output histories from oldest to youngest. On reading
+    // the buffers have been reset, and pushing each sample leaves the
+    // youngest in the same place relative to the oldest
+    const uint8_t oldest = storedIMU.get_oldest_index();
+    for (uint8_t k=0; k<imu_buffer_length; k++) {
+        if (io.reading()) {
+            imu_elements imu;
+            output_elements output;
+            io.field(imu);
+            io.field(output);
+            storedIMU.push_youngest_element(imu);
+            storedOutput[storedIMU.get_youngest_index()] = output;
+        } else {
+            const uint8_t index = (oldest + k) % imu_buffer_length;
+            io.field(storedIMU[index]);
+            io.field(storedOutput[index]);
+        }
+    }
+}
+
+// take a checkpoint of the filter into the ring
+bool NavEKF2_core::storeCheckpoint(void)
+{
+    lastCheckpoint_ms = imuSampleTime_ms;
+
+    // only a filter that can be used is worth restoring
+    if (!checkpoints.enabled() || !statesInitialised || !tiltAlignComplete || !yawAlignComplete || !healthy()) {
+        return false;
+    }
+
+    EKF2_CheckpointIO io(EKF2_CheckpointIO::WRITE, checkpoints.next_slot(), checkpoints.slot_size());
+    transferCheckpoint(io);
+    if (!io.ok()) {
+        return false;
+    }
+    checkpoints.commit(io.offset());
+    return true;
+}
+
+/*
+  restore the filter from a checkpoint in a single frame. A checkpoint
+  from a core using another IMU brings that core's IMU history, which
+  is close enough to this IMU's to carry on from, but not its IMU bias
+  and scale factor states, which start again from their initial values
+ */
+bool NavEKF2_core::restoreCheckpoint(const uint8_t *data, uint16_t length)
+{
+    EKF2_CheckpointHeader header;
+    if (data == nullptr || length < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.version != EKF2_CHECKPOINT_VERSION || header.imu_buffer_length != imu_buffer_length) {
+        return false;
+    }
+    EKF2_CheckpointIO size(EKF2_CheckpointIO::SIZE, nullptr, 0);
+    transferCheckpoint(size);
+    if (length < size.offset()) {
+        return false;
+    }
+
+    InitialiseVariables();
+    dtIMUavg = _ahrs->get_ins().get_loop_delta_t();
+    dtEkfAvg = MIN(0.01f,dtIMUavg);
+
+    EKF2_CheckpointIO io(data, length);
+    transferCheckpoint(io);
+
+    if (header.imu_index != imu_index) {
+        resetIMUBiasStates();
+    }
+
+    // values derived from the states
+    Matrix3f Tbn_temp;
+    stateStruct.quat.rotation_matrix(Tbn_temp);
+    prevTnb = Tbn_temp.transposed();
+    calcEarthRateNED(earthRateNED, _ahrs->get_home().lat);
+
+    statesInitialised = true;
+    return true;
+}
+
+// the next piece of a checkpoint to log
+bool NavEKF2_core::getCheckpointLogChunk(uint8_t &seq, uint8_t &count, uint8_t chunk[EKF2_CHECKPOINT_CHUNK])
+{
+    if (!checkpoints.enabled() || (frontend->_checkpoint & EK2_CKPT_STORE) == 0) {
+        return false;
+    }
+    if (!checkpoints.logging()) {
+        if ((imuSampleTime_ms - lastCheckpointLog_ms) < EKF2_CHECKPOINT_LOG_PERIOD_MS || !checkpoints.start_log()) {
+            return false;
+        }
+        lastCheckpointLog_ms = imuSampleTime_ms;
+    }
+    return checkpoints.log_chunk(seq, count, chunk);
+}
+
+#endif // HAL_CPU_CLASS
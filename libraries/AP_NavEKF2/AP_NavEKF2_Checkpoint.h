@@ -0,0 +1,248 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <stdint.h>
+#include <string.h>
+
+// bits of EK2_CKPT
+#define EK2_CKPT_STORE          (1<<0)  // keep checkpoints of healthy cores and log them
+#define EK2_CKPT_RESTORE_LANES  (1<<1)  // restore failed cores from a checkpoint of the primary
+
+// version of the checkpoint layout, change when NavEKF2_core::transferCheckpoint() changes
+#define EKF2_CHECKPOINT_VERSION 1
+
+// checkpoints kept for each core
+#define EKF2_CHECKPOINT_RING_LENGTH 2
+
+// time between checkpoints of a healthy core
+#define EKF2_CHECKPOINT_PERIOD_MS 1000
+
+// time between logged checkpoints of a core
+#define EKF2_CHECKPOINT_LOG_PERIOD_MS 10000
+
+// a checkpoint is logged in pieces of this size, the size of the Z data field of NKC
+#define EKF2_CHECKPOINT_CHUNK 64
+
+// time a core must be unhealthy before it is restored from the primary
+#define EKF2_CHECKPOINT_LANE_RESTORE_MS 5000
+
+// most cores there can be, one for each IMU in EK2_IMU_MASK
+#define EKF2_CHECKPOINT_MAX_CORES 7
+
+/*
+  start of every checkpoint, so a checkpoint can be matched to a core
+  and a time without knowing its layout
+ */
+struct PACKED EKF2_CheckpointHeader {
+    uint8_t version;
+    uint8_t imu_buffer_length;
+    uint8_t core_index;
+    uint8_t imu_index;
+    uint32_t time_ms;   // imuSampleTime_ms of the core when it was taken
+};
+
+/*
+  moves the fields of a checkpoint to or from a flat buffer. One
+  function lists the fields and is run in each direction, so the
+  layout written is always the layout read. With no buffer it only
+  counts the size
+ */
+class EKF2_CheckpointIO
+{
+public:
+    enum Direction {
+        SIZE,
+        WRITE,
+        READ
+    };
+
+    // count the size, or write to buffer
+    EKF2_CheckpointIO(Direction direction, uint8_t *buffer, uint16_t length) :
+        _direction(direction),
+        _dest(buffer),
+        _src(buffer),
+        _length(length),
+        _offset(0),
+        _ok(true)
+    {}
+
+    // read from buffer
+    EKF2_CheckpointIO(const uint8_t *buffer, uint16_t length) :
+        _direction(READ),
+        _dest(nullptr),
+        _src(buffer),
+        _length(length),
+        _offset(0),
+        _ok(true)
+    {}
+
+    bool reading(void) const { return _direction == READ; }
+
+    void bytes(void *data, uint16_t size)
+    {
+        if (_direction != SIZE) {
+            if (!_ok || _offset + size > _length) {
+                _ok = false;
+                return;
+            }
+            if (_direction == WRITE) {
+                memcpy(&_dest[_offset], data, size);
+            } else {
+                memcpy(data, &_src[_offset], size);
+            }
+        }
+        _offset += size;
+    }
+
+    template <typename T>
+    void field(T &v) { bytes(&v, sizeof(T)); }
+
+    // bools are moved as bits of a byte, from bit 0 up
+    void flags(bool *const *flags, uint8_t count)
+    {
+        uint8_t bits = 0;
+        for (uint8_t i=0; i<count; i++) {
+            if (*flags[i]) {
+                bits |= 1U<<i;
+            }
+        }
+        field(bits);
+        if (reading()) {
+            for (uint8_t i=0; i<count; i++) {
+                *flags[i] = (bits & (1U<<i)) != 0;
+            }
+        }
+    }
+
+    bool ok(void) const { return _ok; }
+    uint16_t offset(void) const { return _offset; }
+
+private:
+    Direction _direction;
+    uint8_t *_dest;
+    const uint8_t *_src;
+    uint16_t _length;
+    uint16_t _offset;
+    bool _ok;
+};
+
+/*
+  a preallocated ring of the latest checkpoints of a core. A
+  checkpoint being logged is held until all of it has been logged, and
+  new checkpoints go to the other slots
+ */
+class EKF2_CheckpointRing
+{
+public:
+    EKF2_CheckpointRing() :
+        _buffer(nullptr),
+        _slot_size(0),
+        _latest(-1),
+        _next(0),
+        _logging(-1),
+        _log_offset(0)
+    {
+        memset(_length, 0, sizeof(_length));
+    }
+
+    // allocate the slots. Returns false if out of memory
+    bool init(uint16_t slot_size)
+    {
+        _buffer = new uint8_t[slot_size * EKF2_CHECKPOINT_RING_LENGTH];
+        if (_buffer == nullptr) {
+            return false;
+        }
+        _slot_size = slot_size;
+        return true;
+    }
+
+    bool enabled(void) const { return _buffer != nullptr; }
+    uint16_t slot_size(void) const { return _slot_size; }
+
+    // the slot to write the next checkpoint to
+    uint8_t *next_slot(void)
+    {
+        _next = (_latest + 1) % EKF2_CHECKPOINT_RING_LENGTH;
+        if (_next == _logging) {
+            _next = (_next + 1) % EKF2_CHECKPOINT_RING_LENGTH;
+        }
+        return &_buffer[_next * _slot_size];
+    }
+
+    // make the slot given by next_slot() the latest checkpoint
+    void commit(uint16_t length)
+    {
+        _length[_next] = length;
+        _latest = _next;
+    }
+
+    // the latest checkpoint, nullptr if there is none
+    const uint8_t *latest(uint16_t &length) const
+    {
+        if (_latest < 0) {
+            return nullptr;
+        }
+        length = _length[_latest];
+        return &_buffer[_latest * _slot_size];
+    }
+
+    bool logging(void) const { return _logging >= 0; }
+
+    // start logging the latest checkpoint. Returns false if there is none
+    bool start_log(void)
+    {
+        if (_latest < 0) {
+            return false;
+        }
+        _logging = _latest;
+        _log_offset = 0;
+        return true;
+    }
+
+    /*
+      the next piece of the checkpoint being logged, padded with
+      zeros. Returns false if no checkpoint is being logged
+     */
+    bool log_chunk(uint8_t &seq, uint8_t &count, uint8_t chunk[EKF2_CHECKPOINT_CHUNK])
+    {
+        if (_logging < 0) {
+            return false;
+        }
+        const uint16_t length = _length[_logging];
+        const uint16_t size = MIN(EKF2_CHECKPOINT_CHUNK, length - _log_offset);
+        memset(chunk, 0, EKF2_CHECKPOINT_CHUNK);
+        memcpy(chunk, &_buffer[_logging * _slot_size + _log_offset], size);
+        seq = _log_offset / EKF2_CHECKPOINT_CHUNK;
+        count = (length + EKF2_CHECKPOINT_CHUNK - 1) / EKF2_CHECKPOINT_CHUNK;
+        _log_offset += size;
+        if (_log_offset >= length) {
+            _logging = -1;
+        }
+        return true;
+    }
+
+private:
+    uint8_t *_buffer;
+    uint16_t _slot_size;
+    uint16_t _length[EKF2_CHECKPOINT_RING_LENGTH];
+    int8_t _latest;
+    int8_t _next;
+    int8_t _logging;
+    uint16_t _log_offset;
+};
@@ -0,0 +1,48 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/*
+  covariance update shared by all the observation fusion steps
+
+  Fusing one observation with Kalman gain K and observation row H
+  gives P = P - K*H*P. With HP = H*P the product K*HP is symmetric
+  for the optimal gain, and is taken as 0.5*(K*HP + (K*HP)') so that P
+  stays symmetric when gains are zeroed to inhibit states. This is the
+  same result as the full update followed by ForceSymmetry().
+
+  Only the upper triangle of states 0..last is calculated, each row in
+  a contiguous loop, and it is then copied to the lower triangle. P
+  must be symmetric on entry and HP must not be part of P.
+ */
+template <typename Matrix, typename VectorK, typename VectorHP>
+void EKF2_UpdateCovariance(Matrix &P, const VectorK &K, const VectorHP &HP, uint8_t last)
+{
+    for (uint8_t i=0; i<=last; i++) {
+        const float Ki = 0.5f * K[i];
+        const float HPi = 0.5f * HP[i];
+        for (uint8_t j=i; j<=last; j++) {
+            P[i][j] -= Ki * HP[j] + HPi * K[j];
+        }
+    }
+    for (uint8_t i=1; i<=last; i++) {
+        for (uint8_t j=0; j<i; j++) {
+            P[i][j] = P[j][i];
+        }
+    }
+}
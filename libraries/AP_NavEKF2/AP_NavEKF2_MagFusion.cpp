@@ -161,7 +161,8 @@ void NavEKF2_core::SelectMagFusion()
             if (PV_AidingMode != AID_ABSOLUTE || (imuSampleTime_ms - lastPosPassTime_ms) > 4000) {
                 FuseDeclination();
             }
-            // fuse the three magnetometer componenents sequentially
+            // fuse the three magnetometer componenents sequentially, counted as one fusion
+            stageTiming.fused(EKF2_STAGE_MAG);
             for (mag_state.obsIndex = 0; mag_state.obsIndex <= 2; mag_state.obsIndex++) {
                 hal.util->perf_begin(_perf_test[0]);
                 FuseMagnetometer();
@@ -548,45 +549,25 @@ void NavEKF2_core::FuseMagnetometer()
     stateStruct.quat.rotate(stateStruct.angErr);
 
     // correct the covariance P = (I - K*H)*P
-    // take advantage of the empty columns in KH to reduce the
+    // take advantage of the empty columns in H to reduce the
     // number of operations
-    for (unsigned i = 0; i<=stateIndexLim; i++) {
-        for (unsigned j = 0; j<=2; j++) {
-            KH[i][j] = Kfusion[i] * H_MAG[j];
-        }
-        for (unsigned j = 3; j<=15; j++) {
-            KH[i][j] = 0.0f;
-        }
-        for (unsigned j = 16; j<=21; j++) {
-            KH[i][j] = Kfusion[i] * H_MAG[j];
-        }
-        for (unsigned j = 22; j<=23; j++) {
-            KH[i][j] = 0.0f;
-        }
-    }
+    Vector24 HP;
     for (unsigned j = 0; j<=stateIndexLim; j++) {
-        for (unsigned i = 0; i<=stateIndexLim; i++) {
-            ftype res = 0;
-            res += KH[i][0] * P[0][j];
-            res += KH[i][1] * P[1][j];
-            res += KH[i][2] * P[2][j];
-            res += KH[i][16] * P[16][j];
-            res += KH[i][17] * P[17][j];
-            res += KH[i][18] * P[18][j];
-            res += KH[i][19] * P[19][j];
-            res += KH[i][20] * P[20][j];
-            res += KH[i][21] * P[21][j];
-            KHP[i][j] = res;
-        }
-    }
-    for (unsigned i = 0; i<=stateIndexLim; i++) {
-        for (unsigned j = 0; j<=stateIndexLim; j++) {
-            P[i][j] = P[i][j] - KHP[i][j];
-        }
-    }
-     // force the covariance matrix to be symmetrical and limit the variances to prevent
-    // ill-condiioning.
-    ForceSymmetry();
+        ftype res = 0;
+        res += H_MAG[0] * P[0][j];
+        res += H_MAG[1] * P[1][j];
+        res += H_MAG[2] * P[2][j];
+        res += H_MAG[16] * P[16][j];
+        res += H_MAG[17] * P[17][j];
+        res += H_MAG[18] * P[18][j];
+        res += H_MAG[19] * P[19][j];
+        res += H_MAG[20] * P[20][j];
+        res += H_MAG[21] * P[21][j];
+        HP[j] = res;
+    }
+    EKF2_UpdateCovariance(P, Kfusion, HP, stateIndexLim);
+
+    // limit the variances to prevent ill-condiioning.
     ConstrainVariances();
 
     hal.util->perf_end(_perf_test[5]);
@@ -605,6 +586,8 @@ void NavEKF2_core::FuseMagnetometer()
 */
 void NavEKF2_core::fuseCompass()
 {
+    stageTiming.fused(EKF2_STAGE_MAG);
+
     float q0 = stateStruct.quat[0];
     float q1 = stateStruct.quat[1];
     float q2 = stateStruct.quat[2];
@@ -724,15 +707,9 @@ void NavEKF2_core::fuseCompass()
             HP[colIndex] += H_MAG[rowIndex]*P[rowIndex][colIndex];
         }
     }
-    for (uint8_t rowIndex=0; rowIndex<=stateIndexLim; rowIndex++) {
-        for (uint8_t colIndex=0; colIndex<=stateIndexLim; colIndex++) {
-            P[rowIndex][colIndex] -= Kfusion[rowIndex] * HP[colIndex];
-        }
-    }
+    EKF2_UpdateCovariance(P, Kfusion, HP, stateIndexLim);
 
-    // force the covariance matrix to be symmetrical and limit the variances to prevent
-    // ill-condiioning.
-    ForceSymmetry();
+    // limit the variances to prevent ill-condiioning.
     ConstrainVariances();
 }
 
@@ -745,6 +722,8 @@ void NavEKF2_core::fuseCompass()
 */
 void NavEKF2_core::FuseDeclination()
 {
+    stageTiming.fused(EKF2_STAGE_MAG);
+
     // declination error variance (rad^2)
     const float R_DECL = 1e-2f;
 
@@ -814,32 +793,15 @@ void NavEKF2_core::FuseDeclination()
     stateStruct.quat.rotate(stateStruct.angErr);
 
     // correct the covariance P = (I - K*H)*P
-    // take advantage of the empty columns in KH to reduce the
+    // take advantage of the empty columns in H to reduce the
     // number of operations
-    for (unsigned i = 0; i<=stateIndexLim; i++) {
-        for (unsigned j = 0; j<=15; j++) {
-            KH[i][j] = 0.0f;
-        }
-        KH[i][16] = Kfusion[i] * H_MAG[16];
-        KH[i][17] = Kfusion[i] * H_MAG[17];
-        for (unsigned j = 18; j<=23; j++) {
-            KH[i][j] = 0.0f;
-        }
-    }
+    Vector24 HP;
     for (unsigned j = 0; j<=stateIndexLim; j++) {
-        for (unsigned i = 0; i<=stateIndexLim; i++) {
-            KHP[i][j] = KH[i][16] * P[16][j] + KH[i][17] * P[17][j];
-        }
-    }
-    for (unsigned i = 0; i<=stateIndexLim; i++) {
-        for (unsigned j = 0; j<=stateIndexLim; j++) {
-            P[i][j] = P[i][j] - KHP[i][j];
-        }
+        HP[j] = H_MAG[16] * P[16][j] + H_MAG[17] * P[17][j];
     }
+    EKF2_UpdateCovariance(P, Kfusion, HP, stateIndexLim);
 
-    // force the covariance matrix to be symmetrical and limit the variances to prevent
-    // ill-condiioning.
-    ForceSymmetry();
+    // limit the variances to prevent ill-condiioning.
     ConstrainVariances();
 
 }
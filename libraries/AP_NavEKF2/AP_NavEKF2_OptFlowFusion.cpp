@@ -275,6 +275,8 @@ void NavEKF2_core::EstimateTerrainOffset()
 */
 void NavEKF2_core::FuseOptFlow()
 {
+    stageTiming.fused(EKF2_STAGE_FLOW);
+
     Vector24 H_LOS;
     Vector3f relVelSensor;
     Vector14 SH_LOS;
@@ -647,42 +649,24 @@ void NavEKF2_core::FuseOptFlow()
             stateStruct.quat.rotate(stateStruct.angErr);
 
             // correct the covariance P = (I - K*H)*P
-            // take advantage of the empty columns in KH to reduce the
+            // take advantage of the empty columns in H to reduce the
             // number of operations
-            for (unsigned i = 0; i<=stateIndexLim; i++) {
-                for (unsigned j = 0; j<=5; j++) {
-                    KH[i][j] = Kfusion[i] * H_LOS[j];
-                }
-                for (unsigned j = 6; j<=7; j++) {
-                    KH[i][j] = 0.0f;
-                }
-                KH[i][8] = Kfusion[i] * H_LOS[8];
-                for (unsigned j = 9; j<=23; j++) {
-                    KH[i][j] = 0.0f;
-                }
-            }
+            Vector24 HP;
             for (unsigned j = 0; j<=stateIndexLim; j++) {
-                for (unsigned i = 0; i<=stateIndexLim; i++) {
-                    ftype res = 0;
-                    res += KH[i][0] * P[0][j];
-                    res += KH[i][1] * P[1][j];
-                    res += KH[i][2] * P[2][j];
-                    res += KH[i][3] * P[3][j];
-                    res += KH[i][4] * P[4][j];
-                    res += KH[i][5] * P[5][j];
-                    res += KH[i][8] * P[8][j];
-                    KHP[i][j] = res;
-                }
-            }
-            for (unsigned i = 0; i<=stateIndexLim; i++) {
-                for (unsigned j = 0; j<=stateIndexLim; j++) {
-                    P[i][j] = P[i][j] - KHP[i][j];
-                }
+                ftype res = 0;
+                res += H_LOS[0] * P[0][j];
+                res += H_LOS[1] * P[1][j];
+                res += H_LOS[2] * P[2][j];
+                res += H_LOS[3] * P[3][j];
+                res += H_LOS[4] * P[4][j];
+                res += H_LOS[5] * P[5][j];
+                res += H_LOS[8] * P[8][j];
+                HP[j] = res;
             }
+            EKF2_UpdateCovariance(P, Kfusion, HP, stateIndexLim);
         }
 
         // fix basic numerical errors
-        ForceSymmetry();
         ConstrainVariances();
 
     }
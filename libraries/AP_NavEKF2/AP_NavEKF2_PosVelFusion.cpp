@@ -194,6 +194,7 @@ void NavEKF2_core::FuseVelPosNED()
 {
     // start performance timer
     hal.util->perf_begin(_perf_FuseVelPosNED);
+    stageTiming.fused(EKF2_STAGE_VELPOS);
 
     // health is set bad until test passed
     velHealth = false;
@@ -509,25 +510,18 @@ void NavEKF2_core::FuseVelPosNED()
                     tiltErrVec += stateStruct.angErr;
                 }
 
-                // update the covariance - take advantage of direct observation of a single state at index = stateIndex to reduce computations
-                // this is a numerically optimised implementation of standard equation P = (I - K*H)*P;
-                for (uint8_t i= 0; i<=stateIndexLim; i++) {
-                    for (uint8_t j= 0; j<=stateIndexLim; j++)
-                    {
-                        KHP[i][j] = Kfusion[i] * P[stateIndex][j];
-                    }
-                }
-                for (uint8_t i= 0; i<=stateIndexLim; i++) {
-                    for (uint8_t j= 0; j<=stateIndexLim; j++) {
-                        P[i][j] = P[i][j] - KHP[i][j];
-                    }
+                // update the covariance P = (I - K*H)*P - take advantage of direct observation of a single
+                // state at index = stateIndex, which makes H*P the row of P for that state
+                Vector24 HP;
+                for (uint8_t j= 0; j<=stateIndexLim; j++) {
+                    HP[j] = P[stateIndex][j];
                 }
+                EKF2_UpdateCovariance(P, Kfusion, HP, stateIndexLim);
             }
         }
     }
 
-    // force the covariance matrix to be symmetrical and limit the variances to prevent ill-condiioning.
-    ForceSymmetry();
+    // limit the variances to prevent ill-condiioning.
     ConstrainVariances();
 
     // stop performance timer
@@ -0,0 +1,175 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+#include <string.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+// Cortex-M4 debug registers for the DWT cycle counter
+#define EKF2_DEMCR      (*(volatile uint32_t *)0xE000EDFCU)
+#define EKF2_DWT_CTRL   (*(volatile uint32_t *)0xE0001000U)
+#define EKF2_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004U)
+#elif CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <time.h>
+#endif
+
+// bits of EK2_TIMING
+#define EK2_TIMING_ENABLE   (1<<0)  // time the stages of UpdateFilter() and log them
+#define EK2_TIMING_SEND     (1<<1)  // also send the timing to the GCS
+
+// period of each timing report
+#define EKF2_TIMING_PERIOD_MS 1000
+
+// stages of NavEKF2_core::UpdateFilter() that are timed
+enum EKF2_TimingStage {
+    EKF2_STAGE_UPDATE_FILTER = 0,   // all of UpdateFilter()
+    EKF2_STAGE_STRAPDOWN,           // UpdateStrapdownEquationsNED()
+    EKF2_STAGE_COVARIANCE,          // CovariancePrediction()
+    EKF2_STAGE_MAG,                 // SelectMagFusion()
+    EKF2_STAGE_VELPOS,              // SelectVelPosFusion()
+    EKF2_STAGE_FLOW,                // SelectFlowFusion()
+    EKF2_STAGE_TAS,                 // SelectTasFusion()
+    EKF2_STAGE_BETA,                // SelectBetaFusion()
+    EKF2_STAGE_OUTPUT,              // calcOutputStatesFast()
+    EKF2_NUM_STAGES
+};
+
+/*
+  timing of the stages of the filter update of one core. Times are
+  taken from the cycle counter on ARM boards, and from the monotonic
+  clock on SITL and Linux, where the system time in microseconds is too
+  coarse or does not move during a simulated step. Statistics are
+  gathered over EKF2_TIMING_PERIOD_MS and then kept as a report while
+  the next period is gathered
+ */
+class EKF2_Timing
+{
+public:
+    // statistics of one stage
+    struct Stage {
+        uint16_t count;     // times the stage ran
+        uint16_t fusions;   // observations fused by the stage
+        uint32_t min_ticks;
+        uint32_t max_ticks;
+        uint32_t sum_ticks;
+    };
+
+    EKF2_Timing() :
+        _period_start_ms(0),
+        _report_ms(0),
+        _report_pending(false)
+    {
+        clear(_current);
+        clear(_report);
+    }
+
+    // start the clock used for timing, if it needs it
+    static void init(void)
+    {
+#if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+        // enable the Cortex-M4 DWT cycle counter
+        EKF2_DEMCR |= (1U<<24);
+        EKF2_DWT_CTRL |= 1U;
+#endif
+    }
+
+    // current time in ticks
+    static uint32_t ticks(void)
+    {
+#if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+        return EKF2_DWT_CYCCNT;
+#elif CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint32_t)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+#else
+        return AP_HAL::micros();
+#endif
+    }
+
+    static float ticks_to_us(uint32_t ticks)
+    {
+#if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+        // the STM32F4 runs at 168MHz
+        return ticks * (1.0f / 168);
+#elif CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+        return ticks * 1.0e-3f;
+#else
+        return ticks;
+#endif
+    }
+
+    // record a run of a stage that started at start_ticks, and return the time now
+    uint32_t end_stage(uint8_t stage, uint32_t start_ticks)
+    {
+        const uint32_t now = ticks();
+        const uint32_t dt = now - start_ticks;
+        Stage &s = _current[stage];
+        s.count++;
+        s.sum_ticks += dt;
+        if (dt < s.min_ticks) {
+            s.min_ticks = dt;
+        }
+        if (dt > s.max_ticks) {
+            s.max_ticks = dt;
+        }
+        return now;
+    }
+
+    // count an observation fused by a stage
+    void fused(uint8_t stage) { _current[stage].fusions++; }
+
+    // end the period when it is over, making it the report
+    void update(uint32_t now_ms)
+    {
+        if (now_ms - _period_start_ms < EKF2_TIMING_PERIOD_MS) {
+            return;
+        }
+        memcpy(_report, _current, sizeof(_report));
+        clear(_current);
+        _period_start_ms = now_ms;
+        _report_ms = now_ms;
+        _report_pending = true;
+    }
+
+    // the report of the last complete period
+    const Stage &get_report(uint8_t stage) const { return _report[stage]; }
+    uint32_t get_report_ms(void) const { return _report_ms; }
+
+    // true once for each new report, for logging
+    bool take_report(void)
+    {
+        const bool ret = _report_pending;
+        _report_pending = false;
+        return ret;
+    }
+
+private:
+    static void clear(Stage *stages)
+    {
+        memset(stages, 0, sizeof(Stage) * EKF2_NUM_STAGES);
+        for (uint8_t i=0; i<EKF2_NUM_STAGES; i++) {
+            stages[i].min_ticks = UINT32_MAX;
+        }
+    }
+
+    Stage _current[EKF2_NUM_STAGES];
+    Stage _report[EKF2_NUM_STAGES];
+    uint32_t _period_start_ms;
+    uint32_t _report_ms;
+    bool _report_pending;
+};
@@ -52,6 +52,7 @@ NavEKF2_core::NavEKF2_core(void) :
     _perf_test[7] = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "EK2_Test7");
     _perf_test[8] = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "EK2_Test8");
     _perf_test[9] = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "EK2_Test9");
+    EKF2_Timing::init();
 }
 
 // setup this core backend
@@ -74,30 +75,19 @@ bool NavEKF2_core::setup_core(NavEKF2 *_frontend, uint8_t _imu_index, uint8_t _c
         // maximum 260 msec delay at 100 Hz fusion rate
         imu_buffer_length = 26;
     }
-    if(!storedGPS.init(OBS_BUFFER_LENGTH)) {
-        return false;
-    }
-    if(!storedMag.init(OBS_BUFFER_LENGTH)) {
-        return false;
-    }
-    if(!storedBaro.init(OBS_BUFFER_LENGTH)) {
-        return false;
-    } 
-    if(!storedTAS.init(OBS_BUFFER_LENGTH)) {
-        return false;
-    }
-    if(!storedOF.init(OBS_BUFFER_LENGTH)) {
-        return false;
-    }
-    if(!storedRange.init(OBS_BUFFER_LENGTH)) {
-        return false;
-    }
     if(!storedIMU.init(imu_buffer_length)) {
         return false;
     }
     if(!storedOutput.init(imu_buffer_length)) {
         return false;
     }
+    if ((frontend->_checkpoint & (EK2_CKPT_STORE | EK2_CKPT_RESTORE_LANES)) != 0) {
+        EKF2_CheckpointIO io(EKF2_CheckpointIO::SIZE, nullptr, 0);
+        transferCheckpoint(io);
+        if (!checkpoints.init(io.offset())) {
+            return false;
+        }
+    }
 
     return true;
 }
@@ -143,6 +133,8 @@ void NavEKF2_core::InitialiseVariables()
     lastPreAlignGpsCheckTime_ms = imuSampleTime_ms;
     lastPosReset_ms = 0;
     lastVelReset_ms = 0;
+    lastCheckpoint_ms = imuSampleTime_ms;
+    lastCheckpointLog_ms = imuSampleTime_ms;
 
     // initialise other variables
     gpsNoiseScaler = 1.0f;
@@ -394,6 +386,29 @@ void NavEKF2_core::CovarianceInit()
 
 }
 
+// reset the IMU bias and scale factor states and their covariances to their initial values
+void NavEKF2_core::resetIMUBiasStates()
+{
+    for (uint8_t i=9; i<=15; i++) {
+        for (uint8_t j=0; j<=stateIndexLim; j++) {
+            P[i][j] = 0.0f;
+            P[j][i] = 0.0f;
+        }
+    }
+    stateStruct.gyro_bias.zero();
+    stateStruct.gyro_scale.x = 1.0f;
+    stateStruct.gyro_scale.y = 1.0f;
+    stateStruct.gyro_scale.z = 1.0f;
+    stateStruct.accel_zbias = 0.0f;
+    P[9][9] = sq(radians(InitialGyroBiasUncertainty() * dtEkfAvg));
+    P[10][10] = P[9][9];
+    P[11][11] = P[9][9];
+    P[12][12] = sq(1e-3);
+    P[13][13] = P[12][12];
+    P[14][14] = P[12][12];
+    P[15][15] = sq(INIT_ACCEL_BIAS_UNCERTAINTY * dtEkfAvg);
+}
+
 /********************************************************
 *                 UPDATE FUNCTIONS                      *
 ********************************************************/
@@ -418,6 +433,11 @@ void NavEKF2_core::UpdateFilter(bool predict)
 #endif
     hal.util->perf_begin(_perf_UpdateFilter);
 
+    // time each stage if enabled, one test of a flag per stage when not
+    const bool timing = (frontend->_timing & EK2_TIMING_ENABLE) != 0;
+    const uint32_t updateStart = timing ? EKF2_Timing::ticks() : 0;
+    uint32_t stageStart = updateStart;
+
     // TODO - in-flight restart method
 
     //get starting time for update step
@@ -431,30 +451,68 @@ void NavEKF2_core::UpdateFilter(bool predict)
 
     // Run the EKF equations to estimate at the fusion time horizon if new IMU data is available in the buffer
     if (runUpdates) {
+        if (timing) {
+            stageStart = EKF2_Timing::ticks();
+        }
+
         // Predict states using IMU data from the delayed time horizon
         UpdateStrapdownEquationsNED();
+        if (timing) {
+            stageStart = stageTiming.end_stage(EKF2_STAGE_STRAPDOWN, stageStart);
+        }
 
         // Predict the covariance growth
         CovariancePrediction();
+        if (timing) {
+            stageStart = stageTiming.end_stage(EKF2_STAGE_COVARIANCE, stageStart);
+        }
 
         // Update states using  magnetometer data
         SelectMagFusion();
+        if (timing) {
+            stageStart = stageTiming.end_stage(EKF2_STAGE_MAG, stageStart);
+        }
 
         // Update states using GPS and altimeter data
         SelectVelPosFusion();
+        if (timing) {
+            stageStart = stageTiming.end_stage(EKF2_STAGE_VELPOS, stageStart);
+        }
 
         // Update states using optical flow data
         SelectFlowFusion();
+        if (timing) {
+            stageStart = stageTiming.end_stage(EKF2_STAGE_FLOW, stageStart);
+        }
 
         // Update states using airspeed data
         SelectTasFusion();
+        if (timing) {
+            stageStart = stageTiming.end_stage(EKF2_STAGE_TAS, stageStart);
+        }
 
         // Update states using sideslip constraint assumption for fly-forward vehicles
         SelectBetaFusion();
+        if (timing) {
+            stageStart = stageTiming.end_stage(EKF2_STAGE_BETA, stageStart);
+        }
     }
 
     // Wind output forward from the fusion to output time horizon
+    if (timing) {
+        stageStart = EKF2_Timing::ticks();
+    }
     calcOutputStatesFast();
+    if (timing) {
+        stageTiming.end_stage(EKF2_STAGE_OUTPUT, stageStart);
+        stageTiming.end_stage(EKF2_STAGE_UPDATE_FILTER, updateStart);
+    }
+    stageTiming.update(imuSampleTime_ms);
+
+    // keep a checkpoint to restore from, see EK2_CKPT
+    if ((frontend->_checkpoint & EK2_CKPT_STORE) && (imuSampleTime_ms - lastCheckpoint_ms) >= EKF2_CHECKPOINT_PERIOD_MS) {
+        storeCheckpoint();
+    }
 
     // stop the timer used for load measurement
     hal.util->perf_end(_perf_UpdateFilter);
@@ -1193,20 +1251,6 @@ void NavEKF2_core::quat2Tbn(Matrix3f &Tbn, const Quaternion &quat) const
     quat.rotation_matrix(Tbn);
 }
 
-// force symmetry on the covariance matrix to prevent ill-conditioning
-void NavEKF2_core::ForceSymmetry()
-{
-    for (uint8_t i=1; i<=stateIndexLim; i++)
-    {
-        for (uint8_t j=0; j<=i-1; j++)
-        {
-            float temp = 0.5f*(P[i][j] + P[j][i]);
-            P[i][j] = temp;
-            P[j][i] = temp;
-        }
-    }
-}
-
 // copy covariances across from covariance prediction calculation
 void NavEKF2_core::CopyCovariances()
 {
@@ -32,6 +32,8 @@
 #include <stdio.h>
 #include <AP_Math/vectorN.h>
 #include <AP_NavEKF2/AP_NavEKF2_Buffer.h>
+#include <AP_NavEKF2/AP_NavEKF2_Covariance.h>
+#include <AP_NavEKF2/AP_NavEKF2_Checkpoint.h>
 
 // GPS pre-flight check bit locations
 #define MASK_GPS_NSATS      (1<<0)
@@ -237,6 +239,24 @@ public:
     // send an EKF_STATUS_REPORT message to GCS
     void send_status_report(mavlink_channel_t chan);
 
+    // timing of the stages of the filter update
+    EKF2_Timing &getStageTiming(void) { return stageTiming; }
+
+    // take a checkpoint of the filter into the ring, see EK2_CKPT
+    // returns false if the filter is not aligned and healthy
+    bool storeCheckpoint(void);
+
+    // the latest checkpoint of the filter, nullptr if there is none
+    const uint8_t *getCheckpoint(uint16_t &length) const { return checkpoints.latest(length); }
+
+    // restore the filter from a checkpoint of this or another core
+    // returns false if the checkpoint does not fit this core
+    bool restoreCheckpoint(const uint8_t *data, uint16_t length);
+
+    // the next piece of a checkpoint to log, once per EKF2_CHECKPOINT_LOG_PERIOD_MS
+    // returns false when there is nothing to log
+    bool getCheckpointLogChunk(uint8_t &seq, uint8_t &count, uint8_t chunk[EKF2_CHECKPOINT_CHUNK]);
+
     // provides the height limit to be observed by the control loops
     // returns false if no height limiting is required
     // this is needed to ensure the vehicle does not fly too high when using optical flow navigation
@@ -390,9 +410,6 @@ private:
     // calculate the predicted state covariance matrix
     void CovariancePrediction();
 
-    // force symmetry on the state covariance matrix
-    void ForceSymmetry();
-
     // copy covariances across from covariance prediction calculation and fix numerical errors
     void CopyCovariances();
 
@@ -473,6 +490,12 @@ private:
     // initialise the covariance matrix
     void CovarianceInit();
 
+    // reset the IMU bias and scale factor states and their covariances
+    void resetIMUBiasStates();
+
+    // move the checkpoint fields in the direction of io
+    void transferCheckpoint(EKF2_CheckpointIO &io);
+
     // helper functions for readIMUData
     bool readDeltaVelocity(uint8_t ins_index, Vector3f &dVel, float &dVel_dt);
     bool readDeltaAngle(uint8_t ins_index, Vector3f &dAng);
@@ -615,8 +638,8 @@ private:
     void selectHeightForFusion();
 
     // Length of FIFO buffers used for non-IMU sensor data.
-    // Must be larger than the time period defined by IMU_BUFFER_LENGTH
-    static const uint32_t OBS_BUFFER_LENGTH = 5;
+    // Must be larger than the time period defined by IMU_BUFFER_LENGTH, and a power of two
+    static const uint16_t OBS_BUFFER_LENGTH = 8;
 
     // Variables
     bool statesInitialised;         // boolean true when filter states have been initialised
@@ -635,15 +658,13 @@ private:
 
     float gpsNoiseScaler;           // Used to scale the  GPS measurement noise and consistency gates to compensate for operation with small satellite counts
     Vector28 Kfusion;               // Kalman gain vector
-    Matrix24 KH;                    // intermediate result used for covariance updates
-    Matrix24 KHP;                   // intermediate result used for covariance updates
     Matrix24 P;                     // covariance matrix
     imu_ring_buffer_t<imu_elements> storedIMU;      // IMU data buffer
-    obs_ring_buffer_t<gps_elements> storedGPS;      // GPS data buffer
-    obs_ring_buffer_t<mag_elements> storedMag;      // Magnetometer data buffer
-    obs_ring_buffer_t<baro_elements> storedBaro;    // Baro data buffer
-    obs_ring_buffer_t<tas_elements> storedTAS;      // TAS data buffer
-    obs_ring_buffer_t<range_elements> storedRange;
+    obs_ring_buffer_t<gps_elements, OBS_BUFFER_LENGTH> storedGPS;      // GPS data buffer
+    obs_ring_buffer_t<mag_elements, OBS_BUFFER_LENGTH> storedMag;      // Magnetometer data buffer
+    obs_ring_buffer_t<baro_elements, OBS_BUFFER_LENGTH> storedBaro;    // Baro data buffer
+    obs_ring_buffer_t<tas_elements, OBS_BUFFER_LENGTH> storedTAS;      // TAS data buffer
+    obs_ring_buffer_t<range_elements, OBS_BUFFER_LENGTH> storedRange;
     imu_ring_buffer_t<output_elements> storedOutput;// output state buffer
     Vector3f correctedDelAng;       // delta angles about the xyz body axes corrected for errors (rad)
     Quaternion correctedDelAngQuat; // quaternion representation of correctedDelAng
@@ -805,7 +826,7 @@ private:
     float lastInnovation;
 
     // variables added for optical flow fusion
-    obs_ring_buffer_t<of_elements> storedOF;    // OF data buffer
+    obs_ring_buffer_t<of_elements, OBS_BUFFER_LENGTH> storedOF;    // OF data buffer
     of_elements ofDataNew;          // OF data at the current time horizon
     of_elements ofDataDelayed;      // OF data at the fusion time horizon
     uint8_t ofStoreIndex;           // OF data storage index
@@ -932,6 +953,14 @@ private:
     AP_HAL::Util::perf_counter_t  _perf_FuseOptFlow;
     AP_HAL::Util::perf_counter_t  _perf_test[10];
 
+    // timing of the stages of UpdateFilter(), see EK2_TIMING
+    EKF2_Timing stageTiming;
+
+    // checkpoints of the filter, see EK2_CKPT
+    EKF2_CheckpointRing checkpoints;
+    uint32_t lastCheckpoint_ms;     // time the last checkpoint was taken (msec)
+    uint32_t lastCheckpointLog_ms;  // time logging of the last checkpoint started (msec)
+
     // should we assume zero sideslip?
     bool assume_zero_sideslip(void) const;
 
@@ -0,0 +1,136 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_NavEKF2/AP_NavEKF2_Buffer.h>
+
+struct obs_elements {
+    Vector3f vel;
+    uint32_t time_ms;
+};
+
+/*
+  the observation buffer as it was before, allocated at init with a
+  linear search using modulo indexing, kept for comparison
+ */
+class linear_obs_buffer_t
+{
+public:
+    ~linear_obs_buffer_t() { delete[] buffer; }
+
+    bool init(uint32_t size)
+    {
+        buffer = new obs_elements[size];
+        memset(buffer, 0, size*sizeof(obs_elements));
+        _size = size;
+        _head = 0;
+        _tail = 0;
+        _new_data = false;
+        return true;
+    }
+
+    bool recall(obs_elements &element, uint32_t sample_time)
+    {
+        if (!_new_data) {
+            return false;
+        }
+        bool success = false;
+        uint8_t tail = _tail, bestIndex = 0;
+        if (_head == tail) {
+            if (buffer[tail].time_ms != 0 && buffer[tail].time_ms <= sample_time) {
+                if (((sample_time - buffer[tail].time_ms) < 100)) {
+                    bestIndex = tail;
+                    success = true;
+                    _new_data = false;
+                }
+            }
+        } else {
+            while (_head != tail) {
+                if (buffer[tail].time_ms != 0 && buffer[tail].time_ms <= sample_time) {
+                    if (((sample_time - buffer[tail].time_ms) < 100)) {
+                        bestIndex = tail;
+                        success = true;
+                    }
+                } else if (buffer[tail].time_ms > sample_time) {
+                    break;
+                }
+                tail = (tail+1)%_size;
+            }
+        }
+        if (success) {
+            element = buffer[bestIndex];
+            _tail = (bestIndex+1)%_size;
+            buffer[bestIndex].time_ms = 0;
+            return true;
+        }
+        return false;
+    }
+
+    void push(const obs_elements &element)
+    {
+        _head = (_head+1)%_size;
+        buffer[_head] = element;
+        _new_data = true;
+    }
+
+private:
+    obs_elements *buffer = nullptr;
+    uint8_t _size, _head, _tail, _new_data;
+};
+
+/*
+  observations arriving at 1kHz and fused at 50Hz with a delay of a
+  third of the buffer, so each recall searches past about a third of
+  the buffer
+ */
+template <typename Buffer>
+static void run(benchmark::State& state, Buffer &buffer, uint16_t size)
+{
+    const uint32_t delay_ms = size / 3;
+    uint32_t now_ms = 1000;
+    obs_elements e = {};
+
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i < 20; i++) {
+            e.time_ms = now_ms++;
+            buffer.push(e);
+        }
+        bool found = buffer.recall(e, now_ms - delay_ms);
+        gbenchmark_escape(&found);
+    }
+}
+
+static void BM_LinearRecall(benchmark::State& state)
+{
+    const uint16_t size = state.range_x();
+    linear_obs_buffer_t buffer;
+    buffer.init(size);
+    run(state, buffer, size);
+}
+
+BENCHMARK(BM_LinearRecall)->Arg(32)->Arg(64)->Arg(128);
+
+template <uint16_t size>
+static void binary_recall(benchmark::State& state)
+{
+    obs_ring_buffer_t<obs_elements, size> buffer;
+    run(state, buffer, size);
+}
+
+static void BM_BinaryRecall(benchmark::State& state)
+{
+    switch (state.range_x()) {
+    case 32:
+        binary_recall<32>(state);
+        break;
+    case 64:
+        binary_recall<64>(state);
+        break;
+    case 128:
+        binary_recall<128>(state);
+        break;
+    }
+}
+
+BENCHMARK(BM_BinaryRecall)->Arg(32)->Arg(64)->Arg(128);
+
+BENCHMARK_MAIN()
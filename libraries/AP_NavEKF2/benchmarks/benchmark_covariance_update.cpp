@@ -0,0 +1,102 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_NavEKF2/AP_NavEKF2_Covariance.h>
+
+typedef float Matrix24[24][24];
+
+/*
+  covariance updates of the fusion steps, selected by the benchmark
+  argument. Each lists the states observed, ended by -1
+ */
+static const int8_t patterns[][10] = {
+    { 4, -1 },                                  // 0: position/velocity/height
+    { 3, 4, 5, 22, 23, -1 },                    // 1: airspeed
+    { 0, 1, 2, 3, 4, 5, 22, 23, -1 },           // 2: sideslip
+    { 0, 1, 2, 16, 17, 18, 19, 20, 21, -1 },    // 3: magnetometer
+    { 0, 1, 2, -1 },                            // 4: euler yaw
+    { 16, 17, -1 },                             // 5: declination
+    { 0, 1, 2, 3, 4, 5, 8, -1 },                // 6: optical flow
+};
+
+static Matrix24 P;
+static Matrix24 KH;
+static Matrix24 KHP;
+static float K[24];
+static float H[24];
+static float HP[24];
+
+static void setup(uint8_t p)
+{
+    for (uint8_t i = 0; i < 24; i++) {
+        for (uint8_t j = 0; j < 24; j++) {
+            P[i][j] = (i == j) ? 1.0f : 0.01f;
+        }
+        K[i] = 1.0e-6f * i;
+        H[i] = 0.0f;
+    }
+    for (uint8_t n = 0; patterns[p][n] >= 0; n++) {
+        H[patterns[p][n]] = 1.0f;
+    }
+}
+
+// the update done with KH and KHP and then ForceSymmetry(), as before
+static void BM_CovarianceUpdateFull(benchmark::State& state)
+{
+    const uint8_t p = state.range_x();
+    setup(p);
+
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i <= 23; i++) {
+            for (uint8_t j = 0; j <= 23; j++) {
+                KH[i][j] = K[i] * H[j];
+            }
+        }
+        for (uint8_t j = 0; j <= 23; j++) {
+            for (uint8_t i = 0; i <= 23; i++) {
+                float res = 0;
+                for (uint8_t n = 0; patterns[p][n] >= 0; n++) {
+                    res += KH[i][patterns[p][n]] * P[patterns[p][n]][j];
+                }
+                KHP[i][j] = res;
+            }
+        }
+        for (uint8_t i = 0; i <= 23; i++) {
+            for (uint8_t j = 0; j <= 23; j++) {
+                P[i][j] = P[i][j] - KHP[i][j];
+            }
+        }
+        for (uint8_t i = 1; i <= 23; i++) {
+            for (uint8_t j = 0; j <= i-1; j++) {
+                float temp = 0.5f*(P[i][j] + P[j][i]);
+                P[i][j] = temp;
+                P[j][i] = temp;
+            }
+        }
+        gbenchmark_escape(&P);
+    }
+}
+
+BENCHMARK(BM_CovarianceUpdateFull)->Arg(0)->Arg(1)->Arg(2)->Arg(3)->Arg(4)->Arg(5)->Arg(6);
+
+static void BM_CovarianceUpdateSymmetric(benchmark::State& state)
+{
+    const uint8_t p = state.range_x();
+    setup(p);
+
+    while (state.KeepRunning()) {
+        for (uint8_t j = 0; j <= 23; j++) {
+            float res = 0;
+            for (uint8_t n = 0; patterns[p][n] >= 0; n++) {
+                res += H[patterns[p][n]] * P[patterns[p][n]][j];
+            }
+            HP[j] = res;
+        }
+        EKF2_UpdateCovariance(P, K, HP, 23);
+        gbenchmark_escape(&P);
+    }
+}
+
+BENCHMARK(BM_CovarianceUpdateSymmetric)->Arg(0)->Arg(1)->Arg(2)->Arg(3)->Arg(4)->Arg(5)->Arg(6);
+
+BENCHMARK_MAIN()
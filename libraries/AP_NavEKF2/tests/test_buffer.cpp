@@ -0,0 +1,124 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_NavEKF2/AP_NavEKF2_Buffer.h>
+
+struct obs_elements {
+    float value;
+    uint32_t time_ms;
+};
+
+static obs_elements obs(uint32_t time_ms)
+{
+    obs_elements e = { time_ms * 0.5f, time_ms };
+    return e;
+}
+
+TEST(EKF2_BufferTest, RecallNewestNotNewer)
+{
+    obs_ring_buffer_t<obs_elements, 8> buffer;
+    obs_elements e;
+    EXPECT_FALSE(buffer.recall(e, 1000));
+
+    for (uint32_t t = 1000; t < 1060; t += 10) {
+        buffer.push(obs(t));
+    }
+    EXPECT_EQ(6, buffer.count());
+
+    // nothing old enough yet
+    EXPECT_FALSE(buffer.recall(e, 995));
+    EXPECT_EQ(6, buffer.count());
+
+    // the newest data not newer than the sample time, dropping older data
+    EXPECT_TRUE(buffer.recall(e, 1025));
+    EXPECT_EQ(1020U, e.time_ms);
+    EXPECT_EQ(510.0f, e.value);
+    EXPECT_EQ(3, buffer.count());
+
+    // recalled data is not used again
+    EXPECT_FALSE(buffer.recall(e, 1029));
+    EXPECT_TRUE(buffer.recall(e, 1030));
+    EXPECT_EQ(1030U, e.time_ms);
+
+    // including the newest
+    EXPECT_TRUE(buffer.recall(e, 1060));
+    EXPECT_EQ(1050U, e.time_ms);
+    EXPECT_EQ(0, buffer.count());
+}
+
+TEST(EKF2_BufferTest, StaleDataDropped)
+{
+    obs_ring_buffer_t<obs_elements, 8> buffer;
+    obs_elements e;
+    buffer.push(obs(1000));
+    buffer.push(obs(1010));
+
+    // data 100msec or more old is never used
+    EXPECT_FALSE(buffer.recall(e, 1110));
+    EXPECT_EQ(0, buffer.count());
+
+    buffer.push(obs(1200));
+    EXPECT_TRUE(buffer.recall(e, 1299));
+    EXPECT_EQ(1200U, e.time_ms);
+}
+
+TEST(EKF2_BufferTest, OverwriteWhenFull)
+{
+    obs_ring_buffer_t<obs_elements, 4> buffer;
+    obs_elements e;
+
+    // keep going round the ring to check the wrap
+    for (uint32_t t = 1000; t < 1100; t += 10) {
+        buffer.push(obs(t));
+    }
+    EXPECT_EQ(4, buffer.count());
+
+    // the oldest data has been overwritten
+    EXPECT_FALSE(buffer.recall(e, 1055));
+    EXPECT_TRUE(buffer.recall(e, 1065));
+    EXPECT_EQ(1060U, e.time_ms);
+    EXPECT_EQ(3, buffer.count());
+
+    buffer.reset();
+    EXPECT_EQ(0, buffer.count());
+    EXPECT_FALSE(buffer.recall(e, 2000));
+}
+
+TEST(EKF2_BufferTest, OutOfOrderPush)
+{
+    obs_ring_buffer_t<obs_elements, 4> buffer;
+    obs_elements e;
+
+    // a median filter can stamp a sample older than the last one pushed
+    buffer.push(obs(1000));
+    buffer.push(obs(1050));
+    buffer.push(obs(1025));
+    buffer.push(obs(1075));
+    EXPECT_EQ(4, buffer.count());
+
+    EXPECT_TRUE(buffer.recall(e, 1030));
+    EXPECT_EQ(1025U, e.time_ms);
+    EXPECT_EQ(2, buffer.count());
+
+    // when full, data older than all of it is the data overwritten
+    buffer.push(obs(1100));
+    buffer.push(obs(1090));
+    EXPECT_EQ(4, buffer.count());
+    buffer.push(obs(1040));
+    EXPECT_EQ(4, buffer.count());
+    EXPECT_TRUE(buffer.recall(e, 1060));
+    EXPECT_EQ(1050U, e.time_ms);
+
+    // and newer data replaces the oldest
+    buffer.push(obs(1080));
+    buffer.push(obs(1095));
+    EXPECT_TRUE(buffer.recall(e, 1085));
+    EXPECT_EQ(1080U, e.time_ms);
+    EXPECT_TRUE(buffer.recall(e, 1092));
+    EXPECT_EQ(1090U, e.time_ms);
+    EXPECT_TRUE(buffer.recall(e, 1150));
+    EXPECT_EQ(1100U, e.time_ms);
+    EXPECT_EQ(0, buffer.count());
+}
+
+AP_GTEST_MAIN()
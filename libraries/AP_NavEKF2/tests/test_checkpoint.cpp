@@ -0,0 +1,115 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_NavEKF2/AP_NavEKF2_Checkpoint.h>
+
+// some fields of a filter, moved in one function as the core does
+struct Fields {
+    Vector3f v;
+    float f[5];
+    uint32_t t;
+    bool a, b, c;
+
+    void transfer(EKF2_CheckpointIO &io)
+    {
+        io.field(v);
+        io.field(f);
+        io.field(t);
+        bool *const flags[] = { &a, &b, &c };
+        io.flags(flags, ARRAY_SIZE(flags));
+    }
+};
+
+TEST(EKF2_CheckpointTest, RoundTrip)
+{
+    Fields in = { Vector3f(1, 2, 3), { 4, 5, 6, 7, 8 }, 123456, true, false, true };
+
+    EKF2_CheckpointIO size(EKF2_CheckpointIO::SIZE, nullptr, 0);
+    in.transfer(size);
+    EXPECT_EQ(sizeof(Vector3f) + 5 * sizeof(float) + sizeof(uint32_t) + 1, size.offset());
+
+    uint8_t buffer[64];
+    EKF2_CheckpointIO write(EKF2_CheckpointIO::WRITE, buffer, sizeof(buffer));
+    in.transfer(write);
+    EXPECT_TRUE(write.ok());
+    EXPECT_EQ(size.offset(), write.offset());
+
+    Fields out = {};
+    EKF2_CheckpointIO read(buffer, write.offset());
+    out.transfer(read);
+    EXPECT_TRUE(read.ok());
+    EXPECT_EQ(0, memcmp(&in.v, &out.v, sizeof(in.v)));
+    EXPECT_EQ(0, memcmp(in.f, out.f, sizeof(in.f)));
+    EXPECT_EQ(in.t, out.t);
+    EXPECT_EQ(in.a, out.a);
+    EXPECT_EQ(in.b, out.b);
+    EXPECT_EQ(in.c, out.c);
+}
+
+TEST(EKF2_CheckpointTest, Overflow)
+{
+    Fields in = {};
+    uint8_t buffer[16];
+    EKF2_CheckpointIO write(EKF2_CheckpointIO::WRITE, buffer, sizeof(buffer));
+    in.transfer(write);
+    EXPECT_FALSE(write.ok());
+
+    Fields out = {};
+    EKF2_CheckpointIO read(buffer, sizeof(buffer));
+    out.transfer(read);
+    EXPECT_FALSE(read.ok());
+}
+
+// store a checkpoint of length bytes, each byte set to value
+static void store(EKF2_CheckpointRing &ring, uint16_t length, uint8_t value)
+{
+    memset(ring.next_slot(), value, length);
+    ring.commit(length);
+}
+
+TEST(EKF2_CheckpointTest, Ring)
+{
+    EKF2_CheckpointRing ring;
+    uint16_t length;
+    EXPECT_FALSE(ring.enabled());
+    EXPECT_TRUE(ring.init(200));
+    EXPECT_TRUE(ring.latest(length) == nullptr);
+    EXPECT_FALSE(ring.start_log());
+
+    for (uint8_t value = 1; value < 5; value++) {
+        store(ring, 150, value);
+        const uint8_t *data = ring.latest(length);
+        EXPECT_EQ(150, length);
+        EXPECT_EQ(value, data[0]);
+        EXPECT_EQ(value, data[149]);
+    }
+}
+
+TEST(EKF2_CheckpointTest, LogChunks)
+{
+    EKF2_CheckpointRing ring;
+    EXPECT_TRUE(ring.init(200));
+    store(ring, 150, 7);
+    EXPECT_TRUE(ring.start_log());
+
+    // checkpoints taken while logging don't overwrite the one being logged
+    uint8_t logged[3 * EKF2_CHECKPOINT_CHUNK];
+    uint8_t seq, count;
+    for (uint8_t n = 0; n < 3; n++) {
+        store(ring, 150, 8 + n);
+        EXPECT_TRUE(ring.logging());
+        EXPECT_TRUE(ring.log_chunk(seq, count, &logged[n * EKF2_CHECKPOINT_CHUNK]));
+        EXPECT_EQ(n, seq);
+        EXPECT_EQ(3, count);
+    }
+    EXPECT_FALSE(ring.logging());
+    EXPECT_FALSE(ring.log_chunk(seq, count, logged));
+
+    for (uint16_t i = 0; i < sizeof(logged); i++) {
+        EXPECT_EQ(i < 150 ? 7 : 0, logged[i]);
+    }
+    uint16_t length;
+    EXPECT_EQ(10, ring.latest(length)[0]);
+}
+
+AP_GTEST_MAIN()
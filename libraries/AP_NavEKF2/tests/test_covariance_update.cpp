@@ -0,0 +1,155 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_NavEKF2/AP_NavEKF2_Covariance.h>
+
+#include <stdlib.h>
+
+typedef float Matrix24[24][24];
+
+// observation patterns of the fusion steps, ended by -1
+static const int8_t patterns[][10] = {
+    { 4, -1 },                                  // position/velocity/height
+    { 3, 4, 5, 22, 23, -1 },                    // airspeed
+    { 0, 1, 2, 3, 4, 5, 22, 23, -1 },           // sideslip
+    { 0, 1, 2, 16, 17, 18, 19, 20, 21, -1 },    // magnetometer
+    { 0, 1, 2, -1 },                            // euler yaw
+    { 16, 17, -1 },                             // declination
+    { 0, 1, 2, 3, 4, 5, 8, -1 },                // optical flow
+};
+
+static float rand_float(void)
+{
+    return (random() / (float)RAND_MAX) * 2.0f - 1.0f;
+}
+
+// a random symmetric positive definite covariance
+static void make_covariance(Matrix24 &P)
+{
+    Matrix24 A;
+    for (uint8_t i = 0; i < 24; i++) {
+        for (uint8_t j = 0; j < 24; j++) {
+            A[i][j] = rand_float();
+        }
+    }
+    for (uint8_t i = 0; i < 24; i++) {
+        for (uint8_t j = 0; j <= i; j++) {
+            float sum = 0;
+            for (uint8_t k = 0; k < 24; k++) {
+                sum += A[i][k] * A[j][k];
+            }
+            P[i][j] = P[j][i] = 0.1f * sum;
+        }
+        P[i][i] += 1.0f;
+    }
+}
+
+// the update as it was done before: P = P - K*H*P, then force symmetry
+static void reference_update(Matrix24 &P, const float *K, const float *H, uint8_t last)
+{
+    Matrix24 KHP;
+    for (uint8_t i = 0; i <= last; i++) {
+        for (uint8_t j = 0; j <= last; j++) {
+            float res = 0;
+            for (uint8_t k = 0; k <= last; k++) {
+                res += K[i] * H[k] * P[k][j];
+            }
+            KHP[i][j] = res;
+        }
+    }
+    for (uint8_t i = 0; i <= last; i++) {
+        for (uint8_t j = 0; j <= last; j++) {
+            P[i][j] -= KHP[i][j];
+        }
+    }
+    for (uint8_t i = 1; i <= last; i++) {
+        for (uint8_t j = 0; j < i; j++) {
+            float temp = 0.5f * (P[i][j] + P[j][i]);
+            P[i][j] = temp;
+            P[j][i] = temp;
+        }
+    }
+}
+
+static void check_pattern(uint8_t p, uint8_t last, bool inhibit)
+{
+    Matrix24 P1, P2;
+    float H[24] = {};
+    float K[24] = {};
+    float HP[24] = {};
+
+    make_covariance(P1);
+    memcpy(P2, P1, sizeof(P1));
+
+    for (uint8_t n = 0; patterns[p][n] >= 0; n++) {
+        if (patterns[p][n] <= last) {
+            H[patterns[p][n]] = rand_float();
+        }
+    }
+
+    // optimal gain K = P*H'/(H*P*H' + R)
+    float innovVar = 0.5f;
+    for (uint8_t j = 0; j <= last; j++) {
+        for (uint8_t k = 0; k <= last; k++) {
+            HP[j] += H[k] * P1[k][j];
+        }
+        innovVar += HP[j] * H[j];
+    }
+    for (uint8_t i = 0; i <= last; i++) {
+        K[i] = HP[i] / innovVar;
+    }
+    if (inhibit) {
+        // the fusion steps zero the gains of states they must not change
+        for (uint8_t i = 9; i <= last; i++) {
+            K[i] = 0.0f;
+        }
+    }
+
+    reference_update(P1, K, H, last);
+    EKF2_UpdateCovariance(P2, K, HP, last);
+
+    for (uint8_t i = 0; i <= last; i++) {
+        for (uint8_t j = 0; j <= last; j++) {
+            EXPECT_NEAR(P1[i][j], P2[i][j], 1.0e-4f * (1.0f + fabsf(P1[i][j])));
+            EXPECT_EQ(P2[i][j], P2[j][i]);
+        }
+    }
+}
+
+TEST(CovarianceUpdateTest, MatchesFullUpdate)
+{
+    const uint8_t lims[] = { 15, 21, 23 };
+    for (uint8_t p = 0; p < ARRAY_SIZE(patterns); p++) {
+        for (uint8_t l = 0; l < ARRAY_SIZE(lims); l++) {
+            for (uint8_t n = 0; n < 20; n++) {
+                check_pattern(p, lims[l], false);
+                check_pattern(p, lims[l], true);
+            }
+        }
+    }
+}
+
+TEST(CovarianceUpdateTest, LeavesUnusedStates)
+{
+    Matrix24 P;
+    float K[24], HP[24];
+    make_covariance(P);
+    for (uint8_t i = 0; i < 24; i++) {
+        K[i] = rand_float();
+        HP[i] = rand_float();
+    }
+    Matrix24 P0;
+    memcpy(P0, P, sizeof(P));
+
+    EKF2_UpdateCovariance(P, K, HP, 15);
+
+    for (uint8_t i = 0; i < 24; i++) {
+        for (uint8_t j = 0; j < 24; j++) {
+            if (i > 15 || j > 15) {
+                EXPECT_EQ(P0[i][j], P[i][j]);
+            }
+        }
+    }
+}
+
+AP_GTEST_MAIN()
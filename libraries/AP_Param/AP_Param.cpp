@@ -24,7 +24,9 @@
 /// @brief  The AP variable store.
 #include "AP_Param.h"
 
+#include <ctype.h>
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <AP_Common/AP_Common.h>
@@ -70,6 +72,25 @@ uint16_t AP_Param::_num_vars;
 // cached parameter count
 uint16_t AP_Param::_parameter_count;
 
+struct AP_Param::StorageStats AP_Param::_storage_stats;
+
+#if AP_PARAM_INDEXED
+// hashed name table for find() and parameter index table for find_by_index()
+struct AP_Param::index_entry *AP_Param::_name_index;
+uint16_t AP_Param::_name_index_count;
+bool AP_Param::_name_index_valid;
+AP_Param::ParamToken *AP_Param::_scalar_index;
+uint16_t AP_Param::_scalar_index_count;
+
+// offsets of stored variables for scan()
+struct AP_Param::storage_entry *AP_Param::_storage_index;
+uint16_t AP_Param::_storage_index_count;
+uint16_t AP_Param::_storage_index_size;
+uint16_t AP_Param::_storage_end;
+bool AP_Param::_storage_index_valid;
+bool AP_Param::_storage_index_failed;
+#endif
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -111,6 +132,14 @@ void AP_Param::erase_all(void)
 
     // add a sentinal directly after the header
     write_sentinal(sizeof(struct EEPROM_header));
+
+#if AP_PARAM_INDEXED
+    _storage_index_count = 0;
+    _storage_end = sizeof(struct EEPROM_header);
+    _storage_index_valid = true;
+#endif
+    _storage_stats.stored_count = 0;
+    _storage_stats.storage_used = sizeof(struct EEPROM_header);
 }
 
 // validate a group info table
@@ -524,7 +553,7 @@ bool AP_Param::is_sentinal(const Param_header &phdr)
 // the variable is stored
 // if not found return the offset of the sentinal
 // if the sentinal isn't found either, the offset is set to 0xFFFF
-bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
+bool AP_Param::scan_linear(const AP_Param::Param_header *target, uint16_t *pofs)
 {
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
@@ -549,6 +578,163 @@ bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
     return false;
 }
 
+#if AP_PARAM_INDEXED
+// return a Param_header as an integer for ordering the storage index
+uint32_t AP_Param::header_value(const struct Param_header &phdr)
+{
+    uint32_t v;
+    memcpy(&v, &phdr, sizeof(v));
+    return v;
+}
+
+// return the position of the first storage index entry not less than header
+uint16_t AP_Param::storage_index_search(uint32_t header)
+{
+    uint16_t lo = 0, hi = _storage_index_count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (_storage_index[mid].header < header) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*
+  make room for one more entry in the storage index. Returns false if
+  the index could not be grown
+ */
+bool AP_Param::storage_index_grow(void)
+{
+    if (_storage_index_count < _storage_index_size) {
+        return true;
+    }
+    uint16_t new_size = _storage_index_size == 0 ? 64 : _storage_index_size * 2;
+    struct storage_entry *new_index = new storage_entry[new_size];
+    if (new_index == NULL) {
+        return false;
+    }
+    if (_storage_index_count > 0) {
+        memcpy(new_index, _storage_index, _storage_index_count * sizeof(new_index[0]));
+    }
+    delete[] _storage_index;
+    _storage_index = new_index;
+    _storage_index_size = new_size;
+    return true;
+}
+
+/*
+  add a newly saved variable to the sorted storage index. Returns
+  false if the index could not be grown
+ */
+bool AP_Param::storage_index_add(const struct Param_header &phdr, uint16_t ofs)
+{
+    uint32_t header = header_value(phdr);
+    uint16_t i = storage_index_search(header);
+    if (i < _storage_index_count && _storage_index[i].header == header) {
+        _storage_index[i].ofs = ofs;
+        return true;
+    }
+    if (!storage_index_grow()) {
+        return false;
+    }
+    memmove(&_storage_index[i+1], &_storage_index[i], (_storage_index_count - i) * sizeof(_storage_index[0]));
+    _storage_index[i].header = header;
+    _storage_index[i].ofs = ofs;
+    _storage_index_count++;
+    return true;
+}
+
+// qsort() comparison for the storage index, ordered by header then offset
+int AP_Param::compare_storage_entry(const void *e1, const void *e2)
+{
+    const struct storage_entry *a = (const struct storage_entry *)e1;
+    const struct storage_entry *b = (const struct storage_entry *)e2;
+    if (a->header != b->header) {
+        return a->header < b->header ? -1 : 1;
+    }
+    return (int)a->ofs - (int)b->ofs;
+}
+
+/*
+  build the storage index with a single pass over storage. Entries
+  are appended in storage order and sorted once at the end. If a
+  variable is stored more than once the last copy is kept, as it is
+  the one load_all() has always ended up with. If there isn't enough
+  memory scan() falls back to reading storage
+ */
+void AP_Param::build_storage_index(void)
+{
+    struct Param_header phdr;
+    uint16_t ofs = sizeof(AP_Param::EEPROM_header);
+
+    _storage_index_count = 0;
+    _storage_end = 0xFFFF;
+    _storage_index_valid = false;
+
+    while (ofs < _storage.size()) {
+        _storage.read_block(&phdr, ofs, sizeof(phdr));
+        if (is_sentinal(phdr)) {
+            _storage_end = ofs;
+            break;
+        }
+        if (!storage_index_grow()) {
+            Debug("no memory for storage index");
+            delete[] _storage_index;
+            _storage_index = NULL;
+            _storage_index_count = 0;
+            _storage_index_size = 0;
+            _storage_index_failed = true;
+            return;
+        }
+        _storage_index[_storage_index_count].header = header_value(phdr);
+        _storage_index[_storage_index_count].ofs = ofs;
+        _storage_index_count++;
+        ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
+    }
+
+    qsort(_storage_index, _storage_index_count, sizeof(_storage_index[0]), compare_storage_entry);
+
+    // drop all but the last copy of each variable
+    uint16_t n = 0;
+    for (uint16_t i=0; i<_storage_index_count; i++) {
+        if (i+1 < _storage_index_count &&
+            _storage_index[i+1].header == _storage_index[i].header) {
+            continue;
+        }
+        _storage_index[n++] = _storage_index[i];
+    }
+    _storage_index_count = n;
+
+    _storage_index_valid = true;
+}
+#endif // AP_PARAM_INDEXED
+
+// find a variable in storage, using the storage index when
+// available. The results are the same as scan_linear(), except that
+// a variable stored more than once is found at its last copy
+bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
+{
+#if AP_PARAM_INDEXED
+    if (!_storage_index_valid && !_storage_index_failed) {
+        build_storage_index();
+    }
+    if (_storage_index_valid) {
+        uint32_t header = header_value(*target);
+        uint16_t i = storage_index_search(header);
+        if (i < _storage_index_count && _storage_index[i].header == header) {
+            *pofs = _storage_index[i].ofs;
+            return true;
+        }
+        *pofs = _storage_end;
+        return false;
+    }
+#endif
+    return scan_linear(target, pofs);
+}
+
 /**
  * add a _X, _Y, _Z suffix to the name of a Vector3f element
  * @param buffer
@@ -666,10 +852,240 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 }
 
 
+#if AP_PARAM_INDEXED
+/*
+  case insensitive FNV-1a hash of a parameter name
+ */
+uint32_t AP_Param::name_hash(const char *name)
+{
+    uint32_t h = 2166136261UL;
+    while (*name) {
+        h ^= (uint8_t)toupper(*name++);
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+// qsort() comparison for the name table, ordered by hash then token
+int AP_Param::compare_index_entry(const void *e1, const void *e2)
+{
+    const struct index_entry *a = (const struct index_entry *)e1;
+    const struct index_entry *b = (const struct index_entry *)e2;
+    if (a->hash != b->hash) {
+        return a->hash < b->hash ? -1 : 1;
+    }
+    if (a->token.key != b->token.key) {
+        return a->token.key < b->token.key ? -1 : 1;
+    }
+    if (a->token.group_element != b->token.group_element) {
+        return a->token.group_element < b->token.group_element ? -1 : 1;
+    }
+    return (int)a->token.idx - (int)b->token.idx;
+}
+
+/*
+  find the offset from the base of variable vindex and the type of
+  the group element with the given id, recursing into nested groups
+  the same way next_group() does
+ */
+bool AP_Param::find_token_group(uint16_t vindex, const struct GroupInfo *group_info,
+                                uint8_t group_base, uint8_t group_shift, ptrdiff_t group_offset,
+                                uint32_t group_element, ptrdiff_t &ofs, enum ap_var_type &type)
+{
+    enum ap_var_type t;
+    for (uint8_t i=0;
+         (t=(enum ap_var_type)group_info[i].type) != AP_PARAM_NONE;
+         i++) {
+        if (t == AP_PARAM_GROUP) {
+            ptrdiff_t new_offset = group_offset;
+            if (!adjust_group_offset(vindex, group_info[i], new_offset)) {
+                continue;
+            }
+            if (find_token_group(vindex, group_info[i].group_info,
+                                 GROUP_ID(group_info, group_base, i, group_shift),
+                                 group_shift + _group_level_shift, new_offset,
+                                 group_element, ofs, type)) {
+                return true;
+            }
+        } else if ((uint32_t)GROUP_ID(group_info, group_base, i, group_shift) == group_element) {
+            ofs = group_info[i].offset + group_offset;
+            type = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  return the variable a token from first()/next() refers to, which
+  is a float for an element of a vector
+ */
+AP_Param *AP_Param::find_by_token(const ParamToken &token, enum ap_var_type *ptype)
+{
+    if (token.key >= _num_vars) {
+        return NULL;
+    }
+    enum ap_var_type type = (enum ap_var_type)_var_info[token.key].type;
+    ptrdiff_t ofs = 0;
+    if (type == AP_PARAM_GROUP &&
+        !find_token_group(token.key, _var_info[token.key].group_info, 0, 0, 0,
+                          token.group_element, ofs, type)) {
+        // the object holding it has gone
+        return NULL;
+    }
+    if (type == AP_PARAM_VECTOR3F && token.idx != 0) {
+        ofs += sizeof(float) * (token.idx - 1u);
+        type = AP_PARAM_FLOAT;
+    }
+    if (ptype != NULL) {
+        *ptype = type;
+    }
+    return (AP_Param *)((ptrdiff_t)_var_info[token.key].ptr + ofs);
+}
+
+/*
+  build the hashed name table from a walk of all variables. Pointer
+  groups that are not allocated yet are not in the table, so it is
+  rebuilt when find_linear() finds a variable it is missing
+ */
+void AP_Param::build_name_index(void)
+{
+    delete[] _name_index;
+    _name_index = NULL;
+    _name_index_count = 0;
+    _name_index_valid = true;
+
+    ParamToken token;
+    enum ap_var_type type;
+    AP_Param *ap;
+    uint16_t count = 0;
+    for (ap = first(&token, &type); ap != NULL; ap = next(&token, &type)) {
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+    _name_index = new index_entry[count];
+    if (_name_index == NULL) {
+        return;
+    }
+
+    for (ap = first(&token, &type); ap != NULL && _name_index_count < count; ap = next(&token, &type)) {
+        if (type == AP_PARAM_GROUP) {
+            continue;
+        }
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(token, name, AP_MAX_NAME_SIZE, token.idx != 0);
+        name[AP_MAX_NAME_SIZE] = 0;
+        if (name[0] == 0) {
+            continue;
+        }
+        struct index_entry &e = _name_index[_name_index_count++];
+        e.hash = name_hash(name);
+        e.token = token;
+    }
+    qsort(_name_index, _name_index_count, sizeof(_name_index[0]), compare_index_entry);
+}
+
+/*
+  build the table of first()/next_scalar() results. The order
+  depends on the values of enable parameters, so this is rebuilt
+  whenever the parameter count is
+ */
+void AP_Param::build_scalar_index(void)
+{
+    delete[] _scalar_index;
+    _scalar_index_count = 0;
+    _scalar_index = new ParamToken[_parameter_count];
+    if (_scalar_index == NULL) {
+        return;
+    }
+
+    /*
+      the same walk as first()/next_scalar(), but keeping the token of
+      each variable before next_scalar() moves it past a disabled tree,
+      so the token can be resolved back to the variable
+     */
+    ParamToken token;
+    enum ap_var_type type;
+    AP_Param *ap = first(&token, &type);
+    while (ap != NULL && _scalar_index_count < _parameter_count) {
+        _scalar_index[_scalar_index_count++] = token;
+        if (type == AP_PARAM_INT8) {
+            skip_disabled_tree(ap, &token);
+        }
+        while ((ap = next(&token, &type)) != NULL && type > AP_PARAM_FLOAT) ;
+    }
+}
+
+/*
+  find a variable by name using the hashed name table. Hash matches
+  are confirmed by comparing the full name
+ */
+AP_Param *AP_Param::find_indexed(const char *name, enum ap_var_type *ptype)
+{
+    if (!_name_index_valid) {
+        build_name_index();
+    }
+    if (_name_index == NULL) {
+        return NULL;
+    }
+
+    const uint32_t hash = name_hash(name);
+    uint16_t lo = 0, hi = _name_index_count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (_name_index[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < _name_index_count && _name_index[lo].hash == hash; lo++) {
+        const struct index_entry &e = _name_index[lo];
+        enum ap_var_type type = AP_PARAM_NONE;
+        AP_Param *ap = find_by_token(e.token, &type);
+        if (ap == NULL) {
+            continue;
+        }
+        char name2[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(e.token, name2, AP_MAX_NAME_SIZE, e.token.idx != 0);
+        name2[AP_MAX_NAME_SIZE] = 0;
+        if (strcasecmp(name, name2) == 0) {
+            *ptype = type;
+            return ap;
+        }
+    }
+    return NULL;
+}
+#endif // AP_PARAM_INDEXED
+
 // Find a variable by name.
 //
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype)
+{
+#if AP_PARAM_INDEXED
+    AP_Param *ap = find_indexed(name, ptype);
+    if (ap != NULL) {
+        return ap;
+    }
+    ap = find_linear(name, ptype);
+    if (ap != NULL) {
+        // the variable is in an object allocated since the name
+        // table was built
+        _name_index_valid = false;
+    }
+    return ap;
+#else
+    return find_linear(name, ptype);
+#endif
+}
+
+// Find a variable by name, walking the var_info tree
+//
+AP_Param *
+AP_Param::find_linear(const char *name, enum ap_var_type *ptype)
 {
     for (uint16_t i=0; i<_num_vars; i++) {
         uint8_t type = _var_info[i].type;
@@ -719,11 +1135,32 @@ AP_Param::find_def_value_ptr(const char *name)
     return &info->def_value;
 }
 
-// Find a variable by index. Note that this is quite slow.
+// Find a variable by index. Note that this is quite slow unless
+// AP_PARAM_INDEXED is enabled
 //
 AP_Param *
 AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token)
 {
+#if AP_PARAM_INDEXED
+    // make sure the index table is current
+    count_parameters();
+    if (_scalar_index != NULL && _scalar_index_count == _parameter_count) {
+        if (idx >= _scalar_index_count) {
+            return NULL;
+        }
+        *token = _scalar_index[idx];
+        enum ap_var_type type = AP_PARAM_NONE;
+        AP_Param *ap = find_by_token(*token, &type);
+        if (ap != NULL && type == AP_PARAM_INT8) {
+            // leave the token where next_scalar() would
+            skip_disabled_tree(ap, token);
+        }
+        if (ptype != NULL) {
+            *ptype = type;
+        }
+        return ap;
+    }
+#endif
     AP_Param *ap;
     uint16_t count=0;
     for (ap=AP_Param::first(token, ptype);
@@ -793,6 +1230,19 @@ void AP_Param::notify() const {
 // Save the variable to EEPROM, if supported
 //
 bool AP_Param::save(bool force_save)
+{
+    uint32_t start_us = AP_HAL::micros();
+    bool ret = save_value(force_save);
+    uint32_t dt = AP_HAL::micros() - start_us;
+    _storage_stats.save_count++;
+    _storage_stats.save_total_us += dt;
+    if (dt > _storage_stats.save_max_us) {
+        _storage_stats.save_max_us = dt;
+    }
+    return ret;
+}
+
+bool AP_Param::save_value(bool force_save)
 {
     uint32_t group_element = 0;
     const struct GroupInfo *ginfo;
@@ -875,10 +1325,24 @@ bool AP_Param::save(bool force_save)
     }
 
     // write a new sentinal, then the data, then the header
-    write_sentinal(ofs + sizeof(phdr) + type_size((enum ap_var_type)phdr.type));
+    uint16_t end = ofs + sizeof(phdr) + type_size((enum ap_var_type)phdr.type);
+    write_sentinal(end);
     eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(&phdr, ofs, sizeof(phdr));
 
+#if AP_PARAM_INDEXED
+    if (_storage_index_valid) {
+        if (storage_index_add(phdr, ofs)) {
+            _storage_end = end;
+        } else {
+            // rebuild on the next scan()
+            _storage_index_valid = false;
+        }
+    }
+#endif
+    _storage_stats.stored_count++;
+    _storage_stats.storage_used = end;
+
     send_parameter(name, (enum ap_var_type)phdr.type);
     return true;
 }
@@ -1073,9 +1537,28 @@ void AP_Param::setup_sketch_defaults(void)
 // Load all variables from EEPROM
 //
 bool AP_Param::load_all(void)
+{
+    bool ret = load_stored_values();
+
+#if AP_PARAM_INDEXED
+    /*
+      build the lookup tables now that enable parameters have their
+      stored values, rather than on the first GCS request
+     */
+    build_name_index();
+    count_parameters();
+#endif
+
+    return ret;
+}
+
+// read the value of every variable in storage
+//
+bool AP_Param::load_stored_values(void)
 {
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
+    uint32_t start_us = AP_HAL::micros();
 
 #if HAL_OS_POSIX_IO == 1
     /*
@@ -1085,12 +1568,42 @@ bool AP_Param::load_all(void)
     load_defaults_file(hal.util->get_custom_defaults_file());
 #endif
 
+#if AP_PARAM_INDEXED
+    // the storage index is built in the same single pass over storage
+    build_storage_index();
+    if (_storage_index_valid) {
+        for (uint16_t i=0; i<_storage_index_count; i++) {
+            memcpy(&phdr, &_storage_index[i].header, sizeof(phdr));
+
+            const struct AP_Param::Info *info;
+            void *ptr;
+
+            info = find_by_header(phdr, &ptr);
+            if (info != NULL) {
+                _storage.read_block(ptr, _storage_index[i].ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
+            }
+        }
+        _storage_stats.stored_count = _storage_index_count;
+        _storage_stats.storage_used = _storage_end == 0xFFFF ? _storage.size() : _storage_end;
+        _storage_stats.load_all_us = AP_HAL::micros() - start_us;
+        if (_storage_end == 0xFFFF) {
+            Debug("no sentinal in load_all");
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    uint16_t count = 0;
     while (ofs < _storage.size()) {
         _storage.read_block(&phdr, ofs, sizeof(phdr));
         // note that this is an || not an && for robustness
         // against power off while adding a variable
         if (is_sentinal(phdr)) {
             // we've reached the sentinal
+            _storage_stats.stored_count = count;
+            _storage_stats.storage_used = ofs;
+            _storage_stats.load_all_us = AP_HAL::micros() - start_us;
             return true;
         }
 
@@ -1103,9 +1616,13 @@ bool AP_Param::load_all(void)
         }
 
         ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
+        count++;
     }
 
     // we didn't find the sentinal
+    _storage_stats.stored_count = count;
+    _storage_stats.storage_used = _storage.size();
+    _storage_stats.load_all_us = AP_HAL::micros() - start_us;
     Debug("no sentinal in load_all");
     return false;
 }
@@ -1303,38 +1820,7 @@ AP_Param *AP_Param::next_scalar(ParamToken *token, enum ap_var_type *ptype)
     while ((ap = next(token, &type)) != NULL && type > AP_PARAM_FLOAT) ;
 
     if (ap != NULL && type == AP_PARAM_INT8) {
-        /* 
-           check if this is an enable variable. To do that we need to
-           find the info structures for the variable
-         */
-        uint32_t group_element;
-        const struct GroupInfo *ginfo;
-        const struct GroupInfo *ginfo0;
-        uint8_t idx;
-        const struct AP_Param::Info *info = ap->find_var_info_token(*token, &group_element, ginfo, ginfo0, &idx);
-        if (info && ginfo &&
-            (ginfo->flags & AP_PARAM_FLAG_ENABLE) &&
-            ((AP_Int8 *)ap)->get() == 0) {
-            /*
-              this is a disabled parameter tree, include this
-              parameter but not others below it. We need to keep
-              looking until we go past the parameters in this object
-            */
-            ParamToken token2 = *token;
-            enum ap_var_type type2;
-            AP_Param *ap2;
-            while ((ap2 = next(&token2, &type2)) != NULL) {
-                if (token2.key != token->key) {
-                    break;
-                }
-                if (ginfo0 != NULL && (token->group_element & 0x3F) != (token2.group_element & 0x3F)) {
-                    break;
-                }
-                // update the returned token so the next() call goes from this point
-                *token = token2;
-            }
-            
-        }
+        skip_disabled_tree(ap, token);
     }
 
     if (ap != NULL && ptype != NULL) {
@@ -1343,6 +1829,46 @@ AP_Param *AP_Param::next_scalar(ParamToken *token, enum ap_var_type *ptype)
     return ap;
 }
 
+/*
+  if ap, the int8 variable token refers to, is a disabled enable
+  variable, move token on to the last variable below it, so next()
+  continues after the disabled tree
+ */
+void AP_Param::skip_disabled_tree(AP_Param *ap, ParamToken *token)
+{
+    /* 
+       check if this is an enable variable. To do that we need to
+       find the info structures for the variable
+     */
+    uint32_t group_element;
+    const struct GroupInfo *ginfo;
+    const struct GroupInfo *ginfo0;
+    uint8_t idx;
+    const struct AP_Param::Info *info = ap->find_var_info_token(*token, &group_element, ginfo, ginfo0, &idx);
+    if (info && ginfo &&
+        (ginfo->flags & AP_PARAM_FLAG_ENABLE) &&
+        ((AP_Int8 *)ap)->get() == 0) {
+        /*
+          this is a disabled parameter tree, include this
+          parameter but not others below it. We need to keep
+          looking until we go past the parameters in this object
+        */
+        ParamToken token2 = *token;
+        enum ap_var_type type2;
+        AP_Param *ap2;
+        while ((ap2 = next(&token2, &type2)) != NULL) {
+            if (token2.key != token->key) {
+                break;
+            }
+            if (ginfo0 != NULL && (token->group_element & 0x3F) != (token2.group_element & 0x3F)) {
+                break;
+            }
+            // update the returned token so the next() call goes from this point
+            *token = token2;
+        }
+    }
+}
+
 
 /// cast a variable to a float given its type
 float AP_Param::cast_to_float(enum ap_var_type type) const
@@ -1682,6 +2208,9 @@ uint16_t AP_Param::count_parameters(void)
         do {
             _parameter_count++;
         } while (NULL != (vp = AP_Param::next_scalar(&token, NULL)));
+#if AP_PARAM_INDEXED
+        build_scalar_index();
+#endif
     }
     return _parameter_count;
 }
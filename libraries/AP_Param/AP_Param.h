@@ -32,6 +32,22 @@
 
 #define AP_MAX_NAME_SIZE 16
 
+/*
+  keep hashed name and index tables so that find() and find_by_index()
+  don't need to walk the whole var_info tree. The tables only hold
+  tokens, which are resolved to a variable within its own group, so
+  the index table costs 4 bytes and the name table 8 bytes per
+  parameter, or about 8k of RAM for 700 parameters.
+
+  The tables are built by load_all(). They are rebuilt at runtime,
+  with a new[] and for the name table a qsort(), when an enable
+  parameter changes the set of visible parameters or when find()
+  meets a variable in an object allocated after the last build
+ */
+#ifndef AP_PARAM_INDEXED
+#define AP_PARAM_INDEXED (HAL_CPU_CLASS >= HAL_CPU_CLASS_150)
+#endif
+
 /*
   flags for variables in var_info and group tables
  */
@@ -184,6 +200,8 @@ public:
 
     /// Find a variable by index.
     ///
+    /// The index is the position of the variable in the sequence
+    /// given by first() and next_scalar().
     ///
     /// @param  idx             The index of the variable
     /// @return                 A pointer to the variable, or NULL if
@@ -315,6 +333,17 @@ public:
 
     // count of parameters in tree
     static uint16_t count_parameters(void);
+
+    // statistics of parameter storage access, for logging
+    struct StorageStats {
+        uint32_t load_all_us;   // duration of the last load_all()
+        uint16_t stored_count;  // number of variables in storage
+        uint16_t storage_used;  // bytes of storage in use
+        uint32_t save_count;    // number of calls to save()
+        uint32_t save_max_us;   // longest save()
+        uint32_t save_total_us; // total time spent in save()
+    };
+    static const struct StorageStats &storage_stats(void) { return _storage_stats; }
     
 private:
     /// EEPROM header
@@ -409,6 +438,10 @@ private:
     static bool                 scan(
                                     const struct Param_header *phdr,
                                     uint16_t *pofs);
+    static bool                 scan_linear(
+                                    const struct Param_header *phdr,
+                                    uint16_t *pofs);
+    bool                        save_value(bool force_save);
     static uint8_t				type_size(enum ap_var_type type);
     static void                 eeprom_write_check(
                                     const void *ptr,
@@ -440,11 +473,75 @@ private:
     static bool load_defaults_file(const char *filename);
 #endif
 
+    // read the value of every variable in storage, part of load_all()
+    static bool load_stored_values(void);
+
     static StorageAccess        _storage;
     static uint16_t             _num_vars;
     static uint16_t             _parameter_count;
+    static struct StorageStats  _storage_stats;
     static const struct Info *  _var_info;
 
+#if AP_PARAM_INDEXED
+    /*
+      an entry in the name table, which holds every named variable
+      given by next(), sorted by the hash of its name. Vectors and
+      variables hidden by an enable parameter are not in the index
+      table, so entries hold a token rather than an index into it
+     */
+    struct index_entry {
+        uint32_t hash;
+        ParamToken token;
+    };
+    static struct index_entry * _name_index;
+    static uint16_t             _name_index_count;
+    static bool                 _name_index_valid;
+    // the token of first()/next_scalar() for each parameter index
+    static ParamToken *         _scalar_index;
+    static uint16_t             _scalar_index_count;
+
+    static uint32_t             name_hash(const char *name);
+    static int                  compare_index_entry(const void *e1, const void *e2);
+    static bool                 find_token_group(uint16_t vindex,
+                                                 const struct GroupInfo *group_info,
+                                                 uint8_t group_base,
+                                                 uint8_t group_shift,
+                                                 ptrdiff_t group_offset,
+                                                 uint32_t group_element,
+                                                 ptrdiff_t &ofs,
+                                                 enum ap_var_type &type);
+    static AP_Param *           find_by_token(const ParamToken &token, enum ap_var_type *ptype);
+    static void                 build_name_index(void);
+    static void                 build_scalar_index(void);
+    static AP_Param *           find_indexed(const char *name, enum ap_var_type *ptype);
+
+    /*
+      offsets of the variables in storage, sorted by header, so that
+      scan() doesn't need to read through storage. Built with a
+      single pass over storage and kept up to date by save() and
+      erase_all()
+     */
+    struct storage_entry {
+        uint32_t header;    // Param_header as an integer
+        uint16_t ofs;
+    };
+    static struct storage_entry *_storage_index;
+    static uint16_t             _storage_index_count;
+    static uint16_t             _storage_index_size;
+    static uint16_t             _storage_end;   // offset of the sentinal, or 0xFFFF
+    static bool                 _storage_index_valid;
+    static bool                 _storage_index_failed;  // out of memory, use scan_linear()
+
+    static uint32_t             header_value(const struct Param_header &phdr);
+    static uint16_t             storage_index_search(uint32_t header);
+    static bool                 storage_index_grow(void);
+    static bool                 storage_index_add(const struct Param_header &phdr, uint16_t ofs);
+    static int                  compare_storage_entry(const void *e1, const void *e2);
+    static void                 build_storage_index(void);
+#endif
+    static AP_Param *           find_linear(const char *name, enum ap_var_type *ptype);
+    static void                 skip_disabled_tree(AP_Param *ap, ParamToken *token);
+
     /*
       list of overridden values from load_defaults_file()
     */
@@ -0,0 +1,350 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_ParamBlob.h"
+
+AP_ParamBlob::AP_ParamBlob() :
+    _state(STATE_IDLE),
+    _compressed(false),
+    _diff(false),
+    _have_snapshot(false),
+    _chunk_len(0),
+    _base_hash(0),
+    _ap(NULL),
+    _type(AP_PARAM_NONE),
+    _prepared(0),
+    _values(NULL),
+    _changed(NULL),
+    _size(0),
+    _count(0),
+    _hash(0),
+    _names_hash(0),
+    _new_hash(0),
+    _new_names_hash(0),
+    _chunk_start(NULL),
+    _max_chunks(0),
+    _known_chunks(0),
+    _num_chunks(0)
+{
+    memset(&_token, 0, sizeof(_token));
+}
+
+/*
+  FNV-1a hash of one parameter
+ */
+uint32_t AP_ParamBlob::entry_hash(const char *name, enum ap_var_type type, uint32_t value)
+{
+    uint32_t h = 2166136261UL;
+    while (*name) {
+        h ^= (uint8_t)*name++;
+        h *= 16777619UL;
+    }
+    h ^= (uint8_t)type;
+    h *= 16777619UL;
+    for (uint8_t i=0; i<4; i++) {
+        h ^= (uint8_t)(value >> (8*i));
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+// the value of a parameter as 4 bytes
+uint32_t AP_ParamBlob::raw_value(const AP_Param *ap, enum ap_var_type type)
+{
+    switch (type) {
+    case AP_PARAM_INT8:
+        return (uint32_t)(int32_t)((const AP_Int8 *)ap)->get();
+    case AP_PARAM_INT16:
+        return (uint32_t)(int32_t)((const AP_Int16 *)ap)->get();
+    case AP_PARAM_INT32:
+        return (uint32_t)((const AP_Int32 *)ap)->get();
+    case AP_PARAM_FLOAT: {
+        float f = ((const AP_Float *)ap)->get();
+        uint32_t v;
+        memcpy(&v, &f, sizeof(v));
+        return v;
+    }
+    default:
+        return 0;
+    }
+}
+
+/*
+  make sure the snapshot and the chunk table are big enough
+ */
+bool AP_ParamBlob::allocate(uint16_t count, uint8_t chunk_len)
+{
+    if (count > _size) {
+        delete[] _values;
+        delete[] _changed;
+        _size = 0;
+        _have_snapshot = false;
+        _values = new uint32_t[count];
+        _changed = new uint8_t[(count+7)/8];
+        if (_values == NULL || _changed == NULL) {
+            delete[] _values;
+            delete[] _changed;
+            _values = NULL;
+            _changed = NULL;
+            return false;
+        }
+        _size = count;
+    }
+
+    // every chunk holds at least chunk_len/AP_PARAMBLOB_ENTRY_MAX entries
+    uint16_t max_chunks = count / (chunk_len / AP_PARAMBLOB_ENTRY_MAX) + 2;
+    if (max_chunks > _max_chunks) {
+        delete[] _chunk_start;
+        _max_chunks = 0;
+        _chunk_start = new uint16_t[max_chunks];
+        if (_chunk_start == NULL) {
+            return false;
+        }
+        _max_chunks = max_chunks;
+    }
+    return true;
+}
+
+bool AP_ParamBlob::start(uint32_t base_hash, bool compressed, uint8_t chunk_len)
+{
+    if (chunk_len < AP_PARAMBLOB_ENTRY_MAX) {
+        // leave any blob being sent alone
+        return false;
+    }
+
+    _state = STATE_IDLE;
+    uint16_t count = AP_Param::count_parameters();
+    if (!allocate(count, chunk_len)) {
+        return false;
+    }
+    if (count != _count) {
+        // the values can't be compared with the last snapshot
+        _have_snapshot = false;
+    }
+    if (!_have_snapshot) {
+        memset(_values, 0, count * sizeof(_values[0]));
+    }
+    memset(_changed, 0, (count+7)/8);
+
+    _count = count;
+    _base_hash = base_hash;
+    _compressed = compressed;
+    _chunk_len = chunk_len;
+    _new_hash = 0;
+    _new_names_hash = 0;
+    _prepared = 0;
+    _ap = AP_Param::first(&_token, &_type);
+    _state = STATE_PREPARING;
+    return true;
+}
+
+bool AP_ParamBlob::prepare(uint16_t max_params)
+{
+    if (_state != STATE_PREPARING) {
+        return _state == STATE_READY;
+    }
+
+    for (uint16_t n=0; n<max_params && _ap != NULL && _prepared < _count; n++) {
+        char name[AP_MAX_NAME_SIZE+1];
+        _ap->copy_name_token(_token, name, AP_MAX_NAME_SIZE, true);
+        name[AP_MAX_NAME_SIZE] = 0;
+
+        uint32_t v = raw_value(_ap, _type);
+        if (v != _values[_prepared]) {
+            _changed[_prepared/8] |= 1U<<(_prepared%8);
+            _values[_prepared] = v;
+        }
+        _new_hash += entry_hash(name, _type, v);
+        _new_names_hash += entry_hash(name, _type, 0);
+
+        _ap = AP_Param::next_scalar(&_token, &_type);
+        _prepared++;
+    }
+    if (_ap != NULL && _prepared < _count) {
+        return false;
+    }
+    _count = _prepared;
+
+    if (_base_hash != 0 && _base_hash == _new_hash) {
+        // the client already has the current values
+        _diff = true;
+        memset(_changed, 0, (_count+7)/8);
+    } else {
+        _diff = (_base_hash != 0 && _have_snapshot &&
+                 _base_hash == _hash && _new_names_hash == _names_hash);
+    }
+
+    _hash = _new_hash;
+    _names_hash = _new_names_hash;
+    _have_snapshot = true;
+    _chunk_start[0] = 0;
+    _known_chunks = 1;
+    _num_chunks = 0;
+    _state = STATE_READY;
+    return true;
+}
+
+/*
+  encode one entry. Returns the number of bytes used, or 0 if it
+  doesn't fit
+ */
+uint8_t AP_ParamBlob::encode_entry(uint8_t *buf, uint8_t buf_len, bool compressed, const char *prev_name,
+                                   const char *name, enum ap_var_type type, uint32_t value)
+{
+    if (!compressed) {
+        if (buf_len < AP_MAX_NAME_SIZE + 5) {
+            return 0;
+        }
+        strncpy((char *)buf, name, AP_MAX_NAME_SIZE);
+        buf[AP_MAX_NAME_SIZE] = type;
+        for (uint8_t i=0; i<4; i++) {
+            buf[AP_MAX_NAME_SIZE+1+i] = value >> (8*i);
+        }
+        return AP_MAX_NAME_SIZE + 5;
+    }
+
+    uint8_t prefix_len = 0;
+    while (prefix_len < 15 && name[prefix_len] != 0 && name[prefix_len] == prev_name[prefix_len]) {
+        prefix_len++;
+    }
+    uint8_t suffix_len = strlen(name) - prefix_len;
+    uint8_t value_len = type == AP_PARAM_INT8 ? 1 : type == AP_PARAM_INT16 ? 2 : 4;
+    uint8_t len = 2 + suffix_len + value_len;
+    if (len > buf_len) {
+        return 0;
+    }
+    buf[0] = (prefix_len << 4) | type;
+    buf[1] = suffix_len;
+    memcpy(&buf[2], &name[prefix_len], suffix_len);
+    for (uint8_t i=0; i<value_len; i++) {
+        buf[2+suffix_len+i] = value >> (8*i);
+    }
+    return len;
+}
+
+int16_t AP_ParamBlob::get_chunk(uint16_t seq, uint8_t *buf, bool &last)
+{
+    if (_state != STATE_READY || seq >= _known_chunks ||
+        (_num_chunks != 0 && seq >= _num_chunks)) {
+        return -1;
+    }
+    if (AP_Param::count_parameters() != _count) {
+        // an enable parameter changed, so the names no longer match
+        // the snapshot
+        return -1;
+    }
+
+    uint16_t idx = _chunk_start[seq];
+    enum ap_var_type type;
+    AP_Param::ParamToken token;
+    AP_Param *ap = NULL;
+    if (idx < _count) {
+        ap = AP_Param::find_by_index(idx, &type, &token);
+    }
+
+    char prev_name[AP_MAX_NAME_SIZE+1] = "";
+    uint8_t len = 0;
+    for (; ap != NULL && idx < _count; ap = AP_Param::next_scalar(&token, &type), idx++) {
+        if (_diff && !changed(idx)) {
+            continue;
+        }
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(token, name, AP_MAX_NAME_SIZE, true);
+        name[AP_MAX_NAME_SIZE] = 0;
+        uint8_t n = encode_entry(&buf[len], _chunk_len - len, _compressed, prev_name, name, type, _values[idx]);
+        if (n == 0) {
+            break;
+        }
+        len += n;
+        memcpy(prev_name, name, sizeof(prev_name));
+    }
+    if (ap == NULL) {
+        idx = _count;
+    }
+
+    last = (idx >= _count);
+    if (seq + 1 == _known_chunks) {
+        if (last) {
+            _num_chunks = _known_chunks;
+        } else if (_known_chunks < _max_chunks) {
+            _chunk_start[_known_chunks++] = idx;
+        } else {
+            return -1;
+        }
+    }
+    return len;
+}
+
+uint8_t AP_ParamBlob::decode_entry(const uint8_t *buf, uint8_t len, bool compressed,
+                                   char name[AP_MAX_NAME_SIZE+1], enum ap_var_type &type, float &value)
+{
+    uint8_t value_len;
+    uint8_t used;
+    const uint8_t *vbuf;
+
+    if (!compressed) {
+        if (len < AP_MAX_NAME_SIZE + 5) {
+            return 0;
+        }
+        memcpy(name, buf, AP_MAX_NAME_SIZE);
+        name[AP_MAX_NAME_SIZE] = 0;
+        type = (enum ap_var_type)buf[AP_MAX_NAME_SIZE];
+        value_len = 4;
+        vbuf = &buf[AP_MAX_NAME_SIZE+1];
+        used = AP_MAX_NAME_SIZE + 5;
+    } else {
+        if (len < 2) {
+            return 0;
+        }
+        uint8_t prefix_len = buf[0] >> 4;
+        uint8_t suffix_len = buf[1];
+        type = (enum ap_var_type)(buf[0] & 0x0F);
+        if (prefix_len > strlen(name) || prefix_len + suffix_len > AP_MAX_NAME_SIZE) {
+            return 0;
+        }
+        value_len = type == AP_PARAM_INT8 ? 1 : type == AP_PARAM_INT16 ? 2 : 4;
+        used = 2 + suffix_len + value_len;
+        if (used > len) {
+            return 0;
+        }
+        memcpy(&name[prefix_len], &buf[2], suffix_len);
+        name[prefix_len + suffix_len] = 0;
+        vbuf = &buf[2 + suffix_len];
+    }
+    if (type < AP_PARAM_INT8 || type > AP_PARAM_FLOAT) {
+        return 0;
+    }
+
+    uint32_t v = 0;
+    for (uint8_t i=0; i<value_len; i++) {
+        v |= ((uint32_t)vbuf[i]) << (8*i);
+    }
+    switch (type) {
+    case AP_PARAM_INT8:
+        value = (int8_t)v;
+        break;
+    case AP_PARAM_INT16:
+        value = (int16_t)v;
+        break;
+    case AP_PARAM_INT32:
+        value = (int32_t)v;
+        break;
+    default:
+        memcpy(&value, &v, sizeof(value));
+        break;
+    }
+    return used;
+}
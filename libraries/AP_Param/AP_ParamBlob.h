@@ -0,0 +1,153 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  packed serialisation of the whole parameter set for bulk transfer.
+
+  A blob is a sequence of numbered chunks, each holding whole entries,
+  so any chunk can be decoded on its own. An entry is either
+
+    uncompressed: name[16] (zero padded), type, value[4]
+    compressed:   (prefix_len<<4 | type), suffix_len, suffix, value[n]
+
+  where prefix_len is the number of leading characters shared with the
+  name of the previous entry in the same chunk. Values are
+  little-endian, int32 for integer types and IEEE float for floats,
+  and compressed entries only hold the bytes of the native size of the
+  type (1 for INT8, 2 for INT16).
+
+  The hash of a parameter set is the sum over all parameters of the
+  FNV-1a hash of the name, the type and the 4 byte value. It doesn't
+  depend on the order of the parameters, so a client can compute it
+  over the set it holds.
+
+  The values sent are a snapshot taken when the blob is prepared, so
+  retransmitted chunks are identical to the originals. The snapshot is
+  kept afterwards: a client that asks for a diff against the hash of
+  the last blob gets only the parameters that changed since then, and
+  a client whose hash matches the current set gets an empty diff.
+ */
+#pragma once
+
+#include "AP_Param.h"
+
+#define AP_PARAMBLOB_ENTRY_MAX  (AP_MAX_NAME_SIZE + 5)
+
+class AP_ParamBlob
+{
+public:
+    AP_ParamBlob();
+
+    /*
+      start preparing a blob of chunks of up to chunk_len bytes. If
+      base_hash matches the current set or the last blob the result
+      is a diff, otherwise it holds every parameter. Returns false if
+      there isn't enough memory, in which case the blob is left idle,
+      or if chunk_len is too small, in which case the blob is left
+      as it was
+     */
+    bool start(uint32_t base_hash, bool compressed, uint8_t chunk_len);
+
+    /*
+      take the snapshot of up to max_params parameters. Returns true
+      once the blob is ready to be sent
+     */
+    bool prepare(uint16_t max_params);
+
+    bool idle(void) const { return _state == STATE_IDLE; }
+    bool ready(void) const { return _state == STATE_READY; }
+    bool compressed(void) const { return _compressed; }
+    bool is_diff(void) const { return _diff; }
+
+    // hash of the whole parameter set as of the snapshot
+    uint32_t get_hash(void) const { return _hash; }
+
+    // number of parameters in the snapshot
+    uint16_t get_count(void) const { return _count; }
+
+    /*
+      encode chunk seq into buf, which must hold chunk_len bytes.
+      Chunks must first be asked for in order, after which any of
+      them can be asked for again. last is set for the final
+      chunk. Returns the number of bytes in the chunk, or -1 if the
+      chunk doesn't exist or the parameter tree changed shape since
+      the snapshot was taken
+     */
+    int16_t get_chunk(uint16_t seq, uint8_t *buf, bool &last);
+
+    // number of chunks, or 0 if the last chunk hasn't been reached yet
+    uint16_t get_num_chunks(void) const { return _num_chunks; }
+
+    /*
+      encode one entry into a chunk. prev_name is the name of the
+      previous entry of the chunk, or empty for the first entry.
+      value is an int32 for integer types and the bits of the float
+      for AP_PARAM_FLOAT. Returns the
+      number of bytes used, or 0 if the entry doesn't fit in buf_len
+     */
+    static uint8_t encode_entry(uint8_t *buf, uint8_t buf_len, bool compressed, const char *prev_name,
+                                const char *name, enum ap_var_type type, uint32_t value);
+
+    /*
+      decode one entry from a chunk. name must hold the previous name
+      of the chunk, or be empty for the first entry. Returns the
+      number of bytes used, or 0 if the entry is malformed
+     */
+    static uint8_t decode_entry(const uint8_t *buf, uint8_t len, bool compressed,
+                                char name[AP_MAX_NAME_SIZE+1], enum ap_var_type &type, float &value);
+
+private:
+    enum blob_state {
+        STATE_IDLE = 0,
+        STATE_PREPARING,
+        STATE_READY
+    };
+
+    static uint32_t entry_hash(const char *name, enum ap_var_type type, uint32_t value);
+    static uint32_t raw_value(const AP_Param *ap, enum ap_var_type type);
+    bool changed(uint16_t idx) const { return (_changed[idx/8] & (1U<<(idx%8))) != 0; }
+    bool allocate(uint16_t count, uint8_t chunk_len);
+
+    enum blob_state _state;
+    bool _compressed;
+    bool _diff;
+    bool _have_snapshot;
+    uint8_t _chunk_len;
+    uint32_t _base_hash;
+
+    // walk of the parameter tree while preparing
+    AP_Param *_ap;
+    AP_Param::ParamToken _token;
+    enum ap_var_type _type;
+    uint16_t _prepared;
+
+    // snapshot of the values, the parameters that changed since the
+    // last snapshot, and the hashes of the snapshot
+    uint32_t *_values;
+    uint8_t *_changed;
+    uint16_t _size;
+    uint16_t _count;
+    uint32_t _hash;
+    uint32_t _names_hash;
+    uint32_t _new_hash;
+    uint32_t _new_names_hash;
+
+    // parameter index at the start of each chunk found so far
+    uint16_t *_chunk_start;
+    uint16_t _max_chunks;
+    uint16_t _known_chunks;
+    uint16_t _num_chunks;
+};
@@ -0,0 +1,87 @@
+#include <AP_gbenchmark.h>
+
+#include <stdio.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+ * A parameter tree of a similar size to a vehicle: 16 objects of 32
+ * floats each, for 512 parameters.
+ */
+#define BENCH_GROUP_SIZE 32
+#define BENCH_NUM_GROUPS 16
+
+class BenchGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Float _p[BENCH_GROUP_SIZE];
+};
+
+#define BENCH_PARAM(i) AP_GROUPINFO("P" #i, i, BenchGroup, _p[i], 0)
+
+const AP_Param::GroupInfo BenchGroup::var_info[] = {
+    BENCH_PARAM(0),  BENCH_PARAM(1),  BENCH_PARAM(2),  BENCH_PARAM(3),
+    BENCH_PARAM(4),  BENCH_PARAM(5),  BENCH_PARAM(6),  BENCH_PARAM(7),
+    BENCH_PARAM(8),  BENCH_PARAM(9),  BENCH_PARAM(10), BENCH_PARAM(11),
+    BENCH_PARAM(12), BENCH_PARAM(13), BENCH_PARAM(14), BENCH_PARAM(15),
+    BENCH_PARAM(16), BENCH_PARAM(17), BENCH_PARAM(18), BENCH_PARAM(19),
+    BENCH_PARAM(20), BENCH_PARAM(21), BENCH_PARAM(22), BENCH_PARAM(23),
+    BENCH_PARAM(24), BENCH_PARAM(25), BENCH_PARAM(26), BENCH_PARAM(27),
+    BENCH_PARAM(28), BENCH_PARAM(29), BENCH_PARAM(30), BENCH_PARAM(31),
+    AP_GROUPEND
+};
+
+static BenchGroup groups[BENCH_NUM_GROUPS];
+
+#define BENCH_GROUP(i) { AP_PARAM_GROUP, "G" #i "_", i, &groups[i], { group_info : BenchGroup::var_info } }
+
+static const AP_Param::Info var_info[] = {
+    BENCH_GROUP(0),  BENCH_GROUP(1),  BENCH_GROUP(2),  BENCH_GROUP(3),
+    BENCH_GROUP(4),  BENCH_GROUP(5),  BENCH_GROUP(6),  BENCH_GROUP(7),
+    BENCH_GROUP(8),  BENCH_GROUP(9),  BENCH_GROUP(10), BENCH_GROUP(11),
+    BENCH_GROUP(12), BENCH_GROUP(13), BENCH_GROUP(14), BENCH_GROUP(15),
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+/*
+ * Lookup by name as done for PARAM_SET and PARAM_REQUEST_READ. The
+ * argument is the object holding the parameter, so without the name
+ * index the cost grows with it.
+ */
+static void BM_ParamFind(benchmark::State& state)
+{
+    char name[AP_MAX_NAME_SIZE+1];
+    snprintf(name, sizeof(name), "G%d_P%d", (int)state.range_x(), BENCH_GROUP_SIZE-1);
+    enum ap_var_type ptype;
+
+    while (state.KeepRunning()) {
+        AP_Param *vp = AP_Param::find(name, &ptype);
+        gbenchmark_escape(vp);
+    }
+}
+
+BENCHMARK(BM_ParamFind)->Arg(0)->Arg(BENCH_NUM_GROUPS/2)->Arg(BENCH_NUM_GROUPS-1);
+
+/*
+ * Lookup by index as done for PARAM_REQUEST_READ with a param_index
+ */
+static void BM_ParamFindByIndex(benchmark::State& state)
+{
+    const uint16_t idx = state.range_x();
+    enum ap_var_type ptype;
+    AP_Param::ParamToken token;
+
+    while (state.KeepRunning()) {
+        AP_Param *vp = AP_Param::find_by_index(idx, &ptype, &token);
+        gbenchmark_escape(vp);
+    }
+}
+
+BENCHMARK(BM_ParamFindByIndex)->Arg(0)->Arg(BENCH_NUM_GROUPS*BENCH_GROUP_SIZE/2)->Arg(BENCH_NUM_GROUPS*BENCH_GROUP_SIZE-1);
+
+BENCHMARK_MAIN()
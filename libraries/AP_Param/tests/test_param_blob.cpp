@@ -0,0 +1,147 @@
+#include <AP_gtest.h>
+
+#include <AP_Param/AP_ParamBlob.h>
+
+static uint32_t float_bits(float f)
+{
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    return v;
+}
+
+// encode one entry and decode it back, checking both lengths agree
+static void round_trip(bool compressed, const char *prev_name, const char *name,
+                       enum ap_var_type type, uint32_t raw, float expected)
+{
+    uint8_t buf[AP_PARAMBLOB_ENTRY_MAX];
+    uint8_t n = AP_ParamBlob::encode_entry(buf, sizeof(buf), compressed, prev_name, name, type, raw);
+    EXPECT_TRUE(n > 0);
+
+    char name2[AP_MAX_NAME_SIZE+1];
+    strncpy(name2, prev_name, sizeof(name2));
+    enum ap_var_type type2;
+    float value;
+    EXPECT_EQ(n, AP_ParamBlob::decode_entry(buf, n, compressed, name2, type2, value));
+    EXPECT_EQ(0, strcmp(name, name2));
+    EXPECT_EQ(type, type2);
+    EXPECT_FLOAT_EQ(expected, value);
+}
+
+TEST(ParamBlobTest, FullEncoding)
+{
+    round_trip(false, "", "RLL2SRV_P", AP_PARAM_FLOAT, float_bits(0.45f), 0.45f);
+    round_trip(false, "", "SYSID_THISMAV", AP_PARAM_INT16, (uint32_t)(int32_t)-300, -300);
+    round_trip(false, "", "LOG_BITMASK", AP_PARAM_INT32, 0x7ffffff0, 0x7ffffff0);
+    round_trip(false, "", "ARMING_CHECK", AP_PARAM_INT8, (uint32_t)(int32_t)-5, -5);
+    // a name using every character, with no terminator on the wire
+    round_trip(false, "", "ABCDEFGHIJKLMNOP", AP_PARAM_FLOAT, float_bits(-1.5f), -1.5f);
+
+    uint8_t buf[AP_PARAMBLOB_ENTRY_MAX];
+    EXPECT_EQ(AP_MAX_NAME_SIZE + 5,
+              AP_ParamBlob::encode_entry(buf, sizeof(buf), false, "", "A", AP_PARAM_INT8, 1));
+}
+
+TEST(ParamBlobTest, DiffEncoding)
+{
+    round_trip(true, "", "RLL2SRV_P", AP_PARAM_FLOAT, float_bits(0.45f), 0.45f);
+    round_trip(true, "RLL2SRV_P", "RLL2SRV_I", AP_PARAM_FLOAT, float_bits(0.1f), 0.1f);
+    round_trip(true, "RLL2SRV_I", "RLL2SRV_IMAX", AP_PARAM_INT16, 3000, 3000);
+    round_trip(true, "", "ARMING_CHECK", AP_PARAM_INT8, (uint32_t)(int32_t)-5, -5);
+    round_trip(true, "ABCDEFGHIJKLMNOP", "ABCDEFGHIJKLMNOQ", AP_PARAM_INT32, 7, 7);
+
+    // shared prefixes are not sent again, and values take their native size
+    uint8_t buf[AP_PARAMBLOB_ENTRY_MAX];
+    EXPECT_EQ(2 + 1 + 4,
+              AP_ParamBlob::encode_entry(buf, sizeof(buf), true, "RLL2SRV_P", "RLL2SRV_I",
+                                         AP_PARAM_FLOAT, 0));
+    EXPECT_EQ(8, buf[0] >> 4);
+    EXPECT_EQ(2 + 3 + 1,
+              AP_ParamBlob::encode_entry(buf, sizeof(buf), true, "", "FOO", AP_PARAM_INT8, 0));
+    EXPECT_EQ(2 + 3 + 2,
+              AP_ParamBlob::encode_entry(buf, sizeof(buf), true, "", "FOO", AP_PARAM_INT16, 0));
+
+    // a chunk of entries decodes in sequence
+    const char *names[] = { "RLL2SRV_P", "RLL2SRV_I", "RLL2SRV_D", "RLL_LIM" };
+    uint8_t chunk[64];
+    uint8_t len = 0;
+    const char *prev = "";
+    for (uint8_t i = 0; i < 4; i++) {
+        uint8_t n = AP_ParamBlob::encode_entry(&chunk[len], sizeof(chunk) - len, true, prev,
+                                               names[i], AP_PARAM_INT16, i);
+        EXPECT_TRUE(n > 0);
+        len += n;
+        prev = names[i];
+    }
+    char name[AP_MAX_NAME_SIZE+1] = "";
+    uint8_t ofs = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        enum ap_var_type type;
+        float value;
+        uint8_t n = AP_ParamBlob::decode_entry(&chunk[ofs], len - ofs, true, name, type, value);
+        EXPECT_TRUE(n > 0);
+        EXPECT_EQ(0, strcmp(names[i], name));
+        EXPECT_FLOAT_EQ(i, value);
+        ofs += n;
+    }
+    EXPECT_EQ(len, ofs);
+}
+
+TEST(ParamBlobTest, Truncation)
+{
+    uint8_t buf[AP_PARAMBLOB_ENTRY_MAX];
+    char name[AP_MAX_NAME_SIZE+1];
+    enum ap_var_type type;
+    float value;
+
+    // entries that don't fit are not encoded
+    EXPECT_EQ(0, AP_ParamBlob::encode_entry(buf, AP_MAX_NAME_SIZE + 4, false, "", "A",
+                                            AP_PARAM_FLOAT, 0));
+    EXPECT_EQ(0, AP_ParamBlob::encode_entry(buf, 2 + 3 + 3, true, "", "FOO",
+                                            AP_PARAM_FLOAT, 0));
+    EXPECT_EQ(2 + 3 + 4, AP_ParamBlob::encode_entry(buf, 2 + 3 + 4, true, "", "FOO",
+                                                    AP_PARAM_FLOAT, 0));
+
+    // and entries cut short are not decoded
+    uint8_t n = AP_ParamBlob::encode_entry(buf, sizeof(buf), false, "", "FOO", AP_PARAM_FLOAT, 0);
+    name[0] = 0;
+    EXPECT_EQ(0, AP_ParamBlob::decode_entry(buf, n - 1, false, name, type, value));
+    n = AP_ParamBlob::encode_entry(buf, sizeof(buf), true, "", "FOO", AP_PARAM_FLOAT, 0);
+    EXPECT_EQ(0, AP_ParamBlob::decode_entry(buf, n - 1, true, name, type, value));
+    EXPECT_EQ(0, AP_ParamBlob::decode_entry(buf, 1, true, name, type, value));
+    EXPECT_EQ(0, AP_ParamBlob::decode_entry(buf, 0, true, name, type, value));
+}
+
+TEST(ParamBlobTest, Bounds)
+{
+    uint8_t buf[AP_PARAMBLOB_ENTRY_MAX];
+    char name[AP_MAX_NAME_SIZE+1];
+    enum ap_var_type type;
+    float value;
+
+    // a prefix longer than the previous name
+    buf[0] = (4 << 4) | AP_PARAM_INT8;
+    buf[1] = 1;
+    buf[2] = 'X';
+    buf[3] = 0;
+    strcpy(name, "ABC");
+    EXPECT_EQ(0, AP_ParamBlob::decode_entry(buf, 4, true, name, type, value));
+
+    // a name longer than AP_MAX_NAME_SIZE
+    memset(buf, 'X', sizeof(buf));
+    buf[0] = (3 << 4) | AP_PARAM_INT8;
+    buf[1] = AP_MAX_NAME_SIZE - 2;
+    EXPECT_EQ(0, AP_ParamBlob::decode_entry(buf, sizeof(buf), true, name, type, value));
+    EXPECT_EQ(0, strcmp("ABC", name));
+
+    // types that are not scalar parameters
+    buf[0] = AP_PARAM_NONE;
+    buf[1] = 1;
+    EXPECT_EQ(0, AP_ParamBlob::decode_entry(buf, sizeof(buf), true, name, type, value));
+    buf[0] = AP_PARAM_VECTOR3F;
+    EXPECT_EQ(0, AP_ParamBlob::decode_entry(buf, sizeof(buf), true, name, type, value));
+    memset(buf, 'X', sizeof(buf));
+    buf[AP_MAX_NAME_SIZE] = AP_PARAM_GROUP;
+    EXPECT_EQ(0, AP_ParamBlob::decode_entry(buf, sizeof(buf), false, name, type, value));
+}
+
+AP_GTEST_MAIN()
@@ -61,6 +61,8 @@ const AP_Param::GroupInfo AP_Rally::var_info[] = {
 AP_Rally::AP_Rally(AP_AHRS &ahrs) 
     : _ahrs(ahrs)
     , _last_change_time_ms(0xFFFFFFFF)
+    , _index_valid(false)
+    , _index_total(0)
 {
     AP_Param::setup_object_defaults(this, var_info);
 }
@@ -95,6 +97,7 @@ bool AP_Rally::set_rally_point_with_index(uint8_t i, const RallyLocation &rallyL
     _storage.write_block(i * sizeof(RallyLocation), &rallyLoc, sizeof(RallyLocation));
 
     _last_change_time_ms = AP_HAL::millis();
+    _index_valid = false;
 
     return true;
 }
@@ -118,23 +121,56 @@ Location AP_Rally::rally_location_to_location(const RallyLocation &rally_loc) co
     return ret;
 }
 
+// rebuild the index of rally points if they have changed
+void AP_Rally::update_index(void)
+{
+    uint8_t total = (uint8_t)_rally_point_total_count;
+    if (_index_valid && _index_total == total) {
+        return;
+    }
+    // init() empties the index even when it fails, so the linear
+    // search must be used until a rebuild succeeds
+    _index_valid = false;
+    if (!_index.init(total)) {
+        return;
+    }
+    for (uint8_t i = 0; i < total; i++) {
+        RallyLocation rally_point;
+        if (get_rally_point_with_index(i, rally_point)) {
+            _index.add(rally_location_to_location(rally_point), i);
+        }
+    }
+    _index.finish();
+    _index_valid = true;
+    _index_total = total;
+}
+
 // returns true if a valid rally point is found, otherwise returns false to indicate home position should be used
-bool AP_Rally::find_nearest_rally_point(const Location &current_loc, RallyLocation &return_loc) const
+bool AP_Rally::find_nearest_rally_point(const Location &current_loc, RallyLocation &return_loc)
 {
     float min_dis = -1;
     const struct Location &home_loc = _ahrs.get_home();
 
-    for (uint8_t i = 0; i < (uint8_t) _rally_point_total_count; i++) {
-        RallyLocation next_rally;
-        if (!get_rally_point_with_index(i, next_rally)) {
-            continue;
+    update_index();
+    if (_index_valid) {
+        int32_t nearest = _index.nearest(current_loc, min_dis);
+        if (nearest < 0 || !get_rally_point_with_index(nearest, return_loc)) {
+            min_dis = -1;
         }
-        Location rally_loc = rally_location_to_location(next_rally);
-        float dis = get_distance(current_loc, rally_loc);
-
-        if (dis < min_dis || min_dis < 0) {
-            min_dis = dis;
-            return_loc = next_rally;
+    } else {
+        // no memory for the index, check every rally point
+        for (uint8_t i = 0; i < (uint8_t) _rally_point_total_count; i++) {
+            RallyLocation next_rally;
+            if (!get_rally_point_with_index(i, next_rally)) {
+                continue;
+            }
+            Location rally_loc = rally_location_to_location(next_rally);
+            float dis = get_distance(current_loc, rally_loc);
+
+            if (dis < min_dis || min_dis < 0) {
+                min_dis = dis;
+                return_loc = next_rally;
+            }
         }
     }
 
@@ -153,7 +189,7 @@ bool AP_Rally::find_nearest_rally_point(const Location &current_loc, RallyLocati
 }
 
 // return best RTL location from current position
-Location AP_Rally::calc_best_rally_or_home_location(const Location &current_loc, float rtl_home_alt) const
+Location AP_Rally::calc_best_rally_or_home_location(const Location &current_loc, float rtl_home_alt)
 {
     RallyLocation ral_loc = {};
     Location return_loc = {};
@@ -20,6 +20,7 @@
 #include <AP_Common/AP_Common.h>
 #include <AP_Param/AP_Param.h>
 #include <AP_AHRS/AP_AHRS.h>
+#include <AP_Math/AP_Math.h>
 #include <StorageManager/StorageManager.h>
 
 #define AP_RALLY_WP_SIZE        15  // eeprom size of rally points
@@ -53,8 +54,8 @@ public:
     Location rally_location_to_location(const RallyLocation &ret) const;
 
     // logic handling
-    Location calc_best_rally_or_home_location(const Location &current_loc, float rtl_home_alt) const;
-    bool find_nearest_rally_point(const Location &myloc, RallyLocation &ret) const;
+    Location calc_best_rally_or_home_location(const Location &current_loc, float rtl_home_alt);
+    bool find_nearest_rally_point(const Location &myloc, RallyLocation &ret);
 
     // last time rally points changed
     uint32_t last_change_time_ms(void) const { return _last_change_time_ms; }
@@ -65,6 +66,9 @@ public:
 private:
     static StorageAccess _storage;
 
+    // rebuild the index of rally points if they have changed
+    void update_index(void);
+
     // internal variables
     const AP_AHRS& _ahrs; // used only for home position
 
@@ -74,6 +78,12 @@ private:
     AP_Int8  _rally_incl_home;
 
     uint32_t _last_change_time_ms;
+
+    // index of the valid rally points, so the nearest one is found
+    // without reading them all from storage
+    PointIndex _index;
+    bool _index_valid;
+    uint8_t _index_total;
 };
 
 
@@ -55,6 +55,16 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     AP_GROUPINFO("LOOP_RATE",  1, AP_Scheduler, _loop_rate_hz, SCHEDULER_DEFAULT_LOOP_RATE),
 #endif
 
+#if AP_SCHEDULER_HISTOGRAMS
+    // @Param: TASK_HIST
+    // @DisplayName: Task run time histograms
+    // @Description: When enabled the scheduler keeps a histogram of the run time of each task, as well as those of the main loop period, the wait for the IMU and the time left over in each loop that it always keeps. The percentiles of the histograms are logged in PMH messages with the performance monitoring log, and sent to the GCS as LOOP_TIMING messages. Each task histogram needs about 300 bytes of memory. This only takes effect on restart
+    // @Values: 0:Disabled,1:Enabled
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("TASK_HIST",  2, AP_Scheduler, _task_histograms, 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -66,6 +76,10 @@ AP_Scheduler::AP_Scheduler(void)
 #endif
     AP_Param::setup_object_defaults(this, var_info);
 
+#if AP_SCHEDULER_HISTOGRAMS
+    _task_hist = nullptr;
+#endif
+
     // only allow 50 to 400 Hz
     if (_loop_rate_hz < 50) {
         _loop_rate_hz.set(50);
@@ -82,6 +96,12 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks)
     _last_run = new uint16_t[_num_tasks];
     memset(_last_run, 0, sizeof(_last_run[0]) * _num_tasks);
     _tick_counter = 0;
+#if AP_SCHEDULER_HISTOGRAMS
+    _task_hist = nullptr;
+    if (_task_histograms != 0) {
+        _task_hist = new AP_TimeHistogram[_num_tasks];
+    }
+#endif
 }
 
 // one tick has passed
@@ -135,6 +155,11 @@ void AP_Scheduler::run(uint16_t time_available)
                 // work out how long the event actually took
                 now = AP_HAL::micros();
                 uint32_t time_taken = now - _task_time_started;
+#if AP_SCHEDULER_HISTOGRAMS
+                if (_task_hist != nullptr) {
+                    _task_hist[i].add(time_taken);
+                }
+#endif
 
                 if (time_taken > _task_time_allowed) {
                     // the event overran!
@@ -147,6 +172,9 @@ void AP_Scheduler::run(uint16_t time_available)
                     }
                 }
                 if (time_taken >= time_available) {
+#if AP_SCHEDULER_HISTOGRAMS
+                    _spare_hist.add(0);
+#endif
                     goto update_spare_ticks;
                 }
                 time_available -= time_taken;
@@ -156,6 +184,9 @@ void AP_Scheduler::run(uint16_t time_available)
 
     // update number of spare microseconds
     _spare_micros += time_available;
+#if AP_SCHEDULER_HISTOGRAMS
+    _spare_hist.add(time_available);
+#endif
 
 update_spare_ticks:
     _spare_ticks++;
@@ -188,3 +219,59 @@ float AP_Scheduler::load_average(uint32_t tick_time_usec) const
     uint32_t used_time = tick_time_usec - (_spare_micros/_spare_ticks);
     return used_time / (float)tick_time_usec;
 }
+
+// number of timing histograms, including the task histograms if they are enabled
+uint8_t AP_Scheduler::num_histograms(void) const
+{
+#if AP_SCHEDULER_HISTOGRAMS
+    return HISTOGRAM_FIRST_TASK + (_task_hist != nullptr ? _num_tasks : 0);
+#else
+    return 0;
+#endif
+}
+
+const AP_TimeHistogram *AP_Scheduler::get_histogram(uint8_t id) const
+{
+#if AP_SCHEDULER_HISTOGRAMS
+    switch (id) {
+    case HISTOGRAM_LOOP_PERIOD:
+        return &_loop_period_hist;
+    case HISTOGRAM_LOOP_WAIT:
+        return &_loop_wait_hist;
+    case HISTOGRAM_SPARE:
+        return &_spare_hist;
+    }
+    if (id < num_histograms()) {
+        return &_task_hist[id - HISTOGRAM_FIRST_TASK];
+    }
+#endif
+    return nullptr;
+}
+
+const char *AP_Scheduler::histogram_name(uint8_t id) const
+{
+    switch (id) {
+    case HISTOGRAM_LOOP_PERIOD:
+        return "loop_period";
+    case HISTOGRAM_LOOP_WAIT:
+        return "loop_wait";
+    case HISTOGRAM_SPARE:
+        return "spare";
+    }
+    if (id < num_histograms()) {
+        return _tasks[id - HISTOGRAM_FIRST_TASK].name;
+    }
+    return "";
+}
+
+void AP_Scheduler::reset_histograms(void)
+{
+#if AP_SCHEDULER_HISTOGRAMS
+    _loop_period_hist.reset();
+    _loop_wait_hist.reset();
+    _spare_hist.reset();
+    for (uint8_t i=0; _task_hist != nullptr && i<_num_tasks; i++) {
+        _task_hist[i].reset();
+    }
+#endif
+}
@@ -47,6 +47,10 @@
 
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Vehicle/AP_Vehicle.h>
+#include "AP_TimeHistogram.h"
+
+// keep histograms of loop and task timing on boards with the memory for them
+#define AP_SCHEDULER_HISTOGRAMS (HAL_CPU_CLASS >= HAL_CPU_CLASS_150)
 
 class AP_Scheduler
 {
@@ -90,6 +94,29 @@ public:
         return _loop_rate_hz;
     }
     
+    // record the period of a main loop and the time it waited for the INS
+    void update_loop_timing(uint32_t period_us, uint32_t wait_us) {
+#if AP_SCHEDULER_HISTOGRAMS
+        _loop_period_hist.add(period_us);
+        _loop_wait_hist.add(wait_us);
+#endif
+    }
+
+    // timing histograms: the loop period, the wait for the INS, the
+    // time left over after run(), then the run time of each task
+    enum {
+        HISTOGRAM_LOOP_PERIOD = 0,
+        HISTOGRAM_LOOP_WAIT,
+        HISTOGRAM_SPARE,
+        HISTOGRAM_FIRST_TASK
+    };
+    uint8_t num_histograms(void) const;
+    const AP_TimeHistogram *get_histogram(uint8_t id) const;
+    const char *histogram_name(uint8_t id) const;
+
+    // start the histograms again, for the next reporting period
+    void reset_histograms(void);
+
     static const struct AP_Param::GroupInfo var_info[];
 
     // current running task, or -1 if none. Used to debug stuck tasks
@@ -126,4 +153,16 @@ private:
 
     // number of ticks that _spare_micros is counted over
     uint8_t _spare_ticks;
+
+#if AP_SCHEDULER_HISTOGRAMS
+    // enable a run time histogram for each task
+    AP_Int8 _task_histograms;
+
+    AP_TimeHistogram _loop_period_hist;
+    AP_TimeHistogram _loop_wait_hist;
+    AP_TimeHistogram _spare_hist;
+
+    // one for each task, allocated by init() when enabled
+    AP_TimeHistogram *_task_hist;
+#endif
 };
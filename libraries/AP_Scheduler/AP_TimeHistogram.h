@@ -0,0 +1,122 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+  a histogram of times in microseconds with fixed buckets, for finding
+  percentiles of loop and task timing.
+
+  Times below 8us have a bucket each. Above that each power of two is
+  split into 8 buckets, so a bucket is at most 12.5% wide, up to about
+  one second. Adding a time is a few instructions with no allocation
+  and no locks. There is a single writer, the main loop, and readers in
+  the main loop, so nothing is shared between threads. Percentiles are
+  worked out from the counts when they are asked for
+ */
+class AP_TimeHistogram
+{
+public:
+    static const uint8_t sub_bits = 3;
+    static const uint8_t max_exponent = 20;
+    static const uint16_t num_buckets = (max_exponent - sub_bits + 1) << sub_bits;
+
+    AP_TimeHistogram() { reset(); }
+
+    void reset(void)
+    {
+        memset(_counts, 0, sizeof(_counts));
+        _count = 0;
+        _max_us = 0;
+    }
+
+    void add(uint32_t time_us)
+    {
+        uint16_t &c = _counts[bucket(time_us)];
+        if (c != UINT16_MAX) {
+            c++;
+        }
+        _count++;
+        if (time_us > _max_us) {
+            _max_us = time_us;
+        }
+    }
+
+    uint32_t count(void) const { return _count; }
+    uint32_t max_us(void) const { return _max_us; }
+
+    /*
+      the time that a fraction p of the times are at or below, as the
+      top of the bucket it is in, but no more than the longest time. 0
+      if there are no times
+     */
+    uint32_t percentile(float p) const
+    {
+        if (_count == 0) {
+            return 0;
+        }
+        uint32_t total = 0;
+        for (uint16_t b=0; b<num_buckets; b++) {
+            total += _counts[b];
+        }
+        uint32_t target = (uint32_t)(p * total + 0.999f);
+        if (target < 1) {
+            target = 1;
+        }
+        uint32_t sum = 0;
+        for (uint16_t b=0; b<num_buckets; b++) {
+            sum += _counts[b];
+            if (sum >= target) {
+                const uint32_t top = bucket_top(b);
+                return top < _max_us ? top : _max_us;
+            }
+        }
+        return _max_us;
+    }
+
+    // the bucket a time goes in
+    static uint16_t bucket(uint32_t time_us)
+    {
+        if (time_us < (1U<<sub_bits)) {
+            return time_us;
+        }
+        if (time_us >= (1UL<<max_exponent)) {
+            return num_buckets - 1;
+        }
+        // position of the top bit, at least sub_bits
+        const uint8_t e = sizeof(unsigned long)*8 - 1 - __builtin_clzl(time_us);
+        const uint8_t shift = e - sub_bits;
+        return ((shift + 1) << sub_bits) + (time_us >> shift) - (1U<<sub_bits);
+    }
+
+    // the longest time that goes in bucket b
+    static uint32_t bucket_top(uint16_t b)
+    {
+        if (b < (1U<<sub_bits)) {
+            return b;
+        }
+        const uint8_t shift = (b >> sub_bits) - 1;
+        const uint32_t mantissa = (1U<<sub_bits) + (b & ((1U<<sub_bits)-1));
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    uint16_t _counts[num_buckets];
+    uint32_t _count;
+    uint32_t _max_us;
+};
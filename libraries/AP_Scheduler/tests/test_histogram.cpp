@@ -0,0 +1,46 @@
+#include <AP_gtest.h>
+
+#include <AP_Scheduler/AP_TimeHistogram.h>
+
+TEST(AP_TimeHistogramTest, Buckets)
+{
+    // every time falls in a bucket whose top is at or above it, and
+    // below the top of the bucket before
+    uint16_t last = 0;
+    for (uint32_t t = 0; t < (1UL<<AP_TimeHistogram::max_exponent); t++) {
+        const uint16_t b = AP_TimeHistogram::bucket(t);
+        EXPECT_TRUE(b == last || b == last + 1);
+        EXPECT_TRUE(AP_TimeHistogram::bucket_top(b) >= t);
+        if (b > 0) {
+            EXPECT_TRUE(AP_TimeHistogram::bucket_top(b - 1) < t);
+        }
+        last = b;
+    }
+    EXPECT_EQ(AP_TimeHistogram::num_buckets - 1, last);
+    EXPECT_EQ(AP_TimeHistogram::num_buckets - 1, AP_TimeHistogram::bucket(UINT32_MAX));
+}
+
+TEST(AP_TimeHistogramTest, Percentiles)
+{
+    AP_TimeHistogram hist;
+    EXPECT_EQ(0U, hist.percentile(0.5f));
+
+    // a 2500us loop with one slow loop in a thousand
+    for (uint16_t i = 0; i < 999; i++) {
+        hist.add(2500);
+    }
+    hist.add(9000);
+    EXPECT_EQ(1000U, hist.count());
+    EXPECT_EQ(9000U, hist.max_us());
+
+    // within the 12.5% width of a bucket
+    EXPECT_TRUE(hist.percentile(0.5f) >= 2500 && hist.percentile(0.5f) < 2500 * 1.125f);
+    EXPECT_TRUE(hist.percentile(0.99f) >= 2500 && hist.percentile(0.99f) < 2500 * 1.125f);
+    EXPECT_EQ(9000U, hist.percentile(0.9999f));
+
+    hist.reset();
+    EXPECT_EQ(0U, hist.count());
+    EXPECT_EQ(0U, hist.max_us());
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,270 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Spectrum.h"
+
+extern const AP_HAL::HAL& hal;
+
+// butterflies done between checks of the time budget
+#define SPECTRUM_BUTTERFLY_CHUNK    64
+
+// raw IMU samples copied per read of the INS rings
+#define SPECTRUM_IMU_BATCH          32
+
+// table of user settable parameters
+const AP_Param::GroupInfo AP_Spectrum::var_info[] = {
+    // @Param: ENABLE
+    // @DisplayName: Spectrum analyser enable
+    // @Description: Enable the on-board vibration spectrum analyser. IMU channels analyse the full sensor rate when INS_FAST_SAMPLE is set for the primary IMU. Takes effect after a reboot
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("ENABLE", 0, AP_Spectrum, _enable, 0),
+
+    // @Param: BUDGET
+    // @DisplayName: Spectrum analyser time budget
+    // @Description: Maximum time spent on the spectrum analysis per scheduler call
+    // @Units: microseconds
+    // @Range: 50 1000
+    // @Increment: 10
+    // @User: Advanced
+    AP_GROUPINFO("BUDGET", 1, AP_Spectrum, _budget_us, 200),
+
+    // @Param: CHAN
+    // @DisplayName: Spectrum analyser channels
+    // @Description: Bitmask of channels to analyse. Bits 0 to 5 are the gyro X, Y, Z and accel X, Y, Z axes of the primary IMU, the higher bits are external channels such as strain gauges. Takes effect after a reboot
+    // @Bitmask: 0:GyroX,1:GyroY,2:GyroZ,3:AccelX,4:AccelY,5:AccelZ,6:Ext1,7:Ext2,8:Ext3,9:Ext4,10:Ext5,11:Ext6,12:Ext7,13:Ext8,14:Ext9,15:Ext10,16:Ext11,17:Ext12
+    // @User: Advanced
+    AP_GROUPINFO("CHAN", 2, AP_Spectrum, _channel_mask, 0x3FFFF),
+
+    AP_GROUPEND
+};
+
+AP_Spectrum::AP_Spectrum(AP_InertialSensor &ins) :
+    _ins(ins),
+    _fft(nullptr),
+    _current(-1),
+    _current_us(0),
+    _current_rate_hz(0),
+    _next(0),
+    _last_channel(0),
+    _gyro_cursor(0),
+    _accel_cursor(0),
+    _gyro_instance(0),
+    _accel_instance(0)
+{
+    AP_Param::setup_object_defaults(this, var_info);
+    memset(_channels, 0, sizeof(_channels));
+    memset(_unsent, 0, sizeof(_unsent));
+}
+
+/*
+  allocate the frame buffers and the transform. Nothing is allocated
+  when disabled
+ */
+void AP_Spectrum::init(void)
+{
+    if (_enable == 0 || _fft != nullptr) {
+        return;
+    }
+
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < AP_SPECTRUM_MAX_CHANNELS; i++) {
+        if (_channel_mask & (1UL<<i)) {
+            n++;
+        }
+    }
+    if (n == 0) {
+        return;
+    }
+
+    float *arena = new float[n * AP_SPECTRUM_FFT_SIZE];
+    if (arena == nullptr) {
+        return;
+    }
+    _fft = new IncrementalFFT<AP_SPECTRUM_FFT_SIZE>();
+    if (_fft == nullptr) {
+        delete[] arena;
+        return;
+    }
+
+    for (uint8_t i = 0; i < AP_SPECTRUM_MAX_CHANNELS; i++) {
+        if (_channel_mask & (1UL<<i)) {
+            _channels[i].frame = arena;
+            arena += AP_SPECTRUM_FFT_SIZE;
+        }
+    }
+
+    _gyro_instance = _ins.get_primary_gyro();
+    _accel_instance = _ins.get_primary_accel();
+}
+
+void AP_Spectrum::push_sample(uint8_t ext_channel, float value, uint64_t sample_us)
+{
+    if (ext_channel >= AP_SPECTRUM_EXT_CHANNELS) {
+        return;
+    }
+    _add_sample(AP_SPECTRUM_IMU_CHANNELS + ext_channel, value, sample_us);
+}
+
+/*
+  append a sample to the frame of a channel. Samples arriving while a
+  full frame waits for the transform are dropped, so a frame is always
+  a contiguous run of samples
+ */
+void AP_Spectrum::_add_sample(uint8_t channel, float value, uint64_t sample_us)
+{
+    struct channel_state &c = _channels[channel];
+    if (c.frame == nullptr || c.state != FRAME_FILLING) {
+        return;
+    }
+    if (c.fill == 0) {
+        c.first_us = sample_us;
+    }
+    c.frame[c.fill++] = value;
+    c.last_us = sample_us;
+    if (c.fill == AP_SPECTRUM_FFT_SIZE) {
+        c.state = FRAME_READY;
+    }
+}
+
+/*
+  copy new raw samples of the primary IMU into the frames
+ */
+void AP_Spectrum::_collect_imu(void)
+{
+    AP_InertialSensor_SampleRing::sample samples[SPECTRUM_IMU_BATCH];
+    uint16_t n;
+
+    while ((n = _ins.get_raw_gyro_batch(_gyro_instance, _gyro_cursor, samples, SPECTRUM_IMU_BATCH)) > 0) {
+        for (uint16_t i = 0; i < n; i++) {
+            _add_sample(0, samples[i].v.x, samples[i].sample_us);
+            _add_sample(1, samples[i].v.y, samples[i].sample_us);
+            _add_sample(2, samples[i].v.z, samples[i].sample_us);
+        }
+    }
+    while ((n = _ins.get_raw_accel_batch(_accel_instance, _accel_cursor, samples, SPECTRUM_IMU_BATCH)) > 0) {
+        for (uint16_t i = 0; i < n; i++) {
+            _add_sample(3, samples[i].v.x, samples[i].sample_us);
+            _add_sample(4, samples[i].v.y, samples[i].sample_us);
+            _add_sample(5, samples[i].v.z, samples[i].sample_us);
+        }
+    }
+}
+
+/*
+  start the transform of the next full frame, round robin over the
+  channels. The frame is released for refilling as soon as it has been
+  loaded into the transform
+ */
+bool AP_Spectrum::_start_next(void)
+{
+    for (uint8_t i = 0; i < AP_SPECTRUM_MAX_CHANNELS; i++) {
+        uint8_t ch = (_next + i) % AP_SPECTRUM_MAX_CHANNELS;
+        struct channel_state &c = _channels[ch];
+        if (c.frame == nullptr || c.state != FRAME_READY) {
+            continue;
+        }
+        _fft->load(c.frame);
+        _current = ch;
+        _current_us = c.last_us;
+        _current_rate_hz = 0;
+        if (c.last_us > c.first_us) {
+            _current_rate_hz = (AP_SPECTRUM_FFT_SIZE - 1) * 1.0e6f / (c.last_us - c.first_us);
+        }
+        c.fill = 0;
+        c.state = FRAME_FILLING;
+        _next = (ch + 1) % AP_SPECTRUM_MAX_CHANNELS;
+        return true;
+    }
+    return false;
+}
+
+/*
+  store the peaks of the completed transform
+ */
+void AP_Spectrum::_finish(void)
+{
+    struct channel_state &c = _channels[_current];
+    float bins[AP_SPECTRUM_NUM_PEAKS];
+    float power[AP_SPECTRUM_NUM_PEAKS];
+
+    c.peaks.count = _fft->find_peaks(bins, power, AP_SPECTRUM_NUM_PEAKS);
+    c.peaks.time_us = _current_us;
+    c.peaks.sample_rate_hz = _current_rate_hz;
+    for (uint8_t i = 0; i < AP_SPECTRUM_NUM_PEAKS; i++) {
+        if (i < c.peaks.count) {
+            c.peaks.freq_hz[i] = bins[i] * _current_rate_hz / AP_SPECTRUM_FFT_SIZE;
+            // the Hann window has a coherent gain of 0.5
+            c.peaks.amplitude[i] = 4.0f * sqrtf(power[i]) / AP_SPECTRUM_FFT_SIZE;
+        } else {
+            c.peaks.freq_hz[i] = 0;
+            c.peaks.amplitude[i] = 0;
+        }
+    }
+    c.have_result = true;
+
+    for (uint8_t i = 0; i < MAVLINK_COMM_NUM_BUFFERS; i++) {
+        _unsent[i] |= 1UL << _current;
+    }
+    _last_channel = _current;
+    _current = -1;
+}
+
+bool AP_Spectrum::update(void)
+{
+    if (_fft == nullptr) {
+        return false;
+    }
+
+    uint32_t start_us = AP_HAL::micros();
+
+    _collect_imu();
+
+    if (_current < 0 && !_start_next()) {
+        return false;
+    }
+
+    while (!_fft->run(SPECTRUM_BUTTERFLY_CHUNK)) {
+        if (AP_HAL::micros() - start_us >= (uint32_t)_budget_us.get()) {
+            return false;
+        }
+    }
+
+    _finish();
+    return true;
+}
+
+void AP_Spectrum::send_peaks(mavlink_channel_t chan)
+{
+    if (chan >= MAVLINK_COMM_NUM_BUFFERS || _unsent[chan] == 0) {
+        return;
+    }
+    uint8_t ch = 0;
+    while ((_unsent[chan] & (1UL<<ch)) == 0) {
+        ch++;
+    }
+    _unsent[chan] &= ~(1UL<<ch);
+
+    const Peaks &p = _channels[ch].peaks;
+    mavlink_msg_vibration_peaks_send(
+        chan,
+        p.time_us,
+        p.sample_rate_hz,
+        p.freq_hz,
+        p.amplitude,
+        ch,
+        p.count);
+}
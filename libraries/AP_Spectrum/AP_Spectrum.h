@@ -0,0 +1,137 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  on-board vibration spectrum analyser.
+
+  Frames of AP_SPECTRUM_FFT_SIZE samples are collected for each
+  channel: the gyro and accel axes of the primary IMU, taken from the
+  raw sample rings of the INS (which are deep enough for the full
+  sensor rate when INS_FAST_SAMPLE is set for that IMU), and any number of external channels such as wing strain gauges
+  fed with push_sample(). Completed frames are transformed one at a
+  time in the background, a bounded number of microseconds per call to
+  update(), and the dominant peaks of each channel are kept for
+  logging and telemetry.
+
+  All buffers are allocated once in init(), and only when the analyser
+  is enabled.
+ */
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Param/AP_Param.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/fft.h>
+#include <AP_InertialSensor/AP_InertialSensor.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+
+#define AP_SPECTRUM_FFT_SIZE        256
+#define AP_SPECTRUM_NUM_PEAKS       3
+#define AP_SPECTRUM_IMU_CHANNELS    6   // primary gyro XYZ then primary accel XYZ
+#define AP_SPECTRUM_EXT_CHANNELS    12
+#define AP_SPECTRUM_MAX_CHANNELS    (AP_SPECTRUM_IMU_CHANNELS + AP_SPECTRUM_EXT_CHANNELS)
+
+class AP_Spectrum
+{
+public:
+    AP_Spectrum(AP_InertialSensor &ins);
+
+    // result of the last transform of a channel
+    struct Peaks {
+        uint64_t time_us;       // time of the last sample of the frame
+        float sample_rate_hz;   // measured over the frame
+        uint8_t count;          // number of valid peaks
+        float freq_hz[AP_SPECTRUM_NUM_PEAKS];
+        float amplitude[AP_SPECTRUM_NUM_PEAKS]; // in the units of the channel
+    };
+
+    static const struct AP_Param::GroupInfo var_info[];
+
+    // allocate buffers if enabled. Must be called before update()
+    void init(void);
+
+    bool enabled(void) const { return _fft != nullptr; }
+
+    // add a sample of an external channel, 0 <= channel < AP_SPECTRUM_EXT_CHANNELS
+    void push_sample(uint8_t ext_channel, float value, uint64_t sample_us);
+
+    /*
+      collect IMU samples and advance the analysis for at most
+      SPEC_BUDGET microseconds. Returns true if a channel got a new
+      result, which is then given by get_last_channel()
+     */
+    bool update(void);
+
+    uint8_t get_last_channel(void) const { return _last_channel; }
+
+    // peaks of a channel, or nullptr if it has no result yet
+    const Peaks *get_peaks(uint8_t channel) const {
+        if (channel >= AP_SPECTRUM_MAX_CHANNELS || !_channels[channel].have_result) {
+            return nullptr;
+        }
+        return &_channels[channel].peaks;
+    }
+
+    // send the next result not yet sent on a link as VIBRATION_PEAKS
+    void send_peaks(mavlink_channel_t chan);
+
+private:
+    enum frame_state {
+        FRAME_FILLING = 0,
+        FRAME_READY,    // waiting for the transform
+    };
+
+    struct channel_state {
+        float *frame;           // nullptr if the channel is not analysed
+        uint16_t fill;
+        uint8_t state;
+        bool have_result;
+        uint64_t first_us;
+        uint64_t last_us;
+        Peaks peaks;
+    };
+
+    void _add_sample(uint8_t channel, float value, uint64_t sample_us);
+    void _collect_imu(void);
+    bool _start_next(void);
+    void _finish(void);
+
+    AP_InertialSensor &_ins;
+
+    AP_Int8 _enable;
+    AP_Int16 _budget_us;
+    AP_Int32 _channel_mask;
+
+    IncrementalFFT<AP_SPECTRUM_FFT_SIZE> *_fft;
+    struct channel_state _channels[AP_SPECTRUM_MAX_CHANNELS];
+
+    // channel being transformed, or -1 when idle
+    int8_t _current;
+    uint64_t _current_us;
+    float _current_rate_hz;
+    uint8_t _next;
+    uint8_t _last_channel;
+
+    // read positions in the INS raw sample rings
+    uint32_t _gyro_cursor;
+    uint32_t _accel_cursor;
+    uint8_t _gyro_instance;
+    uint8_t _accel_instance;
+
+    // channels with results not yet sent, per link
+    uint32_t _unsent[MAVLINK_COMM_NUM_BUFFERS];
+};
@@ -44,11 +44,19 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
 
     // @Param: SPACING
     // @DisplayName: Terrain grid spacing
-    // @Description: Distance between terrain grid points in meters. This controls the horizontal resolution of the terrain data that is stored on te SD card and requested from the ground station. If your GCS is using the worldwide SRTM database then a resolution of 100 meters is appropriate. Some parts of the world may have higher resolution data available, such as 30 meter data available in the SRTM database in the USA. The grid spacing also controls how much data is kept in memory during flight. A larger grid spacing will allow for a larger amount of data in memory. A grid spacing of 100 meters results in the vehicle keeping 12 grid squares in memory with each grid square having a size of 2.7 kilometers by 3.2 kilometers. Any additional grid squares are stored on the SD once they are fetched from the GCS and will be demand loaded as needed.
+    // @Description: Distance between terrain grid points in meters. This controls the horizontal resolution of the terrain data that is stored on te SD card and requested from the ground station. If your GCS is using the worldwide SRTM database then a resolution of 100 meters is appropriate. Some parts of the world may have higher resolution data available, such as 30 meter data available in the SRTM database in the USA. The grid spacing also controls how much data is kept in memory during flight. A larger grid spacing will allow for a larger amount of data in memory. A grid spacing of 100 meters results in each of the TERRAIN_CACHE_SZ grid squares kept in memory having a size of 2.7 kilometers by 3.2 kilometers. Any additional grid squares are stored on the SD once they are fetched from the GCS and will be demand loaded as needed.
     // @Units: meters
     // @Increment: 1
     AP_GROUPINFO("SPACING",   1, AP_Terrain, grid_spacing, 100),
 
+    // @Param: CACHE_SZ
+    // @DisplayName: Terrain cache size
+    // @Description: Number of terrain grid squares kept in memory. Each takes a little over 2 kilobytes. Grid squares along the ground track are loaded from the SD card ahead of the vehicle, so a larger cache lets faster vehicles keep the terrain ahead in memory. Boards other than Linux are limited to 24 to leave them enough free memory. Takes effect after a reboot
+    // @Range: 4 255
+    // @Increment: 1
+    // @User: Advanced
+    AP_GROUPINFO("CACHE_SZ",  2, AP_Terrain, cache_size_param, TERRAIN_GRID_BLOCK_CACHE_SIZE),
+
     AP_GROUPEND
 };
 
@@ -57,7 +65,11 @@ AP_Terrain::AP_Terrain(AP_AHRS &_ahrs, const AP_Mission &_mission, const AP_Rall
     ahrs(_ahrs),
     mission(_mission),
     rally(_rally),
+    cache_hits(0),
+    cache_misses(0),
+    cache_prefetches(0),
     disk_io_state(DiskIoIdle),
+    disk_block_count(0),
     fd(-1),
     timer_setup(false),
     file_lat_degrees(0),
@@ -100,8 +112,9 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height)
 
     calculate_grid_info(loc, info);
 
-    // find the grid
-    const struct grid_block &grid = find_grid_cache(info).grid;
+    // find the grid, from the tile database if it holds it
+    const struct grid_block *tile = find_tile(info);
+    const struct grid_block &grid = tile != nullptr ? *tile : find_grid_cache(info).grid;
 
     /*
       note that we rely on the one square overlap to ensure these
@@ -296,13 +309,19 @@ void AP_Terrain::update(void)
     // just schedule any needed disk IO
     schedule_disk_io();
 
+    // load the blocks ahead of us before touching home and the current
+    // location, so those two stay the most recently used
+    Location loc;
+    bool pos_valid = ahrs.get_position(loc);
+    if (pos_valid) {
+        prefetch(loc);
+    }
+
     // try to ensure the home location is populated
     float height;
     height_amsl(ahrs.get_home(), height);
 
     // update the cached current location height
-    Location loc;
-    bool pos_valid = ahrs.get_position(loc);
     bool terrain_valid = height_amsl(loc, height);
     if (pos_valid && terrain_valid) {
         last_current_loc_height = height;
@@ -368,6 +387,60 @@ void AP_Terrain::log_terrain_data(DataFlash_Class &dataflash)
         loaded         : loaded
     };
     dataflash.WriteBlock(&pkt, sizeof(pkt));
+
+    struct log_TerrainCache cpkt = {
+        LOG_PACKET_HEADER_INIT(LOG_TRCS_MSG),
+        time_us        : pkt.time_us,
+        cache_hits     : cache_hits,
+        cache_misses   : cache_misses,
+        prefetches     : cache_prefetches
+    };
+    dataflash.WriteBlock(&cpkt, sizeof(cpkt));
+}
+
+/*
+  prefetch the blocks along the ground track for the next
+  TERRAIN_PREFETCH_TIME_S seconds, so their disk reads are done before
+  the vehicle gets there. At most a quarter of the cache is used for
+  blocks ahead, so the blocks around the vehicle aren't evicted
+ */
+void AP_Terrain::prefetch(const Location &loc)
+{
+    if (!enable || !allocate() || grid_spacing <= 0) {
+        return;
+    }
+
+    Vector2f velocity = ahrs.groundspeed_vector();
+    float speed = velocity.length();
+    if (speed < 1) {
+        return;
+    }
+    float bearing = degrees(atan2f(velocity.y, velocity.x));
+
+    // step by half the shorter side of a block so no block on the
+    // track is missed
+    float step = 0.5f * TERRAIN_GRID_BLOCK_SPACING_X * grid_spacing;
+    float distance = speed * TERRAIN_PREFETCH_TIME_S;
+    uint8_t max_blocks = MAX(cache_size/4, 1);
+
+    uint8_t blocks = 0;
+    int32_t last_lat = 0, last_lon = 0;
+    for (float d=step; d <= distance && blocks < max_blocks; d += step) {
+        Location loc2 = loc;
+        location_update(loc2, bearing, d);
+        struct grid_info info;
+        calculate_grid_info(loc2, info);
+        if (info.grid_lat == last_lat && info.grid_lon == last_lon) {
+            continue;
+        }
+        last_lat = info.grid_lat;
+        last_lon = info.grid_lon;
+        if (find_tile(info) != nullptr) {
+            continue;
+        }
+        find_grid_cache(info, true);
+        blocks++;
+    }
 }
 
 /*
@@ -382,13 +455,44 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
-    cache = (struct grid_cache *)calloc(TERRAIN_GRID_BLOCK_CACHE_SIZE, sizeof(cache[0]));
-    if (cache == nullptr) {
+    uint8_t size = constrain_int16(cache_size_param, 4, TERRAIN_GRID_BLOCK_CACHE_MAX);
+
+    // at least two hash buckets per entry keeps the chains short
+    uint16_t nbuckets = 1;
+    while (nbuckets < 2*size) {
+        nbuckets <<= 1;
+    }
+
+    cache = (struct grid_cache *)calloc(size, sizeof(cache[0]));
+    links = (struct cache_link *)calloc(size, sizeof(links[0]));
+    hash_head = (int16_t *)calloc(nbuckets, sizeof(hash_head[0]));
+    if (cache == nullptr || links == nullptr || hash_head == nullptr) {
+        free(cache);
+        free(links);
+        free(hash_head);
+        cache = nullptr;
+        links = nullptr;
+        hash_head = nullptr;
         enable.set(0);
         GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         return false;
     }
-    cache_size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+
+    for (uint16_t i=0; i<nbuckets; i++) {
+        hash_head[i] = -1;
+    }
+    hash_size = nbuckets;
+
+    // all entries start out in the LRU list, unused
+    for (uint8_t i=0; i<size; i++) {
+        links[i].hash_next = -1;
+        links[i].lru_prev = i-1;
+        links[i].lru_next = (i+1 < size) ? i+1 : -1;
+    }
+    lru_head = 0;
+    lru_tail = size-1;
+
+    cache_size = size;
     return true;
 }
 
@@ -55,12 +55,44 @@
 #define TERRAIN_GRID_BLOCK_SIZE_X (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X)
 #define TERRAIN_GRID_BLOCK_SIZE_Y (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y)
 
-// number of grid_blocks in the LRU memory cache
+// default and largest number of grid_blocks in the LRU memory cache,
+// set by the TERRAIN_CACHE_SZ parameter. Each takes a little over 2k
+#ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE 64
+#define TERRAIN_GRID_BLOCK_CACHE_MAX 255
+#else
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
+#define TERRAIN_GRID_BLOCK_CACHE_MAX 24
+#endif
+#endif
+#ifndef TERRAIN_GRID_BLOCK_CACHE_MAX
+#define TERRAIN_GRID_BLOCK_CACHE_MAX 255
+#endif
+
+// number of grid_blocks handed to the IO thread at a time
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#define TERRAIN_IO_BATCH 4
+#else
+#define TERRAIN_IO_BATCH 1
+#endif
+
+// seconds of flight along the ground track that are prefetched
+#define TERRAIN_PREFETCH_TIME_S 60
 
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
+// a memory mapped database of preprocessed grid_blocks covering the
+// operating area can be used on boards with a filesystem and plenty of
+// memory. It is created with Tools/scripts/terrain_tiles.py
+#ifndef AP_TERRAIN_TILES_AVAILABLE
+#define AP_TERRAIN_TILES_AVAILABLE (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+#endif
+#define TERRAIN_TILES_FILE "tiles.dat"
+#define TERRAIN_TILES_MAGIC 0x54545041 // "APTT"
+#define TERRAIN_TILES_VERSION 1
+
 #if TERRAIN_DEBUG
 #define ASSERT_RANGE(v,minv,maxv) assert((v)<=(maxv)&&(v)>=(minv))
 #else
@@ -211,6 +243,19 @@ private:
         uint8_t buffer[2048];
     };
 
+    /*
+      header of the tile database, in the first 2048 bytes of the
+      file. It is followed by num_blocks grid_io_blocks, with full
+      bitmaps, sorted by lat_degrees, lon_degrees, grid_idx_x and
+      grid_idx_y
+     */
+    struct PACKED tiles_header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t spacing;
+        uint32_t num_blocks;
+    };
+
     enum GridCacheState {
         GRID_CACHE_INVALID=0,    // when first initialised
         GRID_CACHE_DISKWAIT=1,   // when waiting for disk read
@@ -226,9 +271,16 @@ private:
         struct grid_block grid;
 
         volatile enum GridCacheState state;
+    };
 
-        // the last time access was requested to this block, used for LRU
-        uint32_t last_access_ms;
+    /*
+      links of a cache entry in its hash bucket chain and in the LRU
+      list. Entries that are not INVALID are in a hash chain
+     */
+    struct cache_link {
+        int16_t hash_next;
+        int16_t lru_prev;
+        int16_t lru_next;
     };
 
     /*
@@ -264,9 +316,25 @@ private:
     void calculate_grid_info(const Location &loc, struct grid_info &info) const;
 
     /*
-      find a grid structure given a grid_info
+      find a grid structure given a grid_info, loading it into the cache
+      if needed. prefetch is set for lookups ahead of the aircraft, which
+      are counted separately
     */
-    struct grid_cache &find_grid_cache(const struct grid_info &info);
+    struct grid_cache &find_grid_cache(const struct grid_info &info, bool prefetch=false);
+
+    /*
+      hashed cache lookup and LRU ordering
+     */
+    uint16_t cache_bucket(int32_t lat, int32_t lon, uint16_t spacing) const;
+    int16_t find_cache_idx(int32_t lat, int32_t lon, uint16_t spacing) const;
+    void hash_remove(int16_t idx);
+    void lru_remove(int16_t idx);
+    void lru_push_front(int16_t idx);
+
+    /*
+      bring the blocks ahead of the aircraft into the cache
+     */
+    void prefetch(const Location &loc);
 
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
@@ -300,15 +368,21 @@ private:
     /*
       disk IO functions
      */
-    int16_t find_io_idx(enum GridCacheState state);
-    uint16_t get_block_crc(struct grid_block &block);
+    int16_t find_io_idx(const struct grid_block &block);
+    uint16_t get_block_crc(const struct grid_block &block);
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
-    void open_file(void);
-    void seek_offset(void);
-    void write_block(void);
-    void read_block(void);
+    void open_file(const struct grid_block &block);
+    void seek_offset(const struct grid_block &block);
+    void write_block(union grid_io_block &io);
+    void read_block(union grid_io_block &io);
+
+    /*
+      tile database functions
+     */
+    void tiles_open(void);
+    const struct grid_block *find_tile(const struct grid_info &info);
 
     /*
       check for missing mission terrain data
@@ -324,6 +398,7 @@ private:
     // parameters
     AP_Int8  enable;
     AP_Int16 grid_spacing; // meters between grid points
+    AP_Int16 cache_size_param; // grid_blocks in memory
 
     // reference to AHRS, so we can ask for our position,
     // heading and speed
@@ -341,6 +416,19 @@ private:
     uint8_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // hash buckets of the cache, holding the index of the first entry
+    // of each chain or -1, and the chain and LRU links of each entry
+    uint16_t hash_size = 0;
+    int16_t *hash_head = nullptr;
+    struct cache_link *links = nullptr;
+    int16_t lru_head = -1;  // most recently used
+    int16_t lru_tail = -1;  // least recently used
+
+    // cache statistics for logging
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t cache_prefetches;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -350,7 +438,8 @@ private:
         DiskIoDoneWrite = 4
     };
     volatile enum DiskIoState disk_io_state;
-    union grid_io_block disk_block;
+    union grid_io_block disk_block[TERRAIN_IO_BATCH];
+    uint8_t disk_block_count;
 
     // last time we asked for more grids
     uint32_t last_request_time_ms[MAVLINK_COMM_NUM_BUFFERS];
@@ -373,6 +462,18 @@ private:
     // have we created the terrain directory?
     bool directory_created;
 
+#if AP_TERRAIN_TILES_AVAILABLE
+    // the tile database is mapped by the IO thread, and can be used
+    // by the main thread once tiles_ready is set
+    bool tiles_checked = false;
+    bool tiles_ready = false;
+    const union grid_io_block *tiles = nullptr;
+    const uint8_t *tiles_valid = nullptr;   // bitmap of blocks that passed their checks
+    uint32_t tiles_count = 0;
+    uint16_t tiles_spacing = 0;
+    const struct grid_block *tiles_last = nullptr;
+#endif
+
     // cache the home altitude, as it is needed so often
     float home_height;
     Location home_loc;
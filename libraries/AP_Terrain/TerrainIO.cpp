@@ -37,17 +37,20 @@
 extern const AP_HAL::HAL& hal;
 
 /*
-  check for blocks that need to be read from disk
+  check for blocks that need to be read from disk, most recently used
+  first
  */
 void AP_Terrain::check_disk_read(void)
 {
-    for (uint16_t i=0; i<cache_size; i++) {
+    disk_block_count = 0;
+    for (int16_t i=lru_head; i != -1 && disk_block_count < TERRAIN_IO_BATCH; i=links[i].lru_next) {
         if (cache[i].state == GRID_CACHE_DISKWAIT) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitRead;
-            return;
+            disk_block[disk_block_count++].block = cache[i].grid;
         }
-    }    
+    }
+    if (disk_block_count > 0) {
+        disk_io_state = DiskIoWaitRead;
+    }
 }
 
 /*
@@ -55,13 +58,15 @@ void AP_Terrain::check_disk_read(void)
  */
 void AP_Terrain::check_disk_write(void)
 {
-    for (uint16_t i=0; i<cache_size; i++) {
+    disk_block_count = 0;
+    for (int16_t i=lru_head; i != -1 && disk_block_count < TERRAIN_IO_BATCH; i=links[i].lru_next) {
         if (cache[i].state == GRID_CACHE_DIRTY) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitWrite;
-            return;
+            disk_block[disk_block_count++].block = cache[i].grid;
         }
-    }    
+    }
+    if (disk_block_count > 0) {
+        disk_io_state = DiskIoWaitWrite;
+    }
 }
 
 /*
@@ -89,25 +94,30 @@ void AP_Terrain::schedule_disk_io(void)
         break;
         
     case DiskIoDoneRead: {
-        // a read has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DISKWAIT);
-        if (cache_idx != -1) {
-            if (disk_block.block.bitmap != 0) {
+        // reads have completed
+        for (uint8_t i=0; i<disk_block_count; i++) {
+            const struct grid_block &block = disk_block[i].block;
+            int16_t cache_idx = find_io_idx(block);
+            if (cache_idx == -1 || cache[cache_idx].state != GRID_CACHE_DISKWAIT) {
+                continue;
+            }
+            if (block.bitmap != 0) {
                 // when bitmap is zero we read an empty block
-                cache[cache_idx].grid = disk_block.block;
+                cache[cache_idx].grid = block;
             }
             cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
         }
         disk_io_state = DiskIoIdle;
         break;
     }
 
     case DiskIoDoneWrite: {
-        // a write has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DIRTY);
-        if (cache_idx != -1) {
-            if (cache[cache_idx].grid.bitmap == disk_block.block.bitmap) {
+        // writes have completed
+        for (uint8_t i=0; i<disk_block_count; i++) {
+            int16_t cache_idx = find_io_idx(disk_block[i].block);
+            if (cache_idx != -1 &&
+                cache[cache_idx].state == GRID_CACHE_DIRTY &&
+                cache[cache_idx].grid.bitmap == disk_block[i].block.bitmap) {
                 // only mark valid if more grids haven't been added
                 cache[cache_idx].state = GRID_CACHE_VALID;
             }
@@ -139,11 +149,10 @@ All file operations are done by the IO thread.
 
 
 /*
-  open the current degree file
+  open the degree file of a block
  */
-void AP_Terrain::open_file(void)
+void AP_Terrain::open_file(const struct grid_block &block)
 {
-    struct grid_block &block = disk_block.block;
     if (fd != -1 && 
         block.lat_degrees == file_lat_degrees &&
         block.lon_degrees == file_lon_degrees) {
@@ -202,11 +211,10 @@ void AP_Terrain::open_file(void)
 }
 
 /*
-  seek to the right offset for disk_block
+  seek to the right offset for a block
  */
-void AP_Terrain::seek_offset(void)
+void AP_Terrain::seek_offset(const struct grid_block &block)
 {
-    struct grid_block &block = disk_block.block;
     // work out how many longitude blocks there are at this latitude
     Location loc1, loc2;
     loc1.lat = block.lat_degrees*10*1000*1000L;
@@ -233,19 +241,19 @@ void AP_Terrain::seek_offset(void)
 }
 
 /*
-  write out disk_block
+  write out a block
  */
-void AP_Terrain::write_block(void)
+void AP_Terrain::write_block(union grid_io_block &io)
 {
-    seek_offset();
+    seek_offset(io.block);
     if (io_failure) {
         return;
     }
 
-    disk_block.block.crc = get_block_crc(disk_block.block);
+    io.block.crc = get_block_crc(io.block);
 
-    ssize_t ret = ::write(fd, &disk_block, sizeof(disk_block));
-    if (ret  != sizeof(disk_block)) {
+    ssize_t ret = ::write(fd, &io, sizeof(io));
+    if (ret  != sizeof(io)) {
 #if TERRAIN_DEBUG
         hal.console->printf("write failed - %s\n", strerror(errno));
 #endif
@@ -253,38 +261,36 @@ void AP_Terrain::write_block(void)
         fd = -1;
         io_failure = true;
     } else {
-        ::fsync(fd);
 #if TERRAIN_DEBUG
         printf("wrote block at %ld %ld ret=%d mask=%07llx\n",
-               (long)disk_block.block.lat,
-               (long)disk_block.block.lon,
+               (long)io.block.lat,
+               (long)io.block.lon,
                (int)ret,
-               (unsigned long long)disk_block.block.bitmap);
+               (unsigned long long)io.block.bitmap);
 #endif
     }
-    disk_io_state = DiskIoDoneWrite;
 }
 
 /*
-  read in disk_block
+  read in a block
  */
-void AP_Terrain::read_block(void)
+void AP_Terrain::read_block(union grid_io_block &io)
 {
-    seek_offset();
+    seek_offset(io.block);
     if (io_failure) {
         return;
     }
-    int32_t lat = disk_block.block.lat;
-    int32_t lon = disk_block.block.lon;
-
-    ssize_t ret = ::read(fd, &disk_block, sizeof(disk_block));
-    if (ret != sizeof(disk_block) || 
-        disk_block.block.lat != lat || 
-        disk_block.block.lon != lon ||
-        disk_block.block.bitmap == 0 ||
-        disk_block.block.spacing != grid_spacing ||
-        disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
-        disk_block.block.crc != get_block_crc(disk_block.block)) {
+    int32_t lat = io.block.lat;
+    int32_t lon = io.block.lon;
+
+    ssize_t ret = ::read(fd, &io, sizeof(io));
+    if (ret != sizeof(io) || 
+        io.block.lat != lat || 
+        io.block.lon != lon ||
+        io.block.bitmap == 0 ||
+        io.block.spacing != grid_spacing ||
+        io.block.version != TERRAIN_GRID_FORMAT_VERSION ||
+        io.block.crc != get_block_crc(io.block)) {
 #if TERRAIN_DEBUG
         printf("read empty block at %ld %ld ret=%d\n",
                (long)lat,
@@ -293,20 +299,19 @@ void AP_Terrain::read_block(void)
 #endif
         // a short read or bad data is not an IO failure, just a
         // missing block on disk
-        memset(&disk_block, 0, sizeof(disk_block));
-        disk_block.block.lat = lat;
-        disk_block.block.lon = lon;
-        disk_block.block.bitmap = 0;
+        memset(&io, 0, sizeof(io));
+        io.block.lat = lat;
+        io.block.lon = lon;
+        io.block.bitmap = 0;
     } else {
 #if TERRAIN_DEBUG
         printf("read block at %ld %ld ret=%d mask=%07llx\n",
                (long)lat,
                (long)lon,
                (int)ret,
-               (unsigned long long)disk_block.block.bitmap);
+               (unsigned long long)io.block.bitmap);
 #endif
     }
-    disk_io_state = DiskIoDoneRead;
 }
 
 /*
@@ -314,6 +319,13 @@ void AP_Terrain::read_block(void)
  */
 void AP_Terrain::io_timer(void)
 {
+#if AP_TERRAIN_TILES_AVAILABLE
+    if (!tiles_checked) {
+        tiles_checked = true;
+        tiles_open();
+    }
+#endif
+
     if (io_failure) {
         // don't keep trying io, so we don't thrash the filesystem
         // code while flying
@@ -328,21 +340,38 @@ void AP_Terrain::io_timer(void)
         break;
         
     case DiskIoWaitWrite:
-        // need to write out the block
-        open_file();
-        if (fd == -1) {
-            return;
+        // need to write out the blocks, with one sync for the batch
+        for (uint8_t i=0; i<disk_block_count; i++) {
+            open_file(disk_block[i].block);
+            if (fd == -1) {
+                return;
+            }
+            write_block(disk_block[i]);
+            if (io_failure) {
+                return;
+            }
+            if (i+1 == disk_block_count ||
+                disk_block[i+1].block.lat_degrees != file_lat_degrees ||
+                disk_block[i+1].block.lon_degrees != file_lon_degrees) {
+                ::fsync(fd);
+            }
         }
-        write_block();
+        disk_io_state = DiskIoDoneWrite;
         break;
 
     case DiskIoWaitRead:
-        // need to read in the block
-        open_file();
-        if (fd == -1) {
-            return;
+        // need to read in the blocks
+        for (uint8_t i=0; i<disk_block_count; i++) {
+            open_file(disk_block[i].block);
+            if (fd == -1) {
+                return;
+            }
+            read_block(disk_block[i]);
+            if (io_failure) {
+                return;
+            }
         }
-        read_block();
+        disk_io_state = DiskIoDoneRead;
         break;
     }
 }
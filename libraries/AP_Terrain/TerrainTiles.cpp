@@ -0,0 +1,188 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  memory mapped terrain tile database
+
+  The tile database holds complete grid_blocks for a whole operating
+  area, so lookups inside it never wait for disk IO or the GCS. Blocks
+  outside it are handled by the grid cache as before
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+#include <GCS_MAVLink/GCS.h>
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_AVAILABLE
+
+#if AP_TERRAIN_TILES_AVAILABLE
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  map the tile database if there is one. This runs in the IO thread
+  and can take a while, as the whole file is read in up front so that
+  lookups don't fault on pages in flight, and every block is checked
+  once here so lookups don't need to
+ */
+void AP_Terrain::tiles_open(void)
+{
+#if AP_TERRAIN_TILES_AVAILABLE
+    const char* terrain_dir = hal.util->get_custom_terrain_directory();
+    if (terrain_dir == NULL) {
+        terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+    }
+    char *path = NULL;
+    if (asprintf(&path, "%s/" TERRAIN_TILES_FILE, terrain_dir) <= 0) {
+        return;
+    }
+    int tfd = ::open(path, O_RDONLY);
+    free(path);
+    if (tfd == -1) {
+        return;
+    }
+
+    struct stat st;
+    struct tiles_header header;
+    if (fstat(tfd, &st) != 0 ||
+        ::read(tfd, &header, sizeof(header)) != sizeof(header) ||
+        header.magic != TERRAIN_TILES_MAGIC ||
+        header.version != TERRAIN_TILES_VERSION ||
+        header.num_blocks == 0 ||
+        (uint64_t)st.st_size != (header.num_blocks + 1ULL) * sizeof(union grid_io_block)) {
+#if TERRAIN_DEBUG
+        hal.console->printf("Bad terrain tiles file\n");
+#endif
+        ::close(tfd);
+        return;
+    }
+
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    void *p = mmap(NULL, st.st_size, PROT_READ, flags, tfd, 0);
+    ::close(tfd);
+    if (p == MAP_FAILED) {
+#if TERRAIN_DEBUG
+        hal.console->printf("mmap of terrain tiles failed - %s\n", strerror(errno));
+#endif
+        return;
+    }
+    madvise(p, st.st_size, MADV_WILLNEED);
+
+    const union grid_io_block *blocks = (const union grid_io_block *)p;
+    uint8_t *valid = (uint8_t *)calloc((header.num_blocks+7)/8, 1);
+    if (valid == nullptr) {
+        munmap(p, st.st_size);
+        return;
+    }
+
+    // a bad block is left to the grid cache
+    uint32_t bad_blocks = 0;
+    for (uint32_t i=0; i<header.num_blocks; i++) {
+        const struct grid_block &b = blocks[i+1].block;
+        if (b.bitmap == bitmap_mask &&
+            b.spacing == header.spacing &&
+            b.version == TERRAIN_GRID_FORMAT_VERSION &&
+            b.crc == get_block_crc(b)) {
+            valid[i/8] |= 1U<<(i%8);
+        } else {
+            bad_blocks++;
+        }
+    }
+#if TERRAIN_DEBUG
+    if (bad_blocks != 0) {
+        hal.console->printf("%u bad terrain tiles\n", (unsigned)bad_blocks);
+    }
+#else
+    (void)bad_blocks;
+#endif
+
+    tiles = blocks;
+    tiles_valid = valid;
+    tiles_count = header.num_blocks;
+    tiles_spacing = header.spacing;
+    __atomic_store_n(&tiles_ready, true, __ATOMIC_RELEASE);
+#endif
+}
+
+/*
+  find the complete block for a grid_info in the tile database, or
+  nullptr if the database doesn't hold it
+ */
+const struct AP_Terrain::grid_block *AP_Terrain::find_tile(const struct grid_info &info)
+{
+#if AP_TERRAIN_TILES_AVAILABLE
+    if (!__atomic_load_n(&tiles_ready, __ATOMIC_ACQUIRE) ||
+        tiles_spacing != grid_spacing) {
+        return nullptr;
+    }
+
+    if (tiles_last != nullptr &&
+        tiles_last->lat_degrees == info.lat_degrees &&
+        tiles_last->lon_degrees == info.lon_degrees &&
+        tiles_last->grid_idx_x == info.grid_idx_x &&
+        tiles_last->grid_idx_y == info.grid_idx_y) {
+        return tiles_last;
+    }
+
+    // binary search of the blocks, which follow the header
+    uint32_t lo = 1, hi = tiles_count + 1;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const struct grid_block &b = tiles[mid].block;
+        int32_t cmp = b.lat_degrees - info.lat_degrees;
+        if (cmp == 0) {
+            cmp = b.lon_degrees - info.lon_degrees;
+        }
+        if (cmp == 0) {
+            cmp = b.grid_idx_x - info.grid_idx_x;
+        }
+        if (cmp == 0) {
+            cmp = b.grid_idx_y - info.grid_idx_y;
+        }
+        if (cmp == 0) {
+            // blocks that failed the check in tiles_open() are left
+            // to the grid cache
+            const uint32_t i = mid - 1;
+            if ((tiles_valid[i/8] & (1U<<(i%8))) == 0) {
+                return nullptr;
+            }
+            tiles_last = &b;
+            return tiles_last;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+#endif
+    return nullptr;
+}
+
+#endif // AP_TERRAIN_AVAILABLE
@@ -113,28 +113,116 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 
 
 /*
-  find a grid structure given a grid_info
+  hash bucket of a grid_block
  */
-AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+uint16_t AP_Terrain::cache_bucket(int32_t lat, int32_t lon, uint16_t spacing) const
 {
-    uint16_t oldest_i = 0;
+    uint32_t h = (uint32_t)lat * 2654435761UL;
+    h ^= (uint32_t)lon * 2246822519UL;
+    h ^= spacing;
+    h ^= h >> 16;
+    return h & (hash_size-1);
+}
 
-    // see if we have that grid
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].grid.lat == info.grid_lat && 
-            cache[i].grid.lon == info.grid_lon &&
-            cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
-            return cache[i];
+/*
+  find the cache index of a grid_block, or -1 if it isn't in the cache
+ */
+int16_t AP_Terrain::find_cache_idx(int32_t lat, int32_t lon, uint16_t spacing) const
+{
+    for (int16_t i = hash_head[cache_bucket(lat, lon, spacing)]; i != -1; i = links[i].hash_next) {
+        const struct grid_block &grid = cache[i].grid;
+        if (grid.lat == lat && grid.lon == lon && grid.spacing == spacing) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+  remove a cache entry from its hash chain
+ */
+void AP_Terrain::hash_remove(int16_t idx)
+{
+    const struct grid_block &grid = cache[idx].grid;
+    int16_t *p = &hash_head[cache_bucket(grid.lat, grid.lon, grid.spacing)];
+    while (*p != -1) {
+        if (*p == idx) {
+            *p = links[idx].hash_next;
+            break;
         }
-        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
-            oldest_i = i;
+        p = &links[*p].hash_next;
+    }
+    links[idx].hash_next = -1;
+}
+
+/*
+  unlink a cache entry from the LRU list
+ */
+void AP_Terrain::lru_remove(int16_t idx)
+{
+    struct cache_link &l = links[idx];
+    if (l.lru_prev != -1) {
+        links[l.lru_prev].lru_next = l.lru_next;
+    } else {
+        lru_head = l.lru_next;
+    }
+    if (l.lru_next != -1) {
+        links[l.lru_next].lru_prev = l.lru_prev;
+    } else {
+        lru_tail = l.lru_prev;
+    }
+    l.lru_prev = l.lru_next = -1;
+}
+
+/*
+  make a cache entry the most recently used
+ */
+void AP_Terrain::lru_push_front(int16_t idx)
+{
+    if (lru_head == idx) {
+        return;
+    }
+    lru_remove(idx);
+    links[idx].lru_next = lru_head;
+    if (lru_head != -1) {
+        links[lru_head].lru_prev = idx;
+    }
+    lru_head = idx;
+    if (lru_tail == -1) {
+        lru_tail = idx;
+    }
+}
+
+/*
+  find a grid structure given a grid_info
+ */
+AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info, bool prefetch)
+{
+    // see if we have that grid
+    int16_t idx = find_cache_idx(info.grid_lat, info.grid_lon, grid_spacing);
+    if (idx != -1) {
+        // a prefetch hit is touched too, so a block loaded ahead of the
+        // vehicle isn't evicted before the vehicle gets to it
+        lru_push_front(idx);
+        if (!prefetch) {
+            if (cache[idx].state >= GRID_CACHE_VALID) {
+                cache_hits++;
+            } else {
+                // still waiting for the disk
+                cache_misses++;
+            }
         }
+        return cache[idx];
+    }
+
+    // Not found. Use the least recently used grid and make it this
+    // grid, initially unpopulated
+    idx = lru_tail;
+    if (cache[idx].state != GRID_CACHE_INVALID) {
+        hash_remove(idx);
     }
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
-    struct grid_cache &grid = cache[oldest_i];
+    struct grid_cache &grid = cache[idx];
     memset(&grid, 0, sizeof(grid));
 
     grid.grid.lat = info.grid_lat;
@@ -145,46 +233,46 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lat_degrees = info.lat_degrees;
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
-    grid.last_access_ms = AP_HAL::millis();
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
+    uint16_t bucket = cache_bucket(info.grid_lat, info.grid_lon, grid_spacing);
+    links[idx].hash_next = hash_head[bucket];
+    hash_head[bucket] = idx;
+
+    lru_push_front(idx);
+    if (prefetch) {
+        cache_prefetches++;
+    } else {
+        cache_misses++;
+    }
+
     return grid;
 }
 
 /*
-  find cache index of disk_block
+  find cache index of a block handed to the IO thread. The block may
+  have been evicted while the IO was in progress
  */
-int16_t AP_Terrain::find_io_idx(enum GridCacheState state)
+int16_t AP_Terrain::find_io_idx(const struct grid_block &block)
 {
-    // try first with given state
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (disk_block.block.lat == cache[i].grid.lat &&
-            disk_block.block.lon == cache[i].grid.lon && 
-            cache[i].state == state) {
-            return i;
-        }
-    }    
-    // then any state
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (disk_block.block.lat == cache[i].grid.lat &&
-            disk_block.block.lon == cache[i].grid.lon) {
-            return i;
-        }
-    }    
-    return -1;
+    return find_cache_idx(block.lat, block.lon, grid_spacing);
 }
 
 /*
   get CRC for a block
  */
-uint16_t AP_Terrain::get_block_crc(struct grid_block &block)
+uint16_t AP_Terrain::get_block_crc(const struct grid_block &block)
 {
-    uint16_t saved_crc = block.crc;
-    block.crc = 0;
-    uint16_t ret = crc16_ccitt((const uint8_t *)&block, sizeof(block), 0);
-    block.crc = saved_crc;
+    // the crc is taken with the crc field zero, without modifying the
+    // block so it works on read-only tiles
+    const uint8_t *p = (const uint8_t *)&block;
+    const uint8_t zero[sizeof(block.crc)] {};
+    const uint16_t ofs = offsetof(struct grid_block, crc);
+    uint16_t ret = crc16_ccitt(p, ofs, 0);
+    ret = crc16_ccitt(zero, sizeof(zero), ret);
+    ret = crc16_ccitt(p + ofs + sizeof(zero), sizeof(block) - (ofs + sizeof(zero)), ret);
     return ret;
 }
 
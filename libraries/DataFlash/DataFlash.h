@@ -19,7 +19,9 @@
 #include <AP_Airspeed/AP_Airspeed.h>
 #include <AP_BattMonitor/AP_BattMonitor.h>
 #include <AP_RPM/AP_RPM.h>
+#include <AP_Spectrum/AP_Spectrum.h>
 #include <AP_RangeFinder/AP_RangeFinder.h>
+#include <AP_Scheduler/AP_Scheduler.h>
 #include <DataFlash/LogStructure.h>
 #include <stdint.h>
 
@@ -124,6 +126,11 @@ public:
                                const AP_Mission::Mission_Command &cmd);
     void Log_Write_Origin(uint8_t origin_type, const Location &loc);
     void Log_Write_RPM(const AP_RPM &rpm_sensor);
+    void Log_Write_Spectrum(const AP_Spectrum &spectrum, uint8_t channel);
+    void Log_Write_ParamStorage();
+    void Log_Write_Storage();
+    void Log_Write_Scheduler_Timing(const AP_Scheduler &scheduler);
+    void Log_Write_Perf_Counters();
     // Custom code
     // Write Strain data packet definition
     struct Strain_sensdata {
@@ -60,7 +60,6 @@ DataFlash_File::DataFlash_File(DataFlash_Class &front,
     _open_error(false),
     _log_directory(log_directory),
     _cached_oldest_log(0),
-    _writebuf(NULL),
 #if defined(CONFIG_ARCH_BOARD_PX4FMU_V1)
     // V1 gets IO errors with larger than 512 byte writes
     _writebuf_chunk(512),
@@ -79,8 +78,6 @@ DataFlash_File::DataFlash_File(DataFlash_Class &front,
 #else
     _writebuf_chunk(4096),
 #endif
-    _writebuf_head(0),
-    _writebuf_tail(0),
     _last_write_time(0),
     _perf_write(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_write")),
     _perf_fsync(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_fsync")),
@@ -134,36 +131,31 @@ void DataFlash_File::Init()
     }
 #endif
     
-    if (_writebuf != NULL) {
-        free(_writebuf);
-        _writebuf = NULL;
-    }
+    _writebuf.set_size(0);
 
     // determine and limit file backend buffersize
     uint8_t bufsize = _front._params.file_bufsize;
     if (bufsize > 64) {
-        // we currently use uint16_t for the ringbuffer.  Also,
+        // bufferspace_available() returns a uint16_t.  Also,
         // PixHawk has DMA limitaitons.
         bufsize = 64;
     }
-    _writebuf_size = bufsize * 1024;
+    uint32_t writebuf_size = bufsize * 1024;
 
     /*
       if we can't allocate the full writebuf then try reducing it
       until we can allocate it
      */
-    while (_writebuf == NULL && _writebuf_size >= _writebuf_chunk) {
-        hal.console->printf("DataFlash_File: buffer size=%u\n", (unsigned)_writebuf_size);
-        _writebuf = (uint8_t *)malloc(_writebuf_size);
-        if (_writebuf == NULL) {
-            _writebuf_size /= 2;
+    while (_writebuf.get_size() == 0 && writebuf_size >= _writebuf_chunk) {
+        hal.console->printf("DataFlash_File: buffer size=%u\n", (unsigned)writebuf_size);
+        if (!_writebuf.set_size(writebuf_size, true)) {
+            writebuf_size /= 2;
         }
     }
-    if (_writebuf == NULL) {
+    if (_writebuf.get_size() == 0) {
         hal.console->printf("Out of memory for logging\n");
         return;        
     }
-    _writebuf_head = _writebuf_tail = 0;
     _initialised = true;
     hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&DataFlash_File::_io_timer, void));
 }
@@ -206,8 +198,7 @@ void DataFlash_File::periodic_fullrate(const uint32_t now)
 
 uint16_t DataFlash_File::bufferspace_available()
 {
-    uint16_t _head;
-    return (BUF_SPACE(_writebuf)) - critical_message_reserved_space();
+    return _writebuf.space() - critical_message_reserved_space();
 }
 
 // return true for CardInserted() if we successfully initialised
@@ -483,8 +474,7 @@ bool DataFlash_File::WritePrioritisedBlock(const void *pBuffer, uint16_t size, b
         return false;
     }
         
-    uint16_t _head;
-    uint16_t space = BUF_SPACE(_writebuf);
+    uint32_t space = _writebuf.space();
 
     if (_writing_startup_messages &&
         _startup_messagewriter->fmt_done()) {
@@ -514,26 +504,7 @@ bool DataFlash_File::WritePrioritisedBlock(const void *pBuffer, uint16_t size, b
         return false;
     }
 
-    if (_writebuf_tail < _head) {
-        // perform as single memcpy
-        assert(((uint32_t)_writebuf_tail)+size <= _writebuf_size);
-        memcpy(&_writebuf[_writebuf_tail], pBuffer, size);
-        BUF_ADVANCETAIL(_writebuf, size);
-    } else {
-        // perform as two memcpy calls
-        uint32_t n = _writebuf_size - _writebuf_tail;
-        if (n > size) n = size;
-        assert(((uint32_t)_writebuf_tail)+n <= _writebuf_size);
-        memcpy(&_writebuf[_writebuf_tail], pBuffer, n);
-        BUF_ADVANCETAIL(_writebuf, n);
-        pBuffer = (const void *)(((const uint8_t *)pBuffer) + n);
-        n = size - n;
-        if (n > 0) {
-            assert(((uint32_t)_writebuf_tail)+n <= _writebuf_size);
-            memcpy(&_writebuf[_writebuf_tail], pBuffer, n);
-            BUF_ADVANCETAIL(_writebuf, n);
-        }
-    }
+    _writebuf.write((const uint8_t *)pBuffer, size);
     semaphore->give();
     return true;
 }
@@ -844,8 +815,7 @@ uint16_t DataFlash_File::start_new_log(void)
     }
     free(fname);
     _write_offset = 0;
-    _writebuf_head = 0;
-    _writebuf_tail = 0;
+    _writebuf.clear();
     log_write_started = true;
 
     // now update lastlog.txt with the new log number
@@ -1018,11 +988,10 @@ void DataFlash_File::ListAvailableLogs(AP_HAL::BetterStream *port)
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
 void DataFlash_File::flush(void)
 {
-    uint16_t _tail;
     uint32_t tnow = AP_HAL::micros();
     hal.scheduler->suspend_timer_procs();
     while (_write_fd != -1 && _initialised && !_open_error &&
-           BUF_AVAILABLE(_writebuf)) {
+           !_writebuf.empty()) {
         // convince the IO timer that it really is OK to write out
         // less than _writebuf_chunk bytes:
         _last_write_time = tnow - 2000000;
@@ -1037,12 +1006,11 @@ void DataFlash_File::flush(void)
 
 void DataFlash_File::_io_timer(void)
 {
-    uint16_t _tail;
     if (_write_fd == -1 || !_initialised || _open_error) {
         return;
     }
 
-    uint16_t nbytes = BUF_AVAILABLE(_writebuf);
+    uint32_t nbytes = _writebuf.available();
     if (nbytes == 0) {
         return;
     }
@@ -1061,10 +1029,10 @@ void DataFlash_File::_io_timer(void)
         // be kind to the FAT PX4 filesystem
         nbytes = _writebuf_chunk;
     }
-    if (_writebuf_head > _tail) {
-        // only write to the end of the buffer
-        nbytes = MIN(nbytes, _writebuf_size - _writebuf_head);
-    }
+    // only write to the end of the buffer, unless it is mirrored
+    ByteBuffer::IoVec vec[2];
+    _writebuf.peekiovec(vec, nbytes);
+    nbytes = vec[0].len;
 
     // try to align writes on a 512 byte boundary to avoid filesystem
     // reads
@@ -1075,8 +1043,7 @@ void DataFlash_File::_io_timer(void)
         }
     }
 
-    assert(((uint32_t)_writebuf_head)+nbytes <= _writebuf_size);
-    ssize_t nwritten = ::write(_write_fd, &_writebuf[_writebuf_head], nbytes);
+    ssize_t nwritten = ::write(_write_fd, vec[0].data, nbytes);
     if (nwritten <= 0) {
         hal.util->perf_count(_perf_errors);
         close(_write_fd);
@@ -1090,7 +1057,7 @@ void DataFlash_File::_io_timer(void)
           chunk, ensuring the directory entry is updated after each
           write.
          */
-        BUF_ADVANCEHEAD(_writebuf, nwritten);
+        _writebuf.advance(nwritten);
 #if CONFIG_HAL_BOARD != HAL_BOARD_SITL && CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE && CONFIG_HAL_BOARD != HAL_BOARD_QURT
         ::fsync(_write_fd);
 #endif
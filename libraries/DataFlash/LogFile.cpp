@@ -1498,6 +1498,47 @@ void DataFlash_Class::Log_Write_EKF2(AP_AHRS_NavEKF &ahrs, bool optFlowEnabled)
         };
         WriteBlock(&pkt9, sizeof(pkt9));
     }
+
+    // write the stage timing of each core once per timing period
+    for (uint8_t i=0; i<ahrs.get_NavEKF2().activeCores(); i++) {
+        EKF2_Timing *timing = ahrs.get_NavEKF2().getStageTiming(i);
+        if (timing == nullptr || !timing->take_report()) {
+            continue;
+        }
+        for (uint8_t stage=0; stage<EKF2_NUM_STAGES; stage++) {
+            const EKF2_Timing::Stage &s = timing->get_report(stage);
+            if (s.count == 0) {
+                continue;
+            }
+            struct log_NKT pkt = {
+                LOG_PACKET_HEADER_INIT(LOG_NKT_MSG),
+                time_us : AP_HAL::micros64(),
+                core    : i,
+                stage   : stage,
+                count   : s.count,
+                fusions : s.fusions,
+                min_us  : EKF2_Timing::ticks_to_us(s.min_ticks),
+                avg_us  : EKF2_Timing::ticks_to_us(s.sum_ticks) / s.count,
+                max_us  : EKF2_Timing::ticks_to_us(s.max_ticks)
+            };
+            WriteBlock(&pkt, sizeof(pkt));
+        }
+    }
+
+    // write a few pieces of any checkpoint being logged, spreading it over several calls
+    for (uint8_t i=0; i<ahrs.get_NavEKF2().activeCores(); i++) {
+        for (uint8_t n=0; n<4; n++) {
+            struct log_NKC pkt = {
+                LOG_PACKET_HEADER_INIT(LOG_NKC_MSG),
+                time_us : AP_HAL::micros64(),
+                core    : i
+            };
+            if (!ahrs.get_NavEKF2().getCheckpointLogChunk(i, pkt.seq, pkt.count, (uint8_t *)pkt.data)) {
+                break;
+            }
+            WriteBlock(&pkt, sizeof(pkt));
+        }
+    }
 }
 #endif
 
@@ -1795,3 +1836,110 @@ void DataFlash_Class::Log_Write_RPM(const AP_RPM &rpm_sensor)
     };
     WriteBlock(&pkt, sizeof(pkt));
 }
+
+// Write the peaks of one spectrum analyser channel
+void DataFlash_Class::Log_Write_Spectrum(const AP_Spectrum &spectrum, uint8_t channel)
+{
+    const AP_Spectrum::Peaks *peaks = spectrum.get_peaks(channel);
+    if (peaks == nullptr) {
+        return;
+    }
+    struct log_Spectrum pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_SPEC_MSG),
+        time_us     : peaks->time_us,
+        channel     : channel,
+        sample_rate : peaks->sample_rate_hz,
+        freq1       : peaks->freq_hz[0],
+        amp1        : peaks->amplitude[0],
+        freq2       : peaks->freq_hz[1],
+        amp2        : peaks->amplitude[1],
+        freq3       : peaks->freq_hz[2],
+        amp3        : peaks->amplitude[2]
+    };
+    WriteBlock(&pkt, sizeof(pkt));
+}
+
+// Write parameter storage load and save timing
+void DataFlash_Class::Log_Write_ParamStorage()
+{
+    const AP_Param::StorageStats &stats = AP_Param::storage_stats();
+    struct log_ParamStorage pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_PSTO_MSG),
+        time_us      : AP_HAL::micros64(),
+        load_all_us  : stats.load_all_us,
+        stored_count : stats.stored_count,
+        storage_used : stats.storage_used,
+        save_count   : stats.save_count,
+        save_max_us  : stats.save_max_us,
+        save_avg_us  : stats.save_count ? stats.save_total_us / stats.save_count : 0
+    };
+    WriteBlock(&pkt, sizeof(pkt));
+}
+
+// Write the write statistics of the storage backend, if it keeps any
+void DataFlash_Class::Log_Write_Storage()
+{
+    AP_HAL::Storage::Stats stats;
+    if (!hal.storage->get_stats(stats)) {
+        return;
+    }
+    struct log_Storage pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_STOR_MSG),
+        time_us       : AP_HAL::micros64(),
+        bytes_changed : stats.bytes_changed,
+        bytes_written : stats.bytes_written,
+        flushes       : stats.flushes,
+        flush_max_us  : stats.flush_max_us,
+        errors        : stats.errors
+    };
+    WriteBlock(&pkt, sizeof(pkt));
+}
+
+// write the percentiles of each scheduler timing histogram with samples
+void DataFlash_Class::Log_Write_Scheduler_Timing(const AP_Scheduler &scheduler)
+{
+    for (uint8_t id=0; id<scheduler.num_histograms(); id++) {
+        const AP_TimeHistogram *hist = scheduler.get_histogram(id);
+        if (hist == nullptr || hist->count() == 0) {
+            continue;
+        }
+        struct log_PMH pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_PMH_MSG),
+            time_us : AP_HAL::micros64(),
+            id      : id,
+            name    : {},
+            count   : hist->count(),
+            p50     : hist->percentile(0.5f),
+            p99     : hist->percentile(0.99f),
+            p999    : hist->percentile(0.999f),
+            max     : hist->max_us()
+        };
+        strncpy(pkt.name, scheduler.histogram_name(id), sizeof(pkt.name));
+        WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+
+// write the HAL perf counters that have been used since the last reset
+void DataFlash_Class::Log_Write_Perf_Counters()
+{
+    const uint16_t n = hal.util->perf_num_counters();
+    for (uint16_t i=0; i<n && i<256; i++) {
+        AP_HAL::Util::perf_counter_info info;
+        if (!hal.util->perf_get_info(i, info) || info.count == 0) {
+            continue;
+        }
+        struct log_PRF pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_PRF_MSG),
+            time_us : AP_HAL::micros64(),
+            id      : (uint8_t)i,
+            name    : {},
+            count   : (uint32_t)info.count,
+            min     : info.min_us,
+            max     : info.max_us,
+            avg     : info.avg_us,
+            stddev  : info.stddev_us
+        };
+        strncpy(pkt.name, info.name, sizeof(pkt.name));
+        WriteBlock(&pkt, sizeof(pkt));
+    }
+}
@@ -476,6 +476,15 @@ struct PACKED log_TERRAIN {
     uint16_t loaded;
 };
 
+// terrain grid cache statistics, kept out of TERR to fit its labels
+struct PACKED log_TerrainCache {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t prefetches;
+};
+
 /*
   UBlox logging
  */
@@ -629,6 +638,88 @@ struct PACKED log_RPM {
     float rpm2;
 };
 
+struct PACKED log_Spectrum {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t channel;
+    float sample_rate;
+    float freq1;
+    float amp1;
+    float freq2;
+    float amp2;
+    float freq3;
+    float amp3;
+};
+
+struct PACKED log_ParamStorage {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t load_all_us;
+    uint16_t stored_count;
+    uint16_t storage_used;
+    uint32_t save_count;
+    uint32_t save_max_us;
+    uint32_t save_avg_us;
+};
+
+struct PACKED log_Storage {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t bytes_changed;
+    uint32_t bytes_written;
+    uint32_t flushes;
+    uint32_t flush_max_us;
+    uint32_t errors;
+};
+
+struct PACKED log_NKT {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t core;
+    uint8_t stage;
+    uint16_t count;
+    uint16_t fusions;
+    float min_us;
+    float avg_us;
+    float max_us;
+};
+
+// a piece of a checkpoint of an EKF2 core, see EK2_CKPT
+struct PACKED log_NKC {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t core;
+    uint8_t seq;
+    uint8_t count;
+    char data[64];  // EKF2_CHECKPOINT_CHUNK
+};
+
+// percentiles of a scheduler timing histogram, see SCHED_TASK_HIST
+struct PACKED log_PMH {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t id;
+    char name[16];
+    uint32_t count;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t p999;
+    uint32_t max;
+};
+
+// a HAL perf counter since the last reset, times in microseconds
+struct PACKED log_PRF {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t id;
+    char name[16];
+    uint32_t count;
+    float min;
+    float max;
+    float avg;
+    float stddev;
+};
+
 // #if SBP_HW_LOGGING
 
 struct PACKED log_SbpLLH {
@@ -784,6 +875,8 @@ Format characters in the format string for binary log messages
       "NKF9","QcccccfbbBBHHb","TimeUS,SV,SP,SH,SM,SVT,errRP,OFN,OFE,FS,TS,SS,GPS,PI" }, \
     { LOG_TERRAIN_MSG, sizeof(log_TERRAIN), \
       "TERR","QBLLHffHH","TimeUS,Status,Lat,Lng,Spacing,TerrH,CHeight,Pending,Loaded" }, \
+    { LOG_TRCS_MSG, sizeof(log_TerrainCache), \
+      "TRCS","QIII","TimeUS,Hit,Miss,Pref" }, \
     { LOG_GPS_UBX1_MSG, sizeof(log_Ubx1), \
       "UBX1", "QBHBBH",  "TimeUS,Instance,noisePerMS,jamInd,aPower,agcCnt" }, \
     { LOG_GPS_UBX2_MSG, sizeof(log_Ubx2), \
@@ -858,6 +951,20 @@ Format characters in the format string for binary log messages
       "ORGN","QBLLe","TimeUS,Type,Lat,Lng,Alt" }, \
     { LOG_RPM_MSG, sizeof(log_RPM), \
       "RPM",  "Qff", "TimeUS,rpm1,rpm2" }, \
+    { LOG_SPEC_MSG, sizeof(log_Spectrum), \
+      "SPEC", "QBfffffff", "TimeUS,Chan,Rate,F1,A1,F2,A2,F3,A3" }, \
+    { LOG_PSTO_MSG, sizeof(log_ParamStorage), \
+      "PSTO", "QIHHIII", "TimeUS,LoadUS,NStor,Used,NSave,SvMax,SvAvg" }, \
+    { LOG_STOR_MSG, sizeof(log_Storage), \
+      "STOR", "QIIIII", "TimeUS,Chg,Wrt,NFlush,FlMax,Err" }, \
+    { LOG_NKT_MSG, sizeof(log_NKT), \
+      "NKT", "QBBHHfff", "TimeUS,C,Stage,N,NFus,Min,Avg,Max" }, \
+    { LOG_NKC_MSG, sizeof(log_NKC), \
+      "NKC", "QBBBZ", "TimeUS,C,Seq,NSeq,Data" }, \
+    { LOG_PMH_MSG, sizeof(log_PMH), \
+      "PMH", "QBNIIIII", "TimeUS,Id,Name,N,P50,P99,P999,Max" }, \
+    { LOG_PRF_MSG, sizeof(log_PRF), \
+      "PRF", "QBNIffff", "TimeUS,Id,Name,N,Min,Max,Avg,SD" }, \
     { LOG_GIMBAL1_MSG, sizeof(log_Gimbal1), \
       "GMB1", "Iffffffffff", "TimeMS,dt,dax,day,daz,dvx,dvy,dvz,jx,jy,jz" }, \
     { LOG_GIMBAL2_MSG, sizeof(log_Gimbal2), \
@@ -977,6 +1084,15 @@ enum LogMessages {
     LOG_GIMBAL2_MSG,
     LOG_GIMBAL3_MSG,
 
+    LOG_SPEC_MSG,
+    LOG_PSTO_MSG,
+    LOG_STOR_MSG,
+    LOG_NKT_MSG,
+    LOG_NKC_MSG,
+    LOG_PMH_MSG,
+    LOG_PRF_MSG,
+    LOG_TRCS_MSG,
+
 // message types 211 to 220 reversed for autotune use
 
 };
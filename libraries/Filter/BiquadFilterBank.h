@@ -0,0 +1,243 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file   BiquadFilterBank.h
+/// @brief  A bank of cascaded biquad filters over many channels.
+///
+/// Coefficients and state are kept as structure-of-arrays, one array
+/// per coefficient indexed by channel, so the inner loop over channels
+/// is a straight run of independent multiply-adds that the compiler
+/// can vectorise. Each channel runs NUM_SECTIONS biquads in series,
+/// e.g. a notch followed by a low pass. Sections that are not
+/// configured pass samples through unchanged.
+///
+/// The per-section maths is the same direct form II used by
+/// DigitalBiquadFilter, so a low pass section gives results identical
+/// to LowPassFilter2p.
+#pragma once
+
+#include <AP_Math/AP_Math.h>
+#include <inttypes.h>
+
+template <uint8_t NUM_CHANNELS, uint8_t NUM_SECTIONS>
+class BiquadFilterBank {
+public:
+    BiquadFilterBank();
+
+    // configure a 2nd order butterworth low pass section on a group of
+    // channels. A zero cutoff makes the section a pass-through
+    void set_lowpass(uint8_t section, uint8_t first_channel, uint8_t num_channels,
+                     float sample_freq, float cutoff_freq);
+
+    // configure a notch section on a group of channels
+    void set_notch(uint8_t section, uint8_t first_channel, uint8_t num_channels,
+                   float sample_freq, float center_freq, float bandwidth, float attenuation_dB);
+
+    // make a section of a group of channels pass samples unchanged
+    void set_passthrough(uint8_t section, uint8_t first_channel, uint8_t num_channels);
+
+    /*
+      filter num_samples frames of interleaved samples in place. Each
+      frame holds num_channels values for channels first_channel
+      onwards, so data has num_samples * num_channels elements. data
+      must not overlap the bank
+     */
+    void apply(float * __restrict data, uint8_t first_channel, uint8_t num_channels, uint16_t num_samples);
+
+    // filter one sample of three consecutive channels, as a drop-in
+    // for LowPassFilter2pVector3f
+    Vector3f apply(uint8_t first_channel, const Vector3f &sample);
+
+    // clear the filter state of a group of channels
+    void reset(uint8_t first_channel, uint8_t num_channels);
+    void reset() { reset(0, NUM_CHANNELS); }
+
+    // return the settings last used for a section of a channel
+    float get_sample_freq(uint8_t section, uint8_t channel) const { return _sample_freq[section][channel]; }
+    float get_center_freq(uint8_t section, uint8_t channel) const { return _center_freq[section][channel]; }
+
+private:
+    struct coefficients {
+        float b0;
+        float b1;
+        float b2;
+        float a1;
+        float a2;
+    };
+
+    void _set_section(uint8_t section, uint8_t first_channel, uint8_t num_channels,
+                      const struct coefficients &c, float sample_freq, float center_freq);
+
+    // clamp a channel group to the bank size, returning the end channel
+    uint8_t _end_channel(uint8_t first_channel, uint8_t num_channels) const {
+        uint16_t end = (uint16_t)first_channel + num_channels;
+        return end > NUM_CHANNELS ? NUM_CHANNELS : end;
+    }
+
+    float _b0[NUM_SECTIONS][NUM_CHANNELS] __attribute__((aligned(16)));
+    float _b1[NUM_SECTIONS][NUM_CHANNELS] __attribute__((aligned(16)));
+    float _b2[NUM_SECTIONS][NUM_CHANNELS] __attribute__((aligned(16)));
+    float _a1[NUM_SECTIONS][NUM_CHANNELS] __attribute__((aligned(16)));
+    float _a2[NUM_SECTIONS][NUM_CHANNELS] __attribute__((aligned(16)));
+    float _delay_element_1[NUM_SECTIONS][NUM_CHANNELS] __attribute__((aligned(16)));
+    float _delay_element_2[NUM_SECTIONS][NUM_CHANNELS] __attribute__((aligned(16)));
+
+    float _sample_freq[NUM_SECTIONS][NUM_CHANNELS];
+    float _center_freq[NUM_SECTIONS][NUM_CHANNELS];
+};
+
+template <uint8_t NUM_CHANNELS, uint8_t NUM_SECTIONS>
+BiquadFilterBank<NUM_CHANNELS, NUM_SECTIONS>::BiquadFilterBank()
+{
+    for (uint8_t s = 0; s < NUM_SECTIONS; s++) {
+        set_passthrough(s, 0, NUM_CHANNELS);
+    }
+    reset();
+}
+
+template <uint8_t NUM_CHANNELS, uint8_t NUM_SECTIONS>
+void BiquadFilterBank<NUM_CHANNELS, NUM_SECTIONS>::_set_section(uint8_t section, uint8_t first_channel,
+                                                                uint8_t num_channels,
+                                                                const struct coefficients &c,
+                                                                float sample_freq, float center_freq)
+{
+    if (section >= NUM_SECTIONS) {
+        return;
+    }
+    const uint8_t end = _end_channel(first_channel, num_channels);
+    for (uint8_t i = first_channel; i < end; i++) {
+        _b0[section][i] = c.b0;
+        _b1[section][i] = c.b1;
+        _b2[section][i] = c.b2;
+        _a1[section][i] = c.a1;
+        _a2[section][i] = c.a2;
+        _sample_freq[section][i] = sample_freq;
+        _center_freq[section][i] = center_freq;
+    }
+}
+
+template <uint8_t NUM_CHANNELS, uint8_t NUM_SECTIONS>
+void BiquadFilterBank<NUM_CHANNELS, NUM_SECTIONS>::set_passthrough(uint8_t section, uint8_t first_channel,
+                                                                   uint8_t num_channels)
+{
+    const struct coefficients c = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    _set_section(section, first_channel, num_channels, c, 0.0f, 0.0f);
+}
+
+template <uint8_t NUM_CHANNELS, uint8_t NUM_SECTIONS>
+void BiquadFilterBank<NUM_CHANNELS, NUM_SECTIONS>::set_lowpass(uint8_t section, uint8_t first_channel,
+                                                               uint8_t num_channels,
+                                                               float sample_freq, float cutoff_freq)
+{
+    if (cutoff_freq <= 0.0f || sample_freq <= 0.0f) {
+        set_passthrough(section, first_channel, num_channels);
+        return;
+    }
+
+    // same coefficients as DigitalBiquadFilter::compute_params()
+    float fr = sample_freq/cutoff_freq;
+    float ohm = tanf(PI/fr);
+    float c = 1.0f+2.0f*cosf(PI/4.0f)*ohm + ohm*ohm;
+
+    struct coefficients coeffs;
+    coeffs.b0 = ohm*ohm/c;
+    coeffs.b1 = 2.0f*coeffs.b0;
+    coeffs.b2 = coeffs.b0;
+    coeffs.a1 = 2.0f*(ohm*ohm-1.0f)/c;
+    coeffs.a2 = (1.0f-2.0f*cosf(PI/4.0f)*ohm+ohm*ohm)/c;
+
+    _set_section(section, first_channel, num_channels, coeffs, sample_freq, cutoff_freq);
+}
+
+template <uint8_t NUM_CHANNELS, uint8_t NUM_SECTIONS>
+void BiquadFilterBank<NUM_CHANNELS, NUM_SECTIONS>::set_notch(uint8_t section, uint8_t first_channel,
+                                                             uint8_t num_channels, float sample_freq,
+                                                             float center_freq, float bandwidth,
+                                                             float attenuation_dB)
+{
+    if (center_freq <= 0.0f || sample_freq <= 0.0f ||
+        bandwidth <= 0.0f || bandwidth >= 2.0f * center_freq ||
+        center_freq >= 0.5f * sample_freq) {
+        set_passthrough(section, first_channel, num_channels);
+        return;
+    }
+
+    // notch with finite depth, derived from the RBJ audio EQ cookbook
+    float omega = 2.0f * PI * center_freq / sample_freq;
+    float octaves = log2f(center_freq / (center_freq - bandwidth/2.0f)) * 2.0f;
+    float A = powf(10.0f, -attenuation_dB/40.0f);
+    float Q = sqrtf(powf(2.0f, octaves)) / (powf(2.0f, octaves) - 1.0f);
+    float alpha = sinf(omega) / (2.0f * Q/A);
+    float a0_inv = 1.0f / (1.0f + alpha);
+
+    struct coefficients coeffs;
+    coeffs.b0 = (1.0f + alpha*A*A) * a0_inv;
+    coeffs.b1 = -2.0f * cosf(omega) * a0_inv;
+    coeffs.b2 = (1.0f - alpha*A*A) * a0_inv;
+    coeffs.a1 = coeffs.b1;
+    coeffs.a2 = (1.0f - alpha) * a0_inv;
+
+    _set_section(section, first_channel, num_channels, coeffs, sample_freq, center_freq);
+}
+
+template <uint8_t NUM_CHANNELS, uint8_t NUM_SECTIONS>
+void BiquadFilterBank<NUM_CHANNELS, NUM_SECTIONS>::reset(uint8_t first_channel, uint8_t num_channels)
+{
+    const uint8_t end = _end_channel(first_channel, num_channels);
+    for (uint8_t s = 0; s < NUM_SECTIONS; s++) {
+        for (uint8_t i = first_channel; i < end; i++) {
+            _delay_element_1[s][i] = 0.0f;
+            _delay_element_2[s][i] = 0.0f;
+        }
+    }
+}
+
+template <uint8_t NUM_CHANNELS, uint8_t NUM_SECTIONS>
+void BiquadFilterBank<NUM_CHANNELS, NUM_SECTIONS>::apply(float * __restrict data, uint8_t first_channel,
+                                                         uint8_t num_channels, uint16_t num_samples)
+{
+    const uint8_t end = _end_channel(first_channel, num_channels);
+    const uint8_t n = end > first_channel ? end - first_channel : 0;
+
+    for (uint16_t k = 0; k < num_samples; k++) {
+        float * __restrict frame = &data[k * num_channels];
+        for (uint8_t s = 0; s < NUM_SECTIONS; s++) {
+            const float * __restrict b0 = &_b0[s][first_channel];
+            const float * __restrict b1 = &_b1[s][first_channel];
+            const float * __restrict b2 = &_b2[s][first_channel];
+            const float * __restrict a1 = &_a1[s][first_channel];
+            const float * __restrict a2 = &_a2[s][first_channel];
+            float * __restrict d1 = &_delay_element_1[s][first_channel];
+            float * __restrict d2 = &_delay_element_2[s][first_channel];
+
+            // no dependency between channels, so this loop vectorises
+            for (uint8_t i = 0; i < n; i++) {
+                float d0 = frame[i] - d1[i] * a1[i] - d2[i] * a2[i];
+                frame[i] = d0 * b0[i] + d1[i] * b1[i] + d2[i] * b2[i];
+                d2[i] = d1[i];
+                d1[i] = d0;
+            }
+        }
+    }
+}
+
+template <uint8_t NUM_CHANNELS, uint8_t NUM_SECTIONS>
+Vector3f BiquadFilterBank<NUM_CHANNELS, NUM_SECTIONS>::apply(uint8_t first_channel, const Vector3f &sample)
+{
+    float v[3] = { sample.x, sample.y, sample.z };
+    apply(v, first_channel, 3, 1);
+    return Vector3f(v[0], v[1], v[2]);
+}
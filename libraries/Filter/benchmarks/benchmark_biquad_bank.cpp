@@ -0,0 +1,105 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <Filter/BiquadFilterBank.h>
+#include <Filter/LowPassFilter2p.h>
+
+#define BM_INSTANCES 6
+#define BM_CHANNELS (3 * BM_INSTANCES)
+#define BM_MAX_SAMPLES 8
+
+/*
+ * Filter 3 accel and 3 gyro instances (18 channels) for a number of samples,
+ * one LowPassFilter2pVector3f per instance as the INS frontend used to
+ */
+static void BM_LowPassFilter2pVector3f(benchmark::State& state)
+{
+    LowPassFilter2pVector3f filters[BM_INSTANCES];
+    Vector3f samples[BM_INSTANCES];
+
+    for (uint8_t i = 0; i < BM_INSTANCES; i++) {
+        filters[i].set_cutoff_frequency(1000, 20);
+        samples[i] = Vector3f(0.1f * i, 0.2f, -9.8f);
+    }
+
+    while (state.KeepRunning()) {
+        for (uint16_t k = 0; k < state.range_x(); k++) {
+            for (uint8_t i = 0; i < BM_INSTANCES; i++) {
+                Vector3f out = filters[i].apply(samples[i]);
+                gbenchmark_escape(&out);
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_LowPassFilter2pVector3f)->Arg(1)->Arg(BM_MAX_SAMPLES);
+
+/*
+ * Same work with a single low pass section per channel in a filter bank
+ */
+static void BM_BiquadFilterBankLowPass(benchmark::State& state)
+{
+    BiquadFilterBank<BM_CHANNELS, 1> bank;
+    float data[BM_CHANNELS * BM_MAX_SAMPLES];
+
+    bank.set_lowpass(0, 0, BM_CHANNELS, 1000, 20);
+    for (uint16_t i = 0; i < BM_CHANNELS * BM_MAX_SAMPLES; i++) {
+        data[i] = 0.1f * i;
+    }
+
+    while (state.KeepRunning()) {
+        bank.apply(data, 0, BM_CHANNELS, state.range_x());
+        gbenchmark_escape(data);
+    }
+}
+
+BENCHMARK(BM_BiquadFilterBankLowPass)->Arg(1)->Arg(BM_MAX_SAMPLES);
+
+/*
+ * Per-instance Vector3f calls, as the INS backends make them
+ */
+static void BM_BiquadFilterBankVector3f(benchmark::State& state)
+{
+    BiquadFilterBank<BM_CHANNELS, 1> bank;
+    Vector3f samples[BM_INSTANCES];
+
+    bank.set_lowpass(0, 0, BM_CHANNELS, 1000, 20);
+    for (uint8_t i = 0; i < BM_INSTANCES; i++) {
+        samples[i] = Vector3f(0.1f * i, 0.2f, -9.8f);
+    }
+
+    while (state.KeepRunning()) {
+        for (uint16_t k = 0; k < state.range_x(); k++) {
+            for (uint8_t i = 0; i < BM_INSTANCES; i++) {
+                Vector3f out = bank.apply(i * 3, samples[i]);
+                gbenchmark_escape(&out);
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_BiquadFilterBankVector3f)->Arg(1)->Arg(BM_MAX_SAMPLES);
+
+/*
+ * Cascaded notch and low pass on every channel
+ */
+static void BM_BiquadFilterBankNotchLowPass(benchmark::State& state)
+{
+    BiquadFilterBank<BM_CHANNELS, 2> bank;
+    float data[BM_CHANNELS * BM_MAX_SAMPLES];
+
+    bank.set_notch(0, 0, BM_CHANNELS, 1000, 80, 20, 40);
+    bank.set_lowpass(1, 0, BM_CHANNELS, 1000, 20);
+    for (uint16_t i = 0; i < BM_CHANNELS * BM_MAX_SAMPLES; i++) {
+        data[i] = 0.1f * i;
+    }
+
+    while (state.KeepRunning()) {
+        bank.apply(data, 0, BM_CHANNELS, state.range_x());
+        gbenchmark_escape(data);
+    }
+}
+
+BENCHMARK(BM_BiquadFilterBankNotchLowPass)->Arg(1)->Arg(BM_MAX_SAMPLES);
+
+BENCHMARK_MAIN()
@@ -17,6 +17,7 @@
 #include "MAVLink_routing.h"
 #include <AP_SerialManager/AP_SerialManager.h>
 #include <AP_Mount/AP_Mount.h>
+#include <AP_Param/AP_ParamBlob.h>
 
 // check if a message will fit in the payload space available
 #define HAVE_PAYLOAD_SPACE(chan, id) (comm_get_txspace(chan) >= MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_MSG_ID_ ## id ## _LEN)
@@ -69,6 +70,11 @@ enum ap_message {
     MSG_VIBRATION,
     MSG_RPM,
     MSG_MISSION_ITEM_REACHED,
+    MSG_VIBRATION_PEAKS,
+    MSG_ADSB_THREAT,
+    MSG_EKF_TIMING,
+    MSG_LOOP_TIMING,
+    MSG_PERF_COUNTER,
     MSG_RETRY_DEFERRED // this must be last
 };
 
@@ -269,6 +275,20 @@ private:
     // start page of log data
     uint16_t _log_data_page;
 
+    // bulk parameter transfer. Only one link at a time can download
+    // the parameter blob
+    static AP_ParamBlob _param_blob;
+    static int8_t _param_blob_chan;
+    uint8_t  _param_blob_sending:1;
+    uint8_t  _param_blob_sysid;
+    uint8_t  _param_blob_compid;
+    uint8_t  _param_blob_window;
+    uint8_t  _param_blob_retries;
+    uint16_t _param_blob_next_seq;      // next chunk to send
+    uint16_t _param_blob_acked;         // first chunk not acknowledged
+    uint32_t _param_blob_ack_ms;        // time of the last progress
+    uint16_t _param_blob_upload_seq;    // next chunk expected in an upload
+
     // deferred message handling
     enum ap_message deferred_messages[MSG_RETRY_DEFERRED];
     uint8_t next_deferred_message;
@@ -298,6 +318,12 @@ private:
     void handle_log_send_listing(DataFlash_Class &dataflash);
     bool handle_log_send_data(DataFlash_Class &dataflash);
 
+    void handle_param_blob_message(mavlink_message_t *msg, DataFlash_Class *DataFlash);
+    void handle_param_blob_request(mavlink_message_t *msg);
+    void handle_param_blob_ack(mavlink_message_t *msg);
+    void handle_param_blob_data(mavlink_message_t *msg, DataFlash_Class *DataFlash);
+    void handle_param_blob_send(void);
+
     void handle_mission_request_list(AP_Mission &mission, mavlink_message_t *msg);
     void handle_mission_request(AP_Mission &mission, mavlink_message_t *msg);
 
@@ -311,6 +337,7 @@ private:
     void handle_param_request_list(mavlink_message_t *msg);
     void handle_param_request_read(mavlink_message_t *msg);
     void handle_param_set(mavlink_message_t *msg, DataFlash_Class *DataFlash);
+    void set_parameter(const char *key, float value, DataFlash_Class *DataFlash);
     void handle_radio_status(mavlink_message_t *msg, DataFlash_Class &dataflash, bool log_radio);
     void handle_serial_control(mavlink_message_t *msg, AP_GPS &gps);
     void lock_channel(mavlink_channel_t chan, bool lock);
@@ -545,23 +545,31 @@ void GCS_MAVLINK::handle_param_set(mavlink_message_t *msg, DataFlash_Class *Data
 {
     mavlink_param_set_t packet;
     mavlink_msg_param_set_decode(msg, &packet);
-    enum ap_var_type var_type;
 
     // set parameter
-    AP_Param *vp;
     char key[AP_MAX_NAME_SIZE+1];
     strncpy(key, (char *)packet.param_id, AP_MAX_NAME_SIZE);
     key[AP_MAX_NAME_SIZE] = 0;
 
+    set_parameter(key, packet.param_value, DataFlash);
+}
+
+/*
+  set, save and log a parameter by name
+ */
+void GCS_MAVLINK::set_parameter(const char *key, float value, DataFlash_Class *DataFlash)
+{
+    enum ap_var_type var_type;
+
     // find existing param so we can get the old value
-    vp = AP_Param::find(key, &var_type);
+    AP_Param *vp = AP_Param::find(key, &var_type);
     if (vp == NULL) {
         return;
     }
     float old_value = vp->cast_to_float(var_type);
 
     // set the value
-    vp->set_float(packet.param_value, var_type);
+    vp->set_float(value, var_type);
 
     /*
       we force the save if the value is not equal to the old
@@ -570,7 +578,7 @@ void GCS_MAVLINK::handle_param_set(mavlink_message_t *msg, DataFlash_Class *Data
       default value which differs from the constructor value doesn't
       save the change
      */
-    bool force_save = !is_equal(packet.param_value, old_value);
+    bool force_save = !is_equal(value, old_value);
 
     // save the change
     vp->save(force_save);
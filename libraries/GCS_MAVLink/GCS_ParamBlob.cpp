@@ -0,0 +1,254 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+  MAVLink bulk parameter transfer functions
+ */
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  The client starts a download with PARAM_BLOB_REQUEST. The vehicle
+  then sends PARAM_BLOB_DATA chunks, keeping at most a window of
+  chunks unacknowledged, and the client acknowledges them with
+  PARAM_BLOB_ACK carrying the next chunk it expects. Chunks that are
+  not acknowledged in time are sent again from the first missing one.
+
+  An upload is a sequence of PARAM_BLOB_DATA chunks from the client,
+  each of which the vehicle applies and acknowledges.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include "GCS.h"
+
+extern const AP_HAL::HAL& hal;
+
+// parameters added to the snapshot per call while preparing a download
+#define PARAM_BLOB_PREPARE_BATCH    50
+
+#define PARAM_BLOB_DEFAULT_WINDOW   4
+#define PARAM_BLOB_MAX_WINDOW       32
+#define PARAM_BLOB_TIMEOUT_MS       1000
+#define PARAM_BLOB_MAX_RETRIES      10
+
+AP_ParamBlob GCS_MAVLINK::_param_blob;
+int8_t GCS_MAVLINK::_param_blob_chan = -1;
+
+/**
+   handle all types of bulk parameter transfer messages
+ */
+void GCS_MAVLINK::handle_param_blob_message(mavlink_message_t *msg, DataFlash_Class *DataFlash)
+{
+    switch (msg->msgid) {
+    case MAVLINK_MSG_ID_PARAM_BLOB_REQUEST:
+        handle_param_blob_request(msg);
+        break;
+    case MAVLINK_MSG_ID_PARAM_BLOB_ACK:
+        handle_param_blob_ack(msg);
+        break;
+    case MAVLINK_MSG_ID_PARAM_BLOB_DATA:
+        handle_param_blob_data(msg, DataFlash);
+        break;
+    }
+}
+
+/**
+   start a download of the parameter blob
+ */
+void GCS_MAVLINK::handle_param_blob_request(mavlink_message_t *msg)
+{
+    mavlink_param_blob_request_t packet;
+    mavlink_msg_param_blob_request_decode(msg, &packet);
+
+    _param_blob_sending = false;
+    if (!_param_blob.start(packet.base_hash,
+                           (packet.flags & PARAM_BLOB_FLAG_COMPRESSED) != 0,
+                           MAVLINK_MSG_PARAM_BLOB_DATA_FIELD_DATA_LEN)) {
+        // a download running on another link carries on, unless the
+        // failed start took its snapshot with it
+        if (_param_blob_chan == chan) {
+            _param_blob_chan = -1;
+        }
+        mavlink_msg_param_blob_ack_send(chan, msg->sysid, msg->compid, 0, PARAM_BLOB_STATUS_FAILED);
+        return;
+    }
+
+    _param_blob_window = packet.window;
+    if (_param_blob_window == 0) {
+        _param_blob_window = PARAM_BLOB_DEFAULT_WINDOW;
+    } else if (_param_blob_window > PARAM_BLOB_MAX_WINDOW) {
+        _param_blob_window = PARAM_BLOB_MAX_WINDOW;
+    }
+    _param_blob_sysid = msg->sysid;
+    _param_blob_compid = msg->compid;
+    _param_blob_next_seq = 0;
+    _param_blob_acked = 0;
+    _param_blob_retries = 0;
+    _param_blob_ack_ms = AP_HAL::millis();
+    _param_blob_chan = chan;
+    _param_blob_sending = true;
+}
+
+/**
+   handle an acknowledgement of downloaded chunks
+ */
+void GCS_MAVLINK::handle_param_blob_ack(mavlink_message_t *msg)
+{
+    mavlink_param_blob_ack_t packet;
+    mavlink_msg_param_blob_ack_decode(msg, &packet);
+
+    if (!_param_blob_sending || _param_blob_chan != chan) {
+        return;
+    }
+
+    if (packet.status != PARAM_BLOB_STATUS_PROGRESS) {
+        // complete or cancelled
+        _param_blob_sending = false;
+        _param_blob_chan = -1;
+        return;
+    }
+
+    if (packet.seq > _param_blob_acked && packet.seq <= _param_blob_next_seq) {
+        _param_blob_acked = packet.seq;
+        _param_blob_ack_ms = AP_HAL::millis();
+        _param_blob_retries = 0;
+    }
+
+    uint16_t num_chunks = _param_blob.get_num_chunks();
+    if (num_chunks != 0 && _param_blob_acked >= num_chunks) {
+        _param_blob_sending = false;
+        _param_blob_chan = -1;
+    }
+}
+
+/**
+   apply an uploaded chunk of parameters
+ */
+void GCS_MAVLINK::handle_param_blob_data(mavlink_message_t *msg, DataFlash_Class *DataFlash)
+{
+    mavlink_param_blob_data_t packet;
+    mavlink_msg_param_blob_data_decode(msg, &packet);
+
+    if (packet.seq == 0) {
+        // start of a new upload
+        _param_blob_upload_seq = 0;
+    }
+
+    if (packet.seq == _param_blob_upload_seq) {
+        bool compressed = (packet.flags & PARAM_BLOB_FLAG_COMPRESSED) != 0;
+        uint8_t len = MIN(packet.len, sizeof(packet.data));
+        uint8_t ofs = 0;
+        char name[AP_MAX_NAME_SIZE+1] = "";
+        while (ofs < len) {
+            enum ap_var_type type;
+            float value;
+            uint8_t n = AP_ParamBlob::decode_entry(&packet.data[ofs], len - ofs, compressed, name, type, value);
+            if (n == 0) {
+                break;
+            }
+            ofs += n;
+            set_parameter(name, value, DataFlash);
+        }
+        _param_blob_upload_seq++;
+    }
+
+    // chunks already applied are acknowledged again, and chunks after
+    // a missing one ask for the missing one
+    uint8_t status = PARAM_BLOB_STATUS_PROGRESS;
+    if ((packet.flags & PARAM_BLOB_FLAG_LAST) && packet.seq < _param_blob_upload_seq) {
+        status = PARAM_BLOB_STATUS_COMPLETE;
+    }
+    mavlink_msg_param_blob_ack_send(chan, msg->sysid, msg->compid, _param_blob_upload_seq, status);
+}
+
+/**
+   send the next chunks of a download, called at 50Hz
+ */
+void GCS_MAVLINK::handle_param_blob_send(void)
+{
+    if (!_param_blob_sending) {
+        return;
+    }
+    if (_param_blob_chan != chan) {
+        // another link has started a download
+        _param_blob_sending = false;
+        return;
+    }
+    if (_param_blob.idle()) {
+        // a failed request on another link freed the snapshot
+        mavlink_msg_param_blob_ack_send(chan, _param_blob_sysid, _param_blob_compid,
+                                        _param_blob_next_seq, PARAM_BLOB_STATUS_FAILED);
+        _param_blob_sending = false;
+        _param_blob_chan = -1;
+        return;
+    }
+    if (!_param_blob.prepare(PARAM_BLOB_PREPARE_BATCH)) {
+        return;
+    }
+
+    uint32_t now = AP_HAL::millis();
+    if (_param_blob_next_seq != _param_blob_acked &&
+        now - _param_blob_ack_ms > PARAM_BLOB_TIMEOUT_MS) {
+        if (++_param_blob_retries > PARAM_BLOB_MAX_RETRIES) {
+            _param_blob_sending = false;
+            _param_blob_chan = -1;
+            return;
+        }
+        // go back to the first chunk not acknowledged
+        _param_blob_next_seq = _param_blob_acked;
+        _param_blob_ack_ms = now;
+    }
+
+    while ((uint16_t)(_param_blob_next_seq - _param_blob_acked) < _param_blob_window &&
+           HAVE_PAYLOAD_SPACE(chan, PARAM_BLOB_DATA)) {
+        uint8_t data[MAVLINK_MSG_PARAM_BLOB_DATA_FIELD_DATA_LEN];
+        bool last;
+        int16_t len = _param_blob.get_chunk(_param_blob_next_seq, data, last);
+        if (len < 0) {
+            uint16_t num_chunks = _param_blob.get_num_chunks();
+            if (num_chunks == 0 || _param_blob_next_seq < num_chunks) {
+                // the parameter tree changed shape during the
+                // download, the client needs to start again
+                mavlink_msg_param_blob_ack_send(chan, _param_blob_sysid, _param_blob_compid,
+                                                _param_blob_next_seq, PARAM_BLOB_STATUS_FAILED);
+                _param_blob_sending = false;
+                _param_blob_chan = -1;
+            }
+            // otherwise everything has been sent
+            break;
+        }
+
+        uint8_t flags = 0;
+        if (_param_blob.compressed()) {
+            flags |= PARAM_BLOB_FLAG_COMPRESSED;
+        }
+        if (_param_blob.is_diff()) {
+            flags |= PARAM_BLOB_FLAG_DIFF;
+        }
+        if (last) {
+            flags |= PARAM_BLOB_FLAG_LAST;
+        }
+        mavlink_msg_param_blob_data_send(
+            chan,
+            _param_blob_sysid,
+            _param_blob_compid,
+            _param_blob_next_seq,
+            _param_blob.get_count(),
+            _param_blob.get_hash(),
+            flags,
+            len,
+            data);
+        _param_blob_next_seq++;
+    }
+}
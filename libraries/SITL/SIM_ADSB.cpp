@@ -25,8 +25,10 @@
 
 namespace SITL {
 
-ADSB::ADSB(const struct sitl_fdm &_fdm, const char *_home_str) :
-    fdm(_fdm)
+ADSB::ADSB(const struct sitl_fdm &_fdm, const char *_home_str, uint16_t _target_port, const World *_world) :
+    fdm(_fdm),
+    target_port(_target_port),
+    world(_world)
 {
     float yaw_degrees;
     Aircraft::parse_home(_home_str, home, yaw_degrees);
@@ -189,18 +191,59 @@ void ADSB::send_report(void)
                 ADSB_FLAGS_SIMULATED;
             adsb_vehicle.squawk = 0; // NOTE: ADSB_FLAGS_VALID_SQUAWK bit is not set
 
-            mavlink_status_t *chan0_status = mavlink_get_channel_status(MAVLINK_COMM_0);
-            uint8_t saved_seq = chan0_status->current_tx_seq;
-            chan0_status->current_tx_seq = mavlink.seq;
-            len = mavlink_msg_adsb_vehicle_encode(vehicle_system_id,
-                                                  MAV_COMP_ID_ADSB,
-                                                  &msg, &adsb_vehicle);
-            chan0_status->current_tx_seq = saved_seq;
-            
-            mav_socket.send(&msg.magic, len);
+            send_adsb_vehicle(adsb_vehicle);
+        }
+
+        // the other vehicles in the world, as they are now
+        for (uint8_t i=0; world != NULL && i<World::max_vehicles; i++) {
+            World::Vehicle vehicle;
+            if (!world->get_vehicle(i, vehicle)) {
+                continue;
+            }
+            mavlink_adsb_vehicle_t adsb_vehicle {};
+            last_report_us = now_us;
+
+            adsb_vehicle.ICAO_address = vehicle.ICAO_address;
+            adsb_vehicle.lat = vehicle.latitude * 1.0e7;
+            adsb_vehicle.lon = vehicle.longitude * 1.0e7;
+            adsb_vehicle.altitude_type = ADSB_ALTITUDE_TYPE_PRESSURE_QNH;
+            adsb_vehicle.altitude = vehicle.altitude * 1000;
+            adsb_vehicle.heading = wrap_360_cd(100*degrees(atan2f(vehicle.speedE, vehicle.speedN))) / 100;
+            adsb_vehicle.hor_velocity = pythagorous2(vehicle.speedN, vehicle.speedE) * 100;
+            adsb_vehicle.ver_velocity = -vehicle.speedD * 100;
+            memcpy(adsb_vehicle.callsign, vehicle.callsign, sizeof(adsb_vehicle.callsign));
+            adsb_vehicle.emitter_type = ADSB_EMITTER_TYPE_UAV;
+            adsb_vehicle.tslc = 1;
+            adsb_vehicle.flags =
+                ADSB_FLAGS_VALID_COORDS |
+                ADSB_FLAGS_VALID_ALTITUDE |
+                ADSB_FLAGS_VALID_HEADING |
+                ADSB_FLAGS_VALID_VELOCITY |
+                ADSB_FLAGS_VALID_CALLSIGN |
+                ADSB_FLAGS_SIMULATED;
+            adsb_vehicle.squawk = 0;
+
+            send_adsb_vehicle(adsb_vehicle);
         }
     }
     
 }
 
+/*
+  send one ADSB_VEHICLE message
+ */
+void ADSB::send_adsb_vehicle(mavlink_adsb_vehicle_t &adsb_vehicle)
+{
+    mavlink_message_t msg;
+    mavlink_status_t *chan0_status = mavlink_get_channel_status(MAVLINK_COMM_0);
+    uint8_t saved_seq = chan0_status->current_tx_seq;
+    chan0_status->current_tx_seq = mavlink.seq;
+    uint16_t len = mavlink_msg_adsb_vehicle_encode(vehicle_system_id,
+                                                   MAV_COMP_ID_ADSB,
+                                                   &msg, &adsb_vehicle);
+    chan0_status->current_tx_seq = saved_seq;
+
+    mav_socket.send(&msg.magic, len);
+}
+
 } // namespace SITL
@@ -22,6 +22,7 @@
 #include <AP_HAL/utility/Socket.h>
 
 #include "SIM_Aircraft.h"
+#include "SIM_World.h"
 
 namespace SITL {
 
@@ -43,13 +44,16 @@ private:
         
 class ADSB {
 public:
-    ADSB(const struct sitl_fdm &_fdm, const char *home_str);
+    ADSB(const struct sitl_fdm &_fdm, const char *home_str, uint16_t target_port, const World *world);
     void update(void);
 
 private:
     const struct sitl_fdm &fdm;
     const char *target_address = "127.0.0.1";
-    const uint16_t target_port = 5762;
+    const uint16_t target_port;
+
+    // other SITL instances to report as traffic, may be NULL
+    const World *world;
 
     Location home;
     static const uint8_t num_vehicles = 6;
@@ -75,6 +79,7 @@ private:
     } mavlink {};
 
     void send_report(void);
+    void send_adsb_vehicle(mavlink_adsb_vehicle_t &adsb_vehicle);
 };
 
 }  // namespace SITL
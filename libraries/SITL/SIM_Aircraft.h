@@ -50,6 +50,14 @@ public:
      */
     void set_speedup(float speedup);
 
+    /*
+      run in lockstep with the autopilot, as fast as possible. The
+      model no longer sleeps to keep pace with the wall clock
+     */
+    void set_lockstep(void) {
+        use_time_sync = false;
+    }
+
     /*
       set instance number
      */
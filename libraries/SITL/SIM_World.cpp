@@ -0,0 +1,208 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  a world shared by SITL instances on one machine
+*/
+
+#include "SIM_World.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace SITL {
+
+/*
+  open the world called name, creating it if this is the first
+  instance to join it, and take the slot for this instance
+ */
+World::World(const char *name, uint8_t _instance, bool _lockstep) :
+    instance(_instance),
+    lockstep(_lockstep)
+{
+    if (instance >= max_vehicles) {
+        ::printf("World: instance %u out of range\n", (unsigned)instance);
+        return;
+    }
+    snprintf(shm_name, sizeof(shm_name), "/ardupilot-world-%s", name);
+
+    int fd = shm_open(shm_name, O_RDWR | O_CREAT, 0666);
+    if (fd == -1) {
+        ::printf("World: shm_open %s failed - %s\n", shm_name, strerror(errno));
+        return;
+    }
+    // a new segment is zero filled, and growing it to the same size again is harmless
+    if (ftruncate(fd, sizeof(Shared)) == -1) {
+        ::printf("World: ftruncate %s failed - %s\n", shm_name, strerror(errno));
+        close(fd);
+        return;
+    }
+    void *p = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        ::printf("World: mmap %s failed - %s\n", shm_name, strerror(errno));
+        return;
+    }
+    Shared *s = (Shared *)p;
+
+    if (s->magic == 0) {
+        s->magic = magic;
+    } else if (s->magic != magic) {
+        ::printf("World: %s has a different layout\n", shm_name);
+        munmap(p, sizeof(Shared));
+        return;
+    }
+
+    Slot &my_slot = s->slots[instance];
+    if (my_slot.pid != 0 && my_slot.pid != getpid() && kill(my_slot.pid, 0) == 0) {
+        ::printf("World: instance %u already in %s\n", (unsigned)instance, shm_name);
+        munmap(p, sizeof(Shared));
+        return;
+    }
+
+    my_slot.seq = 0;
+    my_slot.time_us = 0;
+    my_slot.lockstep = lockstep;
+    my_slot.heartbeat_ms = wall_ms();
+    memset(&my_slot.vehicle, 0, sizeof(my_slot.vehicle));
+    my_slot.vehicle.instance = instance;
+    my_slot.vehicle.ICAO_address = 0x5D0000 + instance;
+    snprintf(my_slot.vehicle.callsign, sizeof(my_slot.vehicle.callsign), "SITL%u", (unsigned)instance);
+    __sync_synchronize();
+    my_slot.pid = getpid();
+
+    shared = s;
+    slot = &my_slot;
+    ::printf("World: instance %u joined %s\n", (unsigned)instance, shm_name);
+}
+
+/*
+  leave the world. It stays in shared memory for the other instances,
+  and for the next run, which takes over the slots of instances that
+  have gone
+ */
+World::~World(void)
+{
+    if (shared == nullptr) {
+        return;
+    }
+    slot->pid = 0;
+    munmap(shared, sizeof(Shared));
+    shared = nullptr;
+    slot = nullptr;
+}
+
+uint32_t World::wall_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000UL;
+}
+
+// true if s belongs to a running instance that has published recently
+bool World::live(const Slot &s, uint32_t now_ms) const
+{
+    return s.pid != 0 && (now_ms - s.heartbeat_ms) < stale_ms;
+}
+
+/*
+  wait until no other lockstep instance is more than max_lead_us behind
+  time_us. The instance furthest behind never waits, so the world as a
+  whole always moves on
+ */
+void World::wait_step(uint64_t time_us)
+{
+    if (shared == nullptr || !lockstep) {
+        return;
+    }
+    while (true) {
+        const uint32_t now_ms = wall_ms();
+        // keep this instance live while it waits
+        slot->heartbeat_ms = now_ms;
+        bool behind = false;
+        for (uint8_t i=0; i<max_vehicles; i++) {
+            const Slot &s = shared->slots[i];
+            if (&s != slot && s.lockstep && live(s, now_ms) && s.time_us + max_lead_us < time_us) {
+                behind = true;
+                break;
+            }
+        }
+        if (!behind) {
+            return;
+        }
+        sched_yield();
+    }
+}
+
+/*
+  publish the state of this instance's vehicle. Readers retry if the
+  sequence number is odd or changes while they copy
+ */
+void World::update(const struct sitl_fdm &fdm)
+{
+    if (shared == nullptr) {
+        return;
+    }
+    slot->seq++;
+    __sync_synchronize();
+    Vehicle &v = slot->vehicle;
+    v.latitude = fdm.latitude;
+    v.longitude = fdm.longitude;
+    v.altitude = fdm.altitude;
+    v.speedN = fdm.speedN;
+    v.speedE = fdm.speedE;
+    v.speedD = fdm.speedD;
+    v.timestamp_us = fdm.timestamp_us;
+    __sync_synchronize();
+    slot->seq++;
+
+    slot->time_us = fdm.timestamp_us;
+    slot->heartbeat_ms = wall_ms();
+}
+
+// get the latest state of the vehicle in slot i, if it is another live instance
+bool World::get_vehicle(uint8_t i, Vehicle &vehicle) const
+{
+    if (shared == nullptr || i >= max_vehicles || i == instance) {
+        return false;
+    }
+    const Slot &s = shared->slots[i];
+    if (!live(s, wall_ms())) {
+        return false;
+    }
+    for (uint8_t tries=0; tries<10; tries++) {
+        const uint32_t seq = s.seq;
+        __sync_synchronize();
+        if (seq & 1) {
+            continue;
+        }
+        memcpy(&vehicle, (const void *)&s.vehicle, sizeof(vehicle));
+        __sync_synchronize();
+        if (s.seq == seq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace SITL
@@ -0,0 +1,100 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  a world shared by SITL instances on one machine
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include "SITL.h"
+
+namespace SITL {
+
+/*
+  A world is a block of shared memory that each SITL instance joined to
+  it publishes its vehicle to after every model step. Instances see
+  each other through it without any sockets, for ADSB traffic and
+  anything else that needs to know about the other vehicles.
+
+  Instances running in lockstep also step together: an instance waits
+  before stepping its model until no other lockstep instance is more
+  than max_lead_us behind it, so a swarm keeps a common simulated time
+  however the processes are scheduled. An instance that stops
+  publishing for stale_ms of wall clock time is left out, so one that
+  exits or is stopped in a debugger doesn't hold up the rest.
+ */
+class World {
+public:
+    // most vehicles in a world, one for each instance number
+    static const uint8_t max_vehicles = 32;
+
+    struct Vehicle {
+        uint8_t instance;
+        uint32_t ICAO_address;
+        char callsign[9];
+        double latitude, longitude; // degrees
+        double altitude;            // MSL
+        double speedN, speedE, speedD; // m/s
+        uint64_t timestamp_us;      // simulated time of the state
+    };
+
+    World(const char *name, uint8_t instance, bool lockstep);
+    ~World(void);
+
+    // true if the world was opened and this instance's slot is free
+    bool joined(void) const { return shared != nullptr; }
+
+    // wait for the other lockstep instances to catch up with time_us
+    void wait_step(uint64_t time_us);
+
+    // publish the state of this instance's vehicle
+    void update(const struct sitl_fdm &fdm);
+
+    // get the latest state of another live vehicle, returns false if there isn't one in slot i
+    bool get_vehicle(uint8_t i, Vehicle &vehicle) const;
+
+private:
+    static const uint32_t magic = 0x57524C44; // WRLD
+    static const uint64_t max_lead_us = 20000;
+    static const uint32_t stale_ms = 2000;
+
+    struct Slot {
+        volatile uint32_t seq;      // odd while being written
+        volatile uint32_t heartbeat_ms; // wall clock time of the last update
+        volatile uint64_t time_us;  // simulated time, for the lockstep wait
+        volatile bool lockstep;
+        volatile pid_t pid;
+        Vehicle vehicle;
+    };
+
+    struct Shared {
+        volatile uint32_t magic;
+        Slot slots[max_vehicles];
+    };
+
+    char shm_name[64];
+    Shared *shared = nullptr;
+    Slot *slot = nullptr;
+    uint8_t instance;
+    bool lockstep;
+
+    bool live(const Slot &s, uint32_t now_ms) const;
+    static uint32_t wall_ms(void);
+};
+
+}  // namespace SITL